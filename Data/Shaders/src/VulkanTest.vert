@@ -17,6 +17,9 @@ layout(binding = 0) uniform UniformBufferObject
 	mat4 proj;	
 } ubo;
 
+//With packed vertices the attributes arrive as unorm16 position, RGBA8 color and half float texcoord.
+//The vertex input stage converts all of them to floats, and ubo.model maps the [0, 1] position back onto the mesh bounds,
+//so this shader is the same for both vertex formats.
 layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec3 inColor;
 layout(location = 2) in vec2 inTexCoord;
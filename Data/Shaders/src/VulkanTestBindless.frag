@@ -0,0 +1,30 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+//The bindless variant of VulkanTest.frag: every texture lives in one array in set 1,
+//and the uniform block of the draw says which element to sample. See BindlessTextureTable.
+
+//The size of the array depends on the device, the pipeline passes it as specialization constant.
+layout(constant_id = 0) const uint TEXTURE_COUNT = 16;
+layout(set = 1, binding = 0) uniform sampler2D textures[TEXTURE_COUNT];
+
+//Same block as the vertex shader reads, only the texture index is used here.
+layout(set = 0, binding = 0) uniform UniformBufferObject
+{
+	mat4 model;
+	mat4 view;
+	mat4 proj;
+	uint textureIndex;
+} ubo;
+
+layout(location = 0) in vec3 fragColor;
+layout(location = 1) in vec2 fragTexCoord;
+
+layout(location = 0) out vec4 outColor;
+
+void main()
+{
+	//The index is the same for the whole draw, so it is dynamically uniform and
+	//shaderSampledImageArrayDynamicIndexing is all we need, no nonuniformEXT.
+	outColor = texture(textures[ubo.textureIndex], fragTexCoord);
+}
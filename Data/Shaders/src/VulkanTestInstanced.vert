@@ -0,0 +1,34 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+//The instanced variant of VulkanTest.vert: every copy of the mesh is placed by the model matrix of its instance,
+//read from the per instance vertex binding. ubo.model is shared by all copies, it holds the spin of the mesh.
+
+layout(binding = 0) uniform UniformBufferObject
+{
+	mat4 model;
+	mat4 view;
+	mat4 proj;
+} ubo;
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inColor;
+layout(location = 2) in vec2 inTexCoord;
+
+//A mat4 input takes locations 3 to 6, one per column.
+layout(location = 3) in mat4 inInstanceModel;
+
+layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec2 fragTexCoord;
+
+out gl_PerVertex
+{
+	vec4 gl_Position;
+};
+
+void main()
+{
+	gl_Position = ubo.proj * ubo.view * inInstanceModel * ubo.model * vec4(inPosition, 1.0f);
+	fragColor = inColor;
+	fragTexCoord = inTexCoord;
+}
@@ -0,0 +1,37 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+//The push constant variant of VulkanTest.vert: the model matrix of every draw is pushed into the command buffer
+//instead of living in a uniform block of its own. ubo.model is shared by all draws, it holds the spin of the mesh.
+
+layout(binding = 0) uniform UniformBufferObject
+{
+	mat4 model;
+	mat4 view;
+	mat4 proj;
+} ubo;
+
+//Matches DrawPushConstants.
+layout(push_constant) uniform PushConstants
+{
+	mat4 model;
+} draw;
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inColor;
+layout(location = 2) in vec2 inTexCoord;
+
+layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec2 fragTexCoord;
+
+out gl_PerVertex
+{
+	vec4 gl_Position;
+};
+
+void main()
+{
+	gl_Position = ubo.proj * ubo.view * draw.model * ubo.model * vec4(inPosition, 1.0f);
+	fragColor = inColor;
+	fragTexCoord = inTexCoord;
+}
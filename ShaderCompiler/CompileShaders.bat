@@ -1,6 +1,14 @@
 glslangValidator.exe -V ../Data/Shaders/src/VulkanTest.vert
 glslangValidator.exe -V ../Data/Shaders/src/VulkanTest.frag
+glslangValidator.exe -V ../Data/Shaders/src/VulkanTestBindless.frag -o bindless_frag.spv
+glslangValidator.exe -V ../Data/Shaders/src/VulkanTestInstanced.vert -o instanced_vert.spv
+glslangValidator.exe -V ../Data/Shaders/src/VulkanTestCull.comp -o cull_comp.spv
+glslangValidator.exe -V ../Data/Shaders/src/VulkanTestPush.vert -o push_vert.spv
 
 MOVE frag.spv ../data/shaders/bin
 MOVE vert.spv ../data/shaders/bin
+MOVE bindless_frag.spv ../data/shaders/bin
+MOVE instanced_vert.spv ../data/shaders/bin
+MOVE cull_comp.spv ../data/shaders/bin
+MOVE push_vert.spv ../data/shaders/bin
 pause
\ No newline at end of file
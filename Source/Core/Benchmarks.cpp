@@ -0,0 +1,188 @@
+#include "Benchmarks.h"
+
+#include "../Help/HelperMethods.h"
+#include "../Help/VertexDeduplicator.h"
+#include "../Help/MipGenerator.h"
+#include "../Help/ThreadPool.h"
+#include "../Vulkan/Texture.h"
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <functional>
+#include <unordered_map>
+#include <thread>
+#include <algorithm>
+#include <stdexcept>
+
+namespace
+{
+	const std::string BENCHMARK_MESH_PATH = "../data/meshes/SniperTank.obj";
+	const std::string BENCHMARK_TEXTURE_PATH = "../data/textures/chalet.jpg";
+
+	const uint32_t DEDUPLICATION_ITERATIONS = 20;
+
+	//The large variant places this many translated copies of the mesh next to each other.
+	const uint32_t DEDUPLICATION_TILES = 64;
+
+	const uint32_t MIP_ITERATIONS = 5;
+
+	//Average wall time of work in milliseconds, after one untimed run to warm up the caches.
+	float MeasureMs(uint32_t iterations, const std::function<void()>& work)
+	{
+		work();
+
+		const auto start = std::chrono::high_resolution_clock::now();
+		for (uint32_t i = 0; i < iterations; ++i)
+			work();
+		const auto end = std::chrono::high_resolution_clock::now();
+
+		return std::chrono::duration<float, std::milli>(end - start).count() / iterations;
+	}
+
+	//What LoadModel used to do: std::hash<Vertex> and two lookups per index.
+	void DeduplicateWithUnorderedMap(const std::vector<Vertex>& stream, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+	{
+		vertices.clear();
+		indices.clear();
+
+		std::unordered_map<Vertex, uint32_t> uniqueVertices = {};
+
+		for (const Vertex& vertex : stream)
+		{
+			if (uniqueVertices.count(vertex) == 0)
+			{
+				uniqueVertices[vertex] = static_cast<uint32_t>(vertices.size());
+				vertices.push_back(vertex);
+			}
+
+			indices.push_back(uniqueVertices[vertex]);
+		}
+	}
+
+	void BenchmarkStream(const std::string& name, const std::vector<Vertex>& stream)
+	{
+		std::vector<Vertex> expectedVertices;
+		std::vector<uint32_t> expectedIndices;
+		const float baselineMs = MeasureMs(DEDUPLICATION_ITERATIONS, [&]() { DeduplicateWithUnorderedMap(stream, expectedVertices, expectedIndices); });
+
+		std::cout << name << ": " << stream.size() << " indices, " << expectedVertices.size() << " unique vertices" << std::endl;
+		std::cout << std::left << std::setw(28) << "  path" << std::right << std::setw(10) << "ms" << std::setw(10) << "speedup" << std::endl;
+		std::cout << std::fixed << std::setprecision(3);
+		std::cout << std::left << std::setw(28) << "  unordered_map" << std::right << std::setw(10) << baselineMs << std::setw(10) << 1.0f << std::endl;
+
+		std::vector<uint32_t> threadCounts = { 1, 2, 4 };
+		const uint32_t hardwareThreads = std::thread::hardware_concurrency();
+		if (hardwareThreads > 4)
+			threadCounts.push_back(hardwareThreads);
+
+		for (uint32_t threadCount : threadCounts)
+		{
+			std::vector<Vertex> vertices;
+			std::vector<uint32_t> indices;
+			const float ms = MeasureMs(DEDUPLICATION_ITERATIONS, [&]() { DeduplicateVertices(stream, vertices, indices, threadCount); });
+
+			//The new path has to produce exactly the same mesh, otherwise the timings mean nothing.
+			//Vertices are compared bitwise now, which only differs from operator== for -0.0 and NaN.
+			if (vertices.size() != expectedVertices.size() || indices != expectedIndices)
+				throw std::runtime_error("deduplication with " + std::to_string(threadCount) + " threads doesn't match the unordered_map!");
+
+			const std::string label = "  vertex table, " + std::to_string(threadCount) + (threadCount == 1 ? " thread" : " threads");
+			std::cout << std::left << std::setw(28) << label << std::right << std::setw(10) << ms << std::setw(10) << baselineMs / ms << std::endl;
+		}
+
+		std::cout.unsetf(std::ios::fixed);
+		std::cout << std::endl;
+	}
+}
+
+bool IsCpuBenchmark(const std::string& name)
+{
+	return name == "dedup" || name == "mips";
+}
+
+void RunCpuBenchmark(const std::string& name)
+{
+	if (name == "dedup")
+		BenchmarkDeduplication(BENCHMARK_MESH_PATH);
+	else if (name == "mips")
+		BenchmarkMipGeneration(BENCHMARK_TEXTURE_PATH);
+	else
+		throw std::runtime_error("unknown benchmark: " + name + "!");
+}
+
+void BenchmarkDeduplication(const std::string& objPath)
+{
+	std::vector<Vertex> stream;
+	LoadVertexStream(stream, objPath);
+
+	std::cout << "deduplication benchmark, average of " << DEDUPLICATION_ITERATIONS << " runs" << std::endl << std::endl;
+	BenchmarkStream(objPath, stream);
+
+	//Translated copies don't share any vertices, so the tiled mesh has DEDUPLICATION_TILES times as many unique vertices.
+	std::vector<Vertex> tiledStream;
+	tiledStream.reserve(stream.size() * DEDUPLICATION_TILES);
+
+	for (uint32_t tile = 0; tile < DEDUPLICATION_TILES; ++tile)
+	{
+		for (Vertex vertex : stream)
+		{
+			vertex.Position.x += 1000.0f * tile;
+			tiledStream.push_back(vertex);
+		}
+	}
+
+	BenchmarkStream(objPath + " x" + std::to_string(DEDUPLICATION_TILES), tiledStream);
+}
+
+void BenchmarkMipGeneration(const std::string& imagePath)
+{
+	TextureData image;
+	LoadTexture(image, imagePath);
+
+	ThreadPool pool;
+
+	std::cout << "mip generation benchmark, " << imagePath << " (" << image.Width << "x" << image.Height << "), average of " << MIP_ITERATIONS << " runs" << std::endl << std::endl;
+
+	const MipFilter filters[] = { MipFilter::Box, MipFilter::Kaiser };
+	const MipColorSpace colorSpaces[] = { MipColorSpace::Linear, MipColorSpace::SRGB };
+
+	for (MipFilter filter : filters)
+	{
+		for (MipColorSpace colorSpace : colorSpaces)
+		{
+			std::cout << (filter == MipFilter::Box ? "box" : "kaiser") << ", " << (colorSpace == MipColorSpace::Linear ? "linear" : "srgb") << std::endl;
+			std::cout << std::left << std::setw(28) << "  kernel" << std::right << std::setw(10) << "ms" << std::setw(10) << "speedup" << std::endl;
+			std::cout << std::fixed << std::setprecision(3);
+
+			std::vector<std::vector<uint8_t>> expected;
+			const float scalarMs = MeasureMs(MIP_ITERATIONS, [&]() { GenerateMipChain(image.Pixels.data(), image.Width, image.Height, colorSpace, filter, expected, nullptr, MipKernel::Scalar); });
+			std::cout << std::left << std::setw(28) << "  scalar" << std::right << std::setw(10) << scalarMs << std::setw(10) << 1.0f << std::endl;
+
+			const auto measure = [&](const std::string& label, MipKernel kernel, ThreadPool* pPool)
+			{
+				if (!IsMipKernelSupported(kernel))
+				{
+					std::cout << std::left << std::setw(28) << label << std::right << std::setw(10) << "n/a" << std::endl;
+					return;
+				}
+
+				std::vector<std::vector<uint8_t>> levels;
+				const float ms = MeasureMs(MIP_ITERATIONS, [&]() { GenerateMipChain(image.Pixels.data(), image.Width, image.Height, colorSpace, filter, levels, pPool, kernel); });
+
+				//The kernels do the same arithmetic in the same order, so anything but identical output is a bug.
+				if (levels != expected)
+					throw std::runtime_error(label + " doesn't match the scalar kernel!");
+
+				std::cout << std::left << std::setw(28) << label << std::right << std::setw(10) << ms << std::setw(10) << scalarMs / ms << std::endl;
+			};
+
+			measure("  sse2", MipKernel::SSE2, nullptr);
+			measure("  avx2", MipKernel::AVX2, nullptr);
+			measure("  best, " + std::to_string(pool.GetThreadCount()) + " threads", MipKernel::Best, &pool);
+
+			std::cout.unsetf(std::ios::fixed);
+			std::cout << std::endl;
+		}
+	}
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <string>
+
+//Benchmarks that only exercise CPU code, so they run without a window, an instance or a GPU.
+//Benchmarks that need the device are part of HelloTriangleApplication.
+
+//Returns whether name is one of the benchmarks below.
+bool IsCpuBenchmark(const std::string& name);
+
+//Runs the benchmark called name and prints its results.
+void RunCpuBenchmark(const std::string& name);
+
+//Compares the old unordered_map deduplication in LoadModel with VertexTable and DeduplicateVertices
+//on the vertex stream of objPath, and on a tiled copy of it to simulate a larger mesh.
+void BenchmarkDeduplication(const std::string& objPath);
+
+//Generates the whole mip chain of imagePath with every filter, color space and kernel MipGenerator has,
+//and compares the SIMD kernels with the scalar one, which doubles as the reference for their output.
+void BenchmarkMipGeneration(const std::string& imagePath);
@@ -11,6 +11,8 @@
 #include <array>
 #include <unordered_map>
 #include <thread>
+#include <iomanip>
+#include <cmath>
 
 //Exposes functions to do precise timekeeping.
 #include <chrono>
@@ -51,28 +53,37 @@
 #include "../Vulkan/DescriptorSetLayout.h"
 #include "../Vulkan/PipelineLayout.h"
 #include "../Vulkan/GraphicsPipeline.h"
-#include "../Vulkan/CommandPool.h"
-#include "../Vulkan/Buffer2D.h"
+#include "../Vulkan/PipelineCache.h"
+#include "../Vulkan/SetupContext.h"
+#include "../Vulkan/UploadManager.h"
 #include "../Vulkan/Texture.h"
+#include "../Vulkan/TextureStreamer.h"
 #include "../Vulkan/TextureSampler.h"
 #include "../Vulkan/VertexBuffer.h"
 #include "../Vulkan/IndexBuffer.h"
 #include "../Vulkan/DescriptorPool.h"
+#include "../Vulkan/BindlessTextureTable.h"
+#include "../Vulkan/GpuCuller.h"
+#include "../Vulkan/RenderGraph.h"
 #include "../Vulkan/Semaphore.h"
 #include "../Vulkan/Fence.h"
-#include "../Vulkan/DepthBuffer.h"
+#include "../Vulkan/Profiler.h"
 
 #include "../Help/HelperMethods.h"
+#include "../Help/TaskGraph.h"
+#include "../Help/FramePacer.h"
+#include "../Help/CameraPath.h"
+#include "../Help/Ktx2Texture.h"
+#include "../Help/TextureCooker.h"
 
 #include "HelloTriangleApplication.h"
 
-//Create different queue family specifically for transfer operatinos. It will require you the following changes:
-//1) Modify QueueFamilyIndices and FindQueueFamilies to explicitly look for a queue family with the VK_QUEUE_TRANSFER bit,
-//but not the VK_QUEUE_GRAPHICS_BIT.
-//2) Modify CreateLogicalDevice to request a handle to the transfer queue
-//3) Create a second command pool for command buffers that are submitted on the transfer queue family
-//4) Change the sharingMode of resources to be VK_SHARING_MODE_CONCURRENT and specify both the graphics and transfer queue families
-//5) Submit any transfer command like vkCmdCopyBuffer to the transfer queue instead of the graphics queue
+//Transfers run on a different queue family than the rendering when the device has one:
+//1) FindQueueFamilies looks for a queue family with the VK_QUEUE_TRANSFER bit, but not the VK_QUEUE_GRAPHICS_BIT.
+//2) The logical device requests a handle to the transfer queue
+//3) The UploadManager has a second command pool for command buffers that are submitted on the transfer queue family
+//4) Resources stay VK_SHARING_MODE_EXCLUSIVE, their ownership is transferred to the graphics queue family with a pair of barriers
+//5) Transfer commands like vkCmdCopyBuffer are batched and submitted to the transfer queue instead of the graphics queue
 
 //Shader stages: the shader modules that define the functionality of the programmable stages of the graphics pipeline
 //Fixed-function state: all of the structures that define the fixed-functoins stages of the pipeline, like input assembly, rasterizer, viewport and color blending
@@ -123,24 +134,76 @@ void main()
 //Dynamic uniforms
 //Separate images and sampler descriptors
 //Pipeline cache
-//Multi-threaded command buffer generation
 //Multiple subpasses
 //Compute shaders
 
-//maybe put this back in the define
-/*std::cout << initLog << std::endl;\
-std::cout << std::string(20, '-') << std::endl << std::endl;\*/
+const uint32_t HelloTriangleApplication::MAX_SUPPORTED_FRAMES_IN_FLIGHT;
 
-#define FULL_CREATION(initLog, creation, initFinsishedLog)\
-creation;\
-std::cout << initFinsishedLog << std::endl;\
-std::cout << std::string(30, '-') << std::endl << std::endl;
+namespace
+{
+	//Draw and thread counts the recording benchmark runs through, and how often each combination is recorded.
+	const std::vector<uint32_t> BENCHMARK_DRAW_COUNTS = { 1, 64, 512, 4096, 16384 };
+	const std::vector<uint32_t> BENCHMARK_THREAD_COUNTS = { 1, 2, 4, 8 };
+	const uint32_t BENCHMARK_ITERATIONS = 50;
+
+	//Copy counts of the instancing benchmark and the frames rendered for each. Only the first triangles of the mesh
+	//are drawn, with the whole mesh a million copies would keep the GPU busy for minutes and hide the cost per draw.
+	const std::vector<uint32_t> BENCHMARK_INSTANCE_COUNTS = { 1, 10, 100, 1000, 10000, 100000, 1000000 };
+	const uint32_t BENCHMARK_INSTANCE_FRAMES = 10;
+	const uint32_t BENCHMARK_INSTANCE_INDEX_COUNT = 3 * 64;
+
+	//The frames benchmark renders the same frames every run: the animation advances a fixed step per frame
+	//and, unless a camera path is given, the camera orbits the scene once in BENCHMARK_ORBIT_DURATION seconds.
+	//The first frames fill the frames in flight and warm up caches and clocks, they aren't measured.
+	const float BENCHMARK_TIME_STEP = 1.0f / 60.0f;
+	const float BENCHMARK_ORBIT_DURATION = 10.0f;
+	const uint32_t BENCHMARK_WARMUP_FRAMES = 10;
+
+	//Relative radius error the GPU culling may make before VerifyCulling rejects it.
+	const float CULLING_TOLERANCE = 1e-4f;
+
+	std::string EscapeJson(const std::string& text)
+	{
+		std::string escaped;
+		for (char c : text)
+		{
+			if (c == '"' || c == '\\')
+				escaped += '\\';
+			escaped += c;
+		}
+		return escaped;
+	}
+}
 
-HelloTriangleApplication::HelloTriangleApplication()
+HelloTriangleApplication::HelloTriangleApplication(const ApplicationDesc& desc):
+	m_Desc(desc),
+	m_MaxFramesInFlight(std::min(std::max(desc.FramesInFlight, 1u), MAX_SUPPORTED_FRAMES_IN_FLIGHT))
 {
-	FULL_CREATION("Window being created", m_UniqueWindow = std::make_unique<Window>(WIDTH, HEIGHT, "VulkanTestProject", false), "Window created");
-	FULL_CREATION("Instance being created", m_UniqueInstance = std::make_unique<VulkanInstance>(true), "Instance created");
-	FULL_CREATION("Surface being created", m_UniqueSurface = std::make_unique<Surface>(m_UniqueInstance->GetInstance(), m_UniqueWindow->GetGLFWWindow()), "Surface created");
+	if (m_MaxFramesInFlight != desc.FramesInFlight)
+		std::cerr << "frames in flight must be between 1 and " << MAX_SUPPORTED_FRAMES_IN_FLIGHT << ", using " << m_MaxFramesInFlight << std::endl;
+
+	if (m_Desc.Benchmark == "frames")
+	{
+		if (m_Desc.TimeStep <= 0.0f)
+			m_Desc.TimeStep = BENCHMARK_TIME_STEP;
+		if (m_Desc.CameraScript.empty())
+			m_Desc.CameraScript = "orbit";
+	}
+
+	//In headless mode there is no window, no surface and nothing to present to.
+	//Validation layers are rarely installed on render farm nodes, so we only request them when we have a window.
+	//The window and instance have to be created on the main thread, everything else is created in InitializeVulkan.
+	if (m_Desc.Headless)
+	{
+		m_UniqueInstance = std::make_unique<VulkanInstance>(false, true);
+		return;
+	}
+
+	m_DeviceExtensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+
+	m_UniqueWindow = std::make_unique<Window>(WIDTH, HEIGHT, "VulkanTestProject", true);
+	m_UniqueInstance = std::make_unique<VulkanInstance>(true);
+	m_UniqueSurface = std::make_unique<Surface>(m_UniqueInstance->GetInstance(), m_UniqueWindow->GetGLFWWindow());
 }
 
 HelloTriangleApplication::~HelloTriangleApplication()
@@ -151,68 +214,369 @@ HelloTriangleApplication::~HelloTriangleApplication()
 void HelloTriangleApplication::Run()
 {
 	InitializeVulkan();
+
+	if (m_Desc.Benchmark == "record")
+	{
+		BenchmarkRecording();
+		return;
+	}
+	else if (m_Desc.Benchmark == "instances")
+	{
+		BenchmarkInstancing();
+		return;
+	}
+	else if (m_Desc.Benchmark == "frames")
+	{
+		BenchmarkFrames();
+		return;
+	}
+	else if (!m_Desc.Benchmark.empty())
+		throw std::runtime_error("unknown benchmark: " + m_Desc.Benchmark + "!");
+
 	MainLoop();
 }
 
 void HelloTriangleApplication::InitializeVulkan()
 {
-	//Start loading model on new thread
-	//needs std::ref because we're running this method on a new thread
-	auto startTime = std::chrono::high_resolution_clock::now();
+	//Startup is described as a graph of tasks instead of a fixed sequence. Loading assets from disk
+	//(the model, the texture and the SPIR-V) doesn't need the device at all, so it runs on worker threads
+	//while the device, swap chain and render pass are being created. Every task only waits for the tasks it actually needs.
+	TaskGraph graph;
+
+	m_ObjectTransforms = CreateObjectTransforms(std::max(m_Desc.ObjectCount, 1u), m_Desc.GridScale);
+	if (UsesPushConstants())
+		m_DrawConstants = CreateDrawConstants(m_ObjectTransforms);
+
+	//The benchmark records up to its largest draw count, so the uniform ring needs a block for each of those draws.
+	uint32_t maxUniformBlocks = static_cast<uint32_t>(m_ObjectTransforms.size());
+	if (m_Desc.Benchmark == "record" || m_Desc.Benchmark == "instances")
+		maxUniformBlocks = std::max(maxUniformBlocks, *std::max_element(BENCHMARK_DRAW_COUNTS.begin(), BENCHMARK_DRAW_COUNTS.end()));
+
+	//GLFW may only be called from the main thread, so the swap chain and frame pacer tasks get the framebuffer size
+	//and the refresh rate from here.
+	VkExtent2D framebufferSize = { WIDTH, HEIGHT };
+	int refreshRate = 0;
+	if (!m_Desc.Headless)
+	{
+		int width = 0;
+		int height = 0;
+		glfwGetFramebufferSize(m_UniqueWindow->GetGLFWWindow(), &width, &height);
+		framebufferSize = { static_cast<uint32_t>(width), static_cast<uint32_t>(height) };
+		refreshRate = GetRefreshRate();
+	}
+
+	TextureData textureData;
+	std::unique_ptr<Ktx2Texture> uniqueCookedTexture;
+	std::vector<char> vertShaderCode;
+	std::vector<char> instancedVertShaderCode;
+	std::vector<char> fragShaderCode;
+	std::vector<char> bindlessFragShaderCode;
+	std::vector<char> cullShaderCode;
+
+	//Work that doesn't touch Vulkan
+	const TaskGraph::TaskId loadModel = graph.Add("Load model", [&]()
+	{
+		if (m_Desc.PackedVertices)
+			m_Mesh.Load(MODEL_PATH, PACKED_MESH_CACHE_PATH, VertexFormat::Packed);
+		else
+			m_Mesh.Load(MODEL_PATH, MESH_CACHE_PATH, VertexFormat::Float);
+	});
+	const TaskGraph::TaskId readShaders = graph.Add("Read shaders", [&]()
+	{
+		vertShaderCode = ReadFile(UsesPushConstants() ? PUSH_VERT_SHADER_PATH : VERT_SHADER_PATH);
+		if (UsesInstancing())
+			instancedVertShaderCode = ReadFile(INSTANCED_VERT_SHADER_PATH);
+		fragShaderCode = ReadFile(FRAG_SHADER_PATH);
+		if (m_Desc.Bindless)
+			bindlessFragShaderCode = ReadFile(BINDLESS_FRAG_SHADER_PATH);
+		if (m_Desc.GpuCulling)
+			cullShaderCode = ReadFile(CULL_COMP_SHADER_PATH);
+	});
+
+	//Device level objects
+	const TaskGraph::TaskId physicalDevice = graph.Add("Pick physical device", [&]() { PickPhysicalDevice(); });
+
+	//Which cooked format we can use depends on the device. Only when the texture wasn't cooked (see --cook)
+	//do we have to decode the source image and generate the mips on the GPU.
+	const TaskGraph::TaskId loadTexture = graph.Add("Load texture", [&]()
+	{
+		const std::string cookedPath = FindCookedTexture(TEXTURE_PATH, m_UniqueGpu.get());
+		uniqueCookedTexture = std::make_unique<Ktx2Texture>();
+		if (cookedPath.empty() || !uniqueCookedTexture->Load(cookedPath))
+		{
+			uniqueCookedTexture.reset();
+			LoadTexture(textureData, TEXTURE_PATH);
+		}
+	}, { physicalDevice });
+	//Whether textures are bindless, and how, depends on the device and decides which extensions we enable.
+	bool useDescriptorIndexing = false;
+	const TaskGraph::TaskId logicalDevice = graph.Add("Create logical device", [&]()
+	{
+		if (m_Desc.Bindless)
+		{
+			m_IsBindless = BindlessTextureTable::IsSupported(m_UniqueGpu.get());
+			useDescriptorIndexing = m_IsBindless && BindlessTextureTable::IsDescriptorIndexingSupported(m_UniqueInstance.get(), m_UniqueGpu.get());
+
+			if (!m_IsBindless)
+				std::cerr << "bindless textures need shaderSampledImageArrayDynamicIndexing, using a descriptor set per frame" << std::endl;
+			else if (useDescriptorIndexing)
+			{
+				m_DeviceExtensions.push_back(VK_KHR_MAINTENANCE3_EXTENSION_NAME);
+				m_DeviceExtensions.push_back(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME);
+			}
+		}
+
+		m_UniqueCpu = std::make_unique<LogicalDevice>(m_UniqueInstance.get(), m_UniqueGpu.get(), m_DeviceExtensions, m_ValidationLayers);
+	}, { physicalDevice });
+
+	const TaskGraph::TaskId swapChain = graph.Add("Create swap chain", [&]()
+	{
+		if (m_Desc.Headless)
+			m_UniqueSwapChain = std::make_unique<SwapChain>(m_UniqueGpu.get(), m_UniqueCpu.get(), WIDTH, HEIGHT, m_MaxFramesInFlight);
+		else
+			m_UniqueSwapChain = std::make_unique<SwapChain>(m_UniqueGpu.get(), framebufferSize, m_UniqueSurface.get(), m_UniqueCpu.get(), m_Desc.Policy);
+
+		m_UniqueSwapChain->CreateImageViews();
+	}, { logicalDevice });
+
+	const TaskGraph::TaskId renderPass = graph.Add("Create render pass", [&]()
+	{
+		m_UniqueRenderPass = std::make_unique<RenderPass>(m_UniqueCpu.get(), m_UniqueSwapChain.get(), m_UniqueGpu.get());
+	}, { swapChain });
+
+	const TaskGraph::TaskId descriptorSetLayout = graph.Add("Create descriptor set layout", [&]()
+	{
+		m_UniqueDescriptorSetLayout = std::make_unique<DescriptorSetLayout>(m_UniqueCpu.get());
+	}, { logicalDevice });
+
+	const TaskGraph::TaskId pipelineCache = graph.Add("Load pipeline cache", [&]()
+	{
+		m_UniquePipelineCache = std::make_unique<PipelineCache>(m_UniqueCpu.get(), m_UniqueGpu.get(), PIPELINE_CACHE_PATH);
+	}, { logicalDevice });
+
+	const TaskGraph::TaskId textureTable = graph.Add("Create texture table", [&]()
+	{
+		if (!m_IsBindless)
+			return;
+
+		m_UniqueTextureTable = std::make_unique<BindlessTextureTable>(m_UniqueCpu.get(), m_UniqueGpu.get(), m_MaxFramesInFlight, useDescriptorIndexing);
+		std::cout << "bindless textures: " << m_UniqueTextureTable->GetCapacity() << " slots, "
+			<< (useDescriptorIndexing ? "partially bound" : "fully bound fallback") << std::endl;
+	}, { logicalDevice });
+
+	//Usually the most expensive step, and it only competes with the uploads below for CPU time.
+	graph.Add("Create graphics pipeline", [&]()
+	{
+		std::vector<VkPushConstantRange> pushConstantRanges;
+		if (UsesPushConstants())
+			pushConstantRanges.push_back(GetPushConstantRange<DrawPushConstants>(VK_SHADER_STAGE_VERTEX_BIT));
+
+		m_UniquePipeline = std::make_unique<GraphicsPipeline>(m_UniqueCpu.get(), m_UniqueRenderPass.get(),
+			m_UniqueDescriptorSetLayout.get(), m_UniquePipelineCache.get(),
+			m_Desc.PackedVertices ? VertexFormat::Packed : VertexFormat::Float, vertShaderCode, m_IsBindless ? bindlessFragShaderCode : fragShaderCode,
+			m_UniqueTextureTable.get(), false, pushConstantRanges);
+
+		if (UsesInstancing())
+		{
+			m_UniqueInstancedPipeline = std::make_unique<GraphicsPipeline>(m_UniqueCpu.get(), m_UniqueRenderPass.get(),
+				m_UniqueDescriptorSetLayout.get(), m_UniquePipelineCache.get(),
+				m_Desc.PackedVertices ? VertexFormat::Packed : VertexFormat::Float, instancedVertShaderCode, m_IsBindless ? bindlessFragShaderCode : fragShaderCode,
+				m_UniqueTextureTable.get(), true);
+		}
+	}, { renderPass, descriptorSetLayout, pipelineCache, readShaders, textureTable });
+
+	const TaskGraph::TaskId setupContext = graph.Add("Create setup context", [&]()
+	{
+		m_UniqueSetupContext = std::make_unique<SetupContext>(m_UniqueCpu.get(), m_UniqueGpu.get());
+	}, { logicalDevice });
+
+	//The profiler comes with the upload manager, so every upload can be measured. Its queries are reset by the setup context.
+	const TaskGraph::TaskId uploadManager = graph.Add("Create upload manager", [&]()
+	{
+		m_UniqueUploadManager = std::make_unique<UploadManager>(m_UniqueCpu.get(), m_UniqueGpu.get());
+
+		//The frames benchmark draws its frames like the main loop, the other benchmarks don't have frames to profile.
+		if (!m_Desc.ProfilePath.empty() && (m_Desc.Benchmark.empty() || m_Desc.Benchmark == "frames"))
+		{
+			m_UniqueProfiler = std::make_unique<Profiler>(m_UniqueCpu.get(), m_UniqueGpu.get(), m_UniqueSetupContext.get());
+			m_UniqueUploadManager->SetProfiler(m_UniqueProfiler.get());
+		}
+		else if (!m_Desc.ProfilePath.empty())
+			std::cerr << "ignoring --profile, the " << m_Desc.Benchmark << " benchmark isn't profiled" << std::endl;
+	}, { logicalDevice, setupContext });
+
+	const TaskGraph::TaskId uniformBuffer = graph.Add("Create uniform buffer", [&]() { m_UniqueSwapChain->CreateUniformBuffer(maxUniformBlocks, m_MaxFramesInFlight); }, { swapChain });
+	const TaskGraph::TaskId descriptorPool = graph.Add("Create descriptor pool", [&]()
+	{
+		m_UniqueDescriptorPool = std::make_unique<DescriptorPool>(m_UniqueCpu.get(), m_MaxFramesInFlight);
+	}, { logicalDevice });
+
+	//The following tasks only record into the setup context or the upload manager, which do their own locking,
+	//so they run in parallel. Nothing is submitted until the whole graph has run.
+
+	//With a budget only the mip tail is uploaded here, the streamer brings in the rest once the frames need it.
+	const TaskGraph::TaskId texture = graph.Add("Upload texture", [&]()
+	{
+		if (m_Desc.TextureBudgetMiB > 0)
+		{
+			m_UniqueTextureStreamer = std::make_unique<TextureStreamer>(m_UniqueCpu.get(), m_UniqueGpu.get(), m_UniqueUploadManager.get(),
+				static_cast<VkDeviceSize>(m_Desc.TextureBudgetMiB) * 1024 * 1024, m_MaxFramesInFlight);
+
+			if (uniqueCookedTexture)
+				m_StreamedTexture = m_UniqueTextureStreamer->Add(std::move(uniqueCookedTexture));
+			else
+				m_StreamedTexture = m_UniqueTextureStreamer->Add(textureData);
+		}
+		else if (uniqueCookedTexture)
+			m_UniqueTexture = std::make_unique<Texture>(m_UniqueCpu.get(), m_UniqueUploadManager.get(), *uniqueCookedTexture);
+		else
+			m_UniqueTexture = std::make_unique<Texture>(m_UniqueCpu.get(), m_UniqueGpu.get(), m_UniqueUploadManager.get(), textureData);
+	}, { uploadManager, loadTexture });
+
+	graph.Add("Upload vertex buffer", [&]()
+	{
+		m_UniqueVertexBuffer = std::make_unique<VertexBuffer>(m_UniqueCpu.get(), m_UniqueUploadManager.get(), m_Mesh.GetVertexData(), m_Mesh.GetVertexDataSize());
+
+		//An InstanceData is nothing but a model matrix, so the transforms are uploaded as they are.
+		//The culler writes its own instance buffer, so culling wins over --instanced.
+		if (m_Desc.Instanced && !m_Desc.GpuCulling)
+		{
+			m_UniqueInstanceBuffer = std::make_unique<VertexBuffer>(m_UniqueCpu.get(), m_UniqueUploadManager.get(),
+				m_ObjectTransforms.data(), m_ObjectTransforms.size() * sizeof(InstanceData));
+		}
+	}, { uploadManager, loadModel });
+
+	graph.Add("Upload index buffer", [&]()
+	{
+		m_UniqueIndexBuffer = std::make_unique<IndexBuffer>(m_UniqueCpu.get(), m_UniqueUploadManager.get(), m_Mesh.GetIndices(), m_Mesh.GetIndexCount());
+	}, { uploadManager, loadModel });
+
+	//The objects and their bounding spheres are uploaded like any other buffer, the compute pipeline goes through the pipeline cache.
+	graph.Add("Create GPU culler", [&]()
+	{
+		if (!m_Desc.GpuCulling)
+			return;
 
-	std::thread t1(LoadModel, std::ref(m_Vertices),  std::ref(m_Indices), MODEL_PATH);
+		if (!GpuCuller::IsSupported(m_UniqueGpu.get()))
+			throw std::runtime_error("gpu culling needs a graphics queue that supports compute shaders!");
 
-	
+		m_UniqueCuller = std::make_unique<GpuCuller>(m_UniqueCpu.get(), m_UniqueGpu.get(), m_UniqueUploadManager.get(), m_UniquePipelineCache.get(),
+			cullShaderCode, m_ObjectTransforms, m_Mesh.GetBoundingRadius(), m_Mesh.GetIndexCount(), m_MaxFramesInFlight);
+	}, { uploadManager, pipelineCache, loadModel, readShaders });
+
+	//The transient images are only created by the first frame, and their frame buffers by the first frame that uses them.
+	graph.Add("Create render graph", [&]() { CreateRenderGraph(); }, { renderPass });
+
+	const TaskGraph::TaskId sampler = graph.Add("Create sampler", [&]()
+	{
+		m_UniqueSampler = std::make_unique<TextureSampler>(m_UniqueCpu.get(), GetTextureLevelCount());
+	}, { texture });
+
+	graph.Add("Create descriptor sets", [&]()
+	{
+		m_UniqueDescriptorPool->CreateDescriptorSets(m_UniqueSwapChain.get(), m_UniqueDescriptorSetLayout.get(), m_UniqueSampler.get(), GetTextureView());
+		if (m_UniqueTextureStreamer)
+		{
+			m_DescriptorTextureVersions.assign(m_MaxFramesInFlight, m_UniqueTextureStreamer->GetViewVersion(m_StreamedTexture));
+			m_TableTextureVersion = m_UniqueTextureStreamer->GetViewVersion(m_StreamedTexture);
+		}
 
-	FULL_CREATION("Physical device being created", PickPhysicalDevice(), "Physical device created");
-	FULL_CREATION("Logical device being created", m_UniqueCpu = std::make_unique<LogicalDevice>(m_UniqueInstance.get(), m_UniqueGpu.get(), m_DeviceExtensions, m_ValidationLayers), "Logical device created");
-	FULL_CREATION("Swapchain being created", m_UniqueSwapChain = std::make_unique<SwapChain>(m_UniqueGpu.get(), m_UniqueWindow.get(), m_UniqueSurface.get(), m_UniqueCpu.get()), "Swapchain created");
-	FULL_CREATION("Swapchain image view being created", m_UniqueSwapChain->CreateImageViews(), "Swapchain image views created");
-	FULL_CREATION("Renderpass being created", m_UniqueRenderPass = std::make_unique<RenderPass>(m_UniqueCpu.get(), m_UniqueSwapChain.get(), m_UniqueGpu.get()), "Renderpass created");
-	FULL_CREATION("DescriptionSetLayout being created", m_UniqueDescriptorSetLayout = std::make_unique<DescriptorSetLayout>(m_UniqueCpu.get()), "DescriptionSetLayout created");
-	FULL_CREATION("Graphics pipeline being created", m_UniquePipeline = std::make_unique<GraphicsPipeline>(m_UniqueCpu.get(), m_UniqueSwapChain.get(), m_UniqueRenderPass.get(), m_UniqueDescriptorSetLayout.get()), "Graphics pipeline created");
-	FULL_CREATION("Command pool being created", m_UniqueCommandPool = std::make_unique<CommandPool>(m_UniqueCpu.get(), m_UniqueGpu.get()), "Command pool created");
+		//Every object samples the same texture for now, but nothing would change if each had its own slot.
+		if (m_UniqueTextureTable)
+		{
+			m_TextureSlot = m_UniqueTextureTable->Register(GetTextureView(), m_UniqueSampler->GetSampler());
+			m_ObjectTextures.assign(m_ObjectTransforms.size(), m_TextureSlot);
 
-	FULL_CREATION("RenderTarget being created", m_UniqueRenderTarget = std::make_unique<Buffer2D>(m_UniqueCpu.get(), m_UniqueCommandPool.get(), m_UniqueRenderPass.get(), m_UniqueGpu.get(),
-		m_UniqueSwapChain->GetExtent().width, m_UniqueSwapChain->GetExtent().height,
-		VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-		m_UniqueSwapChain->GetFormat(), VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL), "Render target created");
+			for (uint32_t frame = 0; frame < m_MaxFramesInFlight; ++frame)
+				m_UniqueTextureTable->Update(frame);
+		}
+	}, { descriptorPool, descriptorSetLayout, uniformBuffer, sampler, textureTable });
 
-	FULL_CREATION("Depth buffer being created", m_UniqueDepthBuffer = std::make_unique<DepthBuffer>(m_UniqueCpu.get(), m_UniqueCommandPool.get(), m_UniqueRenderPass.get(), m_UniqueGpu.get(), m_UniqueSwapChain->GetExtent().width, m_UniqueSwapChain->GetExtent().height), "Depth buffer created");
-	FULL_CREATION("Frame buffers being created", m_UniqueSwapChain->CreateFrameBuffers(m_UniqueRenderPass->GetRenderPass(), m_UniqueRenderTarget->GetImageView(), m_UniqueDepthBuffer->GetBuffer()->GetImageView()), "Frame buffers created");
-	FULL_CREATION("Texture being created", m_UniqueTexture = std::make_unique<Texture>(m_UniqueCpu.get(), m_UniqueGpu.get(), m_UniqueCommandPool.get()), "Texture created");
-	FULL_CREATION("Sampler being created", m_UniqueSampler = std::make_unique<TextureSampler>(m_UniqueCpu.get(), m_UniqueTexture->GetSamples()), "Sampler created");
+	//Command buffers are recorded every frame, here we only create the pools they are recorded from.
+	graph.Add("Create frame recorder", [&]()
+	{
+		m_UniqueFrameRecorder = std::make_unique<FrameRecorder>(m_UniqueCpu.get(), m_UniqueGpu.get(), m_MaxFramesInFlight, m_Desc.RecordThreads);
+	}, { logicalDevice });
 
-	//Wait for model to be loaded.
-	std::cout << "waiting for model to be loaded.." << std::endl;
-	t1.join();
-	std::cout << "Model loaded\n";
+	graph.Add("Create sync objects", [&]() { CreateSyncObjects(); }, { swapChain });
+	graph.Add("Create frame pacer", [&]()
+	{
+		m_UniqueFramePacer = std::make_unique<FramePacer>(m_MaxFramesInFlight, m_Desc.TargetFrameRate, GetPresentDelay(refreshRate));
+	}, { swapChain });
 
-	auto now = std::chrono::high_resolution_clock::now();
-	std::cout << "time it took to load model: " << std::chrono::duration<float>(now - startTime).count() << " seconds" << std::endl;
-	
+	graph.Run();
+	graph.PrintTimings();
 
+	//All setup work and all uploads go out in one submission each. Both submit to the graphics queue, so they go out
+	//from the main thread, which submits the frames too. Nothing waits for them to finish on the CPU,
+	//the first frame is ordered behind their barriers on the graphics queue.
+	m_UniqueSetupContext->Submit();
+	m_UniqueUploadManager->Flush();
 
-	FULL_CREATION("Vertex buffer being created", m_UniqueVertexBuffer = std::make_unique<VertexBuffer>(m_UniqueCpu.get(), m_UniqueGpu.get(), m_UniqueCommandPool.get(), m_Vertices), "Vertex buffer created");
-	FULL_CREATION("Index buffer being created", m_UniqueIndexBuffer = std::make_unique<IndexBuffer>(m_UniqueCpu.get(), m_UniqueGpu.get(), m_UniqueCommandPool.get(), m_Indices), "Index buffer created");
+	if (m_UniqueProfiler)
+		m_UniqueProfiler->Calibrate(m_UniqueSetupContext.get());
 
-	FULL_CREATION("Uniform buffer being created", m_UniqueSwapChain->CreateUniformBuffer(), "Uniform buffer created");
+	//The orbit starts where the camera is by default.
+	if (m_Desc.CameraScript == "orbit")
+		m_UniqueCameraPath = std::make_unique<CameraPath>(CameraPath::CreateOrbit(m_UniqueSwapChain->GetCameraEye(), BENCHMARK_ORBIT_DURATION));
+	else if (!m_Desc.CameraScript.empty())
+		m_UniqueCameraPath = std::make_unique<CameraPath>(CameraPath::Load(m_Desc.CameraScript));
 
-	FULL_CREATION("Descriptor pool being created", m_UniqueDescriptorPool = std::make_unique<DescriptorPool>(m_UniqueCpu.get(), m_UniqueSwapChain->GetImages().size()), "Descriptor pool created");
-	FULL_CREATION("Descriptor sets being created", m_UniqueDescriptorPool->CreateDescriptorSets(m_UniqueSwapChain.get(), m_UniqueDescriptorSetLayout.get(), m_UniqueSampler.get(), m_UniqueTexture.get()), "Descriptor sets created");
-	FULL_CREATION("Command buffers being created", m_UniqueCommandPool->CreateCommandBuffers(m_UniqueRenderPass.get(), m_UniqueSwapChain.get(), m_UniqueVertexBuffer.get(), m_UniqueIndexBuffer.get(), m_UniquePipeline.get(), m_UniqueDescriptorPool->GetSets()), "Command buffers created");
-	FULL_CREATION("Sync objects being created", CreateSyncObjects(), "Sync objects created");
+	m_StartTime = std::chrono::steady_clock::now();
 }
 
 void HelloTriangleApplication::MainLoop()
 {
-	while (!glfwWindowShouldClose(m_UniqueWindow->GetGLFWWindow()))
+	if (m_Desc.Headless)
 	{
-		glfwPollEvents();
-		DrawFrame();
+		for (uint32_t i = 0; i < m_Desc.FrameCount; ++i)
+			DrawFrame();
+
+		FinishHeadlessFrames();
+		PrintFrameStatistics();
+		return;
 	}
 
+	//The events are polled by DrawFrame, once the frame pacer has decided the frame may start.
+	while (!glfwWindowShouldClose(m_UniqueWindow->GetGLFWWindow()))
+		DrawFrame();
+
+	vkDeviceWaitIdle(m_UniqueCpu->GetDevice());
+	PrintFrameStatistics();
+}
+
+void HelloTriangleApplication::FinishHeadlessFrames()
+{
 	vkDeviceWaitIdle(m_UniqueCpu->GetDevice());
+
+	//The device is idle, so the last submitted frame can be read back without waiting on its fence.
+	if (m_FramesSubmitted > 0)
+	{
+		const uint32_t lastImage = static_cast<uint32_t>((m_CurrentFrame + m_MaxFramesInFlight - 1) % m_MaxFramesInFlight);
+		m_UniqueSwapChain->ReadbackImage(lastImage, m_LastFrame);
+
+		if (!m_Desc.OutputPath.empty())
+			WriteImagePPM(m_Desc.OutputPath, m_UniqueSwapChain->GetExtent().width, m_UniqueSwapChain->GetExtent().height, m_LastFrame);
+
+		if (m_UniqueCuller)
+			VerifyCulling();
+	}
+
+	std::cout << "rendered " << m_FramesSubmitted << " headless frames" << std::endl;
+}
+
+void HelloTriangleApplication::PrintFrameStatistics()
+{
+	//The device is idle, so every frame has completed and all GPU results are available.
+	m_UniqueFramePacer->Finish();
+	m_UniqueFramePacer->PrintStatistics();
+
+	if (m_UniqueProfiler)
+	{
+		m_UniqueProfiler->CollectGpuResults();
+		m_UniqueProfiler->PrintSummary();
+		m_UniqueProfiler->WriteChromeTrace(m_Desc.ProfilePath);
+	}
 }
 
 void HelloTriangleApplication::Cleanup()
@@ -285,7 +649,34 @@ void HelloTriangleApplication::DrawFrame()
 	//The vkWaitForFences function takes an array of fences and wait for either any or all of them to be signaled before returning.
 	//The VK_TRUE we pass here indicates that we want to wait for all fences, but in the case of a single one it obviouslt doesn't matter.
 	//just like vkAcquireNExtImageKHR this function also takes a timeout. 
-	vkWaitForFences(m_UniqueCpu->GetDevice(), 1, &m_InFlightFences[m_CurrentFrame]->GetFence(), VK_TRUE, std::numeric_limits<uint64_t>::max());
+	if (m_UniqueProfiler)
+		m_UniqueProfiler->BeginFrame();
+
+	{
+		Profiler::CpuScope scope(m_UniqueProfiler.get(), "fence wait");
+		vkWaitForFences(m_UniqueCpu->GetDevice(), 1, &m_InFlightFences[m_CurrentFrame]->GetFence(), VK_TRUE, std::numeric_limits<uint64_t>::max());
+	}
+
+	//Free the staging memory of uploads that have landed in the meantime.
+	m_UniqueUploadManager->CollectCompleted();
+	DestroyRetiredSwapChains();
+	if (m_UniqueProfiler)
+		m_UniqueProfiler->CollectGpuResults();
+
+	//Waiting for the next frame to be due here, instead of in vkAcquireNextImageKHR or vkQueuePresentKHR,
+	//means the input and animation time the frame is built from are as recent as possible when it starts.
+	{
+		Profiler::CpuScope scope(m_UniqueProfiler.get(), "frame pacing");
+		m_UniqueFramePacer->Pace(static_cast<uint32_t>(m_CurrentFrame));
+	}
+
+	if (m_Desc.Headless)
+	{
+		DrawOffscreenFrame();
+		return;
+	}
+
+	glfwPollEvents();
 
 	//The function calls that get called in this method will return before the operations are actually finished,
 	//and the order of execution is also undefined. That's unfortunate, because each of the operations depends on the previous one finishing.
@@ -308,7 +699,11 @@ void HelloTriangleApplication::DrawFrame()
 	//The last parameter specifies a variable to output the index of the swap chain image that has become available.
 	//The index refers to the VkImage in our m_SwapChainImages array. We're going to use that index to pick the right command buffer.
 
-	VkResult result = vkAcquireNextImageKHR(m_UniqueCpu->GetDevice(), m_UniqueSwapChain->GetSwapChain(), std::numeric_limits<uint64_t>::max(), m_ImageAvailableSemaphores[m_CurrentFrame]->GetSemaphore(), VK_NULL_HANDLE, &imageIndex);
+	VkResult result;
+	{
+		Profiler::CpuScope scope(m_UniqueProfiler.get(), "acquire");
+		result = vkAcquireNextImageKHR(m_UniqueCpu->GetDevice(), m_UniqueSwapChain->GetSwapChain(), std::numeric_limits<uint64_t>::max(), m_ImageAvailableSemaphores[m_CurrentFrame]->GetSemaphore(), VK_NULL_HANDLE, &imageIndex);
+	}
 
 	//if the swap chain turns out to be out of date when attempting to qcquire an image,
 	//then it is no longer possible to present it.
@@ -324,7 +719,27 @@ void HelloTriangleApplication::DrawFrame()
 	else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
 		throw std::runtime_error("failed to acquire swap chain image!");
 
-	m_UniqueSwapChain->UpdateUniformBuffer(imageIndex);
+	//The swap chain may hand out images out of order, or have more or fewer images than we have frames in flight.
+	//If an older frame is still rendering into the image we just acquired, we have to wait for that frame's fence,
+	//otherwise two frames would render into the same image at the same time.
+	if (m_ImagesInFlight[imageIndex] != VK_NULL_HANDLE)
+		vkWaitForFences(m_UniqueCpu->GetDevice(), 1, &m_ImagesInFlight[imageIndex], VK_TRUE, std::numeric_limits<uint64_t>::max());
+
+	//Mark the image as now being in use by this frame.
+	m_ImagesInFlight[imageIndex] = m_InFlightFences[m_CurrentFrame]->GetFence();
+
+	{
+		Profiler::CpuScope scope(m_UniqueProfiler.get(), "update uniforms");
+		UpdateUniforms(static_cast<uint32_t>(m_CurrentFrame));
+	}
+
+	//The fence of this frame has signaled, so its command pools are no longer in use and we can record into them again.
+	VkCommandBuffer commandBuffer;
+	{
+		Profiler::CpuScope scope(m_UniqueProfiler.get(), "record");
+		commandBuffer = m_UniqueFrameRecorder->Record(static_cast<uint32_t>(m_CurrentFrame), imageIndex,
+			GetFrameResources(static_cast<uint32_t>(m_CurrentFrame)), m_DynamicOffsets);
+	}
 
 	VkSubmitInfo submitInfo = {};
 	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
@@ -342,7 +757,7 @@ void HelloTriangleApplication::DrawFrame()
 	//The next 2 parameters specify which command buffers to actually submit for execution. As mentioned earlier
 	//We should submit the command buffer that binds the swap chain image we just acquired as color attachment.
 	submitInfo.commandBufferCount = 1;
-	submitInfo.pCommandBuffers = &m_UniqueCommandPool->GetBuffers()[imageIndex];
+	submitInfo.pCommandBuffers = &commandBuffer;
 
 	//The signalSemaphoreCount and pSigneSemaphores parameters specify which semaphores to signal once the command buffer(s) have finished execution.
 	//In our case we're using the m_RenderFinishedSemaphore for that purpose.
@@ -358,8 +773,14 @@ void HelloTriangleApplication::DrawFrame()
 	//the function takes an array of VkSubmitInfo structues as argument for efficiency when the workload is much larger.
 	//The last parameter references an optional fence that will be signaled when the command buffers finish execution.
 	///Deprecated: We're using semaphores for synchronization, so we'll just pass a VK_NULL_HANDLE
-	if (vkQueueSubmit(m_UniqueCpu->GetGraphicsQueue(), 1, &submitInfo, m_InFlightFences[m_CurrentFrame]->GetFence()) != VK_SUCCESS)
-		throw std::runtime_error("failed to submit draw command buffer!");
+	{
+		Profiler::CpuScope scope(m_UniqueProfiler.get(), "submit");
+		if (vkQueueSubmit(m_UniqueCpu->GetGraphicsQueue(), 1, &submitInfo, m_InFlightFences[m_CurrentFrame]->GetFence()) != VK_SUCCESS)
+			throw std::runtime_error("failed to submit draw command buffer!");
+	}
+
+	++m_FramesSubmitted;
+	m_UniqueFramePacer->OnSubmit(static_cast<uint32_t>(m_CurrentFrame));
 
 	VkPresentInfoKHR presentInfo = {};
 	presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
@@ -386,40 +807,490 @@ void HelloTriangleApplication::DrawFrame()
 	//does not necessarily mean the program should terminate, unlike the functions we've seen so far
 	//The vkQueuePresentKHR also return the same values as before. In this case we will also recreate the swap chain
 	//if is is suboptimal, because we want the best possible result.
-	result = vkQueuePresentKHR(m_UniqueCpu->GetPresentQueue(), &presentInfo);
-
-	if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || m_FrameBufferResized)
 	{
-		m_FrameBufferResized = false;
-		RecreateSwapChain();
+		Profiler::CpuScope scope(m_UniqueProfiler.get(), "present");
+		result = vkQueuePresentKHR(m_UniqueCpu->GetPresentQueue(), &presentInfo);
 	}
+
+	//Not every platform reports a resize as out of date, so the window tells us as well.
+	const bool isResized = m_UniqueWindow->ConsumeResize();
+	if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || isResized)
+		RecreateSwapChain();
 	else if (result != VK_SUCCESS)
 		throw std::runtime_error("failed to present swap chain image!");
 
-	//If you run your application with validation layers enabled and you monitor the memory usage of your application,
-	//you may notice that is is slowly growing. The reason for this is that the applicatoin is rapidly submitting work in the DrawFrame
-	//function, but doesn't actually check if any of it finishes. If the CPU is submitting work faster than the GPU can keep up with then
-	//the queue will slowly fill up with work. Worse, even, is that we are reusing the m_ImageAvailableSemaphores
-	//and m_RenderFinishedSemaphore for multile frames at the same time.
+	//If the CPU submits work faster than the GPU can keep up with, the queue would slowly fill up with work
+	//and we would reuse the m_ImageAvailableSemaphores and m_RenderFinishedSemaphores for multiple frames at the same time.
+	//Waiting for the queue to become idle here would solve that, but then the whole graphics pipeline is only used
+	//for one frame at a time and the CPU and GPU run in lockstep.
+	//Instead every frame has its own semaphores and fence, and the only thing that throttles us is the
+	//vkWaitForFences at the top of this function: the CPU can run at most m_MaxFramesInFlight frames ahead of the GPU.
+	m_CurrentFrame = (m_CurrentFrame + 1) % m_MaxFramesInFlight;
+}
+
+void HelloTriangleApplication::DrawOffscreenFrame()
+{
+	//Without a swap chain there is nothing to acquire: every frame in flight owns one offscreen image.
+	//The fence we just waited on tells us the previous frame rendered into that image has finished,
+	//including the copy into its readback buffer, so this is the moment to bring its pixels back to the host.
+	const uint32_t imageIndex = static_cast<uint32_t>(m_CurrentFrame);
+
+	if (m_FramesSubmitted >= m_MaxFramesInFlight)
+	{
+		Profiler::CpuScope scope(m_UniqueProfiler.get(), "readback");
+		m_UniqueSwapChain->ReadbackImage(imageIndex, m_LastFrame);
+	}
+
+	{
+		Profiler::CpuScope scope(m_UniqueProfiler.get(), "update uniforms");
+		UpdateUniforms(imageIndex);
+	}
+
+	VkCommandBuffer commandBuffer;
+	{
+		Profiler::CpuScope scope(m_UniqueProfiler.get(), "record");
+		commandBuffer = m_UniqueFrameRecorder->Record(static_cast<uint32_t>(m_CurrentFrame), imageIndex,
+			GetFrameResources(static_cast<uint32_t>(m_CurrentFrame)), m_DynamicOffsets);
+	}
+
+	//There are no semaphores to wait on or signal, the fence is the only synchronization we need.
+	VkSubmitInfo submitInfo = {};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &commandBuffer;
+
+	vkResetFences(m_UniqueCpu->GetDevice(), 1, &m_InFlightFences[m_CurrentFrame]->GetFence());
+
+	{
+		Profiler::CpuScope scope(m_UniqueProfiler.get(), "submit");
+		if (vkQueueSubmit(m_UniqueCpu->GetGraphicsQueue(), 1, &submitInfo, m_InFlightFences[m_CurrentFrame]->GetFence()) != VK_SUCCESS)
+			throw std::runtime_error("failed to submit offscreen command buffer!");
+	}
+
+	++m_FramesSubmitted;
+	m_UniqueFramePacer->OnSubmit(static_cast<uint32_t>(m_CurrentFrame));
+	m_CurrentFrame = (m_CurrentFrame + 1) % m_MaxFramesInFlight;
+}
+
+void HelloTriangleApplication::BenchmarkRecording()
+{
+	//Only the CPU side is measured: nothing is submitted, so the GPU never touches the command buffers
+	//and we can reset and record frame 0 over and over. Every thread count gets its own recorder and worker threads.
+	std::vector<uint32_t> dynamicOffsets;
+
+	std::cout << "recording benchmark, average ms per frame over " << BENCHMARK_ITERATIONS << " frames" << std::endl;
+	std::cout << std::setw(8) << "draws";
+	for (uint32_t threadCount : BENCHMARK_THREAD_COUNTS)
+		std::cout << std::setw(12) << (std::to_string(threadCount) + " threads");
+	std::cout << std::endl;
+
+	std::vector<std::unique_ptr<FrameRecorder>> recorders;
+	for (uint32_t threadCount : BENCHMARK_THREAD_COUNTS)
+		recorders.push_back(std::make_unique<FrameRecorder>(m_UniqueCpu.get(), m_UniqueGpu.get(), 1, threadCount));
+
+	for (uint32_t drawCount : BENCHMARK_DRAW_COUNTS)
+	{
+		std::vector<DrawPushConstants> drawConstants;
+		FrameResources resources = GetFrameResources(0);
+		PrepareBenchmarkDraws(CreateObjectTransforms(drawCount), drawConstants, dynamicOffsets, resources);
+
+		std::cout << std::setw(8) << drawCount;
+		for (std::unique_ptr<FrameRecorder>& recorder : recorders)
+		{
+			//The first frame allocates the memory of the command pools, so it isn't counted.
+			recorder->Record(0, 0, resources, dynamicOffsets);
+
+			const auto start = std::chrono::high_resolution_clock::now();
+			for (uint32_t i = 0; i < BENCHMARK_ITERATIONS; ++i)
+				recorder->Record(0, 0, resources, dynamicOffsets);
+			const auto end = std::chrono::high_resolution_clock::now();
+
+			const float ms = std::chrono::duration<float, std::milli>(end - start).count() / BENCHMARK_ITERATIONS;
+			std::cout << std::fixed << std::setprecision(3) << std::setw(12) << ms;
+		}
+		std::cout << std::endl;
+	}
+
+	std::cout.unsetf(std::ios::fixed);
+}
+
+void HelloTriangleApplication::BenchmarkInstancing()
+{
+	//Whole frames are measured, so they have to be submitted, and only offscreen images can be rendered to without presenting them.
+	if (!m_Desc.Headless)
+		throw std::runtime_error("the instances benchmark needs --headless!");
+
+	static_assert(sizeof(InstanceData) == sizeof(glm::mat4), "instance data is uploaded straight from the transforms");
+
+	const uint32_t maxDraws = *std::max_element(BENCHMARK_DRAW_COUNTS.begin(), BENCHMARK_DRAW_COUNTS.end());
+	const VkFence fence = m_InFlightFences[0]->GetFence();
+
+	//Frame 0 is recorded, submitted and waited for over and over. The first frame isn't counted,
+	//it allocates the memory of the command pools.
+	auto timeFrames = [&](const FrameResources& resources, const std::vector<uint32_t>& dynamicOffsets)
+	{
+		float ms = 0.0f;
+		for (uint32_t i = 0; i <= BENCHMARK_INSTANCE_FRAMES; ++i)
+		{
+			const auto start = std::chrono::high_resolution_clock::now();
+
+			const VkCommandBuffer commandBuffer = m_UniqueFrameRecorder->Record(0, 0, resources, dynamicOffsets);
+
+			VkSubmitInfo submitInfo = {};
+			submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+			submitInfo.commandBufferCount = 1;
+			submitInfo.pCommandBuffers = &commandBuffer;
+
+			vkResetFences(m_UniqueCpu->GetDevice(), 1, &fence);
+			if (vkQueueSubmit(m_UniqueCpu->GetGraphicsQueue(), 1, &submitInfo, fence) != VK_SUCCESS)
+				throw std::runtime_error("failed to submit benchmark command buffer!");
+			vkWaitForFences(m_UniqueCpu->GetDevice(), 1, &fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+
+			const auto end = std::chrono::high_resolution_clock::now();
+			if (i > 0)
+				ms += std::chrono::duration<float, std::milli>(end - start).count();
+		}
+
+		return ms / BENCHMARK_INSTANCE_FRAMES;
+	};
+
+	std::cout << "instancing benchmark, average ms per frame over " << BENCHMARK_INSTANCE_FRAMES << " frames, "
+		<< BENCHMARK_INSTANCE_INDEX_COUNT / 3 << " triangles per copy" << std::endl;
+	std::cout << std::setw(10) << "copies" << std::setw(12) << "draws" << std::setw(12) << "instanced" << std::endl;
+	std::cout << std::fixed << std::setprecision(3);
+
+	for (uint32_t copyCount : BENCHMARK_INSTANCE_COUNTS)
+	{
+		const std::vector<glm::mat4> transforms = CreateObjectTransforms(copyCount);
+		std::vector<DrawPushConstants> drawConstants;
+		std::vector<uint32_t> dynamicOffsets;
+
+		FrameResources resources = GetFrameResources(0);
+		resources.IndexCount = BENCHMARK_INSTANCE_INDEX_COUNT;
+
+		std::cout << std::setw(10) << copyCount;
+
+		//A draw per copy needs a uniform block per copy, and the uniform ring only has room for the largest recording benchmark.
+		if (copyCount <= maxDraws)
+		{
+			FrameResources drawResources = resources;
+			PrepareBenchmarkDraws(transforms, drawConstants, dynamicOffsets, drawResources);
+			std::cout << std::setw(12) << timeFrames(drawResources, dynamicOffsets);
+		}
+		else
+			std::cout << std::setw(12) << "-";
+
+		//The instance buffer goes through the upload manager like every other buffer, the copy has to be done before the first frame.
+		VertexBuffer instanceBuffer(m_UniqueCpu.get(), m_UniqueUploadManager.get(), transforms.data(), transforms.size() * sizeof(InstanceData));
+		m_UniqueUploadManager->Wait(m_UniqueUploadManager->Flush());
+
+		resources.pPipeline = m_UniqueInstancedPipeline.get();
+		resources.pDrawConstants = nullptr;
+		resources.InstanceBuffer = instanceBuffer.GetBuffer();
+		resources.InstanceCount = copyCount;
+
+		m_UniqueSwapChain->UpdateUniformBuffer(0, GetAnimationTime(), m_InstancedUniformTransforms, std::vector<uint32_t>(), m_Mesh.GetPositionTransform(), dynamicOffsets);
+		std::cout << std::setw(12) << timeFrames(resources, dynamicOffsets) << std::endl;
+	}
+
+	std::cout.unsetf(std::ios::fixed);
+}
+
+void HelloTriangleApplication::BenchmarkFrames()
+{
+	if (!m_Desc.Headless)
+		throw std::runtime_error("the frames benchmark needs --headless!");
+
+	//Once the frames in flight are filled, DrawFrame waits for the frame that used its slot before,
+	//so in steady state the time between two DrawFrame calls is the time the GPU needs per frame, or the CPU if it's slower.
+	std::vector<double> frameTimes;
+	frameTimes.reserve(m_Desc.FrameCount);
+
+	for (uint32_t i = 0; i < BENCHMARK_WARMUP_FRAMES + m_Desc.FrameCount; ++i)
+	{
+		const auto start = std::chrono::high_resolution_clock::now();
+		DrawFrame();
+		const auto end = std::chrono::high_resolution_clock::now();
+
+		if (i >= BENCHMARK_WARMUP_FRAMES)
+			frameTimes.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+	}
+
+	FinishHeadlessFrames();
+	WriteBenchmarkResults(frameTimes);
+	PrintFrameStatistics();
+}
+
+void HelloTriangleApplication::WriteBenchmarkResults(const std::vector<double>& frameTimes) const
+{
+	if (frameTimes.empty())
+		throw std::runtime_error("the frames benchmark needs at least one frame!");
+
+	std::vector<double> sorted = frameTimes;
+	std::sort(sorted.begin(), sorted.end());
+
+	double sum = 0.0;
+	for (double frameTime : sorted)
+		sum += frameTime;
+
+	//Nearest rank: the smallest time that at least 99% of the frames don't exceed.
+	const size_t p99Rank = static_cast<size_t>(std::ceil(0.99 * sorted.size()));
+	const double minimum = sorted.front();
+	const double average = sum / sorted.size();
+	const double p99 = sorted[std::max<size_t>(p99Rank, 1) - 1];
+	const double maximum = sorted.back();
+
+	std::cout << std::fixed << std::setprecision(3);
+	std::cout << "frames benchmark: " << sorted.size() << " frames, min " << minimum << " ms, avg " << average
+		<< " ms, p99 " << p99 << " ms, max " << maximum << " ms" << std::endl;
+	std::cout.unsetf(std::ios::fixed);
+
+	const std::string csvPath = m_Desc.ResultsPath + ".csv";
+	std::ofstream csv(csvPath);
+	if (!csv)
+		throw std::runtime_error("failed to open " + csvPath + "!");
+
+	csv << "frame,ms" << std::endl;
+	csv << std::fixed << std::setprecision(4);
+	for (size_t i = 0; i < frameTimes.size(); ++i)
+		csv << i << "," << frameTimes[i] << std::endl;
+
+	const std::string jsonPath = m_Desc.ResultsPath + ".json";
+	std::ofstream json(jsonPath);
+	if (!json)
+		throw std::runtime_error("failed to open " + jsonPath + "!");
+
+	json << std::fixed << std::setprecision(4);
+	json << "{" << std::endl;
+	json << "\t\"device\": \"" << EscapeJson(m_UniqueGpu->GetDesc().Properties.deviceName) << "\"," << std::endl;
+	json << "\t\"width\": " << m_UniqueSwapChain->GetExtent().width << "," << std::endl;
+	json << "\t\"height\": " << m_UniqueSwapChain->GetExtent().height << "," << std::endl;
+	json << "\t\"objects\": " << m_ObjectTransforms.size() << "," << std::endl;
+	json << "\t\"frames_in_flight\": " << m_MaxFramesInFlight << "," << std::endl;
+	json << "\t\"warmup_frames\": " << BENCHMARK_WARMUP_FRAMES << "," << std::endl;
+	json << "\t\"frames\": " << frameTimes.size() << "," << std::endl;
+	json << "\t\"time_step\": " << m_Desc.TimeStep << "," << std::endl;
+	json << "\t\"camera_path\": \"" << EscapeJson(m_Desc.CameraScript) << "\"," << std::endl;
+	json << "\t\"min_ms\": " << minimum << "," << std::endl;
+	json << "\t\"avg_ms\": " << average << "," << std::endl;
+	json << "\t\"p99_ms\": " << p99 << "," << std::endl;
+	json << "\t\"max_ms\": " << maximum << std::endl;
+	json << "}" << std::endl;
+
+	std::cout << "frames benchmark: wrote " << csvPath << " and " << jsonPath << std::endl;
+}
+
+FrameResources HelloTriangleApplication::GetFrameResources(uint32_t frameIndex) const
+{
+	FrameResources resources;
+	resources.pRenderPass = m_UniqueRenderPass.get();
+	resources.pSwapChain = m_UniqueSwapChain.get();
+	resources.pRenderGraph = m_UniqueRenderGraph.get();
+	resources.ColorTarget = m_ColorTarget;
+	resources.DepthTarget = m_DepthTarget;
+	resources.pPipeline = m_UniquePipeline.get();
+	resources.pVertexBuffer = m_UniqueVertexBuffer.get();
+	resources.pIndexBuffer = m_UniqueIndexBuffer.get();
+	resources.pProfiler = m_UniqueProfiler.get();
+	resources.DescriptorSet = m_UniqueDescriptorPool->GetSet(frameIndex);
+	if (m_UniqueTextureTable)
+		resources.TextureTableSet = m_UniqueTextureTable->GetSet(frameIndex);
+
+	if (m_UniqueCuller)
+	{
+		resources.pPipeline = m_UniqueInstancedPipeline.get();
+		resources.pCuller = m_UniqueCuller.get();
+		resources.InstanceBuffer = m_UniqueCuller->GetVisibleBuffer(frameIndex);
+		resources.IndirectBuffer = m_UniqueCuller->GetIndirectBuffer(frameIndex);
+	}
+	else if (m_UniqueInstanceBuffer)
+	{
+		resources.pPipeline = m_UniqueInstancedPipeline.get();
+		resources.InstanceBuffer = m_UniqueInstanceBuffer->GetBuffer();
+		resources.InstanceCount = static_cast<uint32_t>(m_ObjectTransforms.size());
+	}
+	else if (UsesPushConstants())
+		resources.pDrawConstants = &m_DrawConstants;
+	return resources;
+}
+
+void HelloTriangleApplication::PrepareBenchmarkDraws(const std::vector<glm::mat4>& transforms, std::vector<DrawPushConstants>& drawConstants,
+	std::vector<uint32_t>& dynamicOffsets, FrameResources& resources)
+{
+	const std::vector<uint32_t> textures(transforms.size(), m_TextureSlot);
+
+	if (!UsesPushConstants())
+	{
+		m_UniqueSwapChain->UpdateUniformBuffer(0, GetAnimationTime(), transforms, textures, m_Mesh.GetPositionTransform(), dynamicOffsets);
+		return;
+	}
+
+	drawConstants = CreateDrawConstants(transforms);
+	m_UniqueSwapChain->UpdateUniformBuffer(0, GetAnimationTime(), m_InstancedUniformTransforms, textures, m_Mesh.GetPositionTransform(), dynamicOffsets);
+	resources.pDrawConstants = &drawConstants;
+}
 
-	//The easy way to solve this is to wait for work to finish right after submitting it, for example by using vkQueueWaitIdle.
-	vkQueueWaitIdle(m_UniqueCpu->GetPresentQueue());
+void HelloTriangleApplication::VerifyCulling() const
+{
+	//The last frame was culled with the camera as it is now, nothing moves it after the last frame is recorded.
+	const uint32_t lastFrame = static_cast<uint32_t>((m_CurrentFrame + m_MaxFramesInFlight - 1) % m_MaxFramesInFlight);
+	const uint32_t gpuCount = m_UniqueCuller->GetVisibleCount(lastFrame);
+
+	//Float math on the GPU may round a sphere that touches a plane to the other side,
+	//so the GPU count has to lie between the counts for slightly smaller and slightly larger spheres.
+	const glm::mat4 viewProjection = m_UniqueSwapChain->GetViewProjection();
+	const uint32_t minCount = m_UniqueCuller->CountVisibleOnCpu(viewProjection, 1.0f - CULLING_TOLERANCE);
+	const uint32_t maxCount = m_UniqueCuller->CountVisibleOnCpu(viewProjection, 1.0f + CULLING_TOLERANCE);
+
+	std::cout << "gpu culling: " << gpuCount << " of " << m_UniqueCuller->GetObjectCount() << " objects visible, cpu reference "
+		<< m_UniqueCuller->CountVisibleOnCpu(viewProjection) << std::endl;
 
-	//However, we are likely not optimally using the GPU in this way, because the whole graphics pipeline is only
-	//used for one frame at a time right now. The stages that the current frame has already progressed through are idle and
-	//could already be used for a next frame.
-	m_CurrentFrame = (m_CurrentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+	if (gpuCount < minCount || gpuCount > maxCount)
+		throw std::runtime_error("gpu culling doesn't match the cpu reference!");
+}
+
+void HelloTriangleApplication::UpdateTextures()
+{
+	if (m_UniqueTextureStreamer)
+	{
+		//Every object maps the whole texture over roughly its bounding sphere, the unscaled model fits in a sphere of radius sqrt(2).
+		for (const glm::mat4& transform : m_ObjectTransforms)
+		{
+			const float radius = glm::length(glm::vec3(transform[0])) * std::sqrt(2.0f);
+			m_UniqueTextureStreamer->RequestFootprint(m_StreamedTexture, m_UniqueSwapChain->GetProjectedDiameter(glm::vec3(transform[3]), radius));
+		}
+
+		m_UniqueTextureStreamer->Update();
+
+		//The fence of this frame has signaled, so its descriptor set isn't in use anymore and can point to the new view.
+		const uint64_t version = m_UniqueTextureStreamer->GetViewVersion(m_StreamedTexture);
+		if (m_DescriptorTextureVersions[m_CurrentFrame] != version)
+		{
+			m_UniqueDescriptorPool->UpdateTexture(static_cast<uint32_t>(m_CurrentFrame), m_UniqueSampler.get(), GetTextureView());
+			m_DescriptorTextureVersions[m_CurrentFrame] = version;
+		}
+
+		if (m_UniqueTextureTable && m_TableTextureVersion != version)
+		{
+			m_UniqueTextureTable->SetView(m_TextureSlot, GetTextureView());
+			m_TableTextureVersion = version;
+		}
+	}
+
+	//Brings the table copy of this frame up to date with every slot that changed while it was in flight.
+	if (m_UniqueTextureTable)
+		m_UniqueTextureTable->Update(static_cast<uint32_t>(m_CurrentFrame));
+}
+
+void HelloTriangleApplication::UpdateUniforms(uint32_t frameIndex)
+{
+	const float time = GetAnimationTime();
+
+	//The texture footprints depend on the camera, so it has to be in place before the textures are updated.
+	if (m_UniqueCameraPath)
+	{
+		glm::vec3 eye;
+		glm::vec3 target;
+		m_UniqueCameraPath->Evaluate(time, eye, target);
+		m_UniqueSwapChain->SetCamera(eye, target);
+	}
+
+	UpdateTextures();
+	m_UniqueSwapChain->UpdateUniformBuffer(frameIndex, time, GetUniformTransforms(), m_ObjectTextures,
+		m_Mesh.GetPositionTransform(), m_DynamicOffsets);
+}
+
+float HelloTriangleApplication::GetAnimationTime() const
+{
+	if (m_Desc.TimeStep > 0.0f)
+		return m_FramesSubmitted * m_Desc.TimeStep;
+
+	return std::chrono::duration<float>(std::chrono::steady_clock::now() - m_StartTime).count();
+}
+
+VkImageView HelloTriangleApplication::GetTextureView() const
+{
+	if (m_UniqueTextureStreamer)
+		return m_UniqueTextureStreamer->GetImageView(m_StreamedTexture);
+
+	return m_UniqueTexture->GetImageView();
+}
+
+uint32_t HelloTriangleApplication::GetTextureLevelCount() const
+{
+	if (m_UniqueTextureStreamer)
+		return m_UniqueTextureStreamer->GetLevelCount(m_StreamedTexture);
+
+	return m_UniqueTexture->GetSamples();
+}
+
+std::vector<glm::mat4> HelloTriangleApplication::CreateObjectTransforms(uint32_t count, float gridScale)
+{
+	//The model roughly fills [-1, 1] on the x and y axis, so a grid of side x side scaled down copies
+	//covers the same area as a single one and the camera doesn't have to move.
+	//A larger grid spreads the same copies over [-gridScale, gridScale].
+	const uint32_t side = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<float>(count))));
+	const float cellSize = 2.0f * gridScale / side;
+
+	std::vector<glm::mat4> transforms;
+	transforms.reserve(count);
+
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		const glm::vec3 center(-gridScale + cellSize * (i % side + 0.5f), -gridScale + cellSize * (i / side + 0.5f), 0.0f);
+
+		glm::mat4 transform = glm::translate(glm::mat4(1.0f), center);
+		transform = glm::scale(transform, glm::vec3(1.0f / side));
+		transforms.push_back(transform);
+	}
+
+	return transforms;
+}
+
+std::vector<DrawPushConstants> HelloTriangleApplication::CreateDrawConstants(const std::vector<glm::mat4>& transforms)
+{
+	std::vector<DrawPushConstants> drawConstants;
+	drawConstants.reserve(transforms.size());
+
+	for (const glm::mat4& transform : transforms)
+		drawConstants.push_back({ transform });
+
+	return drawConstants;
 }
 
 //Create semaphores and fences
 void HelloTriangleApplication::CreateSyncObjects()
 {
-	for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i)
+	for (size_t i = 0; i < m_MaxFramesInFlight; ++i)
 	{
 		m_ImageAvailableSemaphores.push_back(std::make_unique<Semaphore>(m_UniqueCpu.get()));
 		m_RenderFinishedSemaphores.push_back(std::make_unique<Semaphore>(m_UniqueCpu.get()));
 		m_InFlightFences.push_back(std::make_unique<Fence>(m_UniqueCpu.get()));
 	}
+
+	//Initially not a single frame is using an image, so there is no fence to wait on.
+	m_ImagesInFlight.assign(m_UniqueSwapChain->GetImages().size(), VK_NULL_HANDLE);
+}
+
+void HelloTriangleApplication::CreateRenderGraph()
+{
+	m_UniqueRenderGraph = std::make_unique<RenderGraph>(m_UniqueCpu.get(), m_UniqueGpu.get());
+
+	//Both have the resolution of the swap chain images and the sample count of the render pass.
+	//They are only ever attachments, so the render graph can let them share memory and allocate it lazily.
+	RenderGraph::ImageDesc colorDesc;
+	colorDesc.Width = m_UniqueSwapChain->GetExtent().width;
+	colorDesc.Height = m_UniqueSwapChain->GetExtent().height;
+	colorDesc.Format = m_UniqueSwapChain->GetFormat();
+	colorDesc.Samples = m_UniqueRenderPass->GetSamplesCount();
+	colorDesc.Usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+	m_ColorTarget = m_UniqueRenderGraph->CreateImage("color target", colorDesc);
+
+	//The depth format has to be the one the render pass was created with.
+	RenderGraph::ImageDesc depthDesc = colorDesc;
+	depthDesc.Format = FindDepthFormat(m_UniqueGpu.get());
+	depthDesc.Usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+	m_DepthTarget = m_UniqueRenderGraph->CreateImage("depth target", depthDesc);
 }
 
 void HelloTriangleApplication::RecreateSwapChain()
@@ -427,40 +1298,83 @@ void HelloTriangleApplication::RecreateSwapChain()
 	int width = 0;
 	int height = 0;
 
+	//A minimized window has a framebuffer of size 0, there is nothing to present to until it comes back.
+	glfwGetFramebufferSize(m_UniqueWindow->GetGLFWWindow(), &width, &height);
 	while (width == 0 || height == 0)
 	{
-		glfwGetFramebufferSize(m_UniqueWindow->GetGLFWWindow(), &width, &height);
 		glfwWaitEvents();
+		glfwGetFramebufferSize(m_UniqueWindow->GetGLFWWindow(), &width, &height);
 	}
 
-	//To make sure we don't touch any resources that are still in use,
-	//We call vkDeviceWaitIdle first.
-	vkDeviceWaitIdle(m_UniqueCpu->GetDevice());
+	//We don't call vkDeviceWaitIdle: the frames in flight keep rendering into and presenting the old swap chain,
+	//which is retired together with its frame buffer attachments and destroyed once those frames have finished.
+	m_UniqueGpu->UpdateSwapChainSupport();
 
-	//Clean up previous objects before recreating them
-	//CleanupSwapChain();
+	RetiredSwapChain retired;
+	retired.UniqueSwapChain = std::move(m_UniqueSwapChain);
+	retired.UniqueRenderGraph = std::move(m_UniqueRenderGraph);
+	retired.Frame = m_FramesSubmitted;
 
-	//Recreate the swapchain itself
-	//CreateSwapChain();
+	//Passing the old swap chain lets the driver reuse its resources, and hands its uniform ring over.
+	const VkExtent2D framebufferSize = { static_cast<uint32_t>(width), static_cast<uint32_t>(height) };
+	m_UniqueSwapChain = std::make_unique<SwapChain>(m_UniqueGpu.get(), framebufferSize, m_UniqueSurface.get(), m_UniqueCpu.get(),
+		m_Desc.Policy, retired.UniqueSwapChain.get());
 
-	//the image views need to be recreated because they are based directly on the swap chain images
-	//CreateImageViews();
+	//The render pass, and the pipelines built against it, depend on the format of the swap chain images.
+	//It is rare for the format to change during an operation like a window resize and the surface format we pick
+	//doesn't depend on the size, so they are kept. The viewport and scissor are dynamic state, so the size doesn't matter to them.
+	if (m_UniqueSwapChain->GetFormat() != retired.UniqueSwapChain->GetFormat())
+		throw std::runtime_error("swap chain format changed while recreating it!");
 
-	//The render pass needs to be recreated because it depends on the format of the swap chain images.
-	//it is rare for the swap chain image format to change during an operation like a window resize
-	//but it should still be handled
-	//CreateRenderPass();
+	//The image views need to be recreated because they are based directly on the swap chain images
+	m_UniqueSwapChain->CreateImageViews();
 
-	//Viewport and scissor rectangles size is speciifed during graphics pipeline creation, so the pipeline
-	//also needs to be rebuilt. it is possible to avoid this by using dynamic state for the viewports and scissor rectangles.
-	//CreateGraphicsPipeline();
+	//The resolution of the render target and depth buffer should match the new swap chain images.
+	//The new render graph creates them with the next frame, which also moves them into their layouts.
+	CreateRenderGraph();
 
-	//CreateColorResources();
+	//The command buffers are recorded every frame, so they pick up the new frame buffers by themselves.
+	//None of the new images is in use by a frame yet, and their number may have changed.
+	m_ImagesInFlight.assign(m_UniqueSwapChain->GetImages().size(), VK_NULL_HANDLE);
 
-	//The resolution of the depth buffer should change when the window is resized to match the new color attachment resolution.
-	//CreateDepthResources();
+	//The present mode, and with it the time an image waits to be shown, may have changed.
+	m_UniqueFramePacer->SetPresentDelay(GetPresentDelay(GetRefreshRate()));
 
-	//The frame buffers and command buffers also directly depend on the swap chain images.
-	//CreateFrameBuffers();
-	//CreateCommandBuffers();
+	m_RetiredSwapChains.push_back(std::move(retired));
+}
+
+void HelloTriangleApplication::DestroyRetiredSwapChains()
+{
+	//The fence of the current frame has just signaled, so every frame up to m_FramesSubmitted - m_MaxFramesInFlight has finished.
+	m_RetiredSwapChains.erase(std::remove_if(m_RetiredSwapChains.begin(), m_RetiredSwapChains.end(), [this](const RetiredSwapChain& retired)
+	{
+		return m_FramesSubmitted >= retired.Frame + m_MaxFramesInFlight;
+	}), m_RetiredSwapChains.end());
+}
+
+int HelloTriangleApplication::GetRefreshRate() const
+{
+	const GLFWvidmode* pMode = glfwGetVideoMode(glfwGetPrimaryMonitor());
+	return pMode && pMode->refreshRate > 0 ? pMode->refreshRate : 60;
+}
+
+std::chrono::duration<double, std::milli> HelloTriangleApplication::GetPresentDelay(int refreshRate) const
+{
+	//Without VK_GOOGLE_display_timing we can't see when an image is shown, so we estimate it from the refresh rate.
+	if (m_Desc.Headless)
+		return std::chrono::duration<double, std::milli>(0.0);
+
+	const double refreshPeriod = 1000.0 / refreshRate;
+
+	//FIFO shows the image at the first vertical blank after the images queued before it, about a refresh later.
+	//MAILBOX shows it at the next vertical blank, half a refresh later on average, IMMEDIATE right away.
+	switch (m_UniqueSwapChain->GetPresentMode())
+	{
+	case VK_PRESENT_MODE_IMMEDIATE_KHR:
+		return std::chrono::duration<double, std::milli>(0.0);
+	case VK_PRESENT_MODE_MAILBOX_KHR:
+		return std::chrono::duration<double, std::milli>(refreshPeriod * 0.5);
+	default:
+		return std::chrono::duration<double, std::milli>(refreshPeriod);
+	}
 }
@@ -3,10 +3,15 @@
 #include <memory>
 #include <vector>
 #include <string>
+#include <chrono>
 
 #include "../Vulkan/Vertex.h"
 #include "../Vulkan/Semaphore.h"
 #include "../Vulkan/Fence.h"
+#include "../Vulkan/FrameRecorder.h"
+#include "../Vulkan/PushConstants.h"
+#include "../Vulkan/SwapChain.h"
+#include "../Help/Mesh.h"
 
 
 //GLFW Defines and includes
@@ -23,40 +28,179 @@ class LogicalDevice;
 class SwapChain;
 class RenderPass;
 class DescriptorSetLayout;
-class CommandPool;
-class Buffer2D;
+class SetupContext;
+class UploadManager;
+class TextureStreamer;
 class Texture;
 class VertexBuffer;
 class IndexBuffer;
 class DescriptorPool;
+class BindlessTextureTable;
+class GpuCuller;
 class TextureSampler;
 class GraphicsPipeline;
+class PipelineCache;
 class Semaphore;
 class Fence;
-class DepthBuffer;
+class FramePacer;
+class Profiler;
+class CameraPath;
+
+struct ApplicationDesc
+{
+	//Render into offscreen images instead of a window, for machines without a display.
+	bool Headless = false;
+
+	//Number of frames rendered before a headless run stops, or measured by the "frames" benchmark.
+	uint32_t FrameCount = 1;
+
+	//Seconds the animation advances every frame, so every run renders the same frames. 0 follows the wall clock.
+	float TimeStep = 0.0f;
+
+	//"orbit" circles the camera around the scene, anything else is a file for CameraPath::Load. Empty keeps the camera still.
+	std::string CameraScript;
+
+	//When set, the last headless frame is written to this file as a binary PPM.
+	std::string OutputPath;
+
+	//How many frames the CPU may record and submit before it has to wait for the GPU, between 1 and 4.
+	uint32_t FramesInFlight = 2;
+
+	//Picks the present mode and number of swap chain images, see PresentPolicy.
+	PresentPolicy Policy = PresentPolicy::LowLatency;
+
+	//Frames per second the FramePacer holds the main loop to, 0 renders as fast as the present mode allows.
+	float TargetFrameRate = 0.0f;
+
+	//Number of copies of the model that are drawn every frame, laid out in a grid. Each copy is its own draw call.
+	uint32_t ObjectCount = 1;
+
+	//Draw all objects with a single instanced draw instead of a draw per object, see InstanceData.
+	bool Instanced = false;
+
+	//Frustum cull the objects in a compute shader and draw the visible ones with one indirect instanced draw, see GpuCuller.h.
+	//Headless runs check the number of visible objects of the last frame against the CPU.
+	//Takes precedence over Instanced, the culled objects are drawn instanced anyway.
+	bool GpuCulling = false;
+
+	//Push the model matrix of every draw instead of writing a uniform block per object, see PushConstants.h.
+	//Instanced and culled objects don't have draws of their own, so it only applies without those.
+	bool PushConstants = false;
+
+	//Side of the object grid relative to the part of the scene the camera sees. Above 1 objects fall outside the view.
+	float GridScale = 1.0f;
+
+	//Store vertices as PackedVertex (16 bytes) instead of Vertex (32 bytes).
+	bool PackedVertices = false;
+
+	//Worker threads that record the draws of a frame, 0 means one per hardware thread.
+	uint32_t RecordThreads = 0;
+
+	//When set, Run executes this benchmark instead of the main loop. Supported: "record", and "instances" and "frames" with Headless.
+	//"frames" renders FrameCount frames with a fixed time step along a camera path, orbit unless CameraScript says otherwise.
+	//CPU only benchmarks like "dedup" are run by main without creating the application, see Benchmarks.h.
+	std::string Benchmark;
+
+	//Where the "frames" benchmark writes its results: <path>.csv with the time of every frame and <path>.json with the summary.
+	std::string ResultsPath = "benchmark";
+
+	//Device memory in MiB the streamed texture levels may take, see TextureStreamer.h.
+	//0, the default, disables streaming, textures are then uploaded with their whole mip chain. --texture-budget turns it on.
+	uint32_t TextureBudgetMiB = 0;
+
+	//Sample every texture from one descriptor array indexed per draw, see BindlessTextureTable.h.
+	//Falls back to a descriptor set per frame on devices that can't index sampler arrays in shaders.
+	bool Bindless = false;
+
+	//When set, the CPU and GPU time of the frames is measured and the last frames are written to this file
+	//as a Chrome trace when the main loop ends, see Profiler.h. Only the frames benchmark is profiled.
+	std::string ProfilePath;
+
+	//When set, main converts this image into KTX2 files next to it and exits, see TextureCooker.h.
+	std::string CookTexture;
+};
 
 class HelloTriangleApplication
 {
 public:
-	HelloTriangleApplication();
+	HelloTriangleApplication(const ApplicationDesc& desc);
 	~HelloTriangleApplication();
 	void Run();
 
+	//Pixels (RGBA8) of the most recent headless frame that finished rendering.
+	const std::vector<unsigned char>& GetLastFrame() const { return m_LastFrame; }
+
 private:
 	void InitializeVulkan();
 	void MainLoop();
+	//Waits for the device, then reads back, writes and verifies the last headless frame.
+	void FinishHeadlessFrames();
+	//Frame pacing and, when profiling, the profiler summary and trace. The device must be idle.
+	void PrintFrameStatistics();
 	void Cleanup();
 	   
 	std::vector<VkPhysicalDevice> FindGpus();
 
 	void PickPhysicalDevice();
 	void DrawFrame();
+	void DrawOffscreenFrame();
+
+	//Everything the FrameRecorder needs, bundled up. frameIndex selects the descriptor set.
+	FrameResources GetFrameResources(uint32_t frameIndex) const;
+
+	//Feeds the screen size of the objects to the texture streamer and points the descriptor set, or the bindless
+	//texture table, of the frame that is about to be recorded to the current texture view.
+	void UpdateTextures();
+	//Moves the camera along its path, then updates the textures and the uniform blocks of frameIndex.
+	void UpdateUniforms(uint32_t frameIndex);
+	//Seconds of animation of the frame that is being recorded.
+	float GetAnimationTime() const;
+	VkImageView GetTextureView() const;
+	uint32_t GetTextureLevelCount() const;
+
+	//Records (but doesn't submit) a frame for a range of draw and thread counts and prints the average CPU time.
+	void BenchmarkRecording();
+	//Renders frames of 1 up to 1000000 copies of the mesh, with a draw per copy and with one instanced draw,
+	//and prints the average time per frame, recording and GPU time together.
+	void BenchmarkInstancing();
+	//Renders the frames of a headless run and reports their min, average and 99th percentile time.
+	void BenchmarkFrames();
+	void WriteBenchmarkResults(const std::vector<double>& frameTimes) const;
+	bool UsesInstancing() const { return m_Desc.Instanced || m_Desc.GpuCulling || m_Desc.Benchmark == "instances"; }
+	bool UsesPushConstants() const { return m_Desc.PushConstants && !m_Desc.Instanced && !m_Desc.GpuCulling; }
+	//The transforms that get a uniform block each, instanced draws and draws that push their transform share a single one.
+	const std::vector<glm::mat4>& GetUniformTransforms() const
+	{
+		return m_Desc.Instanced || m_Desc.GpuCulling || UsesPushConstants() ? m_InstancedUniformTransforms : m_ObjectTransforms;
+	}
+
+	//Sets up frame 0 of the benchmarks to draw every transform once, with a uniform block or push constants per draw.
+	void PrepareBenchmarkDraws(const std::vector<glm::mat4>& transforms, std::vector<DrawPushConstants>& drawConstants,
+		std::vector<uint32_t>& dynamicOffsets, FrameResources& resources);
+
+	//Compares the number of objects the GPU culling of the last frame kept with the CPU, throws when they don't match.
+	//The device must be idle.
+	void VerifyCulling() const;
+
+	//Spreads count objects over a square grid that fits in the view, or gridScale times as wide.
+	static std::vector<glm::mat4> CreateObjectTransforms(uint32_t count, float gridScale = 1.0f);
+	static std::vector<DrawPushConstants> CreateDrawConstants(const std::vector<glm::mat4>& transforms);
 
 	//Create semaphores and fences
 	void CreateSyncObjects();
+	//The transient images of the render graph match the extent of the current swap chain, so it is created again with it.
+	void CreateRenderGraph();
+	//Replaces the swap chain without waiting for the device to become idle, see m_RetiredSwapChains.
 	void RecreateSwapChain();
+	void DestroyRetiredSwapChains();
+	//Of the primary monitor, 60 when GLFW doesn't know it. Like every GLFW call, only from the main thread.
+	int GetRefreshRate() const;
+	//How long a presented image is expected to wait before it's on the screen, for the latency estimate of the FramePacer.
+	std::chrono::duration<double, std::milli> GetPresentDelay(int refreshRate) const;
 	
 private:
+	ApplicationDesc m_Desc;
+
 	std::unique_ptr<Window> m_UniqueWindow;
 	std::unique_ptr<VulkanInstance> m_UniqueInstance;
 	std::unique_ptr<Surface> m_UniqueSurface;
@@ -65,8 +209,15 @@ private:
 	std::unique_ptr<SwapChain> m_UniqueSwapChain;
 	std::unique_ptr<RenderPass> m_UniqueRenderPass;
 	std::unique_ptr<DescriptorSetLayout> m_UniqueDescriptorSetLayout;
+	std::unique_ptr<PipelineCache> m_UniquePipelineCache;
 	std::unique_ptr<GraphicsPipeline> m_UniquePipeline;
-	std::unique_ptr<CommandPool> m_UniqueCommandPool;
+	std::unique_ptr<GraphicsPipeline> m_UniqueInstancedPipeline;
+	std::unique_ptr<SetupContext> m_UniqueSetupContext;
+	std::unique_ptr<UploadManager> m_UniqueUploadManager;
+	std::unique_ptr<Profiler> m_UniqueProfiler;
+	std::unique_ptr<TextureStreamer> m_UniqueTextureStreamer;
+	std::unique_ptr<FrameRecorder> m_UniqueFrameRecorder;
+	std::unique_ptr<FramePacer> m_UniqueFramePacer;
 	std::unique_ptr<TextureSampler> m_UniqueSampler;
 
 	//In MSAA, each pixel is sampled in an offscreen buffer which is then rendered to the screen.
@@ -74,38 +225,94 @@ private:
 	//they have to be able to store more than one sample per pixel. Once a multisampled buffer is created,
 	// it has to be resolved to the default framebuffer (which stores only a single sample per pixel). 
 	//This is why we have to create an additional render target and modifgy our current drawing procsess.
-	//We only need one render target since only one drawing operation is actie at a time, just like with
-	//the depth buffer.
-	std::unique_ptr<Buffer2D> m_UniqueRenderTarget;
-	std::unique_ptr<DepthBuffer> m_UniqueDepthBuffer;
+	//Both the render target and the depth buffer are transient images of the render graph, which only needs one of each
+	//since only one drawing operation is actie at a time. It decides when they share memory and records their barriers.
+	std::unique_ptr<RenderGraph> m_UniqueRenderGraph;
+	RenderGraph::ResourceId m_ColorTarget = 0;
+	RenderGraph::ResourceId m_DepthTarget = 0;
+
+	//A swap chain that was replaced, with the render graph that owns its frame buffers and their attachments.
+	//Frames submitted before Frame may still use them, so they are destroyed once the fences of those frames
+	//have signaled instead of waiting for the device.
+	struct RetiredSwapChain
+	{
+		std::unique_ptr<SwapChain> UniqueSwapChain;
+		std::unique_ptr<RenderGraph> UniqueRenderGraph;
+		uint64_t Frame;
+	};
+	std::vector<RetiredSwapChain> m_RetiredSwapChains;
+	//Either the whole texture, or when streaming, the id of the streamed one.
 	std::unique_ptr<Texture> m_UniqueTexture;
+	uint32_t m_StreamedTexture = 0;
+
+	//The view version of the streamed texture each frame's descriptor set points to.
+	std::vector<uint64_t> m_DescriptorTextureVersions;
 	std::unique_ptr<VertexBuffer> m_UniqueVertexBuffer;
+	//The InstanceData of every object, only when they are drawn instanced.
+	std::unique_ptr<VertexBuffer> m_UniqueInstanceBuffer;
+	//Only with GPU culling, it owns the instance buffers of the visible objects instead.
+	std::unique_ptr<GpuCuller> m_UniqueCuller;
 	std::unique_ptr<IndexBuffer> m_UniqueIndexBuffer;
 	std::unique_ptr<DescriptorPool> m_UniqueDescriptorPool;
 
+	//Only in bindless mode. m_TableTextureVersion is the view version of the streamed texture the table points to.
+	std::unique_ptr<BindlessTextureTable> m_UniqueTextureTable;
+	bool m_IsBindless = false;
+	uint32_t m_TextureSlot = 0;
+	uint64_t m_TableTextureVersion = 0;
+
 	//Each frame should have its own set of semaphores
 	std::vector<std::unique_ptr<Semaphore>> m_ImageAvailableSemaphores;
 	std::vector<std::unique_ptr<Semaphore>> m_RenderFinishedSemaphores;
 	std::vector<std::unique_ptr<Fence>> m_InFlightFences;
 
+	//The fence of the frame that is currently rendering into each swap chain image, or VK_NULL_HANDLE.
+	std::vector<VkFence> m_ImagesInFlight;
+
+	//The model matrix and texture slot of every object and, for the frame being recorded, the dynamic offset of its uniform block.
+	std::vector<glm::mat4> m_ObjectTransforms;
+	std::vector<uint32_t> m_ObjectTextures;
+	//Instanced, the objects share one uniform block, their own transform is in the instance buffer.
+	const std::vector<glm::mat4> m_InstancedUniformTransforms = { glm::mat4(1.0f) };
+	std::vector<uint32_t> m_DynamicOffsets;
+	//The pushed data of every object, only when the draws use push constants.
+	std::vector<DrawPushConstants> m_DrawConstants;
+
 	size_t m_CurrentFrame = 0;
-	bool m_FrameBufferResized = false;
+
+	//Only with a CameraScript. Time starts when the first frame is drawn, unless there is a fixed time step.
+	std::unique_ptr<CameraPath> m_UniqueCameraPath;
+	std::chrono::steady_clock::time_point m_StartTime;
+
+	//Headless frames are read back here once their fence has signaled.
+	std::vector<unsigned char> m_LastFrame;
+	uint64_t m_FramesSubmitted = 0;
 
 	const std::vector<const char*> m_ValidationLayers = { "VK_LAYER_LUNARG_standard_validation" };
-	const std::vector<const char*> m_DeviceExtensions = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
 
-	const int MAX_FRAMES_IN_FLIGHT = 2;
+	//The swap chain extension is only requested when we render to a window.
+	std::vector<const char*> m_DeviceExtensions;
 
-	//Interleaving vertex attributes: all vertices and their attributes are defined in 1 buffer
-	std::vector<Vertex> m_Vertices;
+	static const uint32_t MAX_SUPPORTED_FRAMES_IN_FLIGHT = 4;
+	const uint32_t m_MaxFramesInFlight;
 
-	//It is possible to use either uin16_t or uin32_t for your index buffer depending on the number
-	//of entries in vertices. We can stick to uint16_t for now because we're using less than 65534 unique vertices
-	std::vector<uint32_t> m_Indices;
+	//Interleaving vertex attributes: all vertices and their attributes are defined in 1 buffer.
+	//The indices are uint32_t, because real models easily have more than 65535 unique vertices.
+	Mesh m_Mesh;
 
 	const uint32_t WIDTH = 800;
 	const uint32_t HEIGHT = 600;
 
 	const std::string MODEL_PATH = "../data/meshes/chalet.obj";
+	const std::string MESH_CACHE_PATH = "../data/meshes/chalet.meshcache";
+	const std::string PACKED_MESH_CACHE_PATH = "../data/meshes/chalet.packed.meshcache";
+	const std::string PIPELINE_CACHE_PATH = "../data/pipeline.cache";
+	const std::string TEXTURE_PATH = "../data/textures/chalet.jpg";
+	const std::string VERT_SHADER_PATH = "../data/shaders/bin/vert.spv";
+	const std::string INSTANCED_VERT_SHADER_PATH = "../data/shaders/bin/instanced_vert.spv";
+	const std::string PUSH_VERT_SHADER_PATH = "../data/shaders/bin/push_vert.spv";
+	const std::string FRAG_SHADER_PATH = "../data/shaders/bin/frag.spv";
+	const std::string BINDLESS_FRAG_SHADER_PATH = "../data/shaders/bin/bindless_frag.spv";
+	const std::string CULL_COMP_SHADER_PATH = "../data/shaders/bin/cull_comp.spv";
 
 };
\ No newline at end of file
@@ -42,6 +42,14 @@ void Window::OnResize(int width, int height)
 {
 	m_Width = width;
 	m_Height = height;
+	m_IsResized = true;
+}
+
+bool Window::ConsumeResize()
+{
+	bool isResized = m_IsResized;
+	m_IsResized = false;
+	return isResized;
 }
 
 GLFWwindow* Window::MakeWindow(int width, int height, const std::string& title) const
@@ -12,11 +12,13 @@ public:
 	Window(int width, int height, const std::string& title, bool isResizable);
 	~Window();
 
-	//window isn't resizable, but this can change
 	static void OnResizeStatic(GLFWwindow* pWindow, int width, int height);
 	void OnResize(int width, int height);
 	GLFWwindow* GetGLFWWindow() const { return m_pWindow.get(); }
 
+	//Whether the framebuffer was resized since the last call, the swap chain has to be recreated when it was.
+	bool ConsumeResize();
+
 private:
 	GLFWwindow* MakeWindow(int width, int height, const std::string& title) const;
 
@@ -24,4 +26,5 @@ private:
 	std::unique_ptr<GLFWwindow, std::function<void(GLFWwindow*)>> m_pWindow;
 	int m_Width;
 	int m_Height;
+	bool m_IsResized = false;
 };
\ No newline at end of file
@@ -1,11 +1,105 @@
 #include <stdexcept>
 #include <iostream>
+#include <string>
 
 #include "HelloTriangleApplication.h"
+#include "Benchmarks.h"
 
-int Program()
+#include "../Help/TextureCooker.h"
+#include "../Help/ThreadPool.h"
+
+ApplicationDesc ParseArguments(int argc, char* argv[])
 {
-	HelloTriangleApplication app;
+	ApplicationDesc desc = {};
+
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string arg = argv[i];
+
+		if (arg == "--headless")
+			desc.Headless = true;
+		else if (arg == "--frames" && i + 1 < argc)
+			desc.FrameCount = static_cast<uint32_t>(std::stoul(argv[++i]));
+		else if (arg == "--time-step" && i + 1 < argc)
+			desc.TimeStep = std::stof(argv[++i]);
+		else if (arg == "--camera-path" && i + 1 < argc)
+			desc.CameraScript = argv[++i];
+		else if (arg == "--results" && i + 1 < argc)
+			desc.ResultsPath = argv[++i];
+		else if (arg == "--output" && i + 1 < argc)
+			desc.OutputPath = argv[++i];
+		else if (arg == "--frames-in-flight" && i + 1 < argc)
+			desc.FramesInFlight = static_cast<uint32_t>(std::stoul(argv[++i]));
+		else if (arg == "--present-policy" && i + 1 < argc)
+		{
+			const std::string policy = argv[++i];
+			if (policy == "low-latency")
+				desc.Policy = PresentPolicy::LowLatency;
+			else if (policy == "vsync")
+				desc.Policy = PresentPolicy::VSync;
+			else if (policy == "throughput")
+				desc.Policy = PresentPolicy::Throughput;
+			else
+				std::cerr << "ignoring unknown present policy: " << policy << std::endl;
+		}
+		else if (arg == "--target-fps" && i + 1 < argc)
+			desc.TargetFrameRate = std::stof(argv[++i]);
+		else if (arg == "--objects" && i + 1 < argc)
+			desc.ObjectCount = static_cast<uint32_t>(std::stoul(argv[++i]));
+		else if (arg == "--packed-vertices")
+			desc.PackedVertices = true;
+		else if (arg == "--record-threads" && i + 1 < argc)
+			desc.RecordThreads = static_cast<uint32_t>(std::stoul(argv[++i]));
+		else if (arg == "--benchmark" && i + 1 < argc)
+			desc.Benchmark = argv[++i];
+		else if (arg == "--instanced")
+			desc.Instanced = true;
+		else if (arg == "--push-constants")
+			desc.PushConstants = true;
+		else if (arg == "--gpu-culling")
+			desc.GpuCulling = true;
+		else if (arg == "--grid-scale" && i + 1 < argc)
+			desc.GridScale = std::stof(argv[++i]);
+		else if (arg == "--bindless")
+			desc.Bindless = true;
+		else if (arg == "--texture-budget" && i + 1 < argc)
+			desc.TextureBudgetMiB = static_cast<uint32_t>(std::stoul(argv[++i]));
+		else if (arg == "--profile" && i + 1 < argc)
+			desc.ProfilePath = argv[++i];
+		else if (arg == "--cook" && i + 1 < argc)
+			desc.CookTexture = argv[++i];
+		else
+			std::cerr << "ignoring unknown argument: " << arg << std::endl;
+	}
+
+	return desc;
+}
+
+int Program(const ApplicationDesc& desc)
+{
+	//CPU benchmarks and the texture cooker don't need a window or a device, so they don't create the application at all.
+	if (IsCpuBenchmark(desc.Benchmark) || !desc.CookTexture.empty())
+	{
+		try
+		{
+			if (!desc.CookTexture.empty())
+			{
+				ThreadPool pool;
+				CookTexture(desc.CookTexture, &pool);
+			}
+			else
+				RunCpuBenchmark(desc.Benchmark);
+		}
+		catch (const std::exception& e)
+		{
+			std::cerr << e.what() << std::endl;
+			return EXIT_FAILURE;
+		}
+
+		return EXIT_SUCCESS;
+	}
+
+	HelloTriangleApplication app(desc);
 
 	try
 	{
@@ -20,12 +114,17 @@ int Program()
 	return EXIT_SUCCESS;
 }
 
-int main()
+int main(int argc, char* argv[])
 {
-	int errCode = Program();
+	const ApplicationDesc desc = ParseArguments(argc, argv);
+
+	int errCode = Program(desc);
 
 	std::cout << "exited with error code: " << errCode;
-	std::cin.get();
+
+	//Headless runs, benchmarks and cooking are unattended, so don't wait for a key press.
+	if (!desc.Headless && desc.Benchmark.empty() && desc.CookTexture.empty())
+		std::cin.get();
 
 	return errCode;
 }
\ No newline at end of file
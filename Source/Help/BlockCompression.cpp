@@ -0,0 +1,558 @@
+#include "BlockCompression.h"
+
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <functional>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+	const uint32_t BLOCK_PIXELS = 16;
+
+	//Rounds the endpoints to the format, picks the indices and fits new endpoints to those indices this many times.
+	const uint32_t REFINE_ITERATIONS = 2;
+
+	//Interpolation weights of the 16 BC7 mode 6 indices, out of 64.
+	const uint32_t BC7_WEIGHTS[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	//A 4x4 block with every channel in [0, 255].
+	struct Block
+	{
+		float Pixels[BLOCK_PIXELS][4];
+	};
+
+	void FetchBlock(const uint8_t* pRGBA, uint32_t width, uint32_t height, uint32_t blockX, uint32_t blockY, Block& block)
+	{
+		for (uint32_t y = 0; y < 4; ++y)
+		{
+			const uint32_t sourceY = std::min(blockY * 4 + y, height - 1);
+
+			for (uint32_t x = 0; x < 4; ++x)
+			{
+				const uint32_t sourceX = std::min(blockX * 4 + x, width - 1);
+				const uint8_t* pPixel = pRGBA + (static_cast<size_t>(sourceY) * width + sourceX) * 4;
+
+				for (uint32_t channel = 0; channel < 4; ++channel)
+					block.Pixels[y * 4 + x][channel] = pPixel[channel];
+			}
+		}
+	}
+
+	//The line through the block that best fits its pixels, from the smallest to the largest projection on it.
+	void FitLine(const Block& block, uint32_t channels, float start[4], float end[4])
+	{
+		float mean[4] = {};
+		for (uint32_t i = 0; i < BLOCK_PIXELS; ++i)
+			for (uint32_t c = 0; c < channels; ++c)
+				mean[c] += block.Pixels[i][c] / BLOCK_PIXELS;
+
+		float covariance[4][4] = {};
+		for (uint32_t i = 0; i < BLOCK_PIXELS; ++i)
+			for (uint32_t a = 0; a < channels; ++a)
+				for (uint32_t b = 0; b < channels; ++b)
+					covariance[a][b] += (block.Pixels[i][a] - mean[a]) * (block.Pixels[i][b] - mean[b]);
+
+		//Power iteration converges to the eigenvector with the largest eigenvalue, the principal axis.
+		//Starting from the row of the channel that varies most keeps the start from being perpendicular to it.
+		uint32_t widestChannel = 0;
+		for (uint32_t c = 1; c < channels; ++c)
+			if (covariance[c][c] > covariance[widestChannel][widestChannel])
+				widestChannel = c;
+
+		float axis[4] = {};
+		std::copy(covariance[widestChannel], covariance[widestChannel] + channels, axis);
+		for (uint32_t iteration = 0; iteration < 8; ++iteration)
+		{
+			float next[4] = {};
+			for (uint32_t a = 0; a < channels; ++a)
+				for (uint32_t b = 0; b < channels; ++b)
+					next[a] += covariance[a][b] * axis[b];
+
+			float length = 0.0f;
+			for (uint32_t c = 0; c < channels; ++c)
+				length = std::max(length, std::abs(next[c]));
+
+			//A flat block, every pixel is the mean.
+			if (length < 1e-6f)
+			{
+				std::copy(mean, mean + 4, start);
+				std::copy(mean, mean + 4, end);
+				return;
+			}
+
+			for (uint32_t c = 0; c < channels; ++c)
+				axis[c] = next[c] / length;
+		}
+
+		float axisLengthSquared = 0.0f;
+		for (uint32_t c = 0; c < channels; ++c)
+			axisLengthSquared += axis[c] * axis[c];
+
+		float minProjection = 0.0f;
+		float maxProjection = 0.0f;
+		for (uint32_t i = 0; i < BLOCK_PIXELS; ++i)
+		{
+			float projection = 0.0f;
+			for (uint32_t c = 0; c < channels; ++c)
+				projection += (block.Pixels[i][c] - mean[c]) * axis[c];
+
+			minProjection = std::min(minProjection, projection / axisLengthSquared);
+			maxProjection = std::max(maxProjection, projection / axisLengthSquared);
+		}
+
+		for (uint32_t c = 0; c < 4; ++c)
+		{
+			start[c] = c < channels ? std::min(std::max(mean[c] + axis[c] * minProjection, 0.0f), 255.0f) : 255.0f;
+			end[c] = c < channels ? std::min(std::max(mean[c] + axis[c] * maxProjection, 0.0f), 255.0f) : 255.0f;
+		}
+	}
+
+	//Least squares endpoints for pixels that are interpolated with the given weights, 0 is start and 1 is end.
+	//Returns false if all weights are the same, then there is nothing to solve.
+	bool RefineLine(const Block& block, uint32_t channels, const float weights[BLOCK_PIXELS], float start[4], float end[4])
+	{
+		float aa = 0.0f;
+		float ab = 0.0f;
+		float bb = 0.0f;
+		float ax[4] = {};
+		float bx[4] = {};
+
+		for (uint32_t i = 0; i < BLOCK_PIXELS; ++i)
+		{
+			const float b = weights[i];
+			const float a = 1.0f - b;
+
+			aa += a * a;
+			ab += a * b;
+			bb += b * b;
+
+			for (uint32_t c = 0; c < channels; ++c)
+			{
+				ax[c] += a * block.Pixels[i][c];
+				bx[c] += b * block.Pixels[i][c];
+			}
+		}
+
+		const float determinant = aa * bb - ab * ab;
+		if (std::abs(determinant) < 1e-6f)
+			return false;
+
+		for (uint32_t c = 0; c < channels; ++c)
+		{
+			start[c] = std::min(std::max((bb * ax[c] - ab * bx[c]) / determinant, 0.0f), 255.0f);
+			end[c] = std::min(std::max((aa * bx[c] - ab * ax[c]) / determinant, 0.0f), 255.0f);
+		}
+
+		return true;
+	}
+
+	float SquaredDistance(const float a[4], const float b[4], uint32_t channels)
+	{
+		float distance = 0.0f;
+		for (uint32_t c = 0; c < channels; ++c)
+			distance += (a[c] - b[c]) * (a[c] - b[c]);
+
+		return distance;
+	}
+
+	//BC1
+	//-------------------------
+
+	uint16_t To565(const float color[4])
+	{
+		const uint32_t r = static_cast<uint32_t>(color[0] * 31.0f / 255.0f + 0.5f);
+		const uint32_t g = static_cast<uint32_t>(color[1] * 63.0f / 255.0f + 0.5f);
+		const uint32_t b = static_cast<uint32_t>(color[2] * 31.0f / 255.0f + 0.5f);
+
+		return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+	}
+
+	//Expands the 5 and 6 bit channels the same way the hardware does, by replicating the high bits.
+	void From565(uint16_t packed, float color[4])
+	{
+		const uint32_t r = (packed >> 11) & 31;
+		const uint32_t g = (packed >> 5) & 63;
+		const uint32_t b = packed & 31;
+
+		color[0] = static_cast<float>((r << 3) | (r >> 2));
+		color[1] = static_cast<float>((g << 2) | (g >> 4));
+		color[2] = static_cast<float>((b << 3) | (b >> 2));
+		color[3] = 255.0f;
+	}
+
+	//Picks the indices for the endpoints in four color mode and returns the squared error.
+	//The weights of the chosen indices are written for RefineLine.
+	float EvaluateBC1(const Block& block, uint16_t color0, uint16_t color1, uint32_t& indices, float weights[BLOCK_PIXELS])
+	{
+		float palette[4][4];
+		From565(color0, palette[0]);
+		From565(color1, palette[1]);
+		for (uint32_t c = 0; c < 3; ++c)
+		{
+			palette[2][c] = (2.0f * palette[0][c] + palette[1][c]) / 3.0f;
+			palette[3][c] = (palette[0][c] + 2.0f * palette[1][c]) / 3.0f;
+		}
+
+		const float paletteWeights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+
+		indices = 0;
+		float error = 0.0f;
+
+		for (uint32_t i = 0; i < BLOCK_PIXELS; ++i)
+		{
+			uint32_t best = 0;
+			float bestDistance = SquaredDistance(block.Pixels[i], palette[0], 3);
+
+			for (uint32_t entry = 1; entry < 4; ++entry)
+			{
+				const float distance = SquaredDistance(block.Pixels[i], palette[entry], 3);
+				if (distance < bestDistance)
+				{
+					best = entry;
+					bestDistance = distance;
+				}
+			}
+
+			indices |= best << (i * 2);
+			weights[i] = paletteWeights[best];
+			error += bestDistance;
+		}
+
+		return error;
+	}
+
+	//Writes an 8 byte BC1 color block. In BC3 the color block is always decoded in four color mode,
+	//in BC1 that mode needs color0 > color1, so the endpoints are ordered that way for both.
+	void EncodeColorBlock(const Block& block, uint8_t* pOutput)
+	{
+		float start[4];
+		float end[4];
+		FitLine(block, 3, start, end);
+
+		uint16_t bestColor0 = 0;
+		uint16_t bestColor1 = 0;
+		uint32_t bestIndices = 0;
+		float bestError = std::numeric_limits<float>::max();
+
+		for (uint32_t iteration = 0; iteration < REFINE_ITERATIONS; ++iteration)
+		{
+			//The weights run from color0 to color1, and start is the end the weights are 0 at.
+			uint16_t color0 = To565(start);
+			uint16_t color1 = To565(end);
+			bool swapped = false;
+
+			if (color0 < color1)
+			{
+				std::swap(color0, color1);
+				swapped = true;
+			}
+
+			uint32_t indices = 0;
+			float weights[BLOCK_PIXELS];
+			float error = 0.0f;
+
+			//Both endpoints rounded to the same color, which is four color mode in BC3 but three color mode in BC1.
+			//Index 0 is the same color in both.
+			if (color0 == color1)
+			{
+				float color[4];
+				From565(color0, color);
+				for (uint32_t i = 0; i < BLOCK_PIXELS; ++i)
+					error += SquaredDistance(block.Pixels[i], color, 3);
+			}
+			else
+				error = EvaluateBC1(block, color0, color1, indices, weights);
+
+			if (error < bestError)
+			{
+				bestError = error;
+				bestColor0 = color0;
+				bestColor1 = color1;
+				bestIndices = indices;
+			}
+
+			if (color0 == color1)
+				break;
+
+			if (swapped)
+				for (uint32_t i = 0; i < BLOCK_PIXELS; ++i)
+					weights[i] = 1.0f - weights[i];
+
+			if (!RefineLine(block, 3, weights, start, end))
+				break;
+		}
+
+		pOutput[0] = static_cast<uint8_t>(bestColor0 & 0xFF);
+		pOutput[1] = static_cast<uint8_t>(bestColor0 >> 8);
+		pOutput[2] = static_cast<uint8_t>(bestColor1 & 0xFF);
+		pOutput[3] = static_cast<uint8_t>(bestColor1 >> 8);
+		for (uint32_t byte = 0; byte < 4; ++byte)
+			pOutput[4 + byte] = static_cast<uint8_t>(bestIndices >> (byte * 8));
+	}
+
+	//BC3 alpha
+	//-------------------------
+
+	//Writes an 8 byte alpha block in the eight value mode: alpha0 > alpha1 and six values in between.
+	void EncodeAlphaBlock(const Block& block, uint8_t* pOutput)
+	{
+		float minAlpha = 255.0f;
+		float maxAlpha = 0.0f;
+		for (uint32_t i = 0; i < BLOCK_PIXELS; ++i)
+		{
+			minAlpha = std::min(minAlpha, block.Pixels[i][3]);
+			maxAlpha = std::max(maxAlpha, block.Pixels[i][3]);
+		}
+
+		const uint32_t alpha0 = static_cast<uint32_t>(maxAlpha + 0.5f);
+		const uint32_t alpha1 = static_cast<uint32_t>(minAlpha + 0.5f);
+
+		//With alpha0 == alpha1 the block is in six value mode, but index 0 is alpha0 in both.
+		float palette[8] = { static_cast<float>(alpha0), static_cast<float>(alpha1) };
+		for (uint32_t entry = 2; entry < 8; ++entry)
+			palette[entry] = static_cast<float>(((8 - entry) * alpha0 + (entry - 1) * alpha1) / 7);
+
+		uint64_t indices = 0;
+		if (alpha0 != alpha1)
+		{
+			for (uint32_t i = 0; i < BLOCK_PIXELS; ++i)
+			{
+				uint64_t best = 0;
+				float bestDistance = std::abs(block.Pixels[i][3] - palette[0]);
+
+				for (uint32_t entry = 1; entry < 8; ++entry)
+				{
+					const float distance = std::abs(block.Pixels[i][3] - palette[entry]);
+					if (distance < bestDistance)
+					{
+						best = entry;
+						bestDistance = distance;
+					}
+				}
+
+				indices |= best << (i * 3);
+			}
+		}
+
+		pOutput[0] = static_cast<uint8_t>(alpha0);
+		pOutput[1] = static_cast<uint8_t>(alpha1);
+		for (uint32_t byte = 0; byte < 6; ++byte)
+			pOutput[2 + byte] = static_cast<uint8_t>(indices >> (byte * 8));
+	}
+
+	//BC7
+	//-------------------------
+
+	struct BC7Endpoint
+	{
+		uint32_t Channels[4];
+		uint32_t PBit;
+	};
+
+	//Mode 6 stores 7 bits per channel plus a p-bit shared by the four channels of an endpoint as their lowest bit.
+	//Both p-bits are tried and the one that rounds the endpoint closest is kept.
+	BC7Endpoint QuantizeBC7(const float color[4])
+	{
+		BC7Endpoint best = {};
+		float bestError = std::numeric_limits<float>::max();
+
+		for (uint32_t pBit = 0; pBit < 2; ++pBit)
+		{
+			BC7Endpoint endpoint = {};
+			endpoint.PBit = pBit;
+
+			float error = 0.0f;
+			for (uint32_t c = 0; c < 4; ++c)
+			{
+				const float quantized = std::floor((color[c] - pBit) / 2.0f + 0.5f);
+				endpoint.Channels[c] = static_cast<uint32_t>(std::min(std::max(quantized, 0.0f), 127.0f));
+
+				const float reconstructed = static_cast<float>(endpoint.Channels[c] * 2 + pBit);
+				error += (reconstructed - color[c]) * (reconstructed - color[c]);
+			}
+
+			if (error < bestError)
+			{
+				best = endpoint;
+				bestError = error;
+			}
+		}
+
+		return best;
+	}
+
+	float EvaluateBC7(const Block& block, const BC7Endpoint& endpoint0, const BC7Endpoint& endpoint1, uint32_t indices[BLOCK_PIXELS], float weights[BLOCK_PIXELS])
+	{
+		float palette[16][4];
+		for (uint32_t entry = 0; entry < 16; ++entry)
+		{
+			for (uint32_t c = 0; c < 4; ++c)
+			{
+				const uint32_t value0 = endpoint0.Channels[c] * 2 + endpoint0.PBit;
+				const uint32_t value1 = endpoint1.Channels[c] * 2 + endpoint1.PBit;
+				palette[entry][c] = static_cast<float>(((64 - BC7_WEIGHTS[entry]) * value0 + BC7_WEIGHTS[entry] * value1 + 32) >> 6);
+			}
+		}
+
+		float error = 0.0f;
+		for (uint32_t i = 0; i < BLOCK_PIXELS; ++i)
+		{
+			uint32_t best = 0;
+			float bestDistance = SquaredDistance(block.Pixels[i], palette[0], 4);
+
+			for (uint32_t entry = 1; entry < 16; ++entry)
+			{
+				const float distance = SquaredDistance(block.Pixels[i], palette[entry], 4);
+				if (distance < bestDistance)
+				{
+					best = entry;
+					bestDistance = distance;
+				}
+			}
+
+			indices[i] = best;
+			weights[i] = BC7_WEIGHTS[best] / 64.0f;
+			error += bestDistance;
+		}
+
+		return error;
+	}
+
+	//Writes bits from the least significant bit of the block upwards, the order BC7 fields are stored in.
+	class BitWriter
+	{
+	public:
+		BitWriter(uint8_t* pOutput): m_pOutput(pOutput), m_Position(0) {}
+
+		void Write(uint32_t value, uint32_t bitCount)
+		{
+			for (uint32_t bit = 0; bit < bitCount; ++bit, ++m_Position)
+			{
+				if ((value >> bit) & 1)
+					m_pOutput[m_Position / 8] |= static_cast<uint8_t>(1 << (m_Position % 8));
+			}
+		}
+
+	private:
+		uint8_t* m_pOutput;
+		uint32_t m_Position;
+	};
+
+	void EncodeBC7Block(const Block& block, uint8_t* pOutput)
+	{
+		float start[4];
+		float end[4];
+		FitLine(block, 4, start, end);
+
+		BC7Endpoint bestEndpoint0 = {};
+		BC7Endpoint bestEndpoint1 = {};
+		uint32_t bestIndices[BLOCK_PIXELS] = {};
+		float bestError = std::numeric_limits<float>::max();
+
+		for (uint32_t iteration = 0; iteration < REFINE_ITERATIONS; ++iteration)
+		{
+			const BC7Endpoint endpoint0 = QuantizeBC7(start);
+			const BC7Endpoint endpoint1 = QuantizeBC7(end);
+
+			uint32_t indices[BLOCK_PIXELS];
+			float weights[BLOCK_PIXELS];
+			const float error = EvaluateBC7(block, endpoint0, endpoint1, indices, weights);
+
+			if (error < bestError)
+			{
+				bestError = error;
+				bestEndpoint0 = endpoint0;
+				bestEndpoint1 = endpoint1;
+				std::copy(indices, indices + BLOCK_PIXELS, bestIndices);
+			}
+
+			if (!RefineLine(block, 4, weights, start, end))
+				break;
+		}
+
+		//The index of the first pixel is stored without its highest bit, which has to be 0.
+		//Swapping the endpoints mirrors all indices and clears it.
+		if (bestIndices[0] >= 8)
+		{
+			std::swap(bestEndpoint0, bestEndpoint1);
+			for (uint32_t i = 0; i < BLOCK_PIXELS; ++i)
+				bestIndices[i] = 15 - bestIndices[i];
+		}
+
+		memset(pOutput, 0, 16);
+		BitWriter writer(pOutput);
+
+		//Mode 6 is a 1 in bit 6.
+		writer.Write(1 << 6, 7);
+
+		for (uint32_t c = 0; c < 4; ++c)
+		{
+			writer.Write(bestEndpoint0.Channels[c], 7);
+			writer.Write(bestEndpoint1.Channels[c], 7);
+		}
+
+		writer.Write(bestEndpoint0.PBit, 1);
+		writer.Write(bestEndpoint1.PBit, 1);
+
+		for (uint32_t i = 0; i < BLOCK_PIXELS; ++i)
+			writer.Write(bestIndices[i], i == 0 ? 3 : 4);
+	}
+
+	void CompressBlocks(const uint8_t* pRGBA, uint32_t width, uint32_t height, std::vector<uint8_t>& blocks, uint32_t bytesPerBlock,
+		ThreadPool* pPool, const std::function<void(const Block&, uint8_t*)>& encode)
+	{
+		const uint32_t blocksX = (width + 3) / 4;
+		const uint32_t blocksY = (height + 3) / 4;
+		blocks.resize(GetCompressedSize(width, height, bytesPerBlock));
+
+		const std::function<void(uint32_t)> compressRow = [&](uint32_t blockY)
+		{
+			Block block;
+			for (uint32_t blockX = 0; blockX < blocksX; ++blockX)
+			{
+				FetchBlock(pRGBA, width, height, blockX, blockY, block);
+				encode(block, blocks.data() + (static_cast<size_t>(blockY) * blocksX + blockX) * bytesPerBlock);
+			}
+		};
+
+		if (pPool)
+			pPool->ParallelFor(blocksY, compressRow);
+		else
+			for (uint32_t blockY = 0; blockY < blocksY; ++blockY)
+				compressRow(blockY);
+	}
+}
+
+void CompressBC1(const uint8_t* pRGBA, uint32_t width, uint32_t height, std::vector<uint8_t>& blocks, ThreadPool* pPool)
+{
+	CompressBlocks(pRGBA, width, height, blocks, 8, pPool, [](const Block& block, uint8_t* pOutput)
+	{
+		EncodeColorBlock(block, pOutput);
+	});
+}
+
+void CompressBC3(const uint8_t* pRGBA, uint32_t width, uint32_t height, std::vector<uint8_t>& blocks, ThreadPool* pPool)
+{
+	//The alpha block comes first.
+	CompressBlocks(pRGBA, width, height, blocks, 16, pPool, [](const Block& block, uint8_t* pOutput)
+	{
+		EncodeAlphaBlock(block, pOutput);
+		EncodeColorBlock(block, pOutput + 8);
+	});
+}
+
+void CompressBC7(const uint8_t* pRGBA, uint32_t width, uint32_t height, std::vector<uint8_t>& blocks, ThreadPool* pPool)
+{
+	CompressBlocks(pRGBA, width, height, blocks, 16, pPool, [](const Block& block, uint8_t* pOutput)
+	{
+		EncodeBC7Block(block, pOutput);
+	});
+}
+
+size_t GetCompressedSize(uint32_t width, uint32_t height, uint32_t bytesPerBlock)
+{
+	return static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4) * bytesPerBlock;
+}
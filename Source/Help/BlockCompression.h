@@ -0,0 +1,26 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+class ThreadPool;
+
+//Encoders for the BCn block compressed formats. Every 4x4 block of RGBA8 pixels becomes 8 (BC1) or 16 (BC3, BC7) bytes,
+//blocks are stored row by row. Images that aren't a multiple of 4 are padded by repeating their last row and column,
+//the GPU never samples those texels.
+//The encoders fit the endpoints along the principal axis of the block and refine them with a least squares fit,
+//which is a lot faster than an exhaustive search and close enough for textures that are cooked once.
+//Rows of blocks are independent, so they are spread over pPool when one is given.
+
+//Opaque BC1, the alpha channel is ignored.
+void CompressBC1(const uint8_t* pRGBA, uint32_t width, uint32_t height, std::vector<uint8_t>& blocks, ThreadPool* pPool = nullptr);
+
+//BC1 color with an 8 bit interpolated alpha block.
+void CompressBC3(const uint8_t* pRGBA, uint32_t width, uint32_t height, std::vector<uint8_t>& blocks, ThreadPool* pPool = nullptr);
+
+//BC7 mode 6: one RGBA line with 7 bit endpoints and 16 levels, the highest quality single subset mode.
+void CompressBC7(const uint8_t* pRGBA, uint32_t width, uint32_t height, std::vector<uint8_t>& blocks, ThreadPool* pPool = nullptr);
+
+//Size in bytes of the blocks of an image with bytesPerBlock bytes per 4x4 block.
+size_t GetCompressedSize(uint32_t width, uint32_t height, uint32_t bytesPerBlock);
@@ -0,0 +1,109 @@
+#include "CameraPath.h"
+
+#include <glm/gtc/constants.hpp>
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	//Keys of an orbit, the spline between them is within a fraction of a percent of the circle.
+	const uint32_t ORBIT_KEY_COUNT = 32;
+
+	glm::vec3 CatmullRom(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2, const glm::vec3& p3, float t)
+	{
+		const float t2 = t * t;
+		const float t3 = t2 * t;
+		return 0.5f * ((2.0f * p1) + (p2 - p0) * t + (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * t2 + (3.0f * p1 - p0 - 3.0f * p2 + p3) * t3);
+	}
+}
+
+CameraPath::CameraPath(const std::vector<CameraKey>& keys):
+	m_Keys(keys)
+{
+	if (m_Keys.empty())
+		throw std::runtime_error("a camera path needs at least one key!");
+
+	for (size_t i = 1; i < m_Keys.size(); ++i)
+	{
+		if (m_Keys[i].Time <= m_Keys[i - 1].Time)
+			throw std::runtime_error("the keys of a camera path must be in increasing time!");
+	}
+}
+
+CameraPath CameraPath::CreateOrbit(const glm::vec3& eye, float duration)
+{
+	//The last key is the first one again, so the path ends where it starts.
+	std::vector<CameraKey> keys(ORBIT_KEY_COUNT + 1);
+	for (uint32_t i = 0; i <= ORBIT_KEY_COUNT; ++i)
+	{
+		const float angle = glm::two_pi<float>() * i / ORBIT_KEY_COUNT;
+		const float c = std::cos(angle);
+		const float s = std::sin(angle);
+
+		keys[i].Time = duration * i / ORBIT_KEY_COUNT;
+		keys[i].Eye = glm::vec3(eye.x * c - eye.y * s, eye.x * s + eye.y * c, eye.z);
+		keys[i].Target = glm::vec3(0.0f);
+	}
+
+	return CameraPath(keys);
+}
+
+CameraPath CameraPath::Load(const std::string& path)
+{
+	std::ifstream file(path);
+	if (!file)
+		throw std::runtime_error("failed to open camera path " + path + "!");
+
+	std::vector<CameraKey> keys;
+	std::string line;
+	while (std::getline(file, line))
+	{
+		const size_t first = line.find_first_not_of(" \t\r");
+		if (first == std::string::npos || line[first] == '#')
+			continue;
+
+		std::istringstream stream(line);
+		CameraKey key;
+		if (!(stream >> key.Time >> key.Eye.x >> key.Eye.y >> key.Eye.z >> key.Target.x >> key.Target.y >> key.Target.z))
+			throw std::runtime_error("invalid key in camera path " + path + ": " + line + "!");
+
+		keys.push_back(key);
+	}
+
+	return CameraPath(keys);
+}
+
+void CameraPath::Evaluate(float time, glm::vec3& eye, glm::vec3& target) const
+{
+	if (time <= m_Keys.front().Time)
+	{
+		eye = m_Keys.front().Eye;
+		target = m_Keys.front().Target;
+		return;
+	}
+
+	if (time >= m_Keys.back().Time)
+	{
+		eye = m_Keys.back().Eye;
+		target = m_Keys.back().Target;
+		return;
+	}
+
+	//The segment between keys i and i + 1 that contains time, the keys around it shape the curve.
+	//At the ends of the path the missing neighbour is the end key itself.
+	const auto next = std::upper_bound(m_Keys.begin(), m_Keys.end(), time, [](float t, const CameraKey& key) { return t < key.Time; });
+	const size_t i = static_cast<size_t>(next - m_Keys.begin()) - 1;
+
+	const CameraKey& k0 = m_Keys[i > 0 ? i - 1 : i];
+	const CameraKey& k1 = m_Keys[i];
+	const CameraKey& k2 = m_Keys[i + 1];
+	const CameraKey& k3 = m_Keys[std::min(i + 2, m_Keys.size() - 1)];
+
+	const float t = (time - k1.Time) / (k2.Time - k1.Time);
+	eye = CatmullRom(k0.Eye, k1.Eye, k2.Eye, k3.Eye, t);
+	target = CatmullRom(k0.Target, k1.Target, k2.Target, k3.Target, t);
+}
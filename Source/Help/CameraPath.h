@@ -0,0 +1,35 @@
+#pragma once
+
+#include <vector>
+#include <string>
+
+#include <glm/glm.hpp>
+
+//Where the camera is and what it looks at, at a point in time.
+struct CameraKey
+{
+	float Time;
+	glm::vec3 Eye;
+	glm::vec3 Target;
+};
+
+//A scripted camera, so every run renders the same frames. The camera moves through the keys with a Catmull-Rom spline,
+//which passes through every key and has no kinks at them, and stays at the first and last key outside of the path.
+class CameraPath
+{
+public:
+	//At least one key, in increasing time.
+	CameraPath(const std::vector<CameraKey>& keys);
+
+	//A full turn around the z axis in duration seconds, starting at eye, looking at the origin.
+	static CameraPath CreateOrbit(const glm::vec3& eye, float duration);
+
+	//One key per line: time, eye x y z and target x y z, separated by whitespace. Empty lines and lines starting with # are skipped.
+	static CameraPath Load(const std::string& path);
+
+	void Evaluate(float time, glm::vec3& eye, glm::vec3& target) const;
+	float GetDuration() const { return m_Keys.back().Time - m_Keys.front().Time; }
+
+private:
+	std::vector<CameraKey> m_Keys;
+};
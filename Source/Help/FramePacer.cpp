@@ -0,0 +1,111 @@
+#include "FramePacer.h"
+
+#include <thread>
+#include <cmath>
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+
+namespace
+{
+	//Sleeping closer to the deadline than this risks oversleeping it, Windows wakes threads up at a 1 ms granularity at best.
+	const std::chrono::duration<double, std::milli> SPIN_MARGIN(2.0);
+}
+
+FramePacer::FramePacer(uint32_t framesInFlight, float targetFrameRate, std::chrono::duration<double, std::milli> presentDelay):
+	m_TargetFrameTime(Clock::duration::zero()),
+	m_PresentDelay(presentDelay),
+	m_FrameStarts(framesInFlight),
+	m_IsPending(framesInFlight, false)
+{
+	if (targetFrameRate > 0.0f)
+		m_TargetFrameTime = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / targetFrameRate));
+}
+
+void FramePacer::Pace(uint32_t frameIndex)
+{
+	Clock::time_point now = Clock::now();
+	Complete(frameIndex, now);
+
+	if (m_TargetFrameTime > Clock::duration::zero())
+	{
+		if (!m_HasStarted)
+			m_NextFrame = now;
+
+		WaitUntil(m_NextFrame);
+		now = Clock::now();
+
+		//Deadlines are a fixed period apart, so a frame that starts a bit late doesn't shift the frames after it.
+		//When we're more than a whole frame behind, we start counting from now instead of rushing to catch up.
+		m_NextFrame += m_TargetFrameTime;
+		if (m_NextFrame < now)
+			m_NextFrame = now;
+	}
+
+	if (m_HasStarted)
+	{
+		const double frameTime = Milliseconds(now - m_LastFrame).count();
+		m_FrameTimeSum += frameTime;
+		m_FrameTimeSquaredSum += frameTime * frameTime;
+		++m_FrameCount;
+	}
+
+	m_HasStarted = true;
+	m_LastFrame = now;
+	m_FrameStart = now;
+}
+
+void FramePacer::OnSubmit(uint32_t frameIndex)
+{
+	m_FrameStarts[frameIndex] = m_FrameStart;
+	m_IsPending[frameIndex] = true;
+}
+
+void FramePacer::Finish()
+{
+	const Clock::time_point now = Clock::now();
+
+	for (uint32_t i = 0; i < m_IsPending.size(); ++i)
+		Complete(i, now);
+}
+
+void FramePacer::PrintStatistics() const
+{
+	if (m_FrameCount == 0)
+		return;
+
+	const double averageFrameTime = m_FrameTimeSum / m_FrameCount;
+	const double variance = std::max(0.0, m_FrameTimeSquaredSum / m_FrameCount - averageFrameTime * averageFrameTime);
+
+	std::cout << std::fixed << std::setprecision(2);
+	std::cout << "frame pacing: " << m_FrameCount << " frames, " << averageFrameTime << " ms per frame (+- " << std::sqrt(variance) << " ms)" << std::endl;
+
+	if (m_LatencyCount > 0)
+	{
+		std::cout << "frame pacing: estimated input to present latency " << m_LatencySum / m_LatencyCount << " ms average, "
+			<< m_LatencyMax << " ms max" << std::endl;
+	}
+}
+
+void FramePacer::WaitUntil(Clock::time_point deadline) const
+{
+	const Clock::time_point sleepUntil = deadline - std::chrono::duration_cast<Clock::duration>(SPIN_MARGIN);
+	if (Clock::now() < sleepUntil)
+		std::this_thread::sleep_until(sleepUntil);
+
+	while (Clock::now() < deadline)
+		std::this_thread::yield();
+}
+
+void FramePacer::Complete(uint32_t frameIndex, Clock::time_point now)
+{
+	if (!m_IsPending[frameIndex])
+		return;
+
+	const double latency = Milliseconds(now - m_FrameStarts[frameIndex]).count() + m_PresentDelay.count();
+	m_LatencySum += latency;
+	m_LatencyMax = std::max(m_LatencyMax, latency);
+	++m_LatencyCount;
+
+	m_IsPending[frameIndex] = false;
+}
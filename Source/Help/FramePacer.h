@@ -0,0 +1,60 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+//Starts frames at a fixed rate and estimates how long it takes for the input a frame was built from to reach the display.
+//Pace is called once the fence of a frame has signaled, right before input is polled and the frame is recorded,
+//and OnSubmit once the frame has been submitted. Frames that are abandoned before they are submitted don't count.
+//With a target frame rate it waits until the frame is due: it sleeps until shortly before the deadline, because sleeping
+//is only accurate to about a millisecond, and yields for the rest. Without one it returns right away.
+//The latency of a frame runs from Pace to the first time its fence is seen signaled, which is an upper bound on
+//when the GPU finished, plus presentDelay for the time the image waits in the presentation engine.
+class FramePacer
+{
+public:
+	//targetFrameRate 0 doesn't limit the frame rate.
+	FramePacer(uint32_t framesInFlight, float targetFrameRate, std::chrono::duration<double, std::milli> presentDelay);
+
+	//Completes the previous frame of frameIndex if it was submitted, then waits until the next frame is due.
+	void Pace(uint32_t frameIndex);
+	void OnSubmit(uint32_t frameIndex);
+
+	//For when the present mode changes, applies to the frames that complete from now on.
+	void SetPresentDelay(std::chrono::duration<double, std::milli> presentDelay) { m_PresentDelay = presentDelay; }
+
+	//Completes the frames that are still pending, the device must be idle.
+	void Finish();
+
+	//Frame time, its standard deviation and the estimated input to present latency so far.
+	void PrintStatistics() const;
+
+private:
+	typedef std::chrono::steady_clock Clock;
+	typedef std::chrono::duration<double, std::milli> Milliseconds;
+
+	void WaitUntil(Clock::time_point deadline) const;
+	void Complete(uint32_t frameIndex, Clock::time_point now);
+
+private:
+	Clock::duration m_TargetFrameTime;
+	Milliseconds m_PresentDelay;
+
+	Clock::time_point m_NextFrame;
+	Clock::time_point m_LastFrame;
+	bool m_HasStarted = false;
+	Clock::time_point m_FrameStart;
+
+	//When each frame in flight started, and whether it has yet to complete.
+	std::vector<Clock::time_point> m_FrameStarts;
+	std::vector<bool> m_IsPending;
+
+	uint64_t m_FrameCount = 0;
+	double m_FrameTimeSum = 0.0;
+	double m_FrameTimeSquaredSum = 0.0;
+
+	uint64_t m_LatencyCount = 0;
+	double m_LatencySum = 0.0;
+	double m_LatencyMax = 0.0;
+};
@@ -8,12 +8,29 @@
 
 #include "../Vulkan/LogicalDevice.h"
 #include "../Vulkan/PhysicalDevice.h"
-#include "../Vulkan/CommandPool.h"
+#include "../Vulkan/MemoryAllocator.h"
+#include "../Vulkan/Texture.h"
+
+#include "VertexDeduplicator.h"
 
 #include <stdexcept>
 #include <fstream>
-#include <unordered_map>
+#include <thread>
+#include <algorithm>
 #include <iostream>
+#include <cstdio>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#endif
+
+#include <stb/stb_image.h>
 
 VkImageView CreateImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, uint32_t mipLevels, LogicalDevice* pLogicalDevice)
 {
@@ -49,7 +66,7 @@ VkImageView CreateImageView(VkImage image, VkFormat format, VkImageAspectFlags a
 	return imageView;
 }
 
-void CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& bufferMemory, LogicalDevice* pLogicalDevice, PhysicalDevice* pGpu)
+void CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, Allocation& bufferAllocation, LogicalDevice* pLogicalDevice)
 {
 	VkBufferCreateInfo bufferInfo = {};
 	bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
@@ -89,20 +106,13 @@ void CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyF
 	//We need to combine the requirements of the buffer and our own application requirements to find the right
 	//type of memory to use.
 
-	//Memory allocatoin is now as simple as specifying the size and type, both of which are derived
-	//from the memory requirements of the vertex buffer and the desired property.
-	VkMemoryAllocateInfo allocInfo = {};
-	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-	allocInfo.allocationSize = memRequirements.size;
-	allocInfo.memoryTypeIndex = FindMemoryType(memRequirements.memoryTypeBits, properties, pGpu);
-
-	if (vkAllocateMemory(pLogicalDevice->GetDevice(), &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS)
-		throw std::runtime_error("failed to allocate buffer memory!");
+	//Instead of a vkAllocateMemory per buffer, the allocator hands out a range of a larger block
+	//of the memory type that FindMemoryType picks for these requirements and properties.
+	bufferAllocation = pLogicalDevice->GetAllocator()->Allocate(memRequirements, properties, false);
 
 	//the fourth parameter is the offset within the region of memory.
-	//Since this memory is allocated specifically for this vertex buffer, the offset is simply 0.
-	//If the offset is non-zero, then it is required to be divisble by memREquirements.alignment.
-	vkBindBufferMemory(pLogicalDevice->GetDevice(), buffer, bufferMemory, 0);
+	//The allocator already made sure it is divisible by memRequirements.alignment.
+	vkBindBufferMemory(pLogicalDevice->GetDevice(), buffer, bufferAllocation.Memory, bufferAllocation.Offset);
 }
 
 uint32_t FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties, PhysicalDevice* pGpu)
@@ -171,10 +181,8 @@ VkFormat FindDepthFormat(PhysicalDevice* pGpu)
 	return FindSupportedFormat({ VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT }, VK_IMAGE_TILING_OPTIMAL, VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT, pGpu);
 }
 
-void CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size, const VkCommandPool& commandPool, LogicalDevice* pCpu)
+void CopyBuffer(VkCommandBuffer commandBuffer, VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size)
 {
-	VkCommandBuffer commandBuffer = BeginSingleTimeCommands(commandPool, pCpu);
-
 	VkBufferCopy copyRegion = {};
 	copyRegion.srcOffset = 0; //Optional
 	copyRegion.dstOffset = 0; //Optional
@@ -185,65 +193,10 @@ void CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size, const
 	//The regions are defined in VkBufferCopy structs and consist of a soruce buffer offset, 
 	//destinaiton buffer offset and size. //It is not possible to specify VK_WHOLE_SIZE here, unlike the vkMapMemory command.
 	vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
-
-	EndSingleTimeCommands(commandBuffer, commandPool, pCpu);
 }
 
 
-VkCommandBuffer BeginSingleTimeCommands(const VkCommandPool& commandPool, LogicalDevice* pCpu)
-{
-	//Memory transfer operations are executed using command buffers, just like drawing commands.
-	//Therefore we must first allocate a temporary command buffer.
-	//You may wish to create a separate command pool for these kinds of short-lived buffers, 
-	//because the implementation may be able to apply memory allocation optimizations.
-	//You should use the VK_COMMAND_POOL_CREATE_TRANSIENT_BIT flag during command pool genreration in that case.
-	VkCommandBufferAllocateInfo allocInfo = {};
-	allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-	allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-	allocInfo.commandPool = commandPool;
-	allocInfo.commandBufferCount = 1;
-
-	VkCommandBuffer commandBuffer;
-	vkAllocateCommandBuffers(pCpu->GetDevice(), &allocInfo, &commandBuffer);
-
-	//Immediatly start recording the command buffer
-	VkCommandBufferBeginInfo beginInfo = {};
-	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-
-	//The VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT flag that we used for the drawing command buffers
-	//is not necessary here, because we're only going to use the command buffer once and wait with returning 
-	//from the function until the copy operation has finished executing. It's good practice to tell the drive
-	//about our intent using VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT.
-	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-
-	vkBeginCommandBuffer(commandBuffer, &beginInfo);
-
-	return commandBuffer;
-}
-
-void EndSingleTimeCommands(VkCommandBuffer commandBuffer, const VkCommandPool& commandPool, LogicalDevice* pCpu)
-{
-	vkEndCommandBuffer(commandBuffer);
-
-	VkSubmitInfo submitInfo = {};
-	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-	submitInfo.commandBufferCount = 1;
-	submitInfo.pCommandBuffers = &commandBuffer;
-
-	//Unlike the draw commands, there are no events we need to wait on this time.
-	//We just want to execute the transfer on the buffers immediatly.
-	//There are again 2 possible ways to wait on this transfer to complete.
-	//We could use a fence and wait with vkWaitForFences, or simply wait for the transfer queue to 
-	//become idle with vkQueueWaitIdle.
-	//A fence would allow you to schedule multiple transfers simultaneously and wait for all of them to complete,
-	//Instead of executing one at a time. That may give the driver more opportunities to optimize.
-	vkQueueSubmit(pCpu->GetGraphicsQueue(), 1, &submitInfo, VK_NULL_HANDLE);
-	vkQueueWaitIdle(pCpu->GetGraphicsQueue());
-
-	vkFreeCommandBuffers(pCpu->GetDevice(), commandPool, 1, &commandBuffer);
-}
-
-void CreateImage(uint32_t width, uint32_t height, uint32_t mipLevels, VkSampleCountFlagBits numSamples, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory, LogicalDevice* pCpu, PhysicalDevice* pGpu)
+void CreateImage(uint32_t width, uint32_t height, uint32_t mipLevels, VkSampleCountFlagBits numSamples, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, Allocation& imageAllocation, LogicalDevice* pCpu)
 {
 	VkImageCreateInfo imageInfo = {};
 	imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
@@ -313,27 +266,20 @@ void CreateImage(uint32_t width, uint32_t height, uint32_t mipLevels, VkSampleCo
 	VkMemoryRequirements memRequirements;
 	vkGetImageMemoryRequirements(pCpu->GetDevice(), image, &memRequirements);
 
-	VkMemoryAllocateInfo allocInfo = {};
-	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-	allocInfo.allocationSize = memRequirements.size;
-	allocInfo.memoryTypeIndex = FindMemoryType(memRequirements.memoryTypeBits, properties, pGpu);
-
-	if (vkAllocateMemory(pCpu->GetDevice(), &allocInfo, nullptr, &imageMemory) != VK_SUCCESS)
-		throw std::runtime_error("failed to allocate image memory!");
+	//Optimal images need to be kept bufferImageGranularity away from buffers in the same block.
+	imageAllocation = pCpu->GetAllocator()->Allocate(memRequirements, properties, tiling == VK_IMAGE_TILING_OPTIMAL);
 
-	vkBindImageMemory(pCpu->GetDevice(), image, imageMemory, 0);
+	vkBindImageMemory(pCpu->GetDevice(), image, imageAllocation.Memory, imageAllocation.Offset);
 }
 
-void CopyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, const VkCommandPool& commandPool, LogicalDevice* pCpu)
+void CopyBufferToImage(VkCommandBuffer commandBuffer, VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, uint32_t mipLevel, VkDeviceSize bufferOffset)
 {
-	VkCommandBuffer commandBuffer = BeginSingleTimeCommands(commandPool, pCpu);
-
 	//Just like with buffer copies, you need to specify which part of is going to be copied to which part of the image.
 	//This happens through VkBufferImageCopy structs.
 	VkBufferImageCopy region = {};
 
 	//Specifies the byte offset in the buffer at which the pixel values start.
-	region.bufferOffset = 0;
+	region.bufferOffset = bufferOffset;
 
 	//specify how the pixels are laid out in memory.
 	//For example, you could have some padding bytes between rows of the image.
@@ -343,7 +289,7 @@ void CopyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t
 
 	//indicates which part of the image we want to copy the pixels
 	region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-	region.imageSubresource.mipLevel = 0;
+	region.imageSubresource.mipLevel = mipLevel;
 	region.imageSubresource.baseArrayLayer = 0;
 	region.imageSubresource.layerCount = 1;
 	region.imageOffset = { 0,0,0 };
@@ -353,8 +299,6 @@ void CopyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t
 	//I'm assuming here that the image has already been transitioned to the layout that is optimal for copying
 	//pixels to.
 	vkCmdCopyBufferToImage(commandBuffer, buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
-
-	EndSingleTimeCommands(commandBuffer, commandPool, pCpu);
 }
 
 bool HasStencilComponent(VkFormat format)
@@ -383,142 +327,8 @@ std::vector<char> ReadFile(const std::string& fileName)
 	return buffer;
 }
 
-void TransitionImageLayout(VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout, uint32_t mipLevels, CommandPool* pCommandPool, LogicalDevice* pCpu)
+void LoadVertexStream(std::vector<Vertex>& stream, const std::string& path)
 {
-	VkCommandBuffer commandBuffer = BeginSingleTimeCommands(pCommandPool->GetPool(), pCpu);
-
-	//One of the most common ways to perform layout transitions is using an image memory barrier.
-	//A pipeline barrier like that is generally used to synchronize access to resources,
-	//like ensuring that a write to a buffer completes before reading from it, but it can also be used
-	//to transition image layours and transfer queue family ownership when VK_SHARING_MODE_EXCLUSIVE is used.
-	//there is an equivalent buffer memory barrier to do this for buffers
-	VkImageMemoryBarrier barrier = {};
-	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-
-	//The first 2 fields specify layout transition. It is possible to use VK_IMAGE_LAYOUT_UNDEFINED
-	//as oldLayout if you don't care about the existing contents of the image.
-	barrier.oldLayout = oldLayout;
-	barrier.newLayout = newLayout;
-
-	//if you are using the barrier to transfer queue family ownership, then these two fields should
-	//be the indices of the queue families. They must be set to VK_QUEUE_FAMILY_IGNORED if you don't want
-	//to do this (not the default value!).
-	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-
-	//The image and subresourceRange specify the image that is affected and the specific part of the image.
-	//Our image is not an array and does not have mipmapping levels, so only one level and layer are specified.
-	barrier.image = image;
-	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-	barrier.subresourceRange.baseMipLevel = 0;
-	barrier.subresourceRange.levelCount = mipLevels;
-	barrier.subresourceRange.baseArrayLayer = 0;
-	barrier.subresourceRange.layerCount = 1;
-
-	//Barriers are primarily used for synchronization purposes, so you must specify which types of operations
-	//that involve the resource must happen before the barrier, and which operations that involve the resource
-	//must wait on the barrier. We need to do that despite already using vkQueueWaitIdle to manually synchronize.
-	//The right values depend on the old and new layout, so we'll get back to this once we've figured out which transitions
-	//we're going to use.
-	barrier.srcAccessMask = 0; //TODO
-	barrier.dstAccessMask = 0; //TODO
-
-	if (newLayout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL)
-	{
-		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
-		if (HasStencilComponent(format))
-			barrier.subresourceRange.aspectMask |= VK_IMAGE_ASPECT_STENCIL_BIT;
-	}
-	else
-		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-
-	VkPipelineStageFlags sourceStage;
-	VkPipelineStageFlags destinationStage;
-
-	//Validate access masks and pipeline stages in trnasitionImageLayout.
-	//There are 2 that need to be set based on the layouts in the transition.
-	//Undefined --> transfer destination: transfer writes that don't need to wait on anything
-	//transfer destination --> shader reading: shader reads should wait on transfer writes, 
-	//specifically the shader reads in the fragment shader, because that's where we're going to use the texture.
-
-	//Since the writes don't have to wait on anythign, you may specify an empty access mask and 
-	//the earliest possible pipeline stage VK_PIPELINE_sTAGE_TOP_OF_PIPE_BIT for the pre-barrier operations.
-	//It should be noted that VK_PIPELINE_STAGE_TRANSFER_BIT is not a read stage within the graphics and compute pipelines.
-	//It is more of a pseudo-stage where transfers happen. 
-	//See the documentatoin for more information and other examples of pseudo-stages.
-	if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL)
-	{
-		barrier.srcAccessMask = 0;
-		barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-
-		sourceStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-		destinationStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-	}
-
-	//The image will be written in the same pipeline stage and subsequently read by the fragment shader,
-	//which is why we specify shader reading access in the fragment shader pipeline stage.
-	else if (oldLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
-	{
-		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-		sourceStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-		destinationStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-	}
-
-	else if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL)
-	{
-		barrier.srcAccessMask = 0;
-		barrier.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-
-		//The depth buffer will be read from to perform depth tests to see if a fragment is visible,
-		//and will be written to when a new fragment is drawn. The reading happens in the VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESS_BIT stage and
-		//the writing in the VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT. You should pick the earliest pipeline stage that matches the specified
-		//operations, so tha tit is ready for usage as depth attachment when it needs to be.
-		sourceStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-		destinationStage = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-	}
-	else if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL)
-	{
-		barrier.srcAccessMask = 0;
-		barrier.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-
-		sourceStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-		destinationStage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-	}
-	else
-		throw std::invalid_argument("unsupported layout transition!");
-
-	//All types of pipeline barriers are submitted using the same function.
-	//The first parameter after the command buffer speicifes in which pipeline stage the operations occur
-	//that should happen before the barrier. The pipeline stages that you are allowed to specify before and after
-	//the barrier depend on how you use the resource before and after the barrier. The allowed values are listed here:
-	//https://www.khronos.org/registry/vulkan/specs/1.0/html/vkspec.html#synchronization-access-types-supported
-	//For example, if you're going to read from a uniform after the barrier, you would specify a usage of VK_ACCESSS_UNIFORM_READ_BIT
-	//and the earliest shader that will read from the unifrom as pipeline stage, for example VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT.
-	//It would not make sense to specify a no-shader pipeline stage for this type of usage and the validation layers
-	//will warn you when you specify a pipeline stage that does not match the type of usage.
-
-	//The third parameter is either 0 or VK_DEPENDENCY_BY_REGION_BIT. the latter turns the barrier into a per-region condition.
-	//That means that the implementation is allowed to already begin reading from the parts of a resource that were written so far, for example.
-
-	//The last 3 pairs of parameters reference arrays of pipeline barriers of the 3 available types:
-	//memory barriers, buffer memory barriers and image memory barriers like the one we're using here.
-	vkCmdPipelineBarrier(
-		commandBuffer,
-		sourceStage, destinationStage,
-		0,
-		0, nullptr,
-		0, nullptr,
-		1, &barrier);
-
-	EndSingleTimeCommands(commandBuffer, pCommandPool->GetPool(), pCpu);
-}
-
-void LoadModel(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, const std::string& path)
-{
-	std::cout << "starting to load model\n";
-
 	tinyobj::attrib_t attrib;
 	std::vector<tinyobj::shape_t> shapes;
 	std::vector<tinyobj::material_t> materials;
@@ -537,7 +347,12 @@ void LoadModel(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, co
 	if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warning, &err, path.c_str()))
 		throw std::runtime_error(err);
 
-	std::unordered_map<Vertex, uint32_t> uniqueVertices = {};
+	size_t indexCount = 0;
+	for (const tinyobj::shape_t& shape : shapes)
+		indexCount += shape.mesh.indices.size();
+
+	stream.clear();
+	stream.reserve(indexCount);
 
 	for (const tinyobj::shape_t& shape : shapes)
 	{
@@ -545,7 +360,6 @@ void LoadModel(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, co
 		{
 			Vertex vertex = {};
 
-			//For simplicity, we will assume that every vertex is unqie for now, hence the simple auto-increment indices.
 			//The index variable is of type tinyobj::index_t, which contains the vertex_index, normal_index and texcoord_index members.
 			//We need to use these indices to look up the actual vertex attributes in the attrib arrays
 
@@ -570,19 +384,79 @@ void LoadModel(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, co
 
 			vertex.Color = { 1.0f, 1.0f, 1.0f };
 
-			//Every time we read a vertex from the OBJ file, we check if we've already seen a vertex
-			//with the exact same position and textrue coordinates before. if not, we add it to vertices
-			//and store its index in the uniqueVertices container. after that we add the index of the new vertex
-			//to indices. if We've seen the exact same vertex before, then we look up its index in uniqueVertices and store
-			//that index in m_Indices.
-			if (uniqueVertices.count(vertex) == 0)
-			{
-				uniqueVertices[vertex] = static_cast<uint32_t>(vertices.size());
-				vertices.push_back(vertex);
-			}
+			stream.push_back(vertex);
+		}
+	}
+}
+
+void LoadModel(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, const std::string& path)
+{
+	std::cout << "starting to load model\n";
+
+	std::vector<Vertex> stream;
+	LoadVertexStream(stream, path);
+
+	//Every time we read a vertex from the OBJ file, we check if we've already seen a vertex
+	//with the exact same position and textrue coordinates before. if not, we add it to vertices.
+	//after that we add the index of the vertex to indices.
+	//For large models this is the expensive part of loading, so it is spread over all hardware threads.
+	DeduplicateVertices(stream, vertices, indices, std::max(1u, std::thread::hardware_concurrency()));
+}
 
-			indices.push_back(uniqueVertices[vertex]);
+void WriteImagePPM(const std::string& fileName, uint32_t width, uint32_t height, const std::vector<unsigned char>& rgbaPixels)
+{
+	std::ofstream file(fileName, std::ios::binary);
+
+	if (!file.is_open())
+		throw std::runtime_error("failed to open image file for writing!");
+
+	//A binary PPM is a tiny text header followed by tightly packed RGB triplets, so the alpha channel is dropped.
+	file << "P6\n" << width << " " << height << "\n255\n";
+
+	std::vector<char> row(static_cast<size_t>(width) * 3);
+	for (uint32_t y = 0; y < height; ++y)
+	{
+		const unsigned char* pSrc = rgbaPixels.data() + static_cast<size_t>(y) * width * 4;
+		for (uint32_t x = 0; x < width; ++x)
+		{
+			row[x * 3 + 0] = static_cast<char>(pSrc[x * 4 + 0]);
+			row[x * 3 + 1] = static_cast<char>(pSrc[x * 4 + 1]);
+			row[x * 3 + 2] = static_cast<char>(pSrc[x * 4 + 2]);
 		}
+
+		file.write(row.data(), row.size());
 	}
 }
 
+void LoadTexture(TextureData& texture, const std::string& path)
+{
+	int texChannels;
+
+	//the stbi_load function takes the file path and number of channels as arguments.
+	//the STBI_rgb_alpha value forces the image to be loaded with an alpha channel, even if it doesn't have one,
+	//which is nice for consistency with other textures in the future.
+	//The middle 3 parameters are outputs for the dith, height and actual number of channels in the image.
+	//The pointer that is returned is the first elemtn in an array of pixel values.
+	//The pixels are laid out row by row with 4 bytes per pixel in the case of STBI_rgba_alpha for a total of texWidth * texHeight * 4 values.
+	stbi_uc* pixels = stbi_load(path.c_str(), &texture.Width, &texture.Height, &texChannels, STBI_rgb_alpha);
+
+	if (!pixels)
+		throw std::runtime_error("failed to load texture image!");
+
+	const size_t imageSize = static_cast<size_t>(texture.Width) * texture.Height * 4; //4 -> rgba
+	texture.Pixels.assign(pixels, pixels + imageSize);
+
+	//clean up the original pixel array
+	stbi_image_free(pixels);
+}
+
+bool AtomicReplaceFile(const std::string& from, const std::string& to)
+{
+	//Renaming within the same directory is atomic: readers either see the old or the new file, never half of one.
+	//std::rename refuses to overwrite an existing file on Windows, so use MoveFileEx there.
+#ifdef _WIN32
+	return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+	return std::rename(from.c_str(), to.c_str()) == 0;
+#endif
+}
\ No newline at end of file
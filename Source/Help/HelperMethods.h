@@ -12,20 +12,25 @@
 
 class LogicalDevice;
 class PhysicalDevice;
-class CommandPool;
+struct Allocation;
+struct TextureData;
 
 VkImageView CreateImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, uint32_t mipLevels, LogicalDevice* pLogicalDevice);
-void CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& bufferMemory, LogicalDevice* pLogicalDevice, PhysicalDevice* pGpu);
+void CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, Allocation& bufferAllocation, LogicalDevice* pLogicalDevice);
 uint32_t FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties, PhysicalDevice* pGpu);
 VkFormat FindSupportedFormat(const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features, PhysicalDevice* pGpu);
 VkFormat FindDepthFormat(PhysicalDevice* pGpu);
-void CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size, const VkCommandPool& commandPool, LogicalDevice* pCpu);
-VkCommandBuffer BeginSingleTimeCommands(const VkCommandPool& commandPool, LogicalDevice* pCpu);
-void EndSingleTimeCommands(VkCommandBuffer commandBuffer, const VkCommandPool& commandPool, LogicalDevice* pCpu);
-void CreateImage(uint32_t width, uint32_t height, uint32_t mipLevels, VkSampleCountFlagBits numSamples, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory, LogicalDevice* pCpu, PhysicalDevice* pGpu);
-void CopyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, const VkCommandPool& commandPool, LogicalDevice* pCpu);
+//The copy functions only record into commandBuffer, see SetupContext and UploadManager for submitting them.
+void CopyBuffer(VkCommandBuffer commandBuffer, VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
+void CreateImage(uint32_t width, uint32_t height, uint32_t mipLevels, VkSampleCountFlagBits numSamples, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, Allocation& imageAllocation, LogicalDevice* pCpu);
+void CopyBufferToImage(VkCommandBuffer commandBuffer, VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, uint32_t mipLevel = 0, VkDeviceSize bufferOffset = 0);
 bool HasStencilComponent(VkFormat format);
 std::vector<char> ReadFile(const std::string& fileName);
-void TransitionImageLayout(VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout, uint32_t mipLevels, CommandPool* pCommandPool, LogicalDevice* pCpu);
+//Parses an OBJ into one vertex per index, without any deduplication.
+void LoadVertexStream(std::vector<Vertex>& stream, const std::string& path);
 void LoadModel(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, const std::string& path);
+void LoadTexture(TextureData& texture, const std::string& path);
+//Moves from over to, replacing to if it exists. Within one directory this is atomic.
+bool AtomicReplaceFile(const std::string& from, const std::string& to);
+void WriteImagePPM(const std::string& fileName, uint32_t width, uint32_t height, const std::vector<unsigned char>& rgbaPixels);
 
@@ -0,0 +1,341 @@
+#include "Ktx2Texture.h"
+
+#include "HelperMethods.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <cstring>
+#include <cstdio>
+
+namespace
+{
+	const uint8_t KTX2_IDENTIFIER[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+	//The identifier, nine 32 bit header fields, the index of the data format descriptor, the key/value data
+	//and the supercompression global data. The level index follows right after.
+	const size_t HEADER_SIZE = 80;
+	const size_t LEVEL_INDEX_ENTRY_SIZE = 24;
+
+	//Values from the Khronos Data Format Specification that the data format descriptor is made of.
+	const uint32_t KHR_DF_MODEL_RGBSDA = 1;
+	const uint32_t KHR_DF_MODEL_BC1A = 128;
+	const uint32_t KHR_DF_MODEL_BC3 = 130;
+	const uint32_t KHR_DF_MODEL_BC7 = 134;
+	const uint32_t KHR_DF_PRIMARIES_BT709 = 1;
+	const uint32_t KHR_DF_TRANSFER_LINEAR = 1;
+	const uint32_t KHR_DF_TRANSFER_SRGB = 2;
+	const uint32_t KHR_DF_CHANNEL_COLOR = 0;
+	const uint32_t KHR_DF_CHANNEL_ALPHA = 15;
+	const uint32_t KHR_DF_SAMPLE_DATATYPE_LINEAR = 0x10;
+
+	struct DataFormatSample
+	{
+		uint32_t BitOffset;
+		uint32_t BitLength;
+		uint32_t Channel;
+		uint32_t Upper;
+	};
+
+	bool IsSRGB(VkFormat format)
+	{
+		return format == VK_FORMAT_R8G8B8A8_SRGB || format == VK_FORMAT_BC1_RGB_SRGB_BLOCK || format == VK_FORMAT_BC3_SRGB_BLOCK || format == VK_FORMAT_BC7_SRGB_BLOCK;
+	}
+
+	uint64_t GetLevelByteSize(VkFormat format, uint32_t width, uint32_t height)
+	{
+		if (Ktx2Texture::IsBlockCompressed(format))
+			return uint64_t((width + 3) / 4) * ((height + 3) / 4) * Ktx2Texture::GetBlockSize(format);
+
+		return uint64_t(width) * height * Ktx2Texture::GetBlockSize(format);
+	}
+
+	void Append32(std::vector<uint8_t>& bytes, uint32_t value)
+	{
+		for (uint32_t byte = 0; byte < 4; ++byte)
+			bytes.push_back(static_cast<uint8_t>(value >> (byte * 8)));
+	}
+
+	void Append64(std::vector<uint8_t>& bytes, uint64_t value)
+	{
+		Append32(bytes, static_cast<uint32_t>(value));
+		Append32(bytes, static_cast<uint32_t>(value >> 32));
+	}
+
+	uint32_t Read32(const uint8_t* pData)
+	{
+		uint32_t value;
+		memcpy(&value, pData, sizeof(value));
+		return value;
+	}
+
+	uint64_t Read64(const uint8_t* pData)
+	{
+		uint64_t value;
+		memcpy(&value, pData, sizeof(value));
+		return value;
+	}
+
+	//KTX2 requires a basic data format descriptor, even though the VkFormat in the header already says it all.
+	std::vector<uint8_t> CreateDataFormatDescriptor(VkFormat format)
+	{
+		const bool isBlockCompressed = Ktx2Texture::IsBlockCompressed(format);
+		const uint32_t blockSize = Ktx2Texture::GetBlockSize(format);
+
+		uint32_t model = KHR_DF_MODEL_RGBSDA;
+		std::vector<DataFormatSample> samples;
+
+		switch (format)
+		{
+		case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+			model = KHR_DF_MODEL_BC1A;
+			samples.push_back({ 0, 64, KHR_DF_CHANNEL_COLOR, 0xFFFFFFFF });
+			break;
+		case VK_FORMAT_BC3_UNORM_BLOCK:
+		case VK_FORMAT_BC3_SRGB_BLOCK:
+			model = KHR_DF_MODEL_BC3;
+			samples.push_back({ 0, 64, KHR_DF_CHANNEL_ALPHA, 0xFFFFFFFF });
+			samples.push_back({ 64, 64, KHR_DF_CHANNEL_COLOR, 0xFFFFFFFF });
+			break;
+		case VK_FORMAT_BC7_UNORM_BLOCK:
+		case VK_FORMAT_BC7_SRGB_BLOCK:
+			model = KHR_DF_MODEL_BC7;
+			samples.push_back({ 0, 128, KHR_DF_CHANNEL_COLOR, 0xFFFFFFFF });
+			break;
+		default:
+			//R, G, B and A, one byte each.
+			for (uint32_t channel = 0; channel < 4; ++channel)
+				samples.push_back({ channel * 8, 8, channel == 3 ? KHR_DF_CHANNEL_ALPHA : channel, 255 });
+			break;
+		}
+
+		const uint32_t blockHeaderSize = 24;
+		const uint32_t descriptorBlockSize = blockHeaderSize + 16 * static_cast<uint32_t>(samples.size());
+
+		std::vector<uint8_t> descriptor;
+		Append32(descriptor, 4 + descriptorBlockSize);
+
+		//Vendor 0 (Khronos), descriptor type 0 (basic), version 2.
+		Append32(descriptor, 0);
+		Append32(descriptor, 2 | (descriptorBlockSize << 16));
+		Append32(descriptor, model | (KHR_DF_PRIMARIES_BT709 << 8) | ((IsSRGB(format) ? KHR_DF_TRANSFER_SRGB : KHR_DF_TRANSFER_LINEAR) << 16));
+
+		//Dimensions of a texel block minus one and the bytes of a block in the first plane.
+		Append32(descriptor, isBlockCompressed ? (3 | (3 << 8)) : 0);
+		Append32(descriptor, blockSize);
+		Append32(descriptor, 0);
+
+		for (const DataFormatSample& sample : samples)
+		{
+			//Alpha is never sRGB encoded, which the descriptor says by marking it linear.
+			uint32_t channelType = sample.Channel;
+			if (IsSRGB(format) && sample.Channel == KHR_DF_CHANNEL_ALPHA)
+				channelType |= KHR_DF_SAMPLE_DATATYPE_LINEAR;
+
+			Append32(descriptor, sample.BitOffset | ((sample.BitLength - 1) << 16) | (channelType << 24));
+			Append32(descriptor, 0);
+			Append32(descriptor, 0);
+			Append32(descriptor, sample.Upper);
+		}
+
+		return descriptor;
+	}
+}
+
+Ktx2Texture::Ktx2Texture():
+	m_Format(VK_FORMAT_UNDEFINED),
+	m_Width(0),
+	m_Height(0)
+{
+}
+
+bool Ktx2Texture::Load(const std::string& path)
+{
+	Close();
+
+	if (!m_MappedFile.Open(path))
+		return false;
+
+	const uint8_t* pData = m_MappedFile.GetData();
+	const size_t fileSize = m_MappedFile.GetSize();
+
+	//A broken cooked texture isn't fatal, the caller falls back to the source image, like a stale mesh cache gets rebuilt.
+	const auto fail = [&](const std::string& reason)
+	{
+		std::cerr << "cooked texture: discarding " << path << " (" << reason << ")" << std::endl;
+		Close();
+		return false;
+	};
+
+	if (fileSize < HEADER_SIZE || memcmp(pData, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) != 0)
+		return fail("not a KTX2 file");
+
+	m_Format = static_cast<VkFormat>(Read32(pData + 12));
+	m_Width = Read32(pData + 20);
+	m_Height = Read32(pData + 24);
+
+	const uint32_t pixelDepth = Read32(pData + 28);
+	const uint32_t layerCount = Read32(pData + 32);
+	const uint32_t faceCount = Read32(pData + 36);
+	const uint32_t levelCount = Read32(pData + 40);
+	const uint32_t supercompressionScheme = Read32(pData + 44);
+
+	if (GetBlockSize(m_Format) == 0)
+		return fail("unsupported format " + std::to_string(m_Format));
+	if (m_Width == 0 || m_Height == 0 || pixelDepth != 0 || layerCount > 1 || faceCount != 1)
+		return fail("only 2D textures without layers or faces are supported");
+	if (supercompressionScheme != 0)
+		return fail("supercompression isn't supported");
+
+	//A level count of 0 asks the loader to generate the mips, the cooker always stores them.
+	if (levelCount == 0 || levelCount > 32 || fileSize < HEADER_SIZE + levelCount * LEVEL_INDEX_ENTRY_SIZE)
+		return fail("invalid level count");
+
+	for (uint32_t level = 0; level < levelCount; ++level)
+	{
+		const uint8_t* pEntry = pData + HEADER_SIZE + level * LEVEL_INDEX_ENTRY_SIZE;
+
+		Level entry = {};
+		entry.Offset = Read64(pEntry);
+		entry.Size = Read64(pEntry + 8);
+		m_Levels.push_back(entry);
+
+		if (entry.Size != GetLevelByteSize(m_Format, GetLevelWidth(level), GetLevelHeight(level)))
+			return fail("level " + std::to_string(level) + " has the wrong size");
+		if (entry.Offset > fileSize || entry.Size > fileSize - entry.Offset)
+			return fail("file is truncated");
+	}
+
+	return true;
+}
+
+void Ktx2Texture::Close()
+{
+	m_MappedFile.Close();
+	m_Format = VK_FORMAT_UNDEFINED;
+	m_Width = 0;
+	m_Height = 0;
+	m_Levels.clear();
+}
+
+void Ktx2Texture::Write(const std::string& path, VkFormat format, uint32_t width, uint32_t height, const std::vector<std::vector<uint8_t>>& levels)
+{
+	const uint32_t blockSize = GetBlockSize(format);
+	if (blockSize == 0)
+		throw std::runtime_error("can't write KTX2 files with format " + std::to_string(format) + "!");
+
+	for (size_t level = 0; level < levels.size(); ++level)
+	{
+		const uint32_t levelWidth = std::max(width >> level, 1u);
+		const uint32_t levelHeight = std::max(height >> level, 1u);
+		if (levels[level].size() != GetLevelByteSize(format, levelWidth, levelHeight))
+			throw std::runtime_error("mip level " + std::to_string(level) + " for " + path + " has the wrong size!");
+	}
+
+	const uint32_t levelCount = static_cast<uint32_t>(levels.size());
+	const std::vector<uint8_t> descriptor = CreateDataFormatDescriptor(format);
+	const uint32_t descriptorOffset = static_cast<uint32_t>(HEADER_SIZE + levelCount * LEVEL_INDEX_ENTRY_SIZE);
+
+	//The levels are stored from the smallest to the largest, so a loader that streams the file can show something early.
+	//Each level starts at a multiple of the block size and of 4.
+	const uint64_t alignment = std::max(blockSize, 4u);
+	std::vector<uint64_t> offsets(levelCount);
+
+	uint64_t offset = descriptorOffset + descriptor.size();
+	for (uint32_t level = levelCount; level-- > 0;)
+	{
+		offset = (offset + alignment - 1) / alignment * alignment;
+		offsets[level] = offset;
+		offset += levels[level].size();
+	}
+
+	std::vector<uint8_t> header(KTX2_IDENTIFIER, KTX2_IDENTIFIER + sizeof(KTX2_IDENTIFIER));
+	Append32(header, static_cast<uint32_t>(format));
+	Append32(header, 1); //typeSize, 1 for block compressed and 8 bit formats
+	Append32(header, width);
+	Append32(header, height);
+	Append32(header, 0); //pixelDepth
+	Append32(header, 0); //layerCount
+	Append32(header, 1); //faceCount
+	Append32(header, levelCount);
+	Append32(header, 0); //supercompressionScheme
+
+	Append32(header, descriptorOffset);
+	Append32(header, static_cast<uint32_t>(descriptor.size()));
+	Append32(header, 0); //no key/value data
+	Append32(header, 0);
+	Append64(header, 0); //no supercompression global data
+	Append64(header, 0);
+
+	for (uint32_t level = 0; level < levelCount; ++level)
+	{
+		Append64(header, offsets[level]);
+		Append64(header, levels[level].size());
+		Append64(header, levels[level].size());
+	}
+
+	header.insert(header.end(), descriptor.begin(), descriptor.end());
+
+	//Same as the mesh cache: write a temporary file and move it over the old one once it's complete.
+	const std::string tempPath = path + ".tmp";
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		file.write(reinterpret_cast<const char*>(header.data()), header.size());
+
+		uint64_t position = header.size();
+		for (uint32_t level = levelCount; level-- > 0;)
+		{
+			const std::vector<char> padding(static_cast<size_t>(offsets[level] - position), 0);
+			file.write(padding.data(), padding.size());
+			file.write(reinterpret_cast<const char*>(levels[level].data()), levels[level].size());
+			position = offsets[level] + levels[level].size();
+		}
+
+		file.flush();
+		if (!file)
+			throw std::runtime_error("failed to write " + tempPath + "!");
+	}
+
+	if (!AtomicReplaceFile(tempPath, path))
+	{
+		std::remove(tempPath.c_str());
+		throw std::runtime_error("failed to replace " + path + "!");
+	}
+}
+
+uint32_t Ktx2Texture::GetLevelWidth(uint32_t level) const
+{
+	return std::max(m_Width >> level, 1u);
+}
+
+uint32_t Ktx2Texture::GetLevelHeight(uint32_t level) const
+{
+	return std::max(m_Height >> level, 1u);
+}
+
+uint32_t Ktx2Texture::GetBlockSize(VkFormat format)
+{
+	switch (format)
+	{
+	case VK_FORMAT_R8G8B8A8_UNORM:
+	case VK_FORMAT_R8G8B8A8_SRGB:
+		return 4;
+	case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+	case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+		return 8;
+	case VK_FORMAT_BC3_UNORM_BLOCK:
+	case VK_FORMAT_BC3_SRGB_BLOCK:
+	case VK_FORMAT_BC7_UNORM_BLOCK:
+	case VK_FORMAT_BC7_SRGB_BLOCK:
+		return 16;
+	default:
+		return 0;
+	}
+}
+
+bool Ktx2Texture::IsBlockCompressed(VkFormat format)
+{
+	return GetBlockSize(format) != 0 && format != VK_FORMAT_R8G8B8A8_UNORM && format != VK_FORMAT_R8G8B8A8_SRGB;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#ifndef GLFW_INCLUDE_VULKAN
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+#endif
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+#include "MappedFile.h"
+
+//A 2D texture in a KTX2 container (https://github.khronos.org/KTX-Specification/), with its whole mip chain.
+//The file stores the VkFormat and the bytes of every level exactly as vkCmdCopyBufferToImage expects them,
+//so loading one is a memory mapping and handing out pointers into it, there's nothing to decode.
+//Only what the cooker writes is supported: one layer, one face, no supercompression.
+class Ktx2Texture
+{
+public:
+	Ktx2Texture();
+
+	//Returns false if the file doesn't exist or isn't a KTX2 file we can load, the reason for the latter is logged.
+	bool Load(const std::string& path);
+	void Close();
+
+	//levels[0] is the full resolution image, every next level is half the size of the one before, rounded down.
+	static void Write(const std::string& path, VkFormat format, uint32_t width, uint32_t height, const std::vector<std::vector<uint8_t>>& levels);
+
+	VkFormat GetFormat() const { return m_Format; }
+	uint32_t GetWidth() const { return m_Width; }
+	uint32_t GetHeight() const { return m_Height; }
+	uint32_t GetLevelCount() const { return static_cast<uint32_t>(m_Levels.size()); }
+
+	uint32_t GetLevelWidth(uint32_t level) const;
+	uint32_t GetLevelHeight(uint32_t level) const;
+	const uint8_t* GetLevelData(uint32_t level) const { return m_MappedFile.GetData() + m_Levels[level].Offset; }
+	uint64_t GetLevelSize(uint32_t level) const { return m_Levels[level].Size; }
+
+	//Size in bytes of a 4x4 block for block compressed formats, of a texel for the others. 0 if the format isn't supported.
+	static uint32_t GetBlockSize(VkFormat format);
+	static bool IsBlockCompressed(VkFormat format);
+
+private:
+	struct Level
+	{
+		uint64_t Offset;
+		uint64_t Size;
+	};
+
+	MappedFile m_MappedFile;
+	VkFormat m_Format;
+	uint32_t m_Width;
+	uint32_t m_Height;
+	std::vector<Level> m_Levels;
+};
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+
+//Maps a whole file read-only into the address space of the process.
+//The operating system pages the file in on first access and shares the pages with its file cache,
+//so reading a large file this way costs no copy and no allocation up front.
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	//Returns false if the file doesn't exist or can't be mapped, an empty file can't be mapped either.
+	bool Open(const std::string& path);
+	void Close();
+
+	bool IsOpen() const { return m_pData != nullptr; }
+	const uint8_t* GetData() const { return m_pData; }
+	size_t GetSize() const { return m_Size; }
+
+private:
+	const uint8_t* m_pData;
+	size_t m_Size;
+
+#ifdef _WIN32
+	void* m_File;
+	void* m_Mapping;
+#endif
+};
@@ -0,0 +1,313 @@
+#include "Mesh.h"
+
+#include "HelperMethods.h"
+#include "MeshOptimizer.h"
+
+#include <fstream>
+#include <iostream>
+#include <chrono>
+#include <cstring>
+#include <cstdio>
+#include <algorithm>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+namespace
+{
+	const char MESH_CACHE_MAGIC[4] = { 'M', 'E', 'S', 'H' };
+
+	//Bump this whenever the layout of the file or the way LoadModel builds the mesh changes,
+	//so caches written by an older build are thrown away instead of misread.
+	const uint32_t MESH_CACHE_VERSION = 4;
+
+	//The file is this header followed by VertexCount vertices and IndexCount indices, without any padding.
+	//Every member is a multiple of 4 bytes, so the vertex and index arrays in the mapping are properly aligned.
+	struct MeshCacheHeader
+	{
+		char Magic[4];
+		uint32_t Version;
+		uint32_t VertexSize;
+		uint32_t VertexCount;
+		uint32_t IndexCount;
+		uint32_t Format;
+
+		//Describes the OBJ the cache was made from. If the size and modification time still match, the cache is used
+		//without reading the OBJ at all. If they don't, the file may only have been touched (by a checkout for example),
+		//so we hash its contents and only rebuild the cache when the hash differs.
+		uint64_t SourceSize;
+		int64_t SourceTimestamp;
+		uint64_t SourceHash;
+
+		//The bounding box of the positions, only used by packed vertices.
+		float BoundsMin[3];
+		float BoundsExtent[3];
+	};
+
+	struct SourceInfo
+	{
+		uint64_t Size;
+		int64_t Timestamp;
+	};
+
+	bool GetSourceInfo(const std::string& path, SourceInfo& info)
+	{
+		struct stat fileStat;
+		if (stat(path.c_str(), &fileStat) != 0)
+			return false;
+
+		info.Size = static_cast<uint64_t>(fileStat.st_size);
+		info.Timestamp = static_cast<int64_t>(fileStat.st_mtime);
+		return true;
+	}
+
+	//64 bit FNV-1a. Not meant to withstand an attacker, only to notice that a file changed.
+	uint64_t HashFile(const std::string& path)
+	{
+		std::vector<char> data = ReadFile(path);
+
+		uint64_t hash = 14695981039346656037ull;
+		for (char c : data)
+		{
+			hash ^= static_cast<uint8_t>(c);
+			hash *= 1099511628211ull;
+		}
+
+		return hash;
+	}
+}
+
+Mesh::Mesh():
+	m_Format(VertexFormat::Float),
+	m_pVertexData(nullptr),
+	m_pIndices(nullptr),
+	m_VertexCount(0),
+	m_IndexCount(0),
+	m_BoundsMin(0.0f),
+	m_BoundsExtent(1.0f)
+{
+}
+
+void Mesh::Load(const std::string& objPath, const std::string& cachePath, VertexFormat format)
+{
+	auto startTime = std::chrono::high_resolution_clock::now();
+
+	m_Format = format;
+	m_Vertices.clear();
+	m_PackedVertices.clear();
+	m_Indices.clear();
+
+	if (MapCache(objPath, cachePath))
+	{
+		auto now = std::chrono::high_resolution_clock::now();
+		std::cout << "mesh cache: mapped " << cachePath << " in " << std::chrono::duration<float, std::milli>(now - startTime).count() << " ms, "
+			<< GetVertexDataSize() << " bytes of vertices" << std::endl;
+		return;
+	}
+
+	LoadModel(m_Vertices, m_Indices, objPath);
+
+	//Indices come out of the OBJ in face order. Optimizing is too slow to do on every start,
+	//but the result goes into the cache, so it only happens when the cache is rebuilt.
+	MeshOptimizer().Optimize(m_Vertices, m_Indices);
+
+	if (m_Format == VertexFormat::Packed)
+	{
+		PackVertices(m_Vertices);
+		m_Vertices.clear();
+		m_pVertexData = m_PackedVertices.data();
+	}
+	else
+		m_pVertexData = m_Vertices.data();
+
+	m_pIndices = m_Indices.data();
+	m_VertexCount = static_cast<uint32_t>(m_Format == VertexFormat::Packed ? m_PackedVertices.size() : m_Vertices.size());
+	m_IndexCount = static_cast<uint32_t>(m_Indices.size());
+
+	auto now = std::chrono::high_resolution_clock::now();
+	std::cout << "mesh cache: built " << objPath << " in " << std::chrono::duration<float, std::milli>(now - startTime).count() << " ms, "
+		<< GetVertexDataSize() << " bytes of vertices" << std::endl;
+
+	//Failing to write the cache only costs us time on the next run, so it is not an error.
+	WriteCache(objPath, cachePath);
+}
+
+bool Mesh::MapCache(const std::string& objPath, const std::string& cachePath)
+{
+	if (!m_MappedFile.Open(cachePath))
+		return false;
+
+	MeshCacheHeader header;
+	std::string reason;
+
+	if (m_MappedFile.GetSize() < sizeof(header))
+		reason = "file is too small";
+	else
+	{
+		memcpy(&header, m_MappedFile.GetData(), sizeof(header));
+
+		const uint64_t expectedSize = sizeof(header) + uint64_t(header.VertexCount) * GetVertexStride() + uint64_t(header.IndexCount) * sizeof(uint32_t);
+
+		SourceInfo source = {};
+		const bool hasSource = GetSourceInfo(objPath, source);
+
+		if (memcmp(header.Magic, MESH_CACHE_MAGIC, sizeof(MESH_CACHE_MAGIC)) != 0)
+			reason = "not a mesh cache";
+		else if (header.Version != MESH_CACHE_VERSION || header.VertexSize != GetVertexStride())
+			reason = "written by another version";
+		else if (header.Format != static_cast<uint32_t>(m_Format))
+			reason = "different vertex format";
+		else if (m_MappedFile.GetSize() != expectedSize)
+			reason = "file is truncated";
+		//Without the OBJ there is nothing to compare with, but the cache is all we need to draw the mesh.
+		else if (hasSource && (source.Size != header.SourceSize || source.Timestamp != header.SourceTimestamp))
+		{
+			if (source.Size != header.SourceSize || HashFile(objPath) != header.SourceHash)
+				reason = objPath + " changed";
+		}
+	}
+
+	if (!reason.empty())
+	{
+		std::cout << "mesh cache: discarding " << cachePath << " (" << reason << ")" << std::endl;
+		m_MappedFile.Close();
+		return false;
+	}
+
+	m_pVertexData = m_MappedFile.GetData() + sizeof(header);
+	m_pIndices = reinterpret_cast<const uint32_t*>(m_MappedFile.GetData() + sizeof(header) + header.VertexCount * GetVertexStride());
+	m_VertexCount = header.VertexCount;
+	m_IndexCount = header.IndexCount;
+	m_BoundsMin = glm::vec3(header.BoundsMin[0], header.BoundsMin[1], header.BoundsMin[2]);
+	m_BoundsExtent = glm::vec3(header.BoundsExtent[0], header.BoundsExtent[1], header.BoundsExtent[2]);
+	return true;
+}
+
+void Mesh::WriteCache(const std::string& objPath, const std::string& cachePath) const
+{
+	SourceInfo source = {};
+	if (!GetSourceInfo(objPath, source))
+		return;
+
+	MeshCacheHeader header = {};
+	memcpy(header.Magic, MESH_CACHE_MAGIC, sizeof(MESH_CACHE_MAGIC));
+	header.Version = MESH_CACHE_VERSION;
+	header.VertexSize = GetVertexStride();
+	header.Format = static_cast<uint32_t>(m_Format);
+	header.VertexCount = m_VertexCount;
+	header.IndexCount = m_IndexCount;
+	header.SourceSize = source.Size;
+	header.SourceTimestamp = source.Timestamp;
+	header.SourceHash = HashFile(objPath);
+
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		header.BoundsMin[axis] = m_BoundsMin[axis];
+		header.BoundsExtent[axis] = m_BoundsExtent[axis];
+	}
+
+	//Same as the pipeline cache: write a temporary file and move it over the old cache once it's complete.
+	const std::string tempPath = cachePath + ".tmp";
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(static_cast<const char*>(m_pVertexData), GetVertexDataSize());
+		file.write(reinterpret_cast<const char*>(m_pIndices), m_IndexCount * sizeof(uint32_t));
+		file.flush();
+
+		if (!file)
+		{
+			std::cerr << "mesh cache: failed to write " << tempPath << std::endl;
+			return;
+		}
+	}
+
+	if (!AtomicReplaceFile(tempPath, cachePath))
+	{
+		std::cerr << "mesh cache: failed to replace " << cachePath << std::endl;
+		std::remove(tempPath.c_str());
+		return;
+	}
+
+	std::cout << "mesh cache: wrote " << cachePath << std::endl;
+}
+
+uint32_t Mesh::GetVertexStride() const
+{
+	return m_Format == VertexFormat::Packed ? sizeof(PackedVertex) : sizeof(Vertex);
+}
+
+glm::mat4 Mesh::GetPositionTransform() const
+{
+	//The vertex input stage turns a unorm16 position into [0, 1] on every axis,
+	//scaling by the extent and offsetting by the minimum gives back the original position.
+	if (m_Format != VertexFormat::Packed)
+		return glm::mat4(1.0f);
+
+	return glm::scale(glm::translate(glm::mat4(1.0f), m_BoundsMin), m_BoundsExtent);
+}
+
+float Mesh::GetBoundingRadius() const
+{
+	float radius = 0.0f;
+
+	if (m_Format == VertexFormat::Packed)
+	{
+		for (uint32_t corner = 0; corner < 8; ++corner)
+		{
+			const glm::vec3 offset((corner & 1) ? 1.0f : 0.0f, (corner & 2) ? 1.0f : 0.0f, (corner & 4) ? 1.0f : 0.0f);
+			radius = std::max(radius, glm::length(m_BoundsMin + offset * m_BoundsExtent));
+		}
+
+		return radius;
+	}
+
+	const Vertex* pVertices = static_cast<const Vertex*>(m_pVertexData);
+	for (uint32_t i = 0; i < m_VertexCount; ++i)
+		radius = std::max(radius, glm::length(pVertices[i].Position));
+
+	return radius;
+}
+
+void Mesh::PackVertices(const std::vector<Vertex>& vertices)
+{
+	glm::vec3 boundsMax(0.0f);
+	m_BoundsMin = glm::vec3(0.0f);
+
+	if (!vertices.empty())
+	{
+		m_BoundsMin = vertices[0].Position;
+		boundsMax = vertices[0].Position;
+	}
+
+	for (const Vertex& vertex : vertices)
+	{
+		m_BoundsMin = glm::min(m_BoundsMin, vertex.Position);
+		boundsMax = glm::max(boundsMax, vertex.Position);
+	}
+
+	//A flat mesh has no extent along one of the axes, any scale maps that axis onto itself.
+	m_BoundsExtent = boundsMax - m_BoundsMin;
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		if (m_BoundsExtent[axis] <= 0.0f)
+			m_BoundsExtent[axis] = 1.0f;
+	}
+
+	float maxError = 0.0f;
+
+	m_PackedVertices.clear();
+	m_PackedVertices.reserve(vertices.size());
+	for (const Vertex& vertex : vertices)
+	{
+		m_PackedVertices.push_back(PackedVertex::Pack(vertex, m_BoundsMin, m_BoundsExtent));
+
+		const uint16_t* pPosition = m_PackedVertices.back().Position;
+		const glm::vec3 unpacked = m_BoundsMin + glm::vec3(pPosition[0], pPosition[1], pPosition[2]) / 65535.0f * m_BoundsExtent;
+		const glm::vec3 error = glm::abs(unpacked - vertex.Position);
+		maxError = std::max(maxError, std::max(error.x, std::max(error.y, error.z)));
+	}
+
+	std::cout << "mesh cache: packed " << vertices.size() << " vertices from " << sizeof(Vertex) << " to " << sizeof(PackedVertex)
+		<< " bytes, largest position error " << maxError << std::endl;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <vector>
+#include <string>
+
+#include "../Vulkan/Vertex.h"
+#include "MappedFile.h"
+
+//The deduplicated vertices of a model and the indices into them, ready to be copied into a vertex and index buffer.
+//Parsing an OBJ is slow, so the result is stored in a binary cache file next to it. Later runs memory map
+//the cache and hand out pointers straight into the mapping, there is no per vertex work left to do at all.
+class Mesh
+{
+public:
+	Mesh();
+
+	//Maps cachePath if it was written from the current contents of objPath in the requested format.
+	//Otherwise objPath is parsed with LoadModel, optimized with the MeshOptimizer, packed if needed
+	//and the cache is (re)written for next time.
+	void Load(const std::string& objPath, const std::string& cachePath, VertexFormat format = VertexFormat::Float);
+
+	//Vertex or PackedVertex, depending on GetFormat.
+	const void* GetVertexData() const { return m_pVertexData; }
+	size_t GetVertexDataSize() const { return m_VertexCount * GetVertexStride(); }
+	uint32_t GetVertexStride() const;
+
+	const uint32_t* GetIndices() const { return m_pIndices; }
+	uint32_t GetVertexCount() const { return m_VertexCount; }
+	uint32_t GetIndexCount() const { return m_IndexCount; }
+	VertexFormat GetFormat() const { return m_Format; }
+
+	//Maps the positions as the vertex shader receives them to model space: identity for float vertices,
+	//the bounding box of the mesh for packed ones. Apply it before the model matrix.
+	glm::mat4 GetPositionTransform() const;
+
+	//Radius of a sphere around the model space origin that contains the whole mesh, after GetPositionTransform.
+	//For packed vertices it contains the bounding box, which is slightly larger than the mesh.
+	float GetBoundingRadius() const;
+
+	//Whether the last Load came from the cache.
+	bool IsFromCache() const { return m_MappedFile.IsOpen(); }
+
+private:
+	bool MapCache(const std::string& objPath, const std::string& cachePath);
+	void WriteCache(const std::string& objPath, const std::string& cachePath) const;
+
+	void PackVertices(const std::vector<Vertex>& vertices);
+
+private:
+	//Only one of these holds the data: the mapping on a cache hit, the vectors when the OBJ was parsed.
+	MappedFile m_MappedFile;
+	std::vector<Vertex> m_Vertices;
+	std::vector<PackedVertex> m_PackedVertices;
+	std::vector<uint32_t> m_Indices;
+
+	VertexFormat m_Format;
+	const void* m_pVertexData;
+	const uint32_t* m_pIndices;
+	uint32_t m_VertexCount;
+	uint32_t m_IndexCount;
+
+	//The bounding box packed positions are relative to.
+	glm::vec3 m_BoundsMin;
+	glm::vec3 m_BoundsExtent;
+};
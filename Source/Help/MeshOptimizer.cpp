@@ -0,0 +1,363 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <iostream>
+#include <chrono>
+
+namespace
+{
+	const uint32_t INVALID_INDEX = UINT32_MAX;
+
+	//A FIFO cache like the post-transform cache of older GPUs. A vertex is in the cache
+	//if it was inserted less than cacheSize insertions ago, so only a timestamp per vertex is needed.
+	class FifoCache
+	{
+	public:
+		FifoCache(size_t vertexCount, uint32_t cacheSize):
+			m_Timestamps(vertexCount, 0),
+			m_Time(cacheSize + 1),
+			m_CacheSize(cacheSize)
+		{
+		}
+
+		//Returns true on a miss.
+		bool Access(uint32_t vertex)
+		{
+			if (m_Time - m_Timestamps[vertex] <= m_CacheSize)
+				return false;
+
+			m_Timestamps[vertex] = m_Time++;
+			return true;
+		}
+
+		void Clear()
+		{
+			//Moving the clock forward by a whole cache evicts everything without touching the timestamps.
+			m_Time += m_CacheSize + 1;
+		}
+
+	private:
+		std::vector<uint64_t> m_Timestamps;
+		uint64_t m_Time;
+		uint32_t m_CacheSize;
+	};
+
+	uint32_t CountMisses(const std::vector<uint32_t>& indices, size_t first, size_t last, FifoCache& cache)
+	{
+		uint32_t misses = 0;
+		for (size_t i = first; i < last; ++i)
+			misses += cache.Access(indices[i]) ? 1 : 0;
+
+		return misses;
+	}
+
+	void PrintStatistics(const char* label, const VertexCacheStatistics& statistics)
+	{
+		std::cout << "mesh optimizer: " << label << " ACMR " << statistics.ACMR << ", ATVR " << statistics.ATVR << std::endl;
+	}
+}
+
+VertexCacheStatistics AnalyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize)
+{
+	VertexCacheStatistics statistics;
+	if (indices.empty())
+		return statistics;
+
+	FifoCache cache(vertexCount, cacheSize);
+	const uint32_t misses = CountMisses(indices, 0, indices.size(), cache);
+
+	std::vector<bool> isUsed(vertexCount, false);
+	for (uint32_t index : indices)
+		isUsed[index] = true;
+
+	const size_t usedVertexCount = std::count(isUsed.begin(), isUsed.end(), true);
+
+	statistics.ACMR = static_cast<float>(misses) / (indices.size() / 3);
+	statistics.ATVR = static_cast<float>(misses) / usedVertexCount;
+	return statistics;
+}
+
+MeshOptimizer::MeshOptimizer(uint32_t cacheSize, float overdrawThreshold):
+	m_CacheSize(cacheSize),
+	m_OverdrawThreshold(overdrawThreshold)
+{
+}
+
+void MeshOptimizer::Optimize(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) const
+{
+	auto startTime = std::chrono::high_resolution_clock::now();
+	PrintStatistics("before", AnalyzeVertexCache(indices, vertices.size(), m_CacheSize));
+
+	const std::vector<uint32_t> clusters = OptimizeVertexCache(indices, vertices.size());
+	PrintStatistics("vertex cache", AnalyzeVertexCache(indices, vertices.size(), m_CacheSize));
+
+	OptimizeOverdraw(indices, vertices, SplitClusters(indices, vertices.size(), clusters));
+	PrintStatistics("overdraw", AnalyzeVertexCache(indices, vertices.size(), m_CacheSize));
+
+	//Only the numbering of the vertices changes here, so the ACMR and ATVR stay the same.
+	OptimizeVertexFetch(vertices, indices);
+
+	auto now = std::chrono::high_resolution_clock::now();
+	std::cout << "mesh optimizer: done in " << std::chrono::duration<float, std::milli>(now - startTime).count() << " ms" << std::endl;
+}
+
+std::vector<uint32_t> MeshOptimizer::OptimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount) const
+{
+	const size_t triangleCount = indices.size() / 3;
+
+	//Adjacency: the triangles that use each vertex, stored back to back with an offset per vertex.
+	std::vector<uint32_t> liveTriangles(vertexCount, 0);
+	for (uint32_t index : indices)
+		++liveTriangles[index];
+
+	std::vector<uint32_t> offsets(vertexCount + 1, 0);
+	for (size_t vertex = 0; vertex < vertexCount; ++vertex)
+		offsets[vertex + 1] = offsets[vertex] + liveTriangles[vertex];
+
+	std::vector<uint32_t> adjacency(indices.size());
+	std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+	for (size_t i = 0; i < indices.size(); ++i)
+		adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+
+	std::vector<uint64_t> timestamps(vertexCount, 0);
+	std::vector<bool> isEmitted(triangleCount, false);
+	std::vector<uint32_t> deadEnds;
+	std::vector<uint32_t> candidates;
+
+	std::vector<uint32_t> output;
+	output.reserve(indices.size());
+
+	std::vector<uint32_t> clusters;
+
+	uint64_t time = m_CacheSize + 1;
+	uint32_t cursor = 0;
+	uint32_t fanningVertex = vertexCount > 0 ? 0 : INVALID_INDEX;
+
+	//Dead end: none of the candidates has triangles left, so pick a vertex that was used recently
+	//or otherwise the next vertex in input order that still has triangles.
+	auto skipDeadEnd = [&]() -> uint32_t
+	{
+		while (!deadEnds.empty())
+		{
+			const uint32_t vertex = deadEnds.back();
+			deadEnds.pop_back();
+
+			if (liveTriangles[vertex] > 0)
+				return vertex;
+		}
+
+		for (; cursor < vertexCount; ++cursor)
+		{
+			if (liveTriangles[cursor] > 0)
+				return cursor;
+		}
+
+		return INVALID_INDEX;
+	};
+
+	if (triangleCount > 0)
+		clusters.push_back(0);
+
+	while (fanningVertex != INVALID_INDEX)
+	{
+		//Emit every triangle around the fanning vertex that wasn't emitted yet.
+		candidates.clear();
+		for (uint32_t i = offsets[fanningVertex]; i < offsets[fanningVertex + 1]; ++i)
+		{
+			const uint32_t triangle = adjacency[i];
+			if (isEmitted[triangle])
+				continue;
+
+			for (uint32_t corner = 0; corner < 3; ++corner)
+			{
+				const uint32_t vertex = indices[triangle * 3 + corner];
+
+				output.push_back(vertex);
+				deadEnds.push_back(vertex);
+				candidates.push_back(vertex);
+				--liveTriangles[vertex];
+
+				if (time - timestamps[vertex] > m_CacheSize)
+					timestamps[vertex] = time++;
+			}
+
+			isEmitted[triangle] = true;
+		}
+
+		//Continue with the candidate that will still be in the cache after its remaining triangles are emitted,
+		//preferring the one that entered the cache first. If there is none, the cluster ends here.
+		uint32_t nextVertex = INVALID_INDEX;
+		int64_t bestPriority = -1;
+
+		for (uint32_t vertex : candidates)
+		{
+			if (liveTriangles[vertex] == 0)
+				continue;
+
+			int64_t priority = 0;
+			const int64_t age = static_cast<int64_t>(time - timestamps[vertex]);
+			if (age + 2 * liveTriangles[vertex] <= m_CacheSize)
+				priority = age;
+
+			if (priority > bestPriority)
+			{
+				bestPriority = priority;
+				nextVertex = vertex;
+			}
+		}
+
+		if (nextVertex == INVALID_INDEX)
+		{
+			nextVertex = skipDeadEnd();
+
+			//Only a jump to a vertex that is no longer in the cache breaks the locality, that's where a cluster ends.
+			const uint32_t emittedTriangles = static_cast<uint32_t>(output.size() / 3);
+			if (nextVertex != INVALID_INDEX && time - timestamps[nextVertex] > m_CacheSize && emittedTriangles != clusters.back())
+				clusters.push_back(emittedTriangles);
+		}
+
+		fanningVertex = nextVertex;
+	}
+
+	indices.swap(output);
+	return clusters;
+}
+
+std::vector<uint32_t> MeshOptimizer::SplitClusters(const std::vector<uint32_t>& indices, size_t vertexCount, const std::vector<uint32_t>& clusters) const
+{
+	const uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+
+	FifoCache cache(vertexCount, m_CacheSize);
+	std::vector<uint32_t> result;
+
+	for (size_t cluster = 0; cluster < clusters.size(); ++cluster)
+	{
+		const uint32_t first = clusters[cluster];
+		const uint32_t last = cluster + 1 < clusters.size() ? clusters[cluster + 1] : triangleCount;
+
+		//The ACMR of the whole cluster, starting from an empty cache, is what the pieces are measured against.
+		cache.Clear();
+		const float clusterAcmr = static_cast<float>(CountMisses(indices, first * 3, last * 3, cache)) / (last - first);
+		const float threshold = clusterAcmr * m_OverdrawThreshold;
+
+		result.push_back(first);
+		cache.Clear();
+
+		uint32_t pieceStart = first;
+		uint32_t pieceMisses = 0;
+
+		for (uint32_t triangle = first; triangle < last; ++triangle)
+		{
+			pieceMisses += CountMisses(indices, triangle * 3, triangle * 3 + 3, cache);
+
+			//Once a piece is at least as good as the threshold, cut it off. The next piece starts cold,
+			//because after sorting we can't know which cluster will be drawn before it.
+			if (triangle + 1 < last && static_cast<float>(pieceMisses) / (triangle + 1 - pieceStart) <= threshold)
+			{
+				result.push_back(triangle + 1);
+				pieceStart = triangle + 1;
+				pieceMisses = 0;
+				cache.Clear();
+			}
+		}
+	}
+
+	return result;
+}
+
+void MeshOptimizer::OptimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& clusters) const
+{
+	const uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+	if (clusters.size() < 2)
+		return;
+
+	//The centroid of the mesh, weighted by triangle area so a densely tessellated area doesn't pull it towards itself.
+	glm::vec3 meshCentroid(0.0f);
+	float meshArea = 0.0f;
+
+	struct Cluster
+	{
+		uint32_t First;
+		uint32_t Last;
+		float SortKey;
+	};
+
+	std::vector<Cluster> sortedClusters(clusters.size());
+	std::vector<glm::vec3> clusterCentroids(clusters.size());
+	std::vector<glm::vec3> clusterNormals(clusters.size());
+
+	for (size_t cluster = 0; cluster < clusters.size(); ++cluster)
+	{
+		Cluster& info = sortedClusters[cluster];
+		info.First = clusters[cluster];
+		info.Last = cluster + 1 < clusters.size() ? clusters[cluster + 1] : triangleCount;
+
+		glm::vec3 centroid(0.0f);
+		glm::vec3 normal(0.0f);
+		float area = 0.0f;
+
+		for (uint32_t triangle = info.First; triangle < info.Last; ++triangle)
+		{
+			const glm::vec3& a = vertices[indices[triangle * 3 + 0]].Position;
+			const glm::vec3& b = vertices[indices[triangle * 3 + 1]].Position;
+			const glm::vec3& c = vertices[indices[triangle * 3 + 2]].Position;
+
+			//The length of the cross product is twice the area of the triangle, so summing them gives an area weighted normal.
+			const glm::vec3 cross = glm::cross(b - a, c - a);
+			const float triangleArea = glm::length(cross) * 0.5f;
+
+			centroid += (a + b + c) / 3.0f * triangleArea;
+			normal += cross;
+			area += triangleArea;
+		}
+
+		meshCentroid += centroid;
+		meshArea += area;
+
+		clusterCentroids[cluster] = area > 0.0f ? centroid / area : vertices[indices[info.First * 3]].Position;
+		clusterNormals[cluster] = normal;
+	}
+
+	if (meshArea > 0.0f)
+		meshCentroid /= meshArea;
+
+	//Clusters that sit far out and face outward are the most likely to occlude something, whatever the view direction.
+	for (size_t cluster = 0; cluster < clusters.size(); ++cluster)
+	{
+		const float normalLength = glm::length(clusterNormals[cluster]);
+		const glm::vec3 normal = normalLength > 0.0f ? clusterNormals[cluster] / normalLength : glm::vec3(0.0f);
+
+		sortedClusters[cluster].SortKey = glm::dot(clusterCentroids[cluster] - meshCentroid, normal);
+	}
+
+	std::stable_sort(sortedClusters.begin(), sortedClusters.end(), [](const Cluster& a, const Cluster& b) { return a.SortKey > b.SortKey; });
+
+	std::vector<uint32_t> output;
+	output.reserve(indices.size());
+
+	for (const Cluster& cluster : sortedClusters)
+		output.insert(output.end(), indices.begin() + cluster.First * 3, indices.begin() + cluster.Last * 3);
+
+	indices.swap(output);
+}
+
+void MeshOptimizer::OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) const
+{
+	std::vector<uint32_t> remap(vertices.size(), INVALID_INDEX);
+
+	std::vector<Vertex> output;
+	output.reserve(vertices.size());
+
+	for (uint32_t& index : indices)
+	{
+		if (remap[index] == INVALID_INDEX)
+		{
+			remap[index] = static_cast<uint32_t>(output.size());
+			output.push_back(vertices[index]);
+		}
+
+		index = remap[index];
+	}
+
+	vertices.swap(output);
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include "../Vulkan/Vertex.h"
+
+//How well an index buffer uses the post-transform vertex cache, simulated as a FIFO cache on the CPU.
+struct VertexCacheStatistics
+{
+	//Average cache miss ratio: transformed vertices per triangle. 3 is the worst case, 0.5 the best possible for large grids.
+	float ACMR = 0.0f;
+
+	//Average transform to vertex ratio: transformed vertices per unique vertex. 1 is ideal.
+	float ATVR = 0.0f;
+};
+
+VertexCacheStatistics AnalyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize);
+
+//Optimizes the triangle order of an indexed triangle list in three steps:
+//Tipsify reorders the triangles for the vertex cache, the clusters it produces are then sorted to reduce overdraw,
+//and finally the vertices are reordered in the order of first use, so vertex fetches walk through memory linearly.
+class MeshOptimizer
+{
+public:
+	//cacheSize is the size of the vertex cache that is optimized for.
+	//overdrawThreshold is how much worse than the Tipsify order the ACMR of an overdraw cluster may get, 1.05 allows 5%.
+	MeshOptimizer(uint32_t cacheSize = 16, float overdrawThreshold = 1.05f);
+
+	//Runs all three steps and prints the statistics before and after.
+	void Optimize(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) const;
+
+	//Tipsify (Sander, Nehab and Barczak 2007). Returns the index of the first triangle of every cluster,
+	//a cluster ends wherever the fan had to jump to a vertex that wasn't in the cache anymore.
+	std::vector<uint32_t> OptimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount) const;
+
+	//Sorts the clusters so the ones facing away from the center of the mesh come first. Those are likely
+	//to be in front and occlude the rest, so fewer pixels are shaded only to be overwritten later.
+	void OptimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& clusters) const;
+
+	//Reorders the vertices in the order the index buffer first uses them and drops vertices it doesn't use.
+	void OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) const;
+
+private:
+	//Splits the Tipsify clusters further where the ACMR from the start of a piece, starting with an empty cache,
+	//drops below the threshold. More and smaller clusters give the overdraw sort more freedom.
+	std::vector<uint32_t> SplitClusters(const std::vector<uint32_t>& indices, size_t vertexCount, const std::vector<uint32_t>& clusters) const;
+
+private:
+	uint32_t m_CacheSize;
+	float m_OverdrawThreshold;
+};
@@ -0,0 +1,634 @@
+#include "MipGenerator.h"
+
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define MIP_GENERATOR_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+//MSVC lets any function use AVX2 intrinsics, the caller makes sure the CPU has them.
+#define MIP_TARGET_AVX2
+#else
+#define MIP_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace
+{
+	//Radius of the Kaiser filter in destination texels, and the alpha of its window. Larger alphas give less ringing
+	//but a blurrier result, 4 is the usual compromise.
+	const float KAISER_RADIUS = 1.5f;
+	const float KAISER_ALPHA = 4.0f;
+
+	//Destination rows per job. A job decodes every source row its rows need once, so larger bands waste less work
+	//on the rows two bands share but need more memory.
+	const uint32_t ROWS_PER_JOB = 16;
+
+	//Which source texels make up each destination texel along one axis, and how much each of them counts.
+	//Every destination texel has the same number of taps, unused ones have a weight of 0,
+	//so the kernels never have to branch on the tap count.
+	struct FilterTaps
+	{
+		uint32_t TapCount = 0;
+		std::vector<uint32_t> Indices;
+		std::vector<float> Weights;
+	};
+
+	float Sinc(float x)
+	{
+		if (std::fabs(x) < 1e-6f)
+			return 1.0f;
+
+		const float pix = 3.14159265f * x;
+		return std::sin(pix) / pix;
+	}
+
+	//Modified Bessel function of the first kind of order 0, the series converges quickly for the arguments we need.
+	float BesselI0(float x)
+	{
+		float sum = 1.0f;
+		float term = 1.0f;
+		for (int k = 1; k < 32; ++k)
+		{
+			term *= (x * 0.5f / k) * (x * 0.5f / k);
+			sum += term;
+		}
+
+		return sum;
+	}
+
+	float Kaiser(float t)
+	{
+		if (std::fabs(t) >= KAISER_RADIUS)
+			return 0.0f;
+
+		const float window = t / KAISER_RADIUS;
+		return Sinc(t) * BesselI0(KAISER_ALPHA * std::sqrt(1.0f - window * window)) / BesselI0(KAISER_ALPHA);
+	}
+
+	FilterTaps ComputeTaps(uint32_t srcSize, uint32_t dstSize, MipFilter filter)
+	{
+		//How many source texels one destination texel covers, 2 for even sizes and a bit more for odd ones.
+		const float scale = static_cast<float>(srcSize) / dstSize;
+		const float radius = filter == MipFilter::Box ? 0.5f * scale : KAISER_RADIUS * scale;
+
+		std::vector<std::vector<std::pair<uint32_t, float>>> taps(dstSize);
+		uint32_t tapCount = 0;
+
+		for (uint32_t x = 0; x < dstSize; ++x)
+		{
+			const float center = (x + 0.5f) * scale;
+			const int32_t first = static_cast<int32_t>(std::floor(center - radius));
+			const int32_t last = static_cast<int32_t>(std::ceil(center + radius));
+
+			float sum = 0.0f;
+			for (int32_t i = first; i < last; ++i)
+			{
+				float weight;
+				if (filter == MipFilter::Box)
+				{
+					//The part of source texel i that lies under the destination texel.
+					weight = std::min(i + 1.0f, center + radius) - std::max(static_cast<float>(i), center - radius);
+				}
+				else
+					weight = Kaiser((i + 0.5f - center) / scale);
+
+				if (weight == 0.0f || (filter == MipFilter::Box && weight < 0.0f))
+					continue;
+
+				//Texels past the edges repeat the edge texel.
+				const uint32_t index = static_cast<uint32_t>(std::min(std::max(i, 0), static_cast<int32_t>(srcSize) - 1));
+				taps[x].push_back(std::make_pair(index, weight));
+				sum += weight;
+			}
+
+			for (std::pair<uint32_t, float>& tap : taps[x])
+				tap.second /= sum;
+
+			tapCount = std::max(tapCount, static_cast<uint32_t>(taps[x].size()));
+		}
+
+		FilterTaps result;
+		result.TapCount = tapCount;
+		result.Indices.resize(size_t(dstSize) * tapCount);
+		result.Weights.resize(size_t(dstSize) * tapCount, 0.0f);
+
+		for (uint32_t x = 0; x < dstSize; ++x)
+		{
+			for (uint32_t tap = 0; tap < tapCount; ++tap)
+			{
+				const bool isUsed = tap < taps[x].size();
+				result.Indices[x * tapCount + tap] = isUsed ? taps[x][tap].first : taps[x][0].first;
+				result.Weights[x * tapCount + tap] = isUsed ? taps[x][tap].second : 0.0f;
+			}
+		}
+
+		return result;
+	}
+
+	float SRGBToLinear(float value)
+	{
+		return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+	}
+
+	float LinearToSRGB(float value)
+	{
+		return value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+	}
+
+	//8 bit value to linear float, for both color spaces, so decoding a row is one lookup per channel.
+	//Linear follows SRGB directly, so a single gather can look up sRGB color and linear alpha at once.
+	struct DecodeTable
+	{
+		float SRGB[256];
+		float Linear[256];
+
+		DecodeTable()
+		{
+			for (uint32_t i = 0; i < 256; ++i)
+			{
+				SRGB[i] = SRGBToLinear(i / 255.0f);
+				Linear[i] = i / 255.0f;
+			}
+		}
+	};
+
+	//Linear light quantized to 16 bits to the nearest 8 bit sRGB value. 16 bits are fine enough that even the darkest
+	//values, where sRGB is steepest, round to the right byte.
+	struct EncodeTable
+	{
+		static const uint32_t SIZE = 65536;
+		uint8_t SRGB[SIZE];
+
+		EncodeTable()
+		{
+			for (uint32_t i = 0; i < SIZE; ++i)
+				SRGB[i] = static_cast<uint8_t>(LinearToSRGB(i / float(SIZE - 1)) * 255.0f + 0.5f);
+		}
+	};
+
+	const DecodeTable& GetDecodeTable()
+	{
+		static const DecodeTable table;
+		return table;
+	}
+
+	const EncodeTable& GetEncodeTable()
+	{
+		static const EncodeTable table;
+		return table;
+	}
+
+	void DecodeScalar(const uint8_t* pSrc, uint32_t width, MipColorSpace colorSpace, float* pDst)
+	{
+		const DecodeTable& table = GetDecodeTable();
+		const float* pColorTable = colorSpace == MipColorSpace::SRGB ? table.SRGB : table.Linear;
+
+		for (uint32_t x = 0; x < width; ++x)
+		{
+			pDst[x * 4 + 0] = pColorTable[pSrc[x * 4 + 0]];
+			pDst[x * 4 + 1] = pColorTable[pSrc[x * 4 + 1]];
+			pDst[x * 4 + 2] = pColorTable[pSrc[x * 4 + 2]];
+			pDst[x * 4 + 3] = table.Linear[pSrc[x * 4 + 3]];
+		}
+	}
+
+	//The kernels. They all compute exactly the same sums in the same order, without fused multiply adds,
+	//so their results are identical and the benchmark can compare them bit for bit.
+	//	Decode: turns width RGBA8 texels into linear floats.
+	//	Vertical: pDst[i] = sum of pWeights[tap] * ppRows[tap][i], for count floats.
+	//	Horizontal: filters a row of decoded texels down to dstWidth texels with taps.
+	//	Encode: turns width linear RGBA texels back into bytes.
+	struct Kernels
+	{
+		void(*Decode)(const uint8_t* pSrc, uint32_t width, MipColorSpace colorSpace, float* pDst);
+		void(*Vertical)(const float* const* ppRows, const float* pWeights, uint32_t tapCount, uint32_t count, float* pDst);
+		void(*Horizontal)(const float* pSrc, const FilterTaps& taps, uint32_t dstWidth, float* pDst);
+		void(*Encode)(const float* pSrc, uint32_t width, MipColorSpace colorSpace, uint8_t* pDst);
+	};
+
+	void VerticalScalar(const float* const* ppRows, const float* pWeights, uint32_t tapCount, uint32_t count, float* pDst)
+	{
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			float sum = 0.0f;
+			for (uint32_t tap = 0; tap < tapCount; ++tap)
+				sum = sum + pWeights[tap] * ppRows[tap][i];
+			pDst[i] = sum;
+		}
+	}
+
+	void HorizontalScalar(const float* pSrc, const FilterTaps& taps, uint32_t dstWidth, float* pDst)
+	{
+		for (uint32_t x = 0; x < dstWidth; ++x)
+		{
+			const uint32_t* pIndices = &taps.Indices[x * taps.TapCount];
+			const float* pWeights = &taps.Weights[x * taps.TapCount];
+
+			for (uint32_t channel = 0; channel < 4; ++channel)
+			{
+				float sum = 0.0f;
+				for (uint32_t tap = 0; tap < taps.TapCount; ++tap)
+					sum = sum + pWeights[tap] * pSrc[pIndices[tap] * 4 + channel];
+				pDst[x * 4 + channel] = sum;
+			}
+		}
+	}
+
+	uint8_t EncodeTexel(const float* pSrc, uint32_t channel, MipColorSpace colorSpace)
+	{
+		const float value = std::min(std::max(pSrc[channel], 0.0f), 1.0f);
+
+		if (colorSpace == MipColorSpace::SRGB && channel < 3)
+			return GetEncodeTable().SRGB[static_cast<int32_t>(value * float(EncodeTable::SIZE - 1) + 0.5f)];
+
+		return static_cast<uint8_t>(static_cast<int32_t>(value * 255.0f + 0.5f));
+	}
+
+	void EncodeScalar(const float* pSrc, uint32_t width, MipColorSpace colorSpace, uint8_t* pDst)
+	{
+		for (uint32_t i = 0; i < width * 4; ++i)
+			pDst[i] = EncodeTexel(pSrc + (i & ~3u), i & 3, colorSpace);
+	}
+
+#ifdef MIP_GENERATOR_X86
+	//Linear values only need a conversion, 4 texels at a time. sRGB needs the table, which SSE2 can't index.
+	void DecodeSSE2(const uint8_t* pSrc, uint32_t width, MipColorSpace colorSpace, float* pDst)
+	{
+		if (colorSpace == MipColorSpace::SRGB)
+		{
+			DecodeScalar(pSrc, width, colorSpace, pDst);
+			return;
+		}
+
+		const __m128i zero = _mm_setzero_si128();
+		//Divide rather than multiply by 1 / 255, so the results match the table bit for bit.
+		const __m128 scale = _mm_set1_ps(255.0f);
+
+		uint32_t x = 0;
+		for (; x + 4 <= width; x += 4)
+		{
+			const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + x * 4));
+			const __m128i words = _mm_unpacklo_epi8(bytes, zero);
+			const __m128i words2 = _mm_unpackhi_epi8(bytes, zero);
+
+			_mm_storeu_ps(pDst + x * 4 + 0, _mm_div_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(words, zero)), scale));
+			_mm_storeu_ps(pDst + x * 4 + 4, _mm_div_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(words, zero)), scale));
+			_mm_storeu_ps(pDst + x * 4 + 8, _mm_div_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(words2, zero)), scale));
+			_mm_storeu_ps(pDst + x * 4 + 12, _mm_div_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(words2, zero)), scale));
+		}
+
+		DecodeScalar(pSrc + x * 4, width - x, colorSpace, pDst + x * 4);
+	}
+
+	void VerticalSSE2(const float* const* ppRows, const float* pWeights, uint32_t tapCount, uint32_t count, float* pDst)
+	{
+		uint32_t i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 sum = _mm_setzero_ps();
+			for (uint32_t tap = 0; tap < tapCount; ++tap)
+				sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(pWeights[tap]), _mm_loadu_ps(ppRows[tap] + i)));
+			_mm_storeu_ps(pDst + i, sum);
+		}
+
+		for (; i < count; ++i)
+		{
+			float sum = 0.0f;
+			for (uint32_t tap = 0; tap < tapCount; ++tap)
+				sum = sum + pWeights[tap] * ppRows[tap][i];
+			pDst[i] = sum;
+		}
+	}
+
+	//A texel is exactly one register, so every tap is one multiply and add for all 4 channels.
+	void HorizontalSSE2(const float* pSrc, const FilterTaps& taps, uint32_t dstWidth, float* pDst)
+	{
+		for (uint32_t x = 0; x < dstWidth; ++x)
+		{
+			const uint32_t* pIndices = &taps.Indices[x * taps.TapCount];
+			const float* pWeights = &taps.Weights[x * taps.TapCount];
+
+			__m128 sum = _mm_setzero_ps();
+			for (uint32_t tap = 0; tap < taps.TapCount; ++tap)
+				sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(pWeights[tap]), _mm_loadu_ps(pSrc + pIndices[tap] * 4)));
+			_mm_storeu_ps(pDst + x * 4, sum);
+		}
+	}
+
+	void EncodeSSE2(const float* pSrc, uint32_t width, MipColorSpace colorSpace, uint8_t* pDst)
+	{
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 half = _mm_set1_ps(0.5f);
+
+		if (colorSpace == MipColorSpace::Linear)
+		{
+			//4 texels at a time: 16 floats become 16 bytes with two saturating packs.
+			const __m128 scale = _mm_set1_ps(255.0f);
+
+			uint32_t x = 0;
+			for (; x + 4 <= width; x += 4)
+			{
+				__m128i values[4];
+				for (uint32_t texel = 0; texel < 4; ++texel)
+				{
+					const __m128 value = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(pSrc + (x + texel) * 4), zero), one);
+					values[texel] = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(value, scale), half));
+				}
+
+				const __m128i words = _mm_packs_epi32(values[0], values[1]);
+				const __m128i words2 = _mm_packs_epi32(values[2], values[3]);
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + x * 4), _mm_packus_epi16(words, words2));
+			}
+
+			EncodeScalar(pSrc + x * 4, width - x, colorSpace, pDst + x * 4);
+			return;
+		}
+
+		//Color goes through the encode table, so it's scaled to a table index, alpha is scaled to a byte like above.
+		const EncodeTable& table = GetEncodeTable();
+		const __m128 scale = _mm_setr_ps(float(EncodeTable::SIZE - 1), float(EncodeTable::SIZE - 1), float(EncodeTable::SIZE - 1), 255.0f);
+
+		for (uint32_t x = 0; x < width; ++x)
+		{
+			const __m128 value = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(pSrc + x * 4), zero), one);
+
+			alignas(16) int32_t indices[4];
+			_mm_store_si128(reinterpret_cast<__m128i*>(indices), _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(value, scale), half)));
+
+			pDst[x * 4 + 0] = table.SRGB[indices[0]];
+			pDst[x * 4 + 1] = table.SRGB[indices[1]];
+			pDst[x * 4 + 2] = table.SRGB[indices[2]];
+			pDst[x * 4 + 3] = static_cast<uint8_t>(indices[3]);
+		}
+	}
+
+	//Every byte becomes an index into the decode table: color into the table of the color space, alpha into the linear one.
+	//2 texels per gather.
+	MIP_TARGET_AVX2 void DecodeAVX2(const uint8_t* pSrc, uint32_t width, MipColorSpace colorSpace, float* pDst)
+	{
+		const DecodeTable& table = GetDecodeTable();
+		const __m256i tableOffsets = colorSpace == MipColorSpace::SRGB ? _mm256_setr_epi32(0, 0, 0, 256, 0, 0, 0, 256) : _mm256_set1_epi32(256);
+
+		uint32_t x = 0;
+		for (; x + 2 <= width; x += 2)
+		{
+			const __m256i bytes = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(pSrc + x * 4)));
+			_mm256_storeu_ps(pDst + x * 4, _mm256_i32gather_ps(table.SRGB, _mm256_add_epi32(bytes, tableOffsets), 4));
+		}
+
+		DecodeScalar(pSrc + x * 4, width - x, colorSpace, pDst + x * 4);
+	}
+
+	MIP_TARGET_AVX2 void VerticalAVX2(const float* const* ppRows, const float* pWeights, uint32_t tapCount, uint32_t count, float* pDst)
+	{
+		uint32_t i = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			__m256 sum = _mm256_setzero_ps();
+			for (uint32_t tap = 0; tap < tapCount; ++tap)
+				sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_set1_ps(pWeights[tap]), _mm256_loadu_ps(ppRows[tap] + i)));
+			_mm256_storeu_ps(pDst + i, sum);
+		}
+
+		for (; i < count; ++i)
+		{
+			float sum = 0.0f;
+			for (uint32_t tap = 0; tap < tapCount; ++tap)
+				sum = sum + pWeights[tap] * ppRows[tap][i];
+			pDst[i] = sum;
+		}
+	}
+
+	//Two destination texels per register: the low half works on texel x, the high half on texel x + 1.
+	MIP_TARGET_AVX2 void HorizontalAVX2(const float* pSrc, const FilterTaps& taps, uint32_t dstWidth, float* pDst)
+	{
+		uint32_t x = 0;
+		for (; x + 2 <= dstWidth; x += 2)
+		{
+			const uint32_t* pIndices = &taps.Indices[x * taps.TapCount];
+			const float* pWeights = &taps.Weights[x * taps.TapCount];
+
+			__m256 sum = _mm256_setzero_ps();
+			for (uint32_t tap = 0; tap < taps.TapCount; ++tap)
+			{
+				const __m256 texels = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(pSrc + pIndices[tap] * 4)),
+					_mm_loadu_ps(pSrc + pIndices[taps.TapCount + tap] * 4), 1);
+				const __m256 weights = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_set1_ps(pWeights[tap])),
+					_mm_set1_ps(pWeights[taps.TapCount + tap]), 1);
+				sum = _mm256_add_ps(sum, _mm256_mul_ps(weights, texels));
+			}
+			_mm256_storeu_ps(pDst + x * 4, sum);
+		}
+
+		for (; x < dstWidth; ++x)
+		{
+			const uint32_t* pIndices = &taps.Indices[x * taps.TapCount];
+			const float* pWeights = &taps.Weights[x * taps.TapCount];
+
+			__m128 sum = _mm_setzero_ps();
+			for (uint32_t tap = 0; tap < taps.TapCount; ++tap)
+				sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(pWeights[tap]), _mm_loadu_ps(pSrc + pIndices[tap] * 4)));
+			_mm_storeu_ps(pDst + x * 4, sum);
+		}
+	}
+
+	MIP_TARGET_AVX2 void EncodeAVX2(const float* pSrc, uint32_t width, MipColorSpace colorSpace, uint8_t* pDst)
+	{
+		if (colorSpace == MipColorSpace::SRGB)
+		{
+			//The table lookups dominate, wider registers don't help there.
+			EncodeSSE2(pSrc, width, colorSpace, pDst);
+			return;
+		}
+
+		const __m256 zero = _mm256_setzero_ps();
+		const __m256 one = _mm256_set1_ps(1.0f);
+		const __m256 half = _mm256_set1_ps(0.5f);
+		const __m256 scale = _mm256_set1_ps(255.0f);
+
+		//8 texels at a time. The packs work within each 128 bit half, the permute puts the 4 byte groups back in order.
+		uint32_t x = 0;
+		for (; x + 8 <= width; x += 8)
+		{
+			__m256i values[4];
+			for (uint32_t pair = 0; pair < 4; ++pair)
+			{
+				const __m256 value = _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(pSrc + (x + pair * 2) * 4), zero), one);
+				values[pair] = _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(value, scale), half));
+			}
+
+			const __m256i words = _mm256_packs_epi32(values[0], values[1]);
+			const __m256i words2 = _mm256_packs_epi32(values[2], values[3]);
+			const __m256i bytes = _mm256_packus_epi16(words, words2);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(pDst + x * 4), _mm256_permutevar8x32_epi32(bytes, _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7)));
+		}
+
+		EncodeSSE2(pSrc + x * 4, width - x, colorSpace, pDst + x * 4);
+	}
+
+	bool CpuHasAVX2()
+	{
+#ifdef _MSC_VER
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7)
+			return false;
+
+		//The CPU has to support AVX2 and the OS has to save the upper halves of the registers on context switches.
+		__cpuid(info, 1);
+		const bool hasOSXSave = (info[2] & (1 << 27)) != 0;
+		const bool hasAVX = (info[2] & (1 << 28)) != 0;
+		if (!hasOSXSave || !hasAVX || (_xgetbv(0) & 6) != 6)
+			return false;
+
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+#else
+		return __builtin_cpu_supports("avx2") != 0;
+#endif
+	}
+
+	bool CpuHasSSE2()
+	{
+#if defined(_M_X64) || defined(__x86_64__)
+		return true;
+#elif defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 1);
+		return (info[3] & (1 << 26)) != 0;
+#else
+		return __builtin_cpu_supports("sse2") != 0;
+#endif
+	}
+#endif
+
+	MipKernel ResolveKernel(MipKernel kernel)
+	{
+		if (kernel == MipKernel::Best)
+		{
+			if (IsMipKernelSupported(MipKernel::AVX2))
+				return MipKernel::AVX2;
+			if (IsMipKernelSupported(MipKernel::SSE2))
+				return MipKernel::SSE2;
+			return MipKernel::Scalar;
+		}
+
+		if (!IsMipKernelSupported(kernel))
+			throw std::runtime_error("mip kernel isn't supported by this CPU!");
+
+		return kernel;
+	}
+
+	Kernels GetKernels(MipKernel kernel)
+	{
+		switch (ResolveKernel(kernel))
+		{
+#ifdef MIP_GENERATOR_X86
+		case MipKernel::AVX2: return { DecodeAVX2, VerticalAVX2, HorizontalAVX2, EncodeAVX2 };
+		case MipKernel::SSE2: return { DecodeSSE2, VerticalSSE2, HorizontalSSE2, EncodeSSE2 };
+#endif
+		default: return { DecodeScalar, VerticalScalar, HorizontalScalar, EncodeScalar };
+		}
+	}
+}
+
+bool IsMipKernelSupported(MipKernel kernel)
+{
+	switch (kernel)
+	{
+#ifdef MIP_GENERATOR_X86
+	case MipKernel::AVX2:
+	{
+		static const bool hasAVX2 = CpuHasAVX2();
+		return hasAVX2;
+	}
+	case MipKernel::SSE2:
+	{
+		static const bool hasSSE2 = CpuHasSSE2();
+		return hasSSE2;
+	}
+#else
+	case MipKernel::AVX2:
+	case MipKernel::SSE2:
+		return false;
+#endif
+	default:
+		return true;
+	}
+}
+
+void GenerateMip(const uint8_t* pRGBA, uint32_t width, uint32_t height, MipColorSpace colorSpace, MipFilter filter,
+	std::vector<uint8_t>& mip, ThreadPool* pPool, MipKernel kernel)
+{
+	const uint32_t mipWidth = std::max(width / 2, 1u);
+	const uint32_t mipHeight = std::max(height / 2, 1u);
+	mip.resize(size_t(mipWidth) * mipHeight * 4);
+
+	const Kernels kernels = GetKernels(kernel);
+	const FilterTaps horizontalTaps = ComputeTaps(width, mipWidth, filter);
+	const FilterTaps verticalTaps = ComputeTaps(height, mipHeight, filter);
+
+	const uint32_t jobCount = (mipHeight + ROWS_PER_JOB - 1) / ROWS_PER_JOB;
+	const auto filterRows = [&](uint32_t job)
+	{
+		const uint32_t firstRow = job * ROWS_PER_JOB;
+		const uint32_t lastRow = std::min(firstRow + ROWS_PER_JOB, mipHeight);
+
+		//Decode every source row the band reads once, the taps of neighbouring rows overlap.
+		const auto tapsBegin = verticalTaps.Indices.begin() + size_t(firstRow) * verticalTaps.TapCount;
+		const auto tapsEnd = verticalTaps.Indices.begin() + size_t(lastRow) * verticalTaps.TapCount;
+		const uint32_t firstSourceRow = *std::min_element(tapsBegin, tapsEnd);
+		const uint32_t lastSourceRow = *std::max_element(tapsBegin, tapsEnd);
+
+		const size_t rowFloats = size_t(width) * 4;
+		std::vector<float> sourceRows((lastSourceRow - firstSourceRow + 1) * rowFloats);
+		for (uint32_t row = firstSourceRow; row <= lastSourceRow; ++row)
+			kernels.Decode(pRGBA + size_t(row) * width * 4, width, colorSpace, &sourceRows[(row - firstSourceRow) * rowFloats]);
+
+		std::vector<float> column(rowFloats);
+		std::vector<float> filtered(size_t(mipWidth) * 4);
+		std::vector<const float*> rows(verticalTaps.TapCount);
+
+		for (uint32_t y = firstRow; y < lastRow; ++y)
+		{
+			for (uint32_t tap = 0; tap < verticalTaps.TapCount; ++tap)
+				rows[tap] = &sourceRows[(verticalTaps.Indices[y * verticalTaps.TapCount + tap] - firstSourceRow) * rowFloats];
+
+			kernels.Vertical(rows.data(), &verticalTaps.Weights[y * verticalTaps.TapCount], verticalTaps.TapCount, static_cast<uint32_t>(rowFloats), column.data());
+			kernels.Horizontal(column.data(), horizontalTaps, mipWidth, filtered.data());
+			kernels.Encode(filtered.data(), mipWidth, colorSpace, &mip[size_t(y) * mipWidth * 4]);
+		}
+	};
+
+	if (pPool && jobCount > 1)
+		pPool->ParallelFor(jobCount, filterRows);
+	else
+	{
+		for (uint32_t job = 0; job < jobCount; ++job)
+			filterRows(job);
+	}
+}
+
+void GenerateMipChain(const uint8_t* pRGBA, uint32_t width, uint32_t height, MipColorSpace colorSpace, MipFilter filter,
+	std::vector<std::vector<uint8_t>>& levels, ThreadPool* pPool, MipKernel kernel)
+{
+	levels.clear();
+	levels.emplace_back(pRGBA, pRGBA + size_t(width) * height * 4);
+
+	while (width > 1 || height > 1)
+	{
+		std::vector<uint8_t> mip;
+		GenerateMip(levels.back().data(), width, height, colorSpace, filter, mip, pPool, kernel);
+		levels.push_back(std::move(mip));
+
+		width = std::max(width / 2, 1u);
+		height = std::max(height / 2, 1u);
+	}
+}
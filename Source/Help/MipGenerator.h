@@ -0,0 +1,50 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+class ThreadPool;
+
+//Generates mip chains of RGBA8 images on the CPU, for devices that can't blit the texture format with a linear filter
+//and for the texture cooker.
+//Every level is filtered straight from the one above it in linear light: sRGB encoded colors are decoded before they
+//are averaged and encoded again afterwards, alpha is always linear. Averaging the encoded values instead darkens
+//every level a bit more than the one before.
+//Odd sizes are handled by stretching the filter over the whole source level, a 5 texel wide row becomes 2 texels
+//that each cover 2.5 source texels, so no row or column is dropped or counted twice.
+
+enum class MipFilter
+{
+	//The average of the texels under each destination texel. Fast, but lets a bit of aliasing through.
+	Box,
+	//A Kaiser windowed sinc over 6 texels. Sharper, and much better at removing detail the level can't hold.
+	Kaiser
+};
+
+enum class MipColorSpace
+{
+	Linear,
+	SRGB
+};
+
+//Which implementation does the filtering, Best picks the widest one the CPU supports.
+//The others exist to compare them, see the "mips" benchmark.
+enum class MipKernel
+{
+	Best,
+	Scalar,
+	SSE2,
+	AVX2
+};
+
+bool IsMipKernelSupported(MipKernel kernel);
+
+//Fills levels with the whole mip chain of the image, levels[0] being a copy of pRGBA.
+//Every next level is half the size of the one before, rounded down, until both sides are 1.
+//Rows of the destination are spread over pPool when one is given.
+void GenerateMipChain(const uint8_t* pRGBA, uint32_t width, uint32_t height, MipColorSpace colorSpace, MipFilter filter,
+	std::vector<std::vector<uint8_t>>& levels, ThreadPool* pPool = nullptr, MipKernel kernel = MipKernel::Best);
+
+//Filters one width x height image down to max(width / 2, 1) x max(height / 2, 1).
+void GenerateMip(const uint8_t* pRGBA, uint32_t width, uint32_t height, MipColorSpace colorSpace, MipFilter filter,
+	std::vector<uint8_t>& mip, ThreadPool* pPool = nullptr, MipKernel kernel = MipKernel::Best);
@@ -0,0 +1,158 @@
+#include "TaskGraph.h"
+
+#include <thread>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <stdexcept>
+
+TaskGraph::TaskGraph(uint32_t workerCount):
+	m_WorkerCount(workerCount),
+	m_FinishedCount(0),
+	m_RunningCount(0),
+	m_WallTimeMs(0.0f)
+{
+	//hardware_concurrency is allowed to return 0 when it can't tell.
+	if (m_WorkerCount == 0)
+		m_WorkerCount = std::max(1u, std::thread::hardware_concurrency());
+}
+
+TaskGraph::TaskId TaskGraph::Add(const std::string& name, const std::function<void()>& work, const std::vector<TaskId>& dependencies)
+{
+	const TaskId id = m_Tasks.size();
+
+	Task task;
+	task.Name = name;
+	task.Work = work;
+	task.UnfinishedDependencies = static_cast<uint32_t>(dependencies.size());
+	m_Tasks.push_back(task);
+
+	//Because a task can only depend on tasks that were added before it, the graph can never contain a cycle.
+	for (TaskId dependency : dependencies)
+	{
+		if (dependency >= id)
+			throw std::runtime_error("task " + name + " depends on a task that doesn't exist yet!");
+
+		m_Tasks[dependency].Dependents.push_back(id);
+	}
+
+	return id;
+}
+
+void TaskGraph::Run()
+{
+	m_StartTime = std::chrono::high_resolution_clock::now();
+	m_FinishedCount = 0;
+	m_RunningCount = 0;
+	m_Exception = nullptr;
+
+	m_ReadyTasks.clear();
+	for (TaskId id = 0; id < m_Tasks.size(); ++id)
+	{
+		if (m_Tasks[id].UnfinishedDependencies == 0)
+			m_ReadyTasks.push_back(id);
+	}
+
+	//There is no point in starting more workers than there are tasks.
+	const uint32_t workerCount = static_cast<uint32_t>(std::min<size_t>(m_WorkerCount, m_Tasks.size()));
+
+	std::vector<std::thread> workers;
+	for (uint32_t i = 0; i < workerCount; ++i)
+		workers.emplace_back(&TaskGraph::WorkerLoop, this, i);
+
+	for (std::thread& worker : workers)
+		worker.join();
+
+	m_WallTimeMs = GetElapsedMs();
+
+	if (m_Exception)
+		std::rethrow_exception(m_Exception);
+}
+
+void TaskGraph::PrintTimings() const
+{
+	std::vector<const Task*> tasks;
+	for (const Task& task : m_Tasks)
+		tasks.push_back(&task);
+
+	std::sort(tasks.begin(), tasks.end(), [](const Task* pA, const Task* pB) { return pA->StartMs < pB->StartMs; });
+
+	float serialMs = 0.0f;
+
+	std::cout << std::string(60, '-') << std::endl;
+	std::cout << std::left << std::setw(34) << "stage" << std::right << std::setw(8) << "worker" << std::setw(9) << "start" << std::setw(9) << "ms" << std::endl;
+	for (const Task* pTask : tasks)
+	{
+		std::cout << std::left << std::setw(34) << pTask->Name << std::right << std::setw(8) << pTask->Worker
+			<< std::fixed << std::setprecision(1) << std::setw(9) << pTask->StartMs << std::setw(9) << pTask->DurationMs << std::endl;
+
+		serialMs += pTask->DurationMs;
+	}
+
+	std::cout << std::string(60, '-') << std::endl;
+	std::cout << "startup took " << m_WallTimeMs << " ms on " << m_WorkerCount << " workers, "
+		<< serialMs << " ms when run serially (" << (m_WallTimeMs > 0.0f ? serialMs / m_WallTimeMs : 1.0f) << "x)" << std::endl;
+	std::cout.unsetf(std::ios::fixed);
+}
+
+void TaskGraph::WorkerLoop(uint32_t worker)
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
+
+	while (true)
+	{
+		//Sleep until there is something to do, or until we know nothing will ever be ready again:
+		//either every task finished, or a task failed and the ones still running are done.
+		m_Condition.wait(lock, [this]()
+		{
+			return (!m_ReadyTasks.empty() && !m_Exception) || m_FinishedCount == m_Tasks.size() || (m_Exception && m_RunningCount == 0);
+		});
+
+		if (m_ReadyTasks.empty() || m_Exception)
+			break;
+
+		const TaskId id = m_ReadyTasks.front();
+		m_ReadyTasks.pop_front();
+		++m_RunningCount;
+
+		Task& task = m_Tasks[id];
+		task.Worker = worker;
+		task.StartMs = GetElapsedMs();
+
+		lock.unlock();
+
+		std::exception_ptr exception = nullptr;
+		try
+		{
+			task.Work();
+		}
+		catch (...)
+		{
+			exception = std::current_exception();
+		}
+
+		lock.lock();
+
+		task.DurationMs = GetElapsedMs() - task.StartMs;
+		--m_RunningCount;
+		++m_FinishedCount;
+
+		if (exception && !m_Exception)
+			m_Exception = exception;
+
+		for (TaskId dependent : task.Dependents)
+		{
+			if (--m_Tasks[dependent].UnfinishedDependencies == 0)
+				m_ReadyTasks.push_back(dependent);
+		}
+
+		m_Condition.notify_all();
+	}
+
+	m_Condition.notify_all();
+}
+
+float TaskGraph::GetElapsedMs() const
+{
+	return std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - m_StartTime).count();
+}
\ No newline at end of file
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <chrono>
+
+//A small job system for one-off work like application startup.
+//Tasks are added up front with the tasks they depend on, Run then executes them on a pool of worker threads,
+//starting every task as soon as all of its dependencies have finished.
+class TaskGraph
+{
+public:
+	typedef size_t TaskId;
+
+	//workerCount 0 means one worker per hardware thread.
+	TaskGraph(uint32_t workerCount = 0);
+
+	TaskId Add(const std::string& name, const std::function<void()>& work, const std::vector<TaskId>& dependencies = {});
+
+	//Blocks until every task has finished. If a task throws, no new tasks are started
+	//and the first exception is rethrown once the running ones are done.
+	void Run();
+
+	//Prints when and on which worker every task ran, and how the wall time compares to running them one by one.
+	void PrintTimings() const;
+
+private:
+	struct Task
+	{
+		std::string Name;
+		std::function<void()> Work;
+		std::vector<TaskId> Dependents;
+		uint32_t UnfinishedDependencies = 0;
+
+		uint32_t Worker = 0;
+		float StartMs = 0.0f;
+		float DurationMs = 0.0f;
+	};
+
+	void WorkerLoop(uint32_t worker);
+	float GetElapsedMs() const;
+
+private:
+	std::vector<Task> m_Tasks;
+	uint32_t m_WorkerCount;
+
+	std::mutex m_Mutex;
+	std::condition_variable m_Condition;
+	//First in, first out: among the tasks that are ready, the one that was added first runs first.
+	std::deque<TaskId> m_ReadyTasks;
+	size_t m_FinishedCount;
+	size_t m_RunningCount;
+	std::exception_ptr m_Exception;
+
+	std::chrono::high_resolution_clock::time_point m_StartTime;
+	float m_WallTimeMs;
+};
\ No newline at end of file
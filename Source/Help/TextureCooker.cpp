@@ -0,0 +1,140 @@
+#include "TextureCooker.h"
+
+#include "HelperMethods.h"
+#include "BlockCompression.h"
+#include "MipGenerator.h"
+#include "Ktx2Texture.h"
+#include "ThreadPool.h"
+
+#include "../Vulkan/Texture.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+namespace
+{
+	struct CookedFormat
+	{
+		VkFormat Format;
+		const char* pExtension;
+	};
+
+	//In order of preference.
+	const CookedFormat COOKED_FORMATS[] =
+	{
+		{ VK_FORMAT_BC7_UNORM_BLOCK, ".bc7.ktx2" },
+		{ VK_FORMAT_BC3_UNORM_BLOCK, ".bc3.ktx2" },
+		{ VK_FORMAT_BC1_RGB_UNORM_BLOCK, ".bc1.ktx2" },
+		{ VK_FORMAT_R8G8B8A8_UNORM, ".rgba8.ktx2" },
+	};
+
+	std::string GetCookedPrefix(const std::string& sourcePath)
+	{
+		const size_t extension = sourcePath.find_last_of('.');
+		const size_t directory = sourcePath.find_last_of("/\\");
+
+		if (extension == std::string::npos || (directory != std::string::npos && extension < directory))
+			return sourcePath;
+
+		return sourcePath.substr(0, extension);
+	}
+
+	bool HasAlpha(const TextureData& texture)
+	{
+		for (size_t i = 3; i < texture.Pixels.size(); i += 4)
+		{
+			if (texture.Pixels[i] != 255)
+				return true;
+		}
+
+		return false;
+	}
+
+	bool FileExists(const std::string& path)
+	{
+		return std::ifstream(path, std::ios::binary).good();
+	}
+}
+
+void CookTexture(const std::string& sourcePath, ThreadPool* pPool)
+{
+	TextureData source;
+	LoadTexture(source, sourcePath);
+
+	const auto start = std::chrono::high_resolution_clock::now();
+
+	//Source images are authored in sRGB, so they are filtered in linear light even though the textures are sampled as UNORM.
+	std::vector<std::vector<uint8_t>> levels;
+	GenerateMipChain(source.Pixels.data(), source.Width, source.Height, MipColorSpace::SRGB, MipFilter::Kaiser, levels, pPool);
+
+	const std::string prefix = GetCookedPrefix(sourcePath);
+	const bool hasAlpha = HasAlpha(source);
+
+	for (const CookedFormat& cooked : COOKED_FORMATS)
+	{
+		if (cooked.Format == (hasAlpha ? VK_FORMAT_BC1_RGB_UNORM_BLOCK : VK_FORMAT_BC3_UNORM_BLOCK))
+			continue;
+
+		std::vector<std::vector<uint8_t>> blocks(levels.size());
+		for (size_t level = 0; level < levels.size(); ++level)
+		{
+			const uint32_t levelWidth = std::max(static_cast<uint32_t>(source.Width) >> level, 1u);
+			const uint32_t levelHeight = std::max(static_cast<uint32_t>(source.Height) >> level, 1u);
+
+			switch (cooked.Format)
+			{
+			case VK_FORMAT_BC7_UNORM_BLOCK: CompressBC7(levels[level].data(), levelWidth, levelHeight, blocks[level], pPool); break;
+			case VK_FORMAT_BC3_UNORM_BLOCK: CompressBC3(levels[level].data(), levelWidth, levelHeight, blocks[level], pPool); break;
+			case VK_FORMAT_BC1_RGB_UNORM_BLOCK: CompressBC1(levels[level].data(), levelWidth, levelHeight, blocks[level], pPool); break;
+			default: blocks[level] = levels[level]; break;
+			}
+		}
+
+		const std::string path = prefix + cooked.pExtension;
+		Ktx2Texture::Write(path, cooked.Format, source.Width, source.Height, blocks);
+
+		size_t size = 0;
+		for (const std::vector<uint8_t>& level : blocks)
+			size += level.size();
+
+		std::cout << "texture cooker: wrote " << path << " (" << levels.size() << " levels, " << size / 1024 << " KiB)" << std::endl;
+	}
+
+	const std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+	std::cout << "texture cooker: cooked " << sourcePath << " in " << elapsed.count() << " s" << std::endl;
+}
+
+std::string FindCookedTexture(const std::string& sourcePath, PhysicalDevice* pGpu)
+{
+	const std::string prefix = GetCookedPrefix(sourcePath);
+
+	std::vector<VkFormat> candidates;
+	for (const CookedFormat& cooked : COOKED_FORMATS)
+	{
+		if (FileExists(prefix + cooked.pExtension))
+			candidates.push_back(cooked.Format);
+	}
+
+	if (candidates.empty())
+		return std::string();
+
+	//FindSupportedFormat throws when none of the candidates is supported, which only happens when the RGBA8 file is missing.
+	try
+	{
+		const VkFormat format = FindSupportedFormat(candidates, VK_IMAGE_TILING_OPTIMAL, VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT, pGpu);
+
+		for (const CookedFormat& cooked : COOKED_FORMATS)
+		{
+			if (cooked.Format == format)
+				return prefix + cooked.pExtension;
+		}
+	}
+	catch (const std::runtime_error&)
+	{
+	}
+
+	return std::string();
+}
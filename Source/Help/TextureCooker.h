@@ -0,0 +1,18 @@
+#pragma once
+
+#include <string>
+
+class PhysicalDevice;
+class ThreadPool;
+
+//Converts a source image (anything stb_image reads) into KTX2 files next to it, so the application doesn't have to
+//decode the image and generate its mips on every startup. Every file holds the whole mip chain in one format:
+//	<name>.bc7.ktx2		BC7, the best quality, 1 byte per texel
+//	<name>.bc1.ktx2		BC1 for opaque images, 0.5 byte per texel, or
+//	<name>.bc3.ktx2		BC3 when the image has alpha, 1 byte per texel
+//	<name>.rgba8.ktx2	uncompressed, for devices without BC support
+//where <name> is the source path without its extension.
+void CookTexture(const std::string& sourcePath, ThreadPool* pPool);
+
+//Returns the path of the best cooked file for sourcePath that pGpu can sample from, or an empty string if the texture wasn't cooked.
+std::string FindCookedTexture(const std::string& sourcePath, PhysicalDevice* pGpu);
@@ -0,0 +1,90 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(uint32_t threadCount):
+	m_pJob(nullptr),
+	m_JobCount(0),
+	m_NextJob(0),
+	m_FinishedJobs(0),
+	m_IsStopping(false)
+{
+	//hardware_concurrency is allowed to return 0 when it can't tell.
+	if (threadCount == 0)
+		threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+	for (uint32_t i = 0; i < threadCount; ++i)
+		m_Threads.emplace_back(&ThreadPool::WorkerLoop, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_IsStopping = true;
+	}
+
+	m_WorkAvailable.notify_all();
+
+	for (std::thread& thread : m_Threads)
+		thread.join();
+}
+
+void ThreadPool::ParallelFor(uint32_t jobCount, const std::function<void(uint32_t)>& job)
+{
+	if (jobCount == 0)
+		return;
+
+	std::unique_lock<std::mutex> lock(m_Mutex);
+
+	m_pJob = &job;
+	m_JobCount = jobCount;
+	m_NextJob = 0;
+	m_FinishedJobs = 0;
+	m_Exception = nullptr;
+
+	m_WorkAvailable.notify_all();
+	m_WorkDone.wait(lock, [this, jobCount]() { return m_FinishedJobs == jobCount; });
+
+	m_pJob = nullptr;
+	m_JobCount = 0;
+
+	if (m_Exception)
+		std::rethrow_exception(m_Exception);
+}
+
+void ThreadPool::WorkerLoop()
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
+
+	while (true)
+	{
+		m_WorkAvailable.wait(lock, [this]() { return m_IsStopping || m_NextJob < m_JobCount; });
+
+		if (m_IsStopping)
+			return;
+
+		const uint32_t jobIndex = m_NextJob++;
+		const std::function<void(uint32_t)>& job = *m_pJob;
+
+		lock.unlock();
+
+		std::exception_ptr exception = nullptr;
+		try
+		{
+			job(jobIndex);
+		}
+		catch (...)
+		{
+			exception = std::current_exception();
+		}
+
+		lock.lock();
+
+		if (exception && !m_Exception)
+			m_Exception = exception;
+
+		if (++m_FinishedJobs == m_JobCount)
+			m_WorkDone.notify_one();
+	}
+}
\ No newline at end of file
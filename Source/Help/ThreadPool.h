@@ -0,0 +1,41 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+
+//A fixed set of worker threads that stay alive for the lifetime of the pool, for work that repeats every frame.
+//Unlike the TaskGraph there are no dependencies: ParallelFor hands out a batch of jobs and waits for all of them.
+class ThreadPool
+{
+public:
+	//threadCount 0 means one thread per hardware thread.
+	ThreadPool(uint32_t threadCount = 0);
+	~ThreadPool();
+
+	//Calls job(i) for every i in [0, jobCount) on the workers and blocks until they all returned.
+	//If a job throws, the first exception is rethrown here once the whole batch is done.
+	void ParallelFor(uint32_t jobCount, const std::function<void(uint32_t)>& job);
+
+	uint32_t GetThreadCount() const { return static_cast<uint32_t>(m_Threads.size()); }
+
+private:
+	void WorkerLoop();
+
+private:
+	std::vector<std::thread> m_Threads;
+
+	std::mutex m_Mutex;
+	std::condition_variable m_WorkAvailable;
+	std::condition_variable m_WorkDone;
+
+	const std::function<void(uint32_t)>* m_pJob;
+	uint32_t m_JobCount;
+	uint32_t m_NextJob;
+	uint32_t m_FinishedJobs;
+	std::exception_ptr m_Exception;
+	bool m_IsStopping;
+};
\ No newline at end of file
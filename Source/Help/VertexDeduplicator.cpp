@@ -0,0 +1,143 @@
+#include "VertexDeduplicator.h"
+
+#include "ThreadPool.h"
+
+#include <cstring>
+#include <algorithm>
+
+namespace
+{
+	//Final mixing step of SplitMix64/MurmurHash3: a bijection in which every input bit flips about half of the output bits.
+	uint64_t Mix(uint64_t value)
+	{
+		value ^= value >> 30;
+		value *= 0xbf58476d1ce4e5b9ull;
+		value ^= value >> 27;
+		value *= 0x94d049bb133111ebull;
+		value ^= value >> 31;
+		return value;
+	}
+
+	//Below this many vertices per thread, starting the threads costs more than it saves.
+	const size_t MIN_VERTICES_PER_THREAD = 1 << 14;
+}
+
+const uint32_t VertexTable::EMPTY_SLOT;
+
+uint64_t HashVertex(const Vertex& vertex)
+{
+	//Walk over the vertex 8 bytes at a time. memcpy keeps this free of alignment and aliasing issues
+	//and compiles to plain loads.
+	const uint8_t* pBytes = reinterpret_cast<const uint8_t*>(&vertex);
+	uint64_t hash = sizeof(Vertex);
+
+	size_t offset = 0;
+	for (; offset + sizeof(uint64_t) <= sizeof(Vertex); offset += sizeof(uint64_t))
+	{
+		uint64_t word;
+		memcpy(&word, pBytes + offset, sizeof(word));
+		hash = Mix(hash ^ word);
+	}
+
+	if (offset < sizeof(Vertex))
+	{
+		uint64_t word = 0;
+		memcpy(&word, pBytes + offset, sizeof(Vertex) - offset);
+		hash = Mix(hash ^ word);
+	}
+
+	return hash;
+}
+
+VertexTable::VertexTable(size_t maxVertexCount)
+{
+	//A power of 2 so the slot is a mask instead of a modulo, and at least twice the vertex count,
+	//so the table is never more than half full and probe sequences stay short.
+	size_t capacity = 16;
+	while (capacity < maxVertexCount * 2)
+		capacity *= 2;
+
+	Slot emptySlot = {};
+	emptySlot.Index = EMPTY_SLOT;
+
+	m_Slots.assign(capacity, emptySlot);
+	m_Mask = capacity - 1;
+}
+
+uint32_t VertexTable::Insert(const Vertex& vertex, std::vector<Vertex>& vertices)
+{
+	const uint64_t hash = HashVertex(vertex);
+	const uint32_t tag = static_cast<uint32_t>(hash >> 32);
+
+	for (size_t slot = static_cast<size_t>(hash) & m_Mask; ; slot = (slot + 1) & m_Mask)
+	{
+		Slot& entry = m_Slots[slot];
+
+		if (entry.Index == EMPTY_SLOT)
+		{
+			entry.Hash = tag;
+			entry.Index = static_cast<uint32_t>(vertices.size());
+			vertices.push_back(vertex);
+			return entry.Index;
+		}
+
+		if (entry.Hash == tag && memcmp(&vertices[entry.Index], &vertex, sizeof(Vertex)) == 0)
+			return entry.Index;
+	}
+}
+
+void DeduplicateVertices(const std::vector<Vertex>& stream, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, uint32_t threadCount)
+{
+	vertices.clear();
+	indices.resize(stream.size());
+
+	const size_t rangeCount = std::max<size_t>(1, std::min<size_t>(threadCount, stream.size() / MIN_VERTICES_PER_THREAD));
+
+	if (rangeCount == 1)
+	{
+		VertexTable table(stream.size());
+		for (size_t i = 0; i < stream.size(); ++i)
+			indices[i] = table.Insert(stream[i], vertices);
+
+		return;
+	}
+
+	//Every range gets its own table and unique vertices, the indices it writes are local to the range for now.
+	std::vector<std::vector<Vertex>> rangeVertices(rangeCount);
+
+	ThreadPool pool(static_cast<uint32_t>(rangeCount));
+	pool.ParallelFor(static_cast<uint32_t>(rangeCount), [&](uint32_t range)
+	{
+		const size_t first = stream.size() * range / rangeCount;
+		const size_t last = stream.size() * (range + 1) / rangeCount;
+
+		VertexTable table(last - first);
+		for (size_t i = first; i < last; ++i)
+			indices[i] = table.Insert(stream[i], rangeVertices[range]);
+	});
+
+	//Merging only touches the unique vertices of every range, which is a fraction of the stream.
+	//Because the ranges are merged in order, the global order is the order of first use, just like the serial path.
+	size_t totalVertexCount = 0;
+	for (const std::vector<Vertex>& range : rangeVertices)
+		totalVertexCount += range.size();
+
+	VertexTable table(totalVertexCount);
+	std::vector<std::vector<uint32_t>> remaps(rangeCount);
+
+	for (size_t range = 0; range < rangeCount; ++range)
+	{
+		remaps[range].reserve(rangeVertices[range].size());
+		for (const Vertex& vertex : rangeVertices[range])
+			remaps[range].push_back(table.Insert(vertex, vertices));
+	}
+
+	pool.ParallelFor(static_cast<uint32_t>(rangeCount), [&](uint32_t range)
+	{
+		const size_t first = stream.size() * range / rangeCount;
+		const size_t last = stream.size() * (range + 1) / rangeCount;
+
+		for (size_t i = first; i < last; ++i)
+			indices[i] = remaps[range][indices[i]];
+	});
+}
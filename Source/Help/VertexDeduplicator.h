@@ -0,0 +1,40 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include "../Vulkan/Vertex.h"
+
+//64 bit hash over the raw bytes of a vertex. Every bit of every attribute ends up in every bit of the result,
+//unlike the xor/shift combination of std::hash<Vertex>, where similar vertices easily collide.
+uint64_t HashVertex(const Vertex& vertex);
+
+//Open addressing (linear probing) hash table that maps a vertex to its index in a vertex array.
+//It is sized once for the worst case where every vertex is unique, so it never has to grow or rehash,
+//and Insert looks up and inserts in a single probe sequence. Vertices are compared bitwise.
+class VertexTable
+{
+public:
+	explicit VertexTable(size_t maxVertexCount);
+
+	//Returns the index of vertex in vertices. The first time a vertex is seen it is appended to vertices.
+	uint32_t Insert(const Vertex& vertex, std::vector<Vertex>& vertices);
+
+private:
+	struct Slot
+	{
+		//The upper half of the hash, so most mismatches are rejected without touching the vertex array.
+		uint32_t Hash;
+		uint32_t Index;
+	};
+
+	static const uint32_t EMPTY_SLOT = UINT32_MAX;
+
+	std::vector<Slot> m_Slots;
+	size_t m_Mask;
+};
+
+//Turns a stream with a vertex per index into unique vertices and indices, keeping the order of first use.
+//With more than one thread, the stream is split into a contiguous range per thread that is deduplicated on its own,
+//after which the unique vertices of the ranges are merged in order, so the result is identical to the serial one.
+void DeduplicateVertices(const std::vector<Vertex>& stream, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, uint32_t threadCount = 1);
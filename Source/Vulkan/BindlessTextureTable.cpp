@@ -0,0 +1,178 @@
+#include "BindlessTextureTable.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include "VulkanInstance.h"
+#include "LogicalDevice.h"
+#include "PhysicalDevice.h"
+
+namespace
+{
+	bool HasExtension(PhysicalDevice* pGpu, const char* name)
+	{
+		for (const VkExtensionProperties& props : pGpu->GetDescRef().AvailableExtensions)
+		{
+			if (strcmp(props.extensionName, name) == 0)
+				return true;
+		}
+
+		return false;
+	}
+}
+
+bool BindlessTextureTable::IsSupported(PhysicalDevice* pGpu)
+{
+	return pGpu->GetDescRef().Features.shaderSampledImageArrayDynamicIndexing == VK_TRUE;
+}
+
+bool BindlessTextureTable::IsDescriptorIndexingSupported(VulkanInstance* pInstance, PhysicalDevice* pGpu)
+{
+	//VK_EXT_descriptor_indexing depends on VK_KHR_maintenance3, both are enabled together.
+	if (!HasExtension(pGpu, VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME) || !HasExtension(pGpu, VK_KHR_MAINTENANCE3_EXTENSION_NAME))
+		return false;
+
+	VkPhysicalDeviceDescriptorIndexingFeaturesEXT indexingFeatures = {};
+	indexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+
+	VkPhysicalDeviceFeatures2KHR features = {};
+	features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2_KHR;
+	features.pNext = &indexingFeatures;
+
+	if (!pInstance->GetPhysicalDeviceFeatures2(pGpu->GetDevice(), &features))
+		return false;
+
+	return indexingFeatures.descriptorBindingPartiallyBound == VK_TRUE;
+}
+
+BindlessTextureTable::BindlessTextureTable(LogicalDevice* pCpu, PhysicalDevice* pGpu, uint32_t framesInFlight, bool useDescriptorIndexing):
+	m_Sets(framesInFlight),
+	m_UseDescriptorIndexing(useDescriptorIndexing),
+	m_SetVersions(framesInFlight, 0),
+	m_pCpu(pCpu)
+{
+	//The combined image sampler of set 0 counts towards the same per stage limits.
+	const VkPhysicalDeviceLimits& limits = pGpu->GetDescRef().Properties.limits;
+	const uint32_t limit = std::min({ limits.maxPerStageDescriptorSamplers, limits.maxPerStageDescriptorSampledImages,
+		limits.maxDescriptorSetSamplers, limits.maxDescriptorSetSampledImages }) - 1;
+
+	m_Capacity = std::min(m_UseDescriptorIndexing ? DESCRIPTOR_INDEXING_CAPACITY : FALLBACK_CAPACITY, limit);
+
+	VkDescriptorSetLayoutBinding binding = {};
+	binding.binding = 0;
+	binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	binding.descriptorCount = m_Capacity;
+	binding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+	VkDescriptorSetLayoutCreateInfo layoutInfo = {};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layoutInfo.bindingCount = 1;
+	layoutInfo.pBindings = &binding;
+
+	//Partially bound: only the descriptors that are dynamically used have to be valid.
+	const VkDescriptorBindingFlagsEXT bindingFlags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT;
+
+	VkDescriptorSetLayoutBindingFlagsCreateInfoEXT bindingFlagsInfo = {};
+	bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT;
+	bindingFlagsInfo.bindingCount = 1;
+	bindingFlagsInfo.pBindingFlags = &bindingFlags;
+
+	if (m_UseDescriptorIndexing)
+		layoutInfo.pNext = &bindingFlagsInfo;
+
+	if (vkCreateDescriptorSetLayout(pCpu->GetDevice(), &layoutInfo, nullptr, &m_Layout) != VK_SUCCESS)
+		throw std::runtime_error("failed to create bindless descriptor set layout!");
+
+	VkDescriptorPoolSize poolSize = {};
+	poolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	poolSize.descriptorCount = m_Capacity * framesInFlight;
+
+	VkDescriptorPoolCreateInfo poolInfo = {};
+	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolInfo.poolSizeCount = 1;
+	poolInfo.pPoolSizes = &poolSize;
+	poolInfo.maxSets = framesInFlight;
+
+	if (vkCreateDescriptorPool(pCpu->GetDevice(), &poolInfo, nullptr, &m_Pool) != VK_SUCCESS)
+		throw std::runtime_error("failed to create bindless descriptor pool!");
+
+	const std::vector<VkDescriptorSetLayout> layouts(framesInFlight, m_Layout);
+
+	VkDescriptorSetAllocateInfo allocInfo = {};
+	allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocInfo.descriptorPool = m_Pool;
+	allocInfo.descriptorSetCount = framesInFlight;
+	allocInfo.pSetLayouts = layouts.data();
+
+	if (vkAllocateDescriptorSets(pCpu->GetDevice(), &allocInfo, m_Sets.data()) != VK_SUCCESS)
+		throw std::runtime_error("failed to allocate bindless descriptor sets!");
+}
+
+BindlessTextureTable::~BindlessTextureTable()
+{
+	vkDestroyDescriptorPool(m_pCpu->GetDevice(), m_Pool, nullptr);
+	vkDestroyDescriptorSetLayout(m_pCpu->GetDevice(), m_Layout, nullptr);
+}
+
+uint32_t BindlessTextureTable::Register(VkImageView view, VkSampler sampler)
+{
+	if (m_Slots.size() >= m_Capacity)
+		throw std::runtime_error("bindless texture table is full!");
+
+	m_Slots.push_back({ view, sampler, ++m_Version });
+	return static_cast<uint32_t>(m_Slots.size() - 1);
+}
+
+void BindlessTextureTable::SetView(uint32_t slot, VkImageView view)
+{
+	m_Slots[slot].View = view;
+	m_Slots[slot].Version = ++m_Version;
+}
+
+void BindlessTextureTable::Update(uint32_t frameIndex)
+{
+	if (m_SetVersions[frameIndex] == m_Version || m_Slots.empty())
+		return;
+
+	std::vector<VkDescriptorImageInfo> imageInfos;
+	std::vector<VkWriteDescriptorSet> writes;
+	imageInfos.reserve(m_Capacity);
+	writes.reserve(m_Capacity);
+
+	auto addWrite = [&](uint32_t arrayElement, const Slot& slot)
+	{
+		VkDescriptorImageInfo imageInfo = {};
+		imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		imageInfo.imageView = slot.View;
+		imageInfo.sampler = slot.Sampler;
+		imageInfos.push_back(imageInfo);
+
+		VkWriteDescriptorSet write = {};
+		write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		write.dstSet = m_Sets[frameIndex];
+		write.dstBinding = 0;
+		write.dstArrayElement = arrayElement;
+		write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		write.descriptorCount = 1;
+		write.pImageInfo = &imageInfos.back();
+		writes.push_back(write);
+	};
+
+	for (uint32_t index = 0; index < m_Slots.size(); ++index)
+	{
+		if (m_Slots[index].Version > m_SetVersions[frameIndex])
+			addWrite(index, m_Slots[index]);
+	}
+
+	//Without partially bound descriptors every element of the array must be valid, even the ones no draw reads.
+	//They point to the first texture, and follow it when its view is replaced, the old one is about to be destroyed.
+	if (!m_UseDescriptorIndexing && m_Slots[0].Version > m_SetVersions[frameIndex])
+	{
+		for (uint32_t index = static_cast<uint32_t>(m_Slots.size()); index < m_Capacity; ++index)
+			addWrite(index, m_Slots[0]);
+	}
+
+	vkUpdateDescriptorSets(m_pCpu->GetDevice(), static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+	m_SetVersions[frameIndex] = m_Version;
+}
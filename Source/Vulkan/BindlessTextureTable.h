@@ -0,0 +1,70 @@
+#pragma once
+
+#ifndef GLFW_INCLUDE_VULKAN
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+#endif
+
+#include <vector>
+
+class VulkanInstance;
+class LogicalDevice;
+class PhysicalDevice;
+
+//One array of combined image samplers that every texture registers into, bound once per frame as descriptor set 1.
+//Draws select their texture with the index in their uniform block, so drawing differently textured objects
+//doesn't bind anything but the dynamic offset of that block.
+//With VK_EXT_descriptor_indexing the array is large and partially bound: slots that were never written are fine
+//as long as no draw uses them. Without it the array is small and every slot is written, unused ones with the first texture.
+//The size of the array reaches the fragment shader as specialization constant 0.
+//Every frame in flight has its own copy of the set, a copy is only rewritten by Update once its frame has finished,
+//so textures can be added or have their view replaced while frames are in flight.
+class BindlessTextureTable
+{
+public:
+	static const uint32_t DESCRIPTOR_INDEXING_CAPACITY = 4096;
+	static const uint32_t FALLBACK_CAPACITY = 16;
+
+	//Whether the fragment shader may index a sampler array with a dynamically uniform index. Without it there is no table at all.
+	static bool IsSupported(PhysicalDevice* pGpu);
+	//Whether the device can leave slots of the array unwritten, LogicalDevice enables the feature when it is.
+	static bool IsDescriptorIndexingSupported(VulkanInstance* pInstance, PhysicalDevice* pGpu);
+
+	BindlessTextureTable(LogicalDevice* pCpu, PhysicalDevice* pGpu, uint32_t framesInFlight, bool useDescriptorIndexing);
+	~BindlessTextureTable();
+
+	//Returns the slot the shaders read the texture from.
+	uint32_t Register(VkImageView view, VkSampler sampler);
+	void SetView(uint32_t slot, VkImageView view);
+
+	//Writes the slots that changed since the set of frameIndex was written last. The fence of the frame must have signaled.
+	void Update(uint32_t frameIndex);
+
+	const VkDescriptorSetLayout& GetLayout() const { return m_Layout; }
+	const VkDescriptorSet& GetSet(uint32_t frameIndex) const { return m_Sets[frameIndex]; }
+	uint32_t GetCapacity() const { return m_Capacity; }
+	bool UsesDescriptorIndexing() const { return m_UseDescriptorIndexing; }
+
+private:
+	struct Slot
+	{
+		VkImageView View;
+		VkSampler Sampler;
+		uint64_t Version;
+	};
+
+private:
+	VkDescriptorSetLayout m_Layout;
+	VkDescriptorPool m_Pool;
+	std::vector<VkDescriptorSet> m_Sets;
+
+	uint32_t m_Capacity;
+	bool m_UseDescriptorIndexing;
+
+	std::vector<Slot> m_Slots;
+	//Bumped on every change, a set is up to date with every slot whose version is at most its own.
+	uint64_t m_Version = 0;
+	std::vector<uint64_t> m_SetVersions;
+
+	LogicalDevice* m_pCpu;
+};
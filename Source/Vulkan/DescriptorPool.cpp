@@ -6,22 +6,24 @@
 #include "SwapChain.h"
 #include "DescriptorSetLayout.h"
 #include "TextureSampler.h"
-#include "Texture.h"
+#include "UniformRingBuffer.h"
 
 
-DescriptorPool::DescriptorPool(LogicalDevice* pCpu, size_t nrOfSwapChainImages):
+DescriptorPool::DescriptorPool(LogicalDevice* pCpu, uint32_t setCount):
+m_DescriptorSets(setCount),
 m_pCpu(pCpu)
 {
 	//We first need to describe which descriptor types our descriptor sets are going to contain and
 	//how many of them, using VkDescriptorPoolSize structures
 	std::array<VkDescriptorPoolSize, 2> poolSizes = {};
-	poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-	poolSizes[0].descriptorCount = static_cast<uint32_t>(nrOfSwapChainImages);
+	poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+	poolSizes[0].descriptorCount = setCount;
 
 	poolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	poolSizes[1].descriptorCount = static_cast<uint32_t>(nrOfSwapChainImages);
+	poolSizes[1].descriptorCount = setCount;
 
-	//We will allocate one of these descriptors for every frame. This pool size structure is referenced
+	//The uniform data of every frame lives in the same ring buffer and is selected with a dynamic offset,
+	//so every set needs just one of these descriptors. This pool size structure is referenced
 	//ny the main VkDescriptorPoolCreateInfo:
 	VkDescriptorPoolCreateInfo poolInfo = {};
 	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
@@ -30,108 +32,127 @@ m_pCpu(pCpu)
 
 	//Aside from the maimum number of individual descriptors that are available,
 	//We also need to specify the maimum number of descriptors sets that may be allocated.
-	poolInfo.maxSets = static_cast<uint32_t>(nrOfSwapChainImages);
+	poolInfo.maxSets = setCount;
 
 	//The structure has an optional flag similar to command pools that determines if individual
 	//descriptor sets can be freed or not: VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT.
-	//We're not going to touch the descriptor set after creating it, so we don't need this flag.
+	//We only ever rewrite the sets, never free them, so we don't need this flag.
 
 	if (vkCreateDescriptorPool(pCpu->GetDevice(), &poolInfo, nullptr, &m_Pool) != VK_SUCCESS)
 		throw std::runtime_error("failed to create descriptor pool!");
 
 }
 
-void DescriptorPool::CreateDescriptorSets(SwapChain* pSwapChain, DescriptorSetLayout* pDescSetLayout, TextureSampler* pSampler, Texture* pTexture)
+void DescriptorPool::CreateDescriptorSets(SwapChain* pSwapChain, DescriptorSetLayout* pDescSetLayout, TextureSampler* pSampler, VkImageView textureView)
 {
 	//A descriptor set allocation is described with a VkDescriptorSetAllocateInfo struct.
 	//You need to specify the desriptor pool to allocate from, the number of descriptors sets to allocate
 	//and the descriptor layour to base them on.
 
-	std::vector<VkDescriptorSetLayout> layouts(pSwapChain->GetImages().size(), pDescSetLayout->GetDescriptorSetLayout());
+	//Because the uniform buffer is bound with a dynamic offset, one descriptor set per frame in flight serves all swap chain images.
+	const std::vector<VkDescriptorSetLayout> layouts(m_DescriptorSets.size(), pDescSetLayout->GetDescriptorSetLayout());
 
-	//In our case, we will create one descriptor set for each swap chain image, all with the same layout.
-	//Unfortunately we do need all the copies of the layour because the next function expects an array matching the numbers of sets.
 	VkDescriptorSetAllocateInfo allocInfo = {};
 	allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
 	allocInfo.descriptorPool = m_Pool;
-	allocInfo.descriptorSetCount = static_cast<uint32_t>(pSwapChain->GetImages().size());
+	allocInfo.descriptorSetCount = static_cast<uint32_t>(layouts.size());
 	allocInfo.pSetLayouts = layouts.data();
 
-	m_DescriptorSets.resize(pSwapChain->GetImages().size());
-
 	//You don't need to explicitly clean up descriptor sets, because they will be automatically freed
-	//when the desriptor pool is destroyed. The call to vkAllocateDescriptorSets will allocate descriptor
-	//sets, each with one uniform buffer descriptor.
-	if (vkAllocateDescriptorSets(m_pCpu->GetDevice(), &allocInfo, &m_DescriptorSets[0]) != VK_SUCCESS)
+	//when the desriptor pool is destroyed.
+	if (vkAllocateDescriptorSets(m_pCpu->GetDevice(), &allocInfo, m_DescriptorSets.data()) != VK_SUCCESS)
 		throw std::runtime_error("failed to allocate descriptor sets!");
 
+	for (uint32_t index = 0; index < m_DescriptorSets.size(); ++index)
+		UpdateSet(index, pSwapChain, pSampler, textureView);
+}
+
+void DescriptorPool::UpdateTexture(uint32_t index, TextureSampler* pSampler, VkImageView textureView)
+{
+	VkDescriptorImageInfo imageInfo = {};
+	imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	imageInfo.imageView = textureView;
+	imageInfo.sampler = pSampler->GetSampler();
+
+	VkWriteDescriptorSet descriptorWrite = {};
+	descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	descriptorWrite.dstSet = m_DescriptorSets[index];
+	descriptorWrite.dstBinding = 1;
+	descriptorWrite.dstArrayElement = 0;
+	descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	descriptorWrite.descriptorCount = 1;
+	descriptorWrite.pImageInfo = &imageInfo;
+
+	vkUpdateDescriptorSets(m_pCpu->GetDevice(), 1, &descriptorWrite, 0, nullptr);
+}
+
+void DescriptorPool::UpdateSet(uint32_t index, SwapChain* pSwapChain, TextureSampler* pSampler, VkImageView textureView)
+{
+
 
-	//The descriptor sets have been allocated now, but the descriptors within still need to be configured.
-	for (size_t i = 0; i < pSwapChain->GetImages().size(); ++i)
-	{
-		//Descriptors that refer to buffers, like our uniform buffer descriptor, are configured with a vkDescriptorBufferInfo.
-		//This structure specifies the buffer and the region within it that contains the data for the descriptor.
-		VkDescriptorBufferInfo  bufferInfo = {};
-		bufferInfo.buffer = pSwapChain->GetUniformBuffers()[i];
-		bufferInfo.offset = 0;
-		//If you're overwriting the whole buffer, like we are in this case, then it is also possible to use the VK_WHOLE_SIZE
-		//value for the range. The configuration of descriptors is updated using the vkUpdateDescriptorsSets function,
-		//which takes an array of VkWriteDescriptorSet structs as parameter.
-		bufferInfo.range = sizeof(UniformBufferObject);
-
-		//Bind the actual image and sampler resources to the descriptors in the descriptor set.
-
-		//The resources for a combinded image sampler structure must be specified in a VkDescriptorImageInfo struct,
-		//just like the buffer resource for a uniform buffer descriptor is specified in a VkDescriptorBufferInfo struct.
-		VkDescriptorImageInfo imageInfo = {};
-		imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-		imageInfo.imageView = pTexture->GetImageView();
-		imageInfo.sampler = pSampler->GetSampler();
-
-		//The first 2 fields specify the descriptor set to update and the binding.
-		//We gave our uniform buffer binding index 0. Remember that descriptors can be arrays, 
-		//so we also need to specify the first index in the array that we want to update.
-		//We're not using an array, so the index is simply 0.
-		std::array<VkWriteDescriptorSet, 2> descriptorWrites = {};
-		descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		descriptorWrites[0].dstSet = m_DescriptorSets[i];
-		descriptorWrites[0].dstBinding = 0;
-		descriptorWrites[0].dstArrayElement = 0;
-
-		//We need to specify the type of descriptor again. It's possible to update multiple descriptors
-		//at once in an array, starrting at index dstArrayElement. The descriptorCount field specifies
-		//how many array elements you want to update.
-		descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-
-		//pBufferInfo references an array with descriptorCount structs that actually configure the descriptors.
-		//It depends on the type of descriptor which one of the three you actually need to use.
-		//The pBufferInfo field is usedfor descriptors that refer to buffer data, pImageInfo is used for descriptors
-		//that refer to image data, and pTextBufferView is used for descriptors that refer to buffer views.
-		//Our descriptor is based on buffers, so we're using pBufferInfo.
-		descriptorWrites[0].descriptorCount = 1;
-		descriptorWrites[0].pBufferInfo = &bufferInfo;
-		descriptorWrites[0].pImageInfo = nullptr; //Optional
-		descriptorWrites[0].pTexelBufferView = nullptr; //Optional
-
-		descriptorWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		descriptorWrites[1].dstSet = m_DescriptorSets[i];
-		descriptorWrites[1].dstBinding = 1;
-		descriptorWrites[1].dstArrayElement = 0;
-		descriptorWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-		descriptorWrites[1].descriptorCount = 1;
-
-		//The descriptors must be updated with this image info, just like the buffer
-		//This time we're using the pImageInfo array instead of pBufferinfo.
-		//The descriptors are now ready to bused by the shaders!
-		descriptorWrites[1].pImageInfo = &imageInfo;
-
-		//The updates are applied using vkUpdateDescriptorSets.
-		//It accepts two kinds of arrays as parameters:
-		//An array of VkWriteDescriptorSet
-		//An array of VkCopyDescriptorSet.
-		//The latter can be used to copy descriptors to each other, as its name implies.
-		vkUpdateDescriptorSets(m_pCpu->GetDevice(), static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
-	}
+	//The descriptor set has been allocated now, but the descriptors within still need to be configured.
+	//Descriptors that refer to buffers, like our uniform buffer descriptor, are configured with a vkDescriptorBufferInfo.
+	//This structure specifies the buffer and the region within it that contains the data for the descriptor.
+	VkDescriptorBufferInfo  bufferInfo = {};
+	//For a dynamic uniform buffer the offset is added to the dynamic offset that is passed when binding the set,
+	//and the range is the size of a single uniform block. The configuration of descriptors is updated using the
+	//vkUpdateDescriptorsSets function, which takes an array of VkWriteDescriptorSet structs as parameter.
+	bufferInfo.buffer = pSwapChain->GetUniformRing()->GetBuffer();
+	bufferInfo.offset = 0;
+	bufferInfo.range = sizeof(UniformBufferObject);
+
+	//Bind the actual image and sampler resources to the descriptors in the descriptor set.
+
+	//The resources for a combinded image sampler structure must be specified in a VkDescriptorImageInfo struct,
+	//just like the buffer resource for a uniform buffer descriptor is specified in a VkDescriptorBufferInfo struct.
+	VkDescriptorImageInfo imageInfo = {};
+	imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	imageInfo.imageView = textureView;
+	imageInfo.sampler = pSampler->GetSampler();
+
+	//The first 2 fields specify the descriptor set to update and the binding.
+	//We gave our uniform buffer binding index 0. Remember that descriptors can be arrays, 
+	//so we also need to specify the first index in the array that we want to update.
+	//We're not using an array, so the index is simply 0.
+	std::array<VkWriteDescriptorSet, 2> descriptorWrites = {};
+	descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	descriptorWrites[0].dstSet = m_DescriptorSets[index];
+	descriptorWrites[0].dstBinding = 0;
+	descriptorWrites[0].dstArrayElement = 0;
+
+	//We need to specify the type of descriptor again. It's possible to update multiple descriptors
+	//at once in an array, starrting at index dstArrayElement. The descriptorCount field specifies
+	//how many array elements you want to update.
+	descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+
+	//pBufferInfo references an array with descriptorCount structs that actually configure the descriptors.
+	//It depends on the type of descriptor which one of the three you actually need to use.
+	//The pBufferInfo field is usedfor descriptors that refer to buffer data, pImageInfo is used for descriptors
+	//that refer to image data, and pTextBufferView is used for descriptors that refer to buffer views.
+	//Our descriptor is based on buffers, so we're using pBufferInfo.
+	descriptorWrites[0].descriptorCount = 1;
+	descriptorWrites[0].pBufferInfo = &bufferInfo;
+	descriptorWrites[0].pImageInfo = nullptr; //Optional
+	descriptorWrites[0].pTexelBufferView = nullptr; //Optional
+
+	descriptorWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	descriptorWrites[1].dstSet = m_DescriptorSets[index];
+	descriptorWrites[1].dstBinding = 1;
+	descriptorWrites[1].dstArrayElement = 0;
+	descriptorWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	descriptorWrites[1].descriptorCount = 1;
+
+	//The descriptors must be updated with this image info, just like the buffer
+	//This time we're using the pImageInfo array instead of pBufferinfo.
+	//The descriptors are now ready to bused by the shaders!
+	descriptorWrites[1].pImageInfo = &imageInfo;
+
+	//The updates are applied using vkUpdateDescriptorSets.
+	//It accepts two kinds of arrays as parameters:
+	//An array of VkWriteDescriptorSet
+	//An array of VkCopyDescriptorSet.
+	//The latter can be used to copy descriptors to each other, as its name implies.
+	vkUpdateDescriptorSets(m_pCpu->GetDevice(), static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
 
 	//As some of the structues and function calls hinted at,
 	//it is actually possible to bind multiple descriptor sets simultaneously.
@@ -11,21 +11,26 @@ class LogicalDevice;
 class SwapChain;
 class DescriptorSetLayout;
 class TextureSampler;
-class Texture;
-
-
 
+//Holds a descriptor set per frame in flight. They are identical, except while a texture view is being replaced:
+//a set may only be written while no submitted frame uses it, so every frame updates its own set before recording.
 class DescriptorPool
 {
 public:
-	DescriptorPool(LogicalDevice* pCpu, size_t nrOfSwapChainImages);
+	DescriptorPool(LogicalDevice* pCpu, uint32_t setCount);
 	~DescriptorPool();
 
-	void CreateDescriptorSets(SwapChain* pSwapChain, DescriptorSetLayout* pDescSetLayout, TextureSampler* pSampler, Texture* pTexture);
+	void CreateDescriptorSets(SwapChain* pSwapChain, DescriptorSetLayout* pDescSetLayout, TextureSampler* pSampler, VkImageView textureView);
+
+	//Points the texture binding of set index to textureView. The frames that used the set must have finished.
+	void UpdateTexture(uint32_t index, TextureSampler* pSampler, VkImageView textureView);
 
 	const VkDescriptorPool& GetPool() const { return m_Pool; }
-	const std::vector<VkDescriptorSet>& GetSets() const { return m_DescriptorSets; }
+	const VkDescriptorSet& GetSet(uint32_t index) const { return m_DescriptorSets[index]; }
 	
+private:
+	void UpdateSet(uint32_t index, SwapChain* pSwapChain, TextureSampler* pSampler, VkImageView textureView);
+
 private:
 	VkDescriptorPool m_Pool;
 	std::vector<VkDescriptorSet> m_DescriptorSets;
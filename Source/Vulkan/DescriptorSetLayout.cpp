@@ -16,14 +16,16 @@ DescriptorSetLayout::DescriptorSetLayout(LogicalDevice* pCpu):
 	//and descriptorCount specifies the number of values in the array. 
 	//This could be used to specify a transformatoin for each of the bones in a skeleton for skeletal animation, for example.
 	//Our MVP transformation is in a single uniform buffer object, so we're using a descriptorCount of 1.
+	//It is a dynamic uniform buffer: the offset into the buffer is supplied when the set is bound,
+	//so a single descriptor set can point at any uniform block in the ring buffer.
 	uboLayoutBinding.binding = 0;
-	uboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	uboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 	uboLayoutBinding.descriptorCount = 1;
 
 	//We also need to specify in which shader stages the descriptor is going to be referenced.
 	//The stageFlags field can be a combination of VkShaderStageFlagBits values or the value VK_SHADER_STAGE_ALL_GRAPHICS.
-	//In our case, we're only referencing the descriptor from the vertex shader.
-	uboLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+	//The vertex shader reads the transformations, the bindless fragment shader reads the texture index.
+	uboLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
 
 	//The pImmutableSamplers field is only relevant for image sampling related descriptors.
 	uboLayoutBinding.pImmutableSamplers = nullptr; //Optional
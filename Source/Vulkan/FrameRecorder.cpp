@@ -0,0 +1,340 @@
+#include "FrameRecorder.h"
+
+#include "LogicalDevice.h"
+#include "PhysicalDevice.h"
+#include "RenderPass.h"
+#include "SwapChain.h"
+#include "VertexBuffer.h"
+#include "IndexBuffer.h"
+#include "GraphicsPipeline.h"
+#include "PipelineLayout.h"
+#include "GpuCuller.h"
+#include "PushConstants.h"
+#include "Profiler.h"
+
+#include "../Help/ThreadPool.h"
+
+#include <array>
+#include <algorithm>
+#include <stdexcept>
+
+FrameRecorder::FrameRecorder(LogicalDevice* pCpu, PhysicalDevice* pGpu, uint32_t framesInFlight, uint32_t threadCount):
+	m_QueueFamily(static_cast<uint32_t>(pGpu->GetDesc().QueueIndices.GraphicsFamily)),
+	m_pCpu(pCpu)
+{
+	m_UniqueThreadPool = std::make_unique<ThreadPool>(threadCount);
+	m_ThreadCount = m_UniqueThreadPool->GetThreadCount();
+
+	//Command pools are not thread safe: a pool, and every command buffer allocated from it, may only be used by one thread at a time.
+	//That's why every worker gets its own pool. On top of that every frame in flight gets its own set of pools,
+	//so we can reset the pools of a frame while the GPU is still executing the command buffers of the previous one.
+	m_Frames.resize(framesInFlight);
+	for (FrameCommands& frame : m_Frames)
+	{
+		frame.PrimaryPool = CreatePool();
+		frame.Primary = AllocateBuffer(frame.PrimaryPool, VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+
+		for (uint32_t i = 0; i < m_ThreadCount; ++i)
+		{
+			frame.SecondaryPools.push_back(CreatePool());
+			frame.Secondaries.push_back(AllocateBuffer(frame.SecondaryPools.back(), VK_COMMAND_BUFFER_LEVEL_SECONDARY));
+		}
+	}
+}
+
+FrameRecorder::~FrameRecorder()
+{
+	//Destroying a pool frees all of the command buffers that were allocated from it.
+	for (FrameCommands& frame : m_Frames)
+	{
+		vkDestroyCommandPool(m_pCpu->GetDevice(), frame.PrimaryPool, nullptr);
+
+		for (VkCommandPool pool : frame.SecondaryPools)
+			vkDestroyCommandPool(m_pCpu->GetDevice(), pool, nullptr);
+	}
+}
+
+VkCommandBuffer FrameRecorder::Record(uint32_t frameIndex, uint32_t imageIndex, const FrameResources& resources, const std::vector<uint32_t>& dynamicOffsets)
+{
+	FrameCommands& frame = m_Frames[frameIndex];
+
+	//Resetting the whole pool is cheaper than resetting every command buffer on its own,
+	//and it lets the driver recycle the memory of last time's commands.
+	vkResetCommandPool(m_pCpu->GetDevice(), frame.PrimaryPool, 0);
+
+	//Every worker records a contiguous slice of the draws. Slices are as equal as possible,
+	//workers without any draws left don't record anything.
+	//An instanced frame is a single draw, so a single worker records it. With push constants the draws are the pushed blocks.
+	size_t drawCount = resources.InstanceBuffer != VK_NULL_HANDLE ? std::min<size_t>(dynamicOffsets.size(), 1) : dynamicOffsets.size();
+	if (resources.pDrawConstants)
+		drawCount = dynamicOffsets.empty() ? 0 : resources.pDrawConstants->size();
+	const uint32_t sliceCount = static_cast<uint32_t>(std::min<size_t>(m_ThreadCount, std::max<size_t>(drawCount, 1)));
+
+	SwapChain* pSwapChain = resources.pSwapChain;
+	RenderGraph& graph = *resources.pRenderGraph;
+	graph.Reset();
+
+	//A swap chain image is presented after the frame, an offscreen one is copied into its readback buffer instead.
+	const bool isHeadless = pSwapChain->IsHeadless();
+	const RenderGraph::ResourceId image = graph.ImportImage("swap chain image", pSwapChain->GetImages()[imageIndex], pSwapChain->GetImageViews()[imageIndex],
+		pSwapChain->GetFormat(), isHeadless ? ResourceUsage::Undefined : ResourceUsage::Acquired, isHeadless ? ResourceUsage::TransferSrc : ResourceUsage::Present);
+
+	//The multisampled color target is resolved into the swap chain image at the end of the subpass.
+	const std::vector<RenderGraph::ResourceId> attachments = { resources.ColorTarget, resources.DepthTarget, image };
+	std::vector<RenderGraph::PassResource> renderPassResources =
+	{
+		{ resources.ColorTarget, ResourceUsage::ColorAttachment },
+		{ resources.DepthTarget, ResourceUsage::DepthAttachment },
+		{ image, ResourceUsage::ColorAttachment }
+	};
+
+	//Dispatches aren't allowed inside a render pass, so the culling goes first.
+	//Everything the culler writes is only used by this frame, whose fence was waited for before the last time, so it starts out undefined.
+	RenderGraph::ResourceId indirectCommand = 0;
+	if (resources.pCuller)
+	{
+		const RenderGraph::ResourceId visibleInstances = graph.ImportBuffer("visible instances", resources.InstanceBuffer, ResourceUsage::Undefined, ResourceUsage::Undefined);
+		indirectCommand = graph.ImportBuffer("indirect command", resources.IndirectBuffer, ResourceUsage::Undefined, ResourceUsage::Undefined);
+
+		graph.AddPass("culling", { { visibleInstances, ResourceUsage::ComputeWrite }, { indirectCommand, ResourceUsage::ComputeWrite } }, [&](VkCommandBuffer commandBuffer)
+		{
+			resources.pCuller->Record(commandBuffer, frameIndex, pSwapChain->GetViewProjection());
+		});
+
+		renderPassResources.push_back({ visibleInstances, ResourceUsage::VertexRead });
+		renderPassResources.push_back({ indirectCommand, ResourceUsage::IndirectRead });
+	}
+
+	graph.AddPass("render pass", renderPassResources, [&](VkCommandBuffer commandBuffer)
+	{
+		const VkFramebuffer framebuffer = graph.GetFramebuffer(resources.pRenderPass->GetRenderPass(), attachments, pSwapChain->GetExtent());
+
+		//The secondary command buffers have to know the framebuffer, which the graph only has once the attachments exist.
+		m_UniqueThreadPool->ParallelFor(sliceCount, [&](uint32_t slice)
+		{
+			Profiler::CpuScope scope(resources.pProfiler, "record slice");
+			vkResetCommandPool(m_pCpu->GetDevice(), frame.SecondaryPools[slice], 0);
+
+			const size_t first = drawCount * slice / sliceCount;
+			const size_t last = drawCount * (slice + 1) / sliceCount;
+			RecordSlice(frame.Secondaries[slice], framebuffer, resources, dynamicOffsets, first, last);
+		});
+
+		VkRenderPassBeginInfo renderPassInfo = {};
+		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+		renderPassInfo.renderPass = resources.pRenderPass->GetRenderPass();
+		renderPassInfo.framebuffer = framebuffer;
+
+		//the render area defines where shader loads and stores will take place.
+		//The pixels outside this region will have undefined values. It should match the size of the attachments for best performance.
+		renderPassInfo.renderArea.offset = { 0,0 };
+		renderPassInfo.renderArea.extent = pSwapChain->GetExtent();
+
+		std::array<VkClearValue, 2> clearValues = {};
+		clearValues[0].color = { 0.0f, 0.0f, 0.0f, 1.0f };
+
+		//the range of depths in the depth buffer is 0.0 to 1.0 in Vulkan, where 1.0 lies at the far view plane and
+		// 0.0 at the near view plane. The initial value at each point in the depth buffer should be the furthest
+		//possible depth, which is 1.0
+		clearValues[1].depthStencil = { 1.0f, 0 };
+
+		//These parameters define the clear value to use for VK_ATTACHMENT_LOAD_OP_CLEAR
+		//which we used as load operation for the color attachment.
+		renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
+		renderPassInfo.pClearValues = clearValues.data();
+
+		//VK_SUBPASS_CONTENTS_INLINE: The render pass commands will be embedded in the primary command buffer itself
+		//and no secondary dommand will be executed
+		//VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS: The render pass commands iwll be executed from secondary command buffers.
+		//All of our draws are in the secondary command buffers of the workers.
+		vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+		vkCmdExecuteCommands(commandBuffer, sliceCount, frame.Secondaries.data());
+		vkCmdEndRenderPass(commandBuffer);
+	});
+
+	//The copies to host memory are the only outputs of the culling, GetVisibleCount reads it after the fence.
+	if (resources.pCuller)
+	{
+		const RenderGraph::ResourceId visibleCount = graph.ImportBuffer("visible count", resources.pCuller->GetReadbackBuffer(frameIndex),
+			ResourceUsage::Undefined, ResourceUsage::HostRead);
+
+		graph.AddPass("culling readback", { { indirectCommand, ResourceUsage::TransferSrc }, { visibleCount, ResourceUsage::TransferDst } }, [&](VkCommandBuffer commandBuffer)
+		{
+			resources.pCuller->RecordReadback(commandBuffer, frameIndex);
+		});
+	}
+
+	if (isHeadless)
+	{
+		const RenderGraph::ResourceId pixels = graph.ImportBuffer("readback buffer", pSwapChain->GetReadbackBuffers()[imageIndex],
+			ResourceUsage::Undefined, ResourceUsage::HostRead);
+
+		graph.AddPass("readback", { { image, ResourceUsage::TransferSrc }, { pixels, ResourceUsage::TransferDst } }, [&](VkCommandBuffer commandBuffer)
+		{
+			RecordReadback(commandBuffer, pSwapChain, imageIndex);
+		});
+	}
+
+	VkCommandBufferBeginInfo beginInfo = {};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+
+	//The flags parameter specifies how we're going to use the command buffer. the following values are available:
+	//VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT: The command buffer will be rerecorded right after executing one.
+	//VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT: This is a secondary command buffer that will be entirely within a single render pass.
+	//VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT: The command buffer can be resubmitted while it is also already pending exection.
+	//We record a new command buffer every frame, so it is only submitted once.
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+	if (vkBeginCommandBuffer(frame.Primary, &beginInfo) != VK_SUCCESS)
+		throw std::runtime_error("failed to begin recording command buffer!");
+
+	graph.Execute(frame.Primary, resources.pProfiler);
+
+	if (vkEndCommandBuffer(frame.Primary) != VK_SUCCESS)
+		throw std::runtime_error("failed to record command buffer!");
+
+	return frame.Primary;
+}
+
+VkCommandPool FrameRecorder::CreatePool() const
+{
+	//VK_COMMAND_POOL_CREATE_TRANSIENT_BIT: hint that command buffers are rerecorded with new command very often
+	//This may change memory allocatoin behaviour, which is exactly what happens here: everything is rerecorded every frame.
+	VkCommandPoolCreateInfo poolInfo = {};
+	poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	poolInfo.queueFamilyIndex = m_QueueFamily;
+	poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+	VkCommandPool pool;
+	if (vkCreateCommandPool(m_pCpu->GetDevice(), &poolInfo, nullptr, &pool) != VK_SUCCESS)
+		throw std::runtime_error("failed to create command pool!");
+
+	return pool;
+}
+
+VkCommandBuffer FrameRecorder::AllocateBuffer(VkCommandPool pool, VkCommandBufferLevel level) const
+{
+	//The level parameter specifies if the allocated command buffers are primary or secondary command buffers.
+	//VK_COMMAND_BUFFER_LEVEL_PRIMARY: Can be submitted to a queue for exection, but cannot be called from other command buffers.
+	//VK_COMMAND_BUFFER_LEVEL_SECONDARY: Cannot be submitted directly, but can be called from primary command buffers.
+	VkCommandBufferAllocateInfo allocInfo = {};
+	allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	allocInfo.commandPool = pool;
+	allocInfo.level = level;
+	allocInfo.commandBufferCount = 1;
+
+	VkCommandBuffer commandBuffer;
+	if (vkAllocateCommandBuffers(m_pCpu->GetDevice(), &allocInfo, &commandBuffer) != VK_SUCCESS)
+		throw std::runtime_error("failed to allocate command buffers!");
+
+	return commandBuffer;
+}
+
+void FrameRecorder::RecordSlice(VkCommandBuffer commandBuffer, VkFramebuffer framebuffer, const FrameResources& resources, const std::vector<uint32_t>& dynamicOffsets, size_t first, size_t last) const
+{
+	//A secondary command buffer that is executed inside a render pass has to say which render pass and subpass that is.
+	//Passing the framebuffer is optional, but allows the driver to optimize for it.
+	VkCommandBufferInheritanceInfo inheritanceInfo = {};
+	inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+	inheritanceInfo.renderPass = resources.pRenderPass->GetRenderPass();
+	inheritanceInfo.subpass = 0;
+	inheritanceInfo.framebuffer = framebuffer;
+
+	VkCommandBufferBeginInfo beginInfo = {};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+	if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+		throw std::runtime_error("failed to begin recording command buffer!");
+
+	//Secondary command buffers don't inherit any state from the primary one or from each other,
+	//so every slice binds the pipeline and buffers and sets the dynamic state again.
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, resources.pPipeline->GetPipeline());
+
+	VkViewport viewport = {};
+	viewport.x = 0.0f;
+	viewport.y = 0.0f;
+	viewport.width = (float)resources.pSwapChain->GetExtent().width;
+	viewport.height = (float)resources.pSwapChain->GetExtent().height;
+	viewport.minDepth = 0.0f;
+	viewport.maxDepth = 1.0f;
+	vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+
+	VkRect2D scissor = {};
+	scissor.offset = { 0,0 };
+	scissor.extent = resources.pSwapChain->GetExtent();
+	vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+	VkBuffer vertexBuffers[] = { resources.pVertexBuffer->GetBuffer() };
+	VkDeviceSize offsets[] = { 0 };
+
+	//The first 2 parameters, besides the command buffer, specify the offset and number of bindings
+	//we're going to specify vertex buffers for. The last 2 paramets specify the array of vertex buffers
+	//to bind and the byte offsets to start reading vertex data from.
+	vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
+
+	//The instance buffer goes to binding 1, which the vertex input stage advances once per instance.
+	if (resources.InstanceBuffer != VK_NULL_HANDLE)
+		vkCmdBindVertexBuffers(commandBuffer, 1, 1, &resources.InstanceBuffer, offsets);
+
+	//An index buffer is bound with vkCmdBindIndexBuffer which has the index buffer, a byte offset into it,
+	//and the type of the index data as parameters.
+	//The possible types are VK_INDEX_TYPE_UINT16 and VK_INDEX_TYPE_UINT32
+	vkCmdBindIndexBuffer(commandBuffer, resources.pIndexBuffer->GetBuffer(), 0, VK_INDEX_TYPE_UINT32);
+
+	const VkPipelineLayout layout = resources.pPipeline->GetLayout()->GetPipelineLayout();
+	const uint32_t meshIndexCount = static_cast<uint32_t>(resources.pIndexBuffer->GetNrOfIndices());
+	const uint32_t indexCount = resources.IndexCount > 0 ? std::min(resources.IndexCount, meshIndexCount) : meshIndexCount;
+	const uint32_t instanceCount = resources.InstanceBuffer != VK_NULL_HANDLE ? resources.InstanceCount : 1;
+
+	//Binding set 0 again for every draw doesn't disturb set 1, both come from the same pipeline layout.
+	//The texture of a draw is picked by the index in its uniform block, so the table is never bound again.
+	if (resources.TextureTableSet != VK_NULL_HANDLE)
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, layout, 1, 1, &resources.TextureTableSet, 0, nullptr);
+
+	//Draws that push their data share one uniform block, so the set is bound once for the whole slice.
+	if (resources.pDrawConstants && first < last)
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, layout, 0, 1, &resources.DescriptorSet, 1, &dynamicOffsets[0]);
+
+	for (size_t i = first; i < last; ++i)
+	{
+		//The last 2 parameters of vkCmdBindDescriptorSets specify an array of offsets that are used for dynamic descriptors.
+		//Every draw reads its own uniform block from the ring buffer, so only the offset changes between draws.
+		//Pushing the model matrix instead doesn't write any memory at all, it is part of the command buffer.
+		if (resources.pDrawConstants)
+			CmdPushConstants(commandBuffer, layout, VK_SHADER_STAGE_VERTEX_BIT, (*resources.pDrawConstants)[i]);
+		else
+			vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, layout, 0, 1, &resources.DescriptorSet, 1, &dynamicOffsets[i]);
+
+		//the first 2 parameters specify the number of indices and the number of instances.
+		//The next parameter specifies an offset into the index buffer, the second to last parameter speicifes an offset to add to the indices
+		//in the index buffer. the final parameter specifies an offset for instancing, the instance buffer starts at the first copy.
+		//A culled frame reads all of those from the VkDrawIndexedIndirectCommand the culler wrote, only the GPU knows the instance count.
+		if (resources.IndirectBuffer != VK_NULL_HANDLE)
+			vkCmdDrawIndexedIndirect(commandBuffer, resources.IndirectBuffer, 0, 1, sizeof(VkDrawIndexedIndirectCommand));
+		else
+			vkCmdDrawIndexed(commandBuffer, indexCount, instanceCount, 0, 0, 0);
+	}
+
+	if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+		throw std::runtime_error("failed to record command buffer!");
+}
+
+void FrameRecorder::RecordReadback(VkCommandBuffer commandBuffer, SwapChain* pSwapChain, uint32_t imageIndex) const
+{
+	//The render graph has moved the offscreen image to VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL once the resolve was written,
+	//and makes the copy available to the host after the pass. The buffer is tightly packed, just like the staging buffer of a texture upload.
+	VkBufferImageCopy region = {};
+	region.bufferOffset = 0;
+	region.bufferRowLength = 0;
+	region.bufferImageHeight = 0;
+	region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	region.imageSubresource.mipLevel = 0;
+	region.imageSubresource.baseArrayLayer = 0;
+	region.imageSubresource.layerCount = 1;
+	region.imageOffset = { 0, 0, 0 };
+	region.imageExtent = { pSwapChain->GetExtent().width, pSwapChain->GetExtent().height, 1 };
+
+	vkCmdCopyImageToBuffer(commandBuffer, pSwapChain->GetImages()[imageIndex], VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, pSwapChain->GetReadbackBuffers()[imageIndex], 1, &region);
+}
\ No newline at end of file
@@ -0,0 +1,104 @@
+#pragma once
+
+#ifndef GLFW_INCLUDE_VULKAN
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+#endif
+
+#include <vector>
+#include <memory>
+
+#include "RenderGraph.h"
+
+class LogicalDevice;
+class PhysicalDevice;
+class RenderPass;
+class SwapChain;
+class GraphicsPipeline;
+class VertexBuffer;
+class IndexBuffer;
+class ThreadPool;
+class GpuCuller;
+class Profiler;
+struct DrawPushConstants;
+
+//Everything a frame needs to be recorded. These objects outlive the recorder.
+struct FrameResources
+{
+	RenderPass* pRenderPass = nullptr;
+	SwapChain* pSwapChain = nullptr;
+	//Owns the multisampled ColorTarget and the DepthTarget of the render pass, Record builds the passes of the frame in it.
+	RenderGraph* pRenderGraph = nullptr;
+	RenderGraph::ResourceId ColorTarget = 0;
+	RenderGraph::ResourceId DepthTarget = 0;
+	GraphicsPipeline* pPipeline = nullptr;
+	VertexBuffer* pVertexBuffer = nullptr;
+	IndexBuffer* pIndexBuffer = nullptr;
+	VkDescriptorSet DescriptorSet = VK_NULL_HANDLE;
+	//Set 1 when the textures are bindless, bound once per command buffer. See BindlessTextureTable.
+	VkDescriptorSet TextureTableSet = VK_NULL_HANDLE;
+
+	//When set, the frame is a single draw of InstanceCount copies of the mesh, each with the InstanceData at its index
+	//in this buffer, and pPipeline must be an instanced one. Record then takes the one uniform block they share.
+	VkBuffer InstanceBuffer = VK_NULL_HANDLE;
+	uint32_t InstanceCount = 0;
+
+	//When set, Record has the culler fill InstanceBuffer and IndirectBuffer before the render pass, and the single
+	//draw takes its instance count from the indirect command in IndirectBuffer. See GpuCuller.
+	GpuCuller* pCuller = nullptr;
+	VkBuffer IndirectBuffer = VK_NULL_HANDLE;
+
+	//When set, there is a draw per element that pushes it as push constants, and all draws share the uniform block
+	//of the first dynamic offset. pPipeline must have been created with the DrawPushConstants range, see PushConstants.h.
+	const std::vector<DrawPushConstants>* pDrawConstants = nullptr;
+
+	//Number of indices every draw uses from the start of the index buffer, 0 draws the whole mesh.
+	uint32_t IndexCount = 0;
+
+	//When set, the slices are CPU scopes and the passes of the render graph GPU scopes of the current frame.
+	Profiler* pProfiler = nullptr;
+};
+
+//Records the command buffer of every frame from scratch, so the draw list can change from frame to frame.
+//The frame is a render graph of the culling, the render pass and the readbacks, which takes care of the barriers between them.
+//The draws are split in a slice per worker thread. Every worker records its slice in a secondary command buffer
+//from a command pool that only it uses, and the primary command buffer executes them inside the render pass.
+class FrameRecorder
+{
+public:
+	FrameRecorder(LogicalDevice* pCpu, PhysicalDevice* pGpu, uint32_t framesInFlight, uint32_t threadCount);
+	~FrameRecorder();
+
+	//Records one draw of the whole mesh per dynamic uniform offset, or a single instanced draw, see FrameResources::InstanceBuffer,
+	//or the culling and a single indirect draw, see FrameResources::pCuller.
+	//frameIndex selects the command pools, the caller must have waited for the fence of the previous frame that used them.
+	VkCommandBuffer Record(uint32_t frameIndex, uint32_t imageIndex, const FrameResources& resources, const std::vector<uint32_t>& dynamicOffsets);
+
+	uint32_t GetThreadCount() const { return m_ThreadCount; }
+
+private:
+	struct FrameCommands
+	{
+		VkCommandPool PrimaryPool;
+		VkCommandBuffer Primary;
+
+		//One pool and one secondary command buffer per worker thread.
+		std::vector<VkCommandPool> SecondaryPools;
+		std::vector<VkCommandBuffer> Secondaries;
+	};
+
+	VkCommandPool CreatePool() const;
+	VkCommandBuffer AllocateBuffer(VkCommandPool pool, VkCommandBufferLevel level) const;
+
+	void RecordSlice(VkCommandBuffer commandBuffer, VkFramebuffer framebuffer, const FrameResources& resources, const std::vector<uint32_t>& dynamicOffsets, size_t first, size_t last) const;
+	void RecordReadback(VkCommandBuffer commandBuffer, SwapChain* pSwapChain, uint32_t imageIndex) const;
+
+private:
+	std::vector<FrameCommands> m_Frames;
+	uint32_t m_ThreadCount;
+	uint32_t m_QueueFamily;
+
+	std::unique_ptr<ThreadPool> m_UniqueThreadPool;
+
+	LogicalDevice* m_pCpu;
+};
\ No newline at end of file
@@ -0,0 +1,264 @@
+#include "GpuCuller.h"
+
+#include "LogicalDevice.h"
+#include "PhysicalDevice.h"
+#include "UploadManager.h"
+#include "PipelineCache.h"
+#include "ShaderModule.h"
+#include "PushConstants.h"
+
+#include "../Help/HelperMethods.h"
+
+#include <array>
+#include <algorithm>
+#include <stdexcept>
+#include <cstring>
+
+bool GpuCuller::IsSupported(PhysicalDevice* pGpu)
+{
+	const PhysicalDeviceDesc& desc = pGpu->GetDescRef();
+	return (desc.QueueFamilies[desc.QueueIndices.GraphicsFamily].queueFlags & VK_QUEUE_COMPUTE_BIT) != 0;
+}
+
+GpuCuller::GpuCuller(LogicalDevice* pCpu, PhysicalDevice* pGpu, UploadManager* pUploader, PipelineCache* pCache, const std::vector<char>& shaderCode,
+	const std::vector<glm::mat4>& transforms, float meshRadius, uint32_t indexCount, uint32_t framesInFlight):
+	m_IndexCount(indexCount),
+	m_Frames(framesInFlight),
+	m_pCpu(pCpu),
+	m_pGpu(pGpu)
+{
+	//The objects don't move, so their spheres are moved to world space once. A non uniform scale stretches the sphere
+	//into an ellipsoid, the largest axis keeps it inside.
+	m_Objects.reserve(transforms.size());
+	for (const glm::mat4& transform : transforms)
+	{
+		const float scale = std::max({ glm::length(glm::vec3(transform[0])), glm::length(glm::vec3(transform[1])), glm::length(glm::vec3(transform[2])) });
+		m_Objects.push_back({ transform, glm::vec4(glm::vec3(transform[3]), meshRadius * scale) });
+	}
+
+	const VkDeviceSize objectsSize = m_Objects.size() * sizeof(CullObject);
+	CreateBuffer(objectsSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+		m_ObjectBuffer, m_ObjectAllocation, pCpu);
+	pUploader->UploadBuffer(m_ObjectBuffer, m_Objects.data(), objectsSize, VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+
+	//In the worst case every object is visible. The visible buffer is read as InstanceData by the vertex input stage.
+	for (FrameBuffers& frame : m_Frames)
+	{
+		CreateBuffer(m_Objects.size() * sizeof(InstanceData), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			frame.VisibleBuffer, frame.VisibleAllocation, pCpu);
+		CreateBuffer(sizeof(VkDrawIndexedIndirectCommand), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, frame.IndirectBuffer, frame.IndirectAllocation, pCpu);
+		CreateBuffer(sizeof(VkDrawIndexedIndirectCommand), VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			frame.ReadbackBuffer, frame.ReadbackAllocation, pCpu);
+
+		//Nothing has been culled yet, a GetVisibleCount before the first frame finishes reads 0.
+		memset(frame.ReadbackAllocation.pMapped, 0, sizeof(VkDrawIndexedIndirectCommand));
+	}
+
+	CreateDescriptors(framesInFlight);
+	CreatePipeline(pCache, shaderCode);
+}
+
+GpuCuller::~GpuCuller()
+{
+	vkDestroyPipeline(m_pCpu->GetDevice(), m_Pipeline, nullptr);
+	vkDestroyPipelineLayout(m_pCpu->GetDevice(), m_PipelineLayout, nullptr);
+	vkDestroyDescriptorPool(m_pCpu->GetDevice(), m_Pool, nullptr);
+	vkDestroyDescriptorSetLayout(m_pCpu->GetDevice(), m_SetLayout, nullptr);
+
+	for (FrameBuffers& frame : m_Frames)
+	{
+		vkDestroyBuffer(m_pCpu->GetDevice(), frame.VisibleBuffer, nullptr);
+		m_pCpu->GetAllocator()->Free(frame.VisibleAllocation);
+		vkDestroyBuffer(m_pCpu->GetDevice(), frame.IndirectBuffer, nullptr);
+		m_pCpu->GetAllocator()->Free(frame.IndirectAllocation);
+		vkDestroyBuffer(m_pCpu->GetDevice(), frame.ReadbackBuffer, nullptr);
+		m_pCpu->GetAllocator()->Free(frame.ReadbackAllocation);
+	}
+
+	vkDestroyBuffer(m_pCpu->GetDevice(), m_ObjectBuffer, nullptr);
+	m_pCpu->GetAllocator()->Free(m_ObjectAllocation);
+}
+
+void GpuCuller::Record(VkCommandBuffer commandBuffer, uint32_t frameIndex, const glm::mat4& viewProjection) const
+{
+	const FrameBuffers& frame = m_Frames[frameIndex];
+
+	//The shader only counts instances, everything else about the draw is known up front.
+	VkDrawIndexedIndirectCommand command = {};
+	command.indexCount = m_IndexCount;
+	command.instanceCount = 0;
+	command.firstIndex = 0;
+	command.vertexOffset = 0;
+	command.firstInstance = 0;
+	vkCmdUpdateBuffer(commandBuffer, frame.IndirectBuffer, 0, sizeof(command), &command);
+
+	VkMemoryBarrier resetBarrier = {};
+	resetBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	resetBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	resetBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &resetBarrier, 0, nullptr, 0, nullptr);
+
+	PushConstants constants = {};
+	ExtractPlanes(viewProjection, constants.Planes);
+	constants.ObjectCount = static_cast<uint32_t>(m_Objects.size());
+
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_Pipeline);
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_PipelineLayout, 0, 1, &frame.Set, 0, nullptr);
+	CmdPushConstants(commandBuffer, m_PipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, constants);
+	vkCmdDispatch(commandBuffer, (constants.ObjectCount + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1, 1);
+}
+
+void GpuCuller::RecordReadback(VkCommandBuffer commandBuffer, uint32_t frameIndex) const
+{
+	const FrameBuffers& frame = m_Frames[frameIndex];
+
+	VkBufferCopy region = {};
+	region.size = sizeof(VkDrawIndexedIndirectCommand);
+	vkCmdCopyBuffer(commandBuffer, frame.IndirectBuffer, frame.ReadbackBuffer, 1, &region);
+}
+
+uint32_t GpuCuller::GetVisibleCount(uint32_t frameIndex) const
+{
+	VkDrawIndexedIndirectCommand command;
+	memcpy(&command, m_Frames[frameIndex].ReadbackAllocation.pMapped, sizeof(command));
+	return command.instanceCount;
+}
+
+uint32_t GpuCuller::CountVisibleOnCpu(const glm::mat4& viewProjection, float radiusScale) const
+{
+	glm::vec4 planes[6];
+	ExtractPlanes(viewProjection, planes);
+
+	uint32_t count = 0;
+	for (const CullObject& object : m_Objects)
+	{
+		const glm::vec3 center(object.Sphere);
+		const float radius = object.Sphere.w * radiusScale;
+
+		bool isVisible = true;
+		for (const glm::vec4& plane : planes)
+			isVisible = isVisible && glm::dot(glm::vec3(plane), center) + plane.w >= -radius;
+
+		if (isVisible)
+			++count;
+	}
+
+	return count;
+}
+
+void GpuCuller::ExtractPlanes(const glm::mat4& viewProjection, glm::vec4 planes[6])
+{
+	//A point is inside the clip volume when -w <= x <= w, -w <= y <= w and 0 <= z <= w, with Vulkan's depth range.
+	//Each of those inequalities is a plane in world space made out of the rows of the matrix (Gribb and Hartmann).
+	//GLM matrices are column major, so row i is m[0][i], m[1][i], m[2][i], m[3][i].
+	const glm::mat4 transposed = glm::transpose(viewProjection);
+
+	planes[0] = transposed[3] + transposed[0];
+	planes[1] = transposed[3] - transposed[0];
+	planes[2] = transposed[3] + transposed[1];
+	planes[3] = transposed[3] - transposed[1];
+	planes[4] = transposed[2];
+	planes[5] = transposed[3] - transposed[2];
+
+	for (uint32_t i = 0; i < 6; ++i)
+		planes[i] /= glm::length(glm::vec3(planes[i]));
+}
+
+void GpuCuller::CreateDescriptors(uint32_t framesInFlight)
+{
+	//0: the objects, 1: the visible instances, 2: the indirect command.
+	std::array<VkDescriptorSetLayoutBinding, 3> bindings = {};
+	for (uint32_t i = 0; i < bindings.size(); ++i)
+	{
+		bindings[i].binding = i;
+		bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		bindings[i].descriptorCount = 1;
+		bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	}
+
+	VkDescriptorSetLayoutCreateInfo layoutInfo = {};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+	layoutInfo.pBindings = bindings.data();
+
+	if (vkCreateDescriptorSetLayout(m_pCpu->GetDevice(), &layoutInfo, nullptr, &m_SetLayout) != VK_SUCCESS)
+		throw std::runtime_error("failed to create culling descriptor set layout!");
+
+	VkDescriptorPoolSize poolSize = {};
+	poolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	poolSize.descriptorCount = static_cast<uint32_t>(bindings.size()) * framesInFlight;
+
+	VkDescriptorPoolCreateInfo poolInfo = {};
+	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolInfo.poolSizeCount = 1;
+	poolInfo.pPoolSizes = &poolSize;
+	poolInfo.maxSets = framesInFlight;
+
+	if (vkCreateDescriptorPool(m_pCpu->GetDevice(), &poolInfo, nullptr, &m_Pool) != VK_SUCCESS)
+		throw std::runtime_error("failed to create culling descriptor pool!");
+
+	const std::vector<VkDescriptorSetLayout> layouts(framesInFlight, m_SetLayout);
+	std::vector<VkDescriptorSet> sets(framesInFlight);
+
+	VkDescriptorSetAllocateInfo allocInfo = {};
+	allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocInfo.descriptorPool = m_Pool;
+	allocInfo.descriptorSetCount = framesInFlight;
+	allocInfo.pSetLayouts = layouts.data();
+
+	if (vkAllocateDescriptorSets(m_pCpu->GetDevice(), &allocInfo, sets.data()) != VK_SUCCESS)
+		throw std::runtime_error("failed to allocate culling descriptor sets!");
+
+	for (uint32_t frameIndex = 0; frameIndex < framesInFlight; ++frameIndex)
+	{
+		FrameBuffers& frame = m_Frames[frameIndex];
+		frame.Set = sets[frameIndex];
+
+		const std::array<VkDescriptorBufferInfo, 3> bufferInfos = { {
+			{ m_ObjectBuffer, 0, VK_WHOLE_SIZE },
+			{ frame.VisibleBuffer, 0, VK_WHOLE_SIZE },
+			{ frame.IndirectBuffer, 0, VK_WHOLE_SIZE } } };
+
+		std::array<VkWriteDescriptorSet, 3> writes = {};
+		for (uint32_t i = 0; i < writes.size(); ++i)
+		{
+			writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			writes[i].dstSet = frame.Set;
+			writes[i].dstBinding = i;
+			writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			writes[i].descriptorCount = 1;
+			writes[i].pBufferInfo = &bufferInfos[i];
+		}
+
+		vkUpdateDescriptorSets(m_pCpu->GetDevice(), static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+	}
+}
+
+void GpuCuller::CreatePipeline(PipelineCache* pCache, const std::vector<char>& shaderCode)
+{
+	//The planes change every frame and are small, push constants are the cheapest way to get them to the shader.
+	const VkPushConstantRange pushConstantRange = GetPushConstantRange<PushConstants>(VK_SHADER_STAGE_COMPUTE_BIT);
+
+	VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
+	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutInfo.setLayoutCount = 1;
+	pipelineLayoutInfo.pSetLayouts = &m_SetLayout;
+	pipelineLayoutInfo.pushConstantRangeCount = 1;
+	pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+	if (vkCreatePipelineLayout(m_pCpu->GetDevice(), &pipelineLayoutInfo, nullptr, &m_PipelineLayout) != VK_SUCCESS)
+		throw std::runtime_error("failed to create culling pipeline layout!");
+
+	ShaderModule shader = ShaderModule(m_pCpu, shaderCode);
+
+	VkComputePipelineCreateInfo pipelineInfo = {};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+	pipelineInfo.stage.module = shader.GetModule();
+	pipelineInfo.stage.pName = "main";
+	pipelineInfo.layout = m_PipelineLayout;
+
+	m_Pipeline = pCache->CreateComputePipeline(pipelineInfo);
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#ifndef GLFW_INCLUDE_VULKAN
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+#endif
+
+#include <vector>
+
+#include "Vertex.h"
+#include "MemoryAllocator.h"
+
+class LogicalDevice;
+class PhysicalDevice;
+class UploadManager;
+class PipelineCache;
+
+//Frustum culls the objects on the GPU instead of drawing every one of them.
+//Every object is a model matrix and a world space bounding sphere in a storage buffer. Before the render pass a compute
+//shader tests each sphere against the 6 planes of the view frustum, appends the model matrix of every visible object
+//to the visible buffer and counts it in the instance count of a VkDrawIndexedIndirectCommand.
+//The instanced pipeline then draws the mesh with vkCmdDrawIndexedIndirect, reading its InstanceData from the visible buffer,
+//so the CPU never learns how many objects were drawn and nothing has to wait for it.
+//Every frame in flight has its own visible buffer and command, the object buffer is shared.
+class GpuCuller
+{
+public:
+	static const uint32_t WORKGROUP_SIZE = 64;
+
+	//Whether the graphics queue can run the compute shader, the culling is recorded in the frame's command buffer.
+	static bool IsSupported(PhysicalDevice* pGpu);
+
+	//meshRadius bounds the mesh around its model space origin, see Mesh::GetBoundingRadius. Every draw uses the
+	//first indexCount indices of the index buffer.
+	GpuCuller(LogicalDevice* pCpu, PhysicalDevice* pGpu, UploadManager* pUploader, PipelineCache* pCache, const std::vector<char>& shaderCode,
+		const std::vector<glm::mat4>& transforms, float meshRadius, uint32_t indexCount, uint32_t framesInFlight);
+	~GpuCuller();
+
+	//Records the culling of frameIndex into commandBuffer, outside of a render pass. The compute shader writes the indirect
+	//command and the visible buffer of the frame, the render graph makes them visible to the draw, see FrameRecorder.
+	void Record(VkCommandBuffer commandBuffer, uint32_t frameIndex, const glm::mat4& viewProjection) const;
+	//Copies the indirect command of frameIndex to host memory for GetVisibleCount, once the culling has written it.
+	void RecordReadback(VkCommandBuffer commandBuffer, uint32_t frameIndex) const;
+
+	//The instance count the last culling of frameIndex wrote. The fence of that frame must have signaled.
+	uint32_t GetVisibleCount(uint32_t frameIndex) const;
+	//The same test on the CPU, with every radius multiplied by radiusScale, to verify the GPU result.
+	uint32_t CountVisibleOnCpu(const glm::mat4& viewProjection, float radiusScale = 1.0f) const;
+
+	VkBuffer GetVisibleBuffer(uint32_t frameIndex) const { return m_Frames[frameIndex].VisibleBuffer; }
+	VkBuffer GetIndirectBuffer(uint32_t frameIndex) const { return m_Frames[frameIndex].IndirectBuffer; }
+	VkBuffer GetReadbackBuffer(uint32_t frameIndex) const { return m_Frames[frameIndex].ReadbackBuffer; }
+	uint32_t GetObjectCount() const { return static_cast<uint32_t>(m_Objects.size()); }
+
+private:
+	//Matches the Object struct of the compute shader (std430).
+	struct CullObject
+	{
+		glm::mat4 Model;
+		//World space center in xyz, radius in w.
+		glm::vec4 Sphere;
+	};
+
+	struct PushConstants
+	{
+		glm::vec4 Planes[6];
+		uint32_t ObjectCount;
+	};
+
+	struct FrameBuffers
+	{
+		VkBuffer VisibleBuffer = VK_NULL_HANDLE;
+		Allocation VisibleAllocation;
+		VkBuffer IndirectBuffer = VK_NULL_HANDLE;
+		Allocation IndirectAllocation;
+		VkBuffer ReadbackBuffer = VK_NULL_HANDLE;
+		Allocation ReadbackAllocation;
+		VkDescriptorSet Set = VK_NULL_HANDLE;
+	};
+
+	//Left, right, bottom, top, near and far, pointing inwards and normalized so the distance to a plane is a dot product.
+	static void ExtractPlanes(const glm::mat4& viewProjection, glm::vec4 planes[6]);
+
+	void CreateDescriptors(uint32_t framesInFlight);
+	void CreatePipeline(PipelineCache* pCache, const std::vector<char>& shaderCode);
+
+private:
+	std::vector<CullObject> m_Objects;
+	uint32_t m_IndexCount;
+
+	VkBuffer m_ObjectBuffer;
+	Allocation m_ObjectAllocation;
+	std::vector<FrameBuffers> m_Frames;
+
+	VkDescriptorSetLayout m_SetLayout;
+	VkDescriptorPool m_Pool;
+	VkPipelineLayout m_PipelineLayout;
+	VkPipeline m_Pipeline;
+
+	LogicalDevice* m_pCpu;
+	PhysicalDevice* m_pGpu;
+};
@@ -2,21 +2,22 @@
 
 #include "LogicalDevice.h"
 #include "Vertex.h"
-#include "SwapChain.h"
 #include "RenderPass.h"
 #include "DescriptorSetLayout.h"
 #include "PipelineLayout.h"
+#include "PipelineCache.h"
+#include "BindlessTextureTable.h"
 
 #include "../Help/HelperMethods.h"
 
 #include "ShaderModule.h"
 
-GraphicsPipeline::GraphicsPipeline(LogicalDevice* pCpu, SwapChain* pSwapChain, RenderPass* pRenderPass, DescriptorSetLayout* pDescSetLayout) :
+GraphicsPipeline::GraphicsPipeline(LogicalDevice* pCpu, RenderPass* pRenderPass, DescriptorSetLayout* pDescSetLayout, PipelineCache* pCache,
+	VertexFormat vertexFormat, const std::vector<char>& vertShaderCode, const std::vector<char>& fragShaderCode,
+	BindlessTextureTable* pTextureTable, bool isInstanced, const std::vector<VkPushConstantRange>& pushConstantRanges) :
 	m_pCpu(pCpu)
 {
-	std::vector<char> vertShaderCode = ReadFile("../data/shaders/bin/vert.spv");
-	std::vector<char> fragShaderCode = ReadFile("../data/shaders/bin/frag.spv");
-
+	//The SPIR-V is read from disk by the caller, so that file IO can overlap with creating the device and render pass.
 	ShaderModule vertShader = ShaderModule(pCpu, vertShaderCode);
 	ShaderModule fragShader = ShaderModule(pCpu, fragShaderCode);
 
@@ -42,17 +43,44 @@ GraphicsPipeline::GraphicsPipeline(LogicalDevice* pCpu, SwapChain* pSwapChain, R
 	fragShaderStageInfo.module = fragShader.GetModule();
 	fragShaderStageInfo.pName = "main";
 
+	//The bindless fragment shader sizes its texture array with constant 0, so it matches the table on every device.
+	const uint32_t textureTableSize = pTextureTable ? pTextureTable->GetCapacity() : 0;
+
+	VkSpecializationMapEntry specializationEntry = {};
+	specializationEntry.constantID = 0;
+	specializationEntry.offset = 0;
+	specializationEntry.size = sizeof(textureTableSize);
+
+	VkSpecializationInfo specializationInfo = {};
+	specializationInfo.mapEntryCount = 1;
+	specializationInfo.pMapEntries = &specializationEntry;
+	specializationInfo.dataSize = sizeof(textureTableSize);
+	specializationInfo.pData = &textureTableSize;
+
+	if (pTextureTable)
+		fragShaderStageInfo.pSpecializationInfo = &specializationInfo;
+
 	VkPipelineShaderStageCreateInfo shaderStages[] = { vertShaderStageInfo, fragShaderStageInfo };
 
-	VkVertexInputBindingDescription bindingDescription = Vertex::GetBindingDescription();
-	std::array<VkVertexInputAttributeDescription, 3> attributeDescriptions = Vertex::GetAttributeDescriptions();
+	//Both vertex layouts feed the same shader inputs, only the formats and offsets differ.
+	const bool isPacked = vertexFormat == VertexFormat::Packed;
+	std::vector<VkVertexInputBindingDescription> bindingDescriptions = { isPacked ? PackedVertex::GetBindingDescription() : Vertex::GetBindingDescription() };
+	const std::array<VkVertexInputAttributeDescription, 3> vertexAttributes = isPacked ? PackedVertex::GetAttributeDescriptions() : Vertex::GetAttributeDescriptions();
+	std::vector<VkVertexInputAttributeDescription> attributeDescriptions(vertexAttributes.begin(), vertexAttributes.end());
+
+	if (isInstanced)
+	{
+		bindingDescriptions.push_back(InstanceData::GetBindingDescription());
+		const std::array<VkVertexInputAttributeDescription, 4> instanceAttributes = InstanceData::GetAttributeDescriptions();
+		attributeDescriptions.insert(attributeDescriptions.end(), instanceAttributes.begin(), instanceAttributes.end());
+	}
 
 	//The pVertexBindingDescriptions and pVertexAttributeDescriptions members point to an array
 	//of structs that describe that aformentinoed details for loading vertex data.
 	VkPipelineVertexInputStateCreateInfo vertexInputInfo = {};
 	vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-	vertexInputInfo.vertexBindingDescriptionCount = 1;
-	vertexInputInfo.pVertexBindingDescriptions = &bindingDescription; //Optional
+	vertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(bindingDescriptions.size());
+	vertexInputInfo.pVertexBindingDescriptions = bindingDescriptions.data(); //Optional
 	vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
 	vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data(); //Optional
 
@@ -65,24 +93,14 @@ GraphicsPipeline::GraphicsPipeline(LogicalDevice* pCpu, SwapChain* pSwapChain, R
 	inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
 	inputAssembly.primitiveRestartEnable = VK_FALSE;
 
-	VkViewport viewport = {};
-	viewport.x = 0.0f;
-	viewport.y = 0.0f;
-	viewport.width = (float)pSwapChain->GetExtent().width;
-	viewport.height = (float)pSwapChain->GetExtent().height;
-	viewport.minDepth = 0.0f;
-	viewport.maxDepth = 1.0f;
-
-	VkRect2D scissor = {};
-	scissor.offset = { 0,0 };
-	scissor.extent = pSwapChain->GetExtent();
-
+	//The viewport and scissor are dynamic state, set with vkCmdSetViewport and vkCmdSetScissor when recording,
+	//so only their count is part of the pipeline.
 	VkPipelineViewportStateCreateInfo viewportState = {};
 	viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
 	viewportState.viewportCount = 1;
-	viewportState.pViewports = &viewport;
+	viewportState.pViewports = nullptr;
 	viewportState.scissorCount = 1;
-	viewportState.pScissors = &scissor;
+	viewportState.pScissors = nullptr;
 
 	//The rasterizer takes the geometry that is shaped by the vertices from the vertex shader and turns
 	//it into fragments to be colored by the fragment shader. It also performs depth testing, face culling and the scissor test,
@@ -207,9 +225,10 @@ GraphicsPipeline::GraphicsPipeline(LogicalDevice* pCpu, SwapChain* pSwapChain, R
 	//recreating the pipeline. Examples are the size of the viewport, line width and blend constants.
 	//Examples are the size of the viewport, line width and blend constant. if you want to do that, then yo'll
 	//have to fill in a VkPipelineDynamicStateCreateInfo structure like this:
+	//We use it for the viewport and scissor, which change with the size of the window.
 	VkDynamicState dynamicStates[] = {
 		VK_DYNAMIC_STATE_VIEWPORT,
-		VK_DYNAMIC_STATE_LINE_WIDTH
+		VK_DYNAMIC_STATE_SCISSOR
 	};
 
 	VkPipelineDynamicStateCreateInfo dynamicState = {};
@@ -229,7 +248,7 @@ GraphicsPipeline::GraphicsPipeline(LogicalDevice* pCpu, SwapChain* pSwapChain, R
 
 	//if (vkCreatePipelineLayout(m_UniqueCpu->GetDevice(), &pipelineLayoutInfo, nullptr, &m_PipelineLayout) != VK_SUCCESS)
 	//	throw std::runtime_error("failed to create pipeline layout");
-	m_UniqueLayout = std::make_unique<PipelineLayout>(pCpu, pDescSetLayout);
+	m_UniqueLayout = std::make_unique<PipelineLayout>(pCpu, pDescSetLayout, pTextureTable ? pTextureTable->GetLayout() : VK_NULL_HANDLE, pushConstantRanges);
 
 	VkPipelineDepthStencilStateCreateInfo depthStencil = {};
 	depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
@@ -276,7 +295,7 @@ GraphicsPipeline::GraphicsPipeline(LogicalDevice* pCpu, SwapChain* pSwapChain, R
 	pipelineInfo.pMultisampleState = &multiSampling;
 	pipelineInfo.pDepthStencilState = &depthStencil; //Optional
 	pipelineInfo.pColorBlendState = &colorBlending;
-	pipelineInfo.pDynamicState = nullptr; //Optional
+	pipelineInfo.pDynamicState = &dynamicState;
 
 	//then the pipeline layout, which is a Vulkan handle rather than a struct pointer
 	pipelineInfo.layout = m_UniqueLayout->GetPipelineLayout();
@@ -300,12 +319,11 @@ GraphicsPipeline::GraphicsPipeline(LogicalDevice* pCpu, SwapChain* pSwapChain, R
 
 	//The vkCreateGraphicsPipelines function actually has more parameters than the usual object creation functions in Vulkan.
 	//It is designed to take multiple vkGraphicsPipelineCreateInfo objects and create multiple VkPipeline objects in a single call.
-	//The second parameter for which we've passed VK_NULL_HANDLE argument, references an optional VkPipelineCache object.
+	//The second parameter references an optional VkPipelineCache object.
 	//A pipeline cache can be used to store and reuse data relevant to pipeline creation across multiple calls to vkCreateGraphicsPipelines.
 	//and even across program executions if the cache is stored to a file. This makes it possible to significantly speed up pipeline
-	//creation at a later time.
-	if (vkCreateGraphicsPipelines(pCpu->GetDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &m_Pipeline) != VK_SUCCESS)
-		throw std::runtime_error("failed to create graphics pipeline!");
+	//creation at a later time. Our PipelineCache is loaded from and saved to disk, and makes the call for us.
+	m_Pipeline = pCache->CreateGraphicsPipeline(pipelineInfo);
 
 }
 
@@ -6,17 +6,27 @@
 #endif
 
 #include <memory>
+#include <vector>
+
+#include "Vertex.h"
 
 class LogicalDevice;
-class SwapChain;
 class RenderPass;
 class DescriptorSetLayout;
 class PipelineLayout;
+class PipelineCache;
+class BindlessTextureTable;
 
+//isInstanced adds the per instance binding of InstanceData, which the instanced vertex shader reads the model matrix from.
+//pushConstantRanges end up in the pipeline layout, see PushConstants.h.
+//The viewport and scissor are dynamic, so the pipeline doesn't depend on the size of the swap chain and survives its recreation.
 class GraphicsPipeline
 {
 public: 
-	GraphicsPipeline(LogicalDevice* pCpu, SwapChain* pSwapChain, RenderPass* pRenderPass, DescriptorSetLayout* pDescSetLayout);
+	GraphicsPipeline(LogicalDevice* pCpu, RenderPass* pRenderPass, DescriptorSetLayout* pDescSetLayout, PipelineCache* pCache,
+		VertexFormat vertexFormat, const std::vector<char>& vertShaderCode, const std::vector<char>& fragShaderCode,
+		BindlessTextureTable* pTextureTable = nullptr, bool isInstanced = false,
+		const std::vector<VkPushConstantRange>& pushConstantRanges = std::vector<VkPushConstantRange>());
 	~GraphicsPipeline();
 
 	const VkPipeline& GetPipeline() const { return m_Pipeline; }
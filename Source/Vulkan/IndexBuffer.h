@@ -8,24 +8,24 @@
 #include <vector>
 
 #include "../Vulkan/Vertex.h"
+#include "MemoryAllocator.h"
 
 class LogicalDevice;
-class CommandPool;
-class PhysicalDevice;
+class UploadManager;
 
 class IndexBuffer
 {
 public:
-	IndexBuffer(LogicalDevice* pCpu, PhysicalDevice* pGpu, CommandPool* pCommandBuffer, const std::vector<uint32_t>& indices);
+	IndexBuffer(LogicalDevice* pCpu, UploadManager* pUploader, const uint32_t* pIndices, size_t indexCount);
 	~IndexBuffer();
 	
 	const VkBuffer& GetBuffer() const { return m_Buffer; }
-	const VkDeviceMemory GetBufferMemory() const { return m_BufferMemory; }
+	const Allocation& GetBufferAllocation() const { return m_BufferAllocation; }
 	size_t GetNrOfIndices() const { return m_NrOfIndices; }
 
 private:
 	VkBuffer m_Buffer;
-	VkDeviceMemory m_BufferMemory;
+	Allocation m_BufferAllocation;
 	size_t m_NrOfIndices;
 	LogicalDevice* m_pCpu;
 };
\ No newline at end of file
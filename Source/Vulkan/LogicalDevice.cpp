@@ -2,6 +2,7 @@
 
 #include <vector>
 #include <set>
+#include <cstring>
 
 #include "PhysicalDevice.h"
 #include "VulkanInstance.h"
@@ -20,7 +21,7 @@ LogicalDevice::LogicalDevice(VulkanInstance* pInstance, PhysicalDevice* pGpu, co
 	//Vulkan lets you assign priorities to queues to influence the scheduling of command buffer exectuion using
 	//floating point numbers between 0.0 and 1.0. This is required even if there is only a single queue.
 	std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
-	std::set<int> uniqueQueueFamilies = { indices.GraphicsFamily, indices.PresentFamily };
+	std::set<int> uniqueQueueFamilies = { indices.GraphicsFamily, indices.PresentFamily, indices.TransferFamily };
 
 	float queuePriority = 1.0f;
 
@@ -28,7 +29,7 @@ LogicalDevice::LogicalDevice(VulkanInstance* pInstance, PhysicalDevice* pGpu, co
 	{
 		VkDeviceQueueCreateInfo queueCreateInfo = {};
 		queueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
-		queueCreateInfo.queueFamilyIndex = indices.GraphicsFamily;
+		queueCreateInfo.queueFamilyIndex = queueFamiliy;
 		queueCreateInfo.queueCount = 1;
 		queueCreateInfo.pQueuePriorities = &queuePriority;
 
@@ -60,6 +61,18 @@ LogicalDevice::LogicalDevice(VulkanInstance* pInstance, PhysicalDevice* pGpu, co
 	createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
 	createInfo.ppEnabledExtensionNames = extensions.data();
 
+	//Features of extensions are enabled through the pNext chain. The bindless texture table only asks for
+	//VK_EXT_descriptor_indexing when the device supports partially bound descriptors, see BindlessTextureTable.
+	VkPhysicalDeviceDescriptorIndexingFeaturesEXT indexingFeatures = {};
+	indexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+	indexingFeatures.descriptorBindingPartiallyBound = VK_TRUE;
+
+	for (const char* extension : extensions)
+	{
+		if (strcmp(extension, VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME) == 0)
+			createInfo.pNext = &indexingFeatures;
+	}
+
 	//we will enable the same validatoin layers for devices as we did for the instance.
 	//We won't need any device specific extensoins for now.
 	if (pInstance->AreValidationLayersEnabled())
@@ -74,10 +87,18 @@ LogicalDevice::LogicalDevice(VulkanInstance* pInstance, PhysicalDevice* pGpu, co
 		throw std::runtime_error("failed to create logical device!");
 
 	vkGetDeviceQueue(m_Device, indices.GraphicsFamily, 0, &m_GraphicsQueue);
-	vkGetDeviceQueue(m_Device, indices.GraphicsFamily, 0, &m_PresentQueue);
+	vkGetDeviceQueue(m_Device, indices.PresentFamily, 0, &m_PresentQueue);
+	vkGetDeviceQueue(m_Device, indices.TransferFamily, 0, &m_TransferQueue);
+
+	//Every buffer and image sub-allocates its memory from here instead of calling vkAllocateMemory itself.
+	m_UniqueAllocator = std::make_unique<MemoryAllocator>(this, pGpu);
 }
 
 LogicalDevice::~LogicalDevice()
 {
+	//The memory blocks have to be released before the device that owns them.
+	m_UniqueAllocator->PrintStats();
+	m_UniqueAllocator.reset();
+
 	vkDestroyDevice(m_Device, nullptr);
 }
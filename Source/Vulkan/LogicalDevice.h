@@ -6,6 +6,9 @@
 #endif
 
 #include <vector>
+#include <memory>
+
+#include "MemoryAllocator.h"
 
 class PhysicalDevice;
 class VulkanInstance;
@@ -22,9 +25,15 @@ public:
 	VkQueue GetGraphicsQueue() const { return m_GraphicsQueue; }
 	VkQueue GetPresentQueue() const { return m_PresentQueue; }
 
+	//The queue of QueueFamilyIndices::TransferFamily, which is the graphics queue if the device has no dedicated one.
+	VkQueue GetTransferQueue() const { return m_TransferQueue; }
+	MemoryAllocator* GetAllocator() const { return m_UniqueAllocator.get(); }
+
 private:
 	VkDevice m_Device;
 	VkQueue m_GraphicsQueue;
 	VkQueue m_PresentQueue;
+	VkQueue m_TransferQueue;
+	std::unique_ptr<MemoryAllocator> m_UniqueAllocator;
 
 };
\ No newline at end of file
@@ -0,0 +1,329 @@
+#include "MemoryAllocator.h"
+
+#include "LogicalDevice.h"
+#include "PhysicalDevice.h"
+
+#include "../Help/HelperMethods.h"
+
+#include <stdexcept>
+#include <iostream>
+#include <algorithm>
+
+namespace
+{
+	//Large enough that a whole scene fits in a couple of blocks, small enough to not waste a lot of memory
+	//on small heaps. Requests bigger than half a block get their own VkDeviceMemory.
+	const VkDeviceSize DEFAULT_BLOCK_SIZE = 64ull * 1024 * 1024;
+
+	VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+}
+
+float MemoryStats::GetFragmentation() const
+{
+	const VkDeviceSize bytesFree = BytesReserved - BytesUsed;
+	if (bytesFree == 0)
+		return 0.0f;
+
+	return 1.0f - static_cast<float>(LargestFreeRange) / static_cast<float>(bytesFree);
+}
+
+MemoryAllocator::MemoryAllocator(LogicalDevice* pCpu, PhysicalDevice* pGpu):
+	m_pCpu(pCpu),
+	m_pGpu(pGpu),
+	m_MemProperties(pGpu->GetDesc().MemProperties),
+	m_BufferImageGranularity(pGpu->GetDesc().Properties.limits.bufferImageGranularity),
+	m_MaxAllocationCount(pGpu->GetDesc().Properties.limits.maxMemoryAllocationCount),
+	m_DeviceAllocationCount(0),
+	m_DedicatedAllocationCount(0),
+	m_DedicatedBytes(0)
+{
+}
+
+MemoryAllocator::~MemoryAllocator()
+{
+	for (Block& block : m_Blocks)
+	{
+		if (block.Memory != VK_NULL_HANDLE)
+			FreeDeviceMemory(block.Memory);
+	}
+}
+
+Allocation MemoryAllocator::Allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, bool isOptimalImage)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	Allocation allocation = {};
+	allocation.MemoryTypeIndex = FindMemoryType(requirements.memoryTypeBits, properties, m_pGpu);
+
+	//Linear resources (buffers and linear images) and optimal images that live next to each other in the same
+	//VkDeviceMemory must not share a "page" of bufferImageGranularity bytes, or they may alias on some hardware.
+	//Instead of tracking the kind of resource on both sides of every range, we simply start and end every optimal image
+	//on a page boundary. Linear resources can then be packed tightly around them.
+	VkDeviceSize size = requirements.size;
+	VkDeviceSize alignment = requirements.alignment;
+	if (isOptimalImage)
+	{
+		alignment = std::max(alignment, m_BufferImageGranularity);
+		size = AlignUp(size, m_BufferImageGranularity);
+	}
+
+	const VkDeviceSize blockSize = GetBlockSize(allocation.MemoryTypeIndex);
+
+	//Big resources, like render targets, would only fragment the blocks. Give them their own memory.
+	if (size > blockSize / 2)
+	{
+		void* pMapped = nullptr;
+		allocation.Memory = AllocateDeviceMemory(requirements.size, allocation.MemoryTypeIndex, &pMapped);
+		allocation.Size = requirements.size;
+		allocation.pMapped = pMapped;
+		allocation.IsDedicated = true;
+
+		++m_DedicatedAllocationCount;
+		m_DedicatedBytes += requirements.size;
+		return allocation;
+	}
+
+	for (uint32_t i = 0; i < m_Blocks.size(); ++i)
+	{
+		Block& block = m_Blocks[i];
+		if (block.Memory == VK_NULL_HANDLE || block.MemoryTypeIndex != allocation.MemoryTypeIndex)
+			continue;
+
+		if (AllocateFromBlock(block, size, alignment, allocation))
+		{
+			allocation.BlockIndex = i;
+			return allocation;
+		}
+	}
+
+	const uint32_t blockIndex = CreateBlock(allocation.MemoryTypeIndex);
+	if (!AllocateFromBlock(m_Blocks[blockIndex], size, alignment, allocation))
+		throw std::runtime_error("failed to sub-allocate from a new memory block!");
+
+	allocation.BlockIndex = blockIndex;
+	return allocation;
+}
+
+void MemoryAllocator::Free(Allocation& allocation)
+{
+	if (allocation.Memory == VK_NULL_HANDLE)
+		return;
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	if (allocation.IsDedicated)
+	{
+		FreeDeviceMemory(allocation.Memory);
+		--m_DedicatedAllocationCount;
+		m_DedicatedBytes -= allocation.Size;
+		allocation = {};
+		return;
+	}
+
+	Block& block = m_Blocks[allocation.BlockIndex];
+	std::vector<FreeRange>& ranges = block.FreeRanges;
+
+	//Insert the range back in offset order and merge it with the ranges right before and after it.
+	auto next = std::lower_bound(ranges.begin(), ranges.end(), allocation.Offset,
+		[](const FreeRange& range, VkDeviceSize offset) { return range.Offset < offset; });
+	next = ranges.insert(next, { allocation.Offset, allocation.Size });
+
+	if (next + 1 != ranges.end() && next->Offset + next->Size == (next + 1)->Offset)
+	{
+		next->Size += (next + 1)->Size;
+		ranges.erase(next + 1);
+	}
+
+	if (next != ranges.begin() && (next - 1)->Offset + (next - 1)->Size == next->Offset)
+	{
+		(next - 1)->Size += next->Size;
+		ranges.erase(next);
+	}
+
+	--block.AllocationCount;
+	allocation = {};
+
+	//Keep one empty block around per memory type, so that short lived staging buffers
+	//don't allocate and free a whole block every time.
+	if (block.AllocationCount == 0)
+	{
+		for (const Block& other : m_Blocks)
+		{
+			if (&other != &block && other.Memory != VK_NULL_HANDLE && other.MemoryTypeIndex == block.MemoryTypeIndex && other.AllocationCount == 0)
+			{
+				FreeDeviceMemory(block.Memory);
+				block = {};
+				break;
+			}
+		}
+	}
+}
+
+MemoryStats MemoryAllocator::GetStats() const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	MemoryStats stats = {};
+
+	for (const Block& block : m_Blocks)
+	{
+		if (block.Memory == VK_NULL_HANDLE)
+			continue;
+
+		++stats.BlockCount;
+		stats.AllocationCount += block.AllocationCount;
+		stats.BytesReserved += block.Size;
+		stats.BytesUsed += block.Size;
+
+		for (const FreeRange& range : block.FreeRanges)
+		{
+			++stats.FreeRangeCount;
+			stats.BytesUsed -= range.Size;
+			stats.LargestFreeRange = std::max(stats.LargestFreeRange, range.Size);
+		}
+	}
+
+	stats.DedicatedAllocationCount = m_DedicatedAllocationCount;
+	stats.AllocationCount += m_DedicatedAllocationCount;
+	stats.BytesReserved += m_DedicatedBytes;
+	stats.BytesUsed += m_DedicatedBytes;
+
+	return stats;
+}
+
+void MemoryAllocator::PrintStats() const
+{
+	const MemoryStats stats = GetStats();
+	const double mib = 1024.0 * 1024.0;
+
+	std::cout << "device memory: " << stats.AllocationCount << " allocations in "
+		<< stats.BlockCount << " blocks + " << stats.DedicatedAllocationCount << " dedicated ("
+		<< m_DeviceAllocationCount << "/" << m_MaxAllocationCount << " vkAllocateMemory calls)" << std::endl;
+	std::cout << "device memory: " << stats.BytesUsed / mib << " MiB used of " << stats.BytesReserved / mib << " MiB reserved, "
+		<< stats.FreeRangeCount << " free ranges, largest " << stats.LargestFreeRange / mib << " MiB, fragmentation "
+		<< stats.GetFragmentation() * 100.0f << "%" << std::endl;
+}
+
+VkDeviceMemory MemoryAllocator::AllocateDeviceMemory(VkDeviceSize size, uint32_t memoryTypeIndex, void** ppMapped)
+{
+	//maxMemoryAllocationCount may be as low as 4096, even on high end hardware.
+	if (m_DeviceAllocationCount >= m_MaxAllocationCount)
+		throw std::runtime_error("exceeded maxMemoryAllocationCount!");
+
+	VkMemoryAllocateInfo allocInfo = {};
+	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	allocInfo.allocationSize = size;
+	allocInfo.memoryTypeIndex = memoryTypeIndex;
+
+	VkDeviceMemory memory;
+	if (vkAllocateMemory(m_pCpu->GetDevice(), &allocInfo, nullptr, &memory) != VK_SUCCESS)
+		throw std::runtime_error("failed to allocate device memory!");
+
+	++m_DeviceAllocationCount;
+
+	//A VkDeviceMemory can only be mapped once at a time, so with sub-allocation we map the whole thing
+	//up front and hand out pointers into it. We only ask for host coherent memory when mapping,
+	//so there is no need to flush or invalidate ranges.
+	*ppMapped = nullptr;
+	if (IsHostVisible(memoryTypeIndex))
+	{
+		if (vkMapMemory(m_pCpu->GetDevice(), memory, 0, VK_WHOLE_SIZE, 0, ppMapped) != VK_SUCCESS)
+			throw std::runtime_error("failed to map device memory!");
+	}
+
+	return memory;
+}
+
+void MemoryAllocator::FreeDeviceMemory(VkDeviceMemory memory)
+{
+	//Freeing memory implicitly unmaps it.
+	vkFreeMemory(m_pCpu->GetDevice(), memory, nullptr);
+	--m_DeviceAllocationCount;
+}
+
+bool MemoryAllocator::AllocateFromBlock(Block& block, VkDeviceSize size, VkDeviceSize alignment, Allocation& allocation) const
+{
+	//Best fit: take the smallest free range the request fits in, which keeps the large ranges intact for large requests.
+	auto best = block.FreeRanges.end();
+	VkDeviceSize bestOffset = 0;
+
+	for (auto it = block.FreeRanges.begin(); it != block.FreeRanges.end(); ++it)
+	{
+		const VkDeviceSize offset = AlignUp(it->Offset, alignment);
+		if (offset + size > it->Offset + it->Size)
+			continue;
+
+		if (best == block.FreeRanges.end() || it->Size < best->Size)
+		{
+			best = it;
+			bestOffset = offset;
+		}
+	}
+
+	if (best == block.FreeRanges.end())
+		return false;
+
+	//Split the range in the alignment padding in front, the allocation, and whatever is left behind it.
+	const FreeRange range = *best;
+	const VkDeviceSize padding = bestOffset - range.Offset;
+	const VkDeviceSize remaining = range.Size - padding - size;
+
+	if (padding > 0)
+	{
+		best->Size = padding;
+		if (remaining > 0)
+			block.FreeRanges.insert(best + 1, { bestOffset + size, remaining });
+	}
+	else if (remaining > 0)
+		*best = { bestOffset + size, remaining };
+	else
+		block.FreeRanges.erase(best);
+
+	++block.AllocationCount;
+
+	allocation.Memory = block.Memory;
+	allocation.Offset = bestOffset;
+	allocation.Size = size;
+	allocation.pMapped = block.pMapped ? static_cast<char*>(block.pMapped) + bestOffset : nullptr;
+	allocation.IsDedicated = false;
+	return true;
+}
+
+uint32_t MemoryAllocator::CreateBlock(uint32_t memoryTypeIndex)
+{
+	Block block = {};
+	block.Size = GetBlockSize(memoryTypeIndex);
+	block.MemoryTypeIndex = memoryTypeIndex;
+	block.Memory = AllocateDeviceMemory(block.Size, memoryTypeIndex, &block.pMapped);
+	block.FreeRanges.push_back({ 0, block.Size });
+
+	for (uint32_t i = 0; i < m_Blocks.size(); ++i)
+	{
+		if (m_Blocks[i].Memory == VK_NULL_HANDLE)
+		{
+			m_Blocks[i] = block;
+			return i;
+		}
+	}
+
+	m_Blocks.push_back(block);
+	return static_cast<uint32_t>(m_Blocks.size() - 1);
+}
+
+VkDeviceSize MemoryAllocator::GetBlockSize(uint32_t memoryTypeIndex) const
+{
+	//Don't reserve more than an eighth of a heap in a single block, small heaps (like the 256 MiB
+	//device local + host visible heap on many desktop GPUs) would otherwise be gone after a few blocks.
+	const uint32_t heapIndex = m_MemProperties.memoryTypes[memoryTypeIndex].heapIndex;
+	const VkDeviceSize heapSize = m_MemProperties.memoryHeaps[heapIndex].size;
+
+	return std::min(DEFAULT_BLOCK_SIZE, heapSize / 8);
+}
+
+bool MemoryAllocator::IsHostVisible(uint32_t memoryTypeIndex) const
+{
+	return (m_MemProperties.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) != 0;
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#ifndef GLFW_INCLUDE_VULKAN
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+#endif
+
+#include <vector>
+#include <mutex>
+
+class LogicalDevice;
+class PhysicalDevice;
+
+//A piece of device memory handed out by the MemoryAllocator.
+//Resources bind to Memory at Offset, the allocator owns the VkDeviceMemory itself.
+struct Allocation
+{
+	VkDeviceMemory Memory = VK_NULL_HANDLE;
+	VkDeviceSize Offset = 0;
+	VkDeviceSize Size = 0;
+
+	//Points to the first byte of this allocation when the memory is host visible, nullptr otherwise.
+	//Host visible blocks are mapped once for their whole lifetime, so there is no need to call vkMapMemory.
+	void* pMapped = nullptr;
+
+	uint32_t MemoryTypeIndex = 0;
+	uint32_t BlockIndex = 0;
+	bool IsDedicated = false;
+};
+
+struct MemoryStats
+{
+	uint32_t BlockCount = 0;
+	uint32_t DedicatedAllocationCount = 0;
+	uint32_t AllocationCount = 0;
+	uint32_t FreeRangeCount = 0;
+
+	VkDeviceSize BytesReserved = 0;
+	VkDeviceSize BytesUsed = 0;
+	VkDeviceSize LargestFreeRange = 0;
+
+	//0 when all free memory is one contiguous range, approaching 1 when it is scattered over many small holes.
+	float GetFragmentation() const;
+};
+
+//Reserves large blocks of device memory per memory type and sub-allocates buffers and images from them,
+//so we only need a handful of vkAllocateMemory calls instead of one for every resource.
+class MemoryAllocator
+{
+public:
+	MemoryAllocator(LogicalDevice* pCpu, PhysicalDevice* pGpu);
+	~MemoryAllocator();
+
+	//Allocate and Free may be called from multiple threads at the same time.
+	//isOptimalImage must be true for images with VK_IMAGE_TILING_OPTIMAL, so that they are kept
+	//bufferImageGranularity apart from linear resources that share the same block.
+	Allocation Allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, bool isOptimalImage);
+	void Free(Allocation& allocation);
+
+	MemoryStats GetStats() const;
+	void PrintStats() const;
+
+private:
+	struct FreeRange
+	{
+		VkDeviceSize Offset;
+		VkDeviceSize Size;
+	};
+
+	struct Block
+	{
+		VkDeviceMemory Memory = VK_NULL_HANDLE;
+		VkDeviceSize Size = 0;
+		uint32_t MemoryTypeIndex = 0;
+		void* pMapped = nullptr;
+		uint32_t AllocationCount = 0;
+
+		//Sorted on offset, so a freed range can be merged with its neighbours.
+		std::vector<FreeRange> FreeRanges;
+	};
+
+	VkDeviceMemory AllocateDeviceMemory(VkDeviceSize size, uint32_t memoryTypeIndex, void** ppMapped);
+	void FreeDeviceMemory(VkDeviceMemory memory);
+	bool AllocateFromBlock(Block& block, VkDeviceSize size, VkDeviceSize alignment, Allocation& allocation) const;
+	uint32_t CreateBlock(uint32_t memoryTypeIndex);
+	VkDeviceSize GetBlockSize(uint32_t memoryTypeIndex) const;
+	bool IsHostVisible(uint32_t memoryTypeIndex) const;
+
+private:
+	LogicalDevice* m_pCpu;
+	PhysicalDevice* m_pGpu;
+
+	VkPhysicalDeviceMemoryProperties m_MemProperties;
+	VkDeviceSize m_BufferImageGranularity;
+	uint32_t m_MaxAllocationCount;
+	uint32_t m_DeviceAllocationCount;
+
+	//Released blocks keep their slot so the BlockIndex of live allocations stays valid.
+	std::vector<Block> m_Blocks;
+
+	uint32_t m_DedicatedAllocationCount;
+	VkDeviceSize m_DedicatedBytes;
+
+	mutable std::mutex m_Mutex;
+};
@@ -21,7 +21,8 @@ PhysicalDevice::~PhysicalDevice()
 bool PhysicalDevice::IsSuitable() const
 {
 	bool extensionsSupported = CheckDeviceExtensionSupport(m_RequiredExtensions);
-	bool swapChainAdequate = !m_Desc.SwapChainSupportDetails.Formats.empty() && !m_Desc.SwapChainSupportDetails.PresentModes.empty();
+	//Without a surface (headless) we never create a swap chain, so there is nothing to be adequate for.
+	bool swapChainAdequate = !m_pSurface || (!m_Desc.SwapChainSupportDetails.Formats.empty() && !m_Desc.SwapChainSupportDetails.PresentModes.empty());
 	
 	return m_Desc.QueueIndices.IsComplete() && extensionsSupported && swapChainAdequate && m_Desc.Features.samplerAnisotropy;
 }
@@ -69,7 +70,7 @@ void PhysicalDevice::Initialize()
 	//-------------------------
 	bool extensionsSupported = CheckDeviceExtensionSupport(m_RequiredExtensions);
 
-	if (extensionsSupported)
+	if (extensionsSupported && m_pSurface)
 		m_Desc.SwapChainSupportDetails = FindSwapChainSupport();
 
 	//Features
@@ -125,20 +126,47 @@ QueueFamilyIndices PhysicalDevice::FindQueueFamilies(Surface* pSurface) const
 		if (queueFamily.queueCount > 0 && queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT)
 			indices.GraphicsFamily = i;
 
+		//Headless rendering never presents, so the graphics queue doubles as the present queue.
+		if (!pSurface)
+			indices.PresentFamily = indices.GraphicsFamily;
+
 		if (indices.IsComplete())
 			break;
 
 		//Check for a queue family that has the capability of presenting to our window surface.
 		//The function to check for that is vkGetPhysicalDeviceSurfaceSupportKHR, which takes the
-		//physical device, queue family index and surface as parameters.
-		VkBool32 presentSupport = false;
-		vkGetPhysicalDeviceSurfaceSupportKHR(m_Device, i, pSurface->GetSurface(), &presentSupport);
-		if (queueFamily.queueCount >= 0 && presentSupport)
-			indices.PresentFamily = i;
+		//physical device, queue family index and surface as parameters. Headless there is no surface to ask about.
+		if (pSurface)
+		{
+			VkBool32 presentSupport = false;
+			vkGetPhysicalDeviceSurfaceSupportKHR(m_Device, i, pSurface->GetSurface(), &presentSupport);
+			if (queueFamily.queueCount > 0 && presentSupport)
+				indices.PresentFamily = i;
+		}
 
 		++i;
 	}
 
+	//Prefer a family that can only transfer, then one that can at least not do graphics.
+	//Copies submitted there run next to the rendering instead of queueing up behind it.
+	for (size_t family = 0; family < m_Desc.QueueFamilies.size(); ++family)
+	{
+		const VkQueueFamilyProperties& queueFamily = m_Desc.QueueFamilies[family];
+		if (queueFamily.queueCount == 0 || !(queueFamily.queueFlags & VK_QUEUE_TRANSFER_BIT) || (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT))
+			continue;
+
+		const bool transferOnly = !(queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT);
+		if (indices.TransferFamily < 0 || transferOnly)
+			indices.TransferFamily = static_cast<int>(family);
+
+		if (transferOnly)
+			break;
+	}
+
+	//Graphics queues always support transfers, even if they don't advertise it.
+	if (indices.TransferFamily < 0)
+		indices.TransferFamily = indices.GraphicsFamily;
+
 	return indices;
 
 }
@@ -15,7 +15,12 @@ struct QueueFamilyIndices
 	int GraphicsFamily = -1;
 	int PresentFamily = -1;
 
+	//A family that supports transfers but not graphics, usually backed by the DMA engines of the GPU.
+	//Falls back to the graphics family when the device doesn't have one, so it is always valid once IsComplete is.
+	int TransferFamily = -1;
+
 	bool IsComplete() const { return GraphicsFamily >= 0 && PresentFamily >= 0; }
+	bool HasDedicatedTransfer() const { return TransferFamily >= 0 && TransferFamily != GraphicsFamily; }
 };
 
 struct SwapChainSupportDetails
@@ -51,6 +56,10 @@ public:
 	PhysicalDeviceDesc& GetDescRef() { return m_Desc; }
 	const PhysicalDeviceDesc GetDesc() const { return m_Desc; }
 
+	//Queries the surface again, its capabilities, like the current extent, change when the window is resized.
+	//Not thread safe, nothing else may read the desc while this runs.
+	void UpdateSwapChainSupport() { m_Desc.SwapChainSupportDetails = FindSwapChainSupport(); }
+
 private:
 	void Initialize();
 
@@ -0,0 +1,182 @@
+#include "PipelineCache.h"
+
+#include "LogicalDevice.h"
+#include "PhysicalDevice.h"
+
+#include "../Help/HelperMethods.h"
+
+#include <stdexcept>
+#include <fstream>
+#include <iostream>
+#include <chrono>
+#include <cstring>
+
+namespace
+{
+	//Layout of the header that every implementation puts in front of its pipeline cache data (VK_PIPELINE_CACHE_HEADER_VERSION_ONE).
+	struct PipelineCacheHeader
+	{
+		uint32_t HeaderLength;
+		uint32_t HeaderVersion;
+		uint32_t VendorID;
+		uint32_t DeviceID;
+		uint8_t PipelineCacheUUID[VK_UUID_SIZE];
+	};
+
+	std::vector<char> ReadCacheFile(const std::string& path)
+	{
+		//Unlike ReadFile, a missing cache file is not an error: it simply means this is the first run.
+		std::ifstream file(path, std::ios::ate | std::ios::binary);
+		if (!file.is_open())
+			return {};
+
+		std::vector<char> data(static_cast<size_t>(file.tellg()));
+		file.seekg(0);
+		file.read(data.data(), data.size());
+
+		if (!file)
+			return {};
+
+		return data;
+	}
+}
+
+PipelineCache::PipelineCache(LogicalDevice* pCpu, PhysicalDevice* pGpu, const std::string& path):
+	m_Path(path),
+	m_pGpu(pGpu),
+	m_pCpu(pCpu)
+{
+	std::vector<char> data = ReadCacheFile(m_Path);
+
+	//A cache written by another driver version or another GPU is useless at best. Drivers are supposed to reject
+	//incompatible data themselves, but not all of them do so gracefully, so we check the header ourselves first.
+	std::string reason;
+	if (data.empty())
+		std::cout << "pipeline cache: no cache at " << m_Path << ", starting cold" << std::endl;
+	else if (!IsCompatible(data, reason))
+	{
+		std::cout << "pipeline cache: discarding " << m_Path << " (" << reason << ")" << std::endl;
+		data.clear();
+	}
+	else
+		std::cout << "pipeline cache: loaded " << data.size() << " bytes from " << m_Path << std::endl;
+
+	VkPipelineCacheCreateInfo createInfo = {};
+	createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+	createInfo.initialDataSize = data.size();
+	createInfo.pInitialData = data.empty() ? nullptr : data.data();
+
+	if (vkCreatePipelineCache(pCpu->GetDevice(), &createInfo, nullptr, &m_Cache) != VK_SUCCESS)
+		throw std::runtime_error("failed to create pipeline cache!");
+}
+
+PipelineCache::~PipelineCache()
+{
+	Save();
+	vkDestroyPipelineCache(m_pCpu->GetDevice(), m_Cache, nullptr);
+}
+
+VkPipeline PipelineCache::CreateGraphicsPipeline(const VkGraphicsPipelineCreateInfo& pipelineInfo) const
+{
+	//There is no core way to ask whether a pipeline came out of the cache, and the size of the cache data
+	//doesn't tell either: drivers may grow it on a hit and leave it alone on a miss. The creation time is what we report,
+	//together with the sizes that were loaded and saved, a warm cache shows up as a much shorter creation.
+	auto startTime = std::chrono::high_resolution_clock::now();
+
+	VkPipeline pipeline;
+	if (vkCreateGraphicsPipelines(m_pCpu->GetDevice(), m_Cache, 1, &pipelineInfo, nullptr, &pipeline) != VK_SUCCESS)
+		throw std::runtime_error("failed to create graphics pipeline!");
+
+	PrintCreation(startTime);
+	return pipeline;
+}
+
+VkPipeline PipelineCache::CreateComputePipeline(const VkComputePipelineCreateInfo& pipelineInfo) const
+{
+	auto startTime = std::chrono::high_resolution_clock::now();
+
+	VkPipeline pipeline;
+	if (vkCreateComputePipelines(m_pCpu->GetDevice(), m_Cache, 1, &pipelineInfo, nullptr, &pipeline) != VK_SUCCESS)
+		throw std::runtime_error("failed to create compute pipeline!");
+
+	PrintCreation(startTime);
+	return pipeline;
+}
+
+void PipelineCache::PrintCreation(std::chrono::high_resolution_clock::time_point startTime) const
+{
+	auto now = std::chrono::high_resolution_clock::now();
+
+	std::cout << "pipeline cache: pipeline created in "
+		<< std::chrono::duration<float, std::milli>(now - startTime).count() << " ms" << std::endl;
+}
+
+bool PipelineCache::Save() const
+{
+	size_t size = GetDataSize();
+	std::vector<char> data(size);
+	if (size == 0 || vkGetPipelineCacheData(m_pCpu->GetDevice(), m_Cache, &size, data.data()) != VK_SUCCESS)
+	{
+		std::cerr << "pipeline cache: failed to get cache data" << std::endl;
+		return false;
+	}
+
+	//Write everything to a temporary file first and only then move it over the old cache,
+	//so a crash halfway through writing can never leave a truncated cache behind.
+	const std::string tempPath = m_Path + ".tmp";
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		file.write(data.data(), size);
+		file.flush();
+
+		if (!file)
+		{
+			std::cerr << "pipeline cache: failed to write " << tempPath << std::endl;
+			return false;
+		}
+	}
+
+	if (!AtomicReplaceFile(tempPath, m_Path))
+	{
+		std::cerr << "pipeline cache: failed to replace " << m_Path << std::endl;
+		std::remove(tempPath.c_str());
+		return false;
+	}
+
+	std::cout << "pipeline cache: saved " << size << " bytes to " << m_Path << std::endl;
+	return true;
+}
+
+bool PipelineCache::IsCompatible(const std::vector<char>& data, std::string& reason) const
+{
+	if (data.size() < sizeof(PipelineCacheHeader))
+	{
+		reason = "file is too small";
+		return false;
+	}
+
+	PipelineCacheHeader header;
+	memcpy(&header, data.data(), sizeof(header));
+
+	const VkPhysicalDeviceProperties properties = m_pGpu->GetDesc().Properties;
+
+	if (header.HeaderLength < sizeof(PipelineCacheHeader) || header.HeaderVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE)
+		reason = "unknown header version";
+	else if (header.VendorID != properties.vendorID)
+		reason = "written by another vendor";
+	else if (header.DeviceID != properties.deviceID)
+		reason = "written for another device";
+	else if (memcmp(header.PipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) != 0)
+		reason = "written by another driver version";
+	else
+		return true;
+
+	return false;
+}
+
+size_t PipelineCache::GetDataSize() const
+{
+	size_t size = 0;
+	vkGetPipelineCacheData(m_pCpu->GetDevice(), m_Cache, &size, nullptr);
+	return size;
+}
\ No newline at end of file
@@ -0,0 +1,43 @@
+#pragma once
+
+#ifndef GLFW_INCLUDE_VULKAN
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+#endif
+
+#include <string>
+#include <vector>
+#include <chrono>
+
+class LogicalDevice;
+class PhysicalDevice;
+
+//Wraps a VkPipelineCache that is loaded from disk on creation and written back on destruction,
+//so pipelines only have to be compiled by the driver the first time the application runs.
+class PipelineCache
+{
+public:
+	PipelineCache(LogicalDevice* pCpu, PhysicalDevice* pGpu, const std::string& path);
+	~PipelineCache();
+
+	//Creates the pipeline through the cache and reports how long it took.
+	VkPipeline CreateGraphicsPipeline(const VkGraphicsPipelineCreateInfo& pipelineInfo) const;
+	VkPipeline CreateComputePipeline(const VkComputePipelineCreateInfo& pipelineInfo) const;
+
+	//Returns false (and keeps the old file) if the cache could not be written.
+	bool Save() const;
+
+	const VkPipelineCache& GetCache() const { return m_Cache; }
+
+private:
+	bool IsCompatible(const std::vector<char>& data, std::string& reason) const;
+	size_t GetDataSize() const;
+	void PrintCreation(std::chrono::high_resolution_clock::time_point startTime) const;
+
+private:
+	VkPipelineCache m_Cache;
+	std::string m_Path;
+
+	PhysicalDevice* m_pGpu;
+	LogicalDevice* m_pCpu;
+};
\ No newline at end of file
@@ -3,18 +3,22 @@
 #include "LogicalDevice.h"
 #include "DescriptorSetLayout.h"
 
-PipelineLayout::PipelineLayout(LogicalDevice* pCpu, DescriptorSetLayout* pDescSetLayout):
+PipelineLayout::PipelineLayout(LogicalDevice* pCpu, DescriptorSetLayout* pDescSetLayout, VkDescriptorSetLayout textureTableLayout,
+	const std::vector<VkPushConstantRange>& pushConstantRanges):
 	m_pCpu(pCpu)
 {
 	//We need to specifiy the descriptor set layout during pipeline creation to tell Vulkan which descriptors
 	//the shaders will be using. Descriptor set layouts are specified in the pipeline layout objects.
 	//Modify the VkPipelineLayoutCreateInfo to reference the layout object.
+	const VkDescriptorSetLayout setLayouts[] = { pDescSetLayout->GetDescriptorSetLayout(), textureTableLayout };
+
 	VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
 	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-	pipelineLayoutInfo.setLayoutCount = 1; //Optional
-	pipelineLayoutInfo.pSetLayouts = &pDescSetLayout->GetDescriptorSetLayout(); //Optional
-	pipelineLayoutInfo.pushConstantRangeCount = 0; //Optional
-	pipelineLayoutInfo.pPushConstantRanges = nullptr; //Optional
+	pipelineLayoutInfo.setLayoutCount = textureTableLayout != VK_NULL_HANDLE ? 2 : 1; //Optional
+	pipelineLayoutInfo.pSetLayouts = setLayouts; //Optional
+	//Push constants are the other way to get values to the shaders, small blocks of data recorded into the command buffer.
+	pipelineLayoutInfo.pushConstantRangeCount = static_cast<uint32_t>(pushConstantRanges.size()); //Optional
+	pipelineLayoutInfo.pPushConstantRanges = pushConstantRanges.data(); //Optional
 
 	if (vkCreatePipelineLayout(pCpu->GetDevice(), &pipelineLayoutInfo, nullptr, &m_PipelineLayout) != VK_SUCCESS)
 		throw std::runtime_error("failed to create pipeline layout");
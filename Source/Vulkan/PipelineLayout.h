@@ -5,13 +5,18 @@
 #include <GLFW/glfw3.h>
 #endif
 
+#include <vector>
+
 class LogicalDevice;
 class DescriptorSetLayout;
 
 class PipelineLayout
 {
 public:
-	PipelineLayout(LogicalDevice* pCpu, DescriptorSetLayout* pDescSetLayout);
+	//textureTableLayout is set 1 when the textures are bindless, see BindlessTextureTable.
+	//pushConstantRanges come from GetPushConstantRange, which checks their size at compile time, see PushConstants.h.
+	PipelineLayout(LogicalDevice* pCpu, DescriptorSetLayout* pDescSetLayout, VkDescriptorSetLayout textureTableLayout = VK_NULL_HANDLE,
+		const std::vector<VkPushConstantRange>& pushConstantRanges = std::vector<VkPushConstantRange>());
 	~PipelineLayout();
 
 	const VkPipelineLayout& GetPipelineLayout() const { return m_PipelineLayout; }
@@ -0,0 +1,316 @@
+#include "Profiler.h"
+
+#include "LogicalDevice.h"
+#include "PhysicalDevice.h"
+#include "SetupContext.h"
+
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <map>
+#include <algorithm>
+#include <stdexcept>
+
+namespace
+{
+	//The query the calibration writes, after the queries of the scopes.
+	const uint32_t CALIBRATION_QUERY = Profiler::MAX_GPU_SCOPES * 2;
+}
+
+const uint32_t Profiler::MAX_GPU_SCOPES;
+const uint32_t Profiler::FRAME_HISTORY;
+const uint32_t Profiler::INVALID_SCOPE;
+
+Profiler::CpuScope::CpuScope(Profiler* pProfiler, const char* name):
+	m_pProfiler(pProfiler),
+	m_Name(name),
+	m_Start(pProfiler ? pProfiler->GetCpuTime() : 0.0)
+{
+}
+
+Profiler::CpuScope::~CpuScope()
+{
+	if (!m_pProfiler)
+		return;
+
+	const double end = m_pProfiler->GetCpuTime();
+
+	std::lock_guard<std::mutex> lock(m_pProfiler->m_Mutex);
+	ProfileEvent profileEvent = { m_Name, Track::Cpu, m_pProfiler->GetThreadIndex(), m_Start, end - m_Start };
+	m_pProfiler->AddEvent(m_pProfiler->m_Frame, profileEvent);
+}
+
+Profiler::GpuScope::GpuScope(Profiler* pProfiler, VkCommandBuffer commandBuffer, const char* name):
+	m_pProfiler(pProfiler),
+	m_CommandBuffer(commandBuffer),
+	m_Slot(pProfiler ? pProfiler->BeginGpuScope(commandBuffer, name) : INVALID_SCOPE)
+{
+}
+
+Profiler::GpuScope::~GpuScope()
+{
+	if (m_pProfiler)
+		m_pProfiler->EndGpuScope(m_CommandBuffer, m_Slot);
+}
+
+Profiler::Profiler(LogicalDevice* pCpu, PhysicalDevice* pGpu, SetupContext* pSetupContext):
+	m_pCpu(pCpu),
+	m_Epoch(std::chrono::steady_clock::now()),
+	m_QueryPool(VK_NULL_HANDLE),
+	m_TimestampPeriod(pGpu->GetDesc().Properties.limits.timestampPeriod),
+	m_TimestampMask(0),
+	m_Frames(FRAME_HISTORY),
+	m_GpuSlots(MAX_GPU_SCOPES)
+{
+	//timestampValidBits is 0 when the queue family doesn't support timestamps at all.
+	const PhysicalDeviceDesc desc = pGpu->GetDesc();
+	const uint32_t validBits = desc.QueueFamilies[desc.QueueIndices.GraphicsFamily].timestampValidBits;
+	if (validBits == 0)
+	{
+		std::cout << "profiler: the graphics queue doesn't support timestamps, only the CPU is profiled" << std::endl;
+		return;
+	}
+
+	m_TimestampMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+
+	VkQueryPoolCreateInfo poolInfo = {};
+	poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+	poolInfo.queryCount = MAX_GPU_SCOPES * 2 + 1;
+
+	if (vkCreateQueryPool(m_pCpu->GetDevice(), &poolInfo, nullptr, &m_QueryPool) != VK_SUCCESS)
+		throw std::runtime_error("failed to create timestamp query pool!");
+
+	//Queries have to be reset before they are used or read.
+	pSetupContext->Record([&](VkCommandBuffer commandBuffer)
+	{
+		vkCmdResetQueryPool(commandBuffer, m_QueryPool, 0, poolInfo.queryCount);
+	});
+
+	//Handed out from the back, so the first scopes get the first slots.
+	for (uint32_t slot = MAX_GPU_SCOPES; slot > 0; --slot)
+		m_FreeGpuSlots.push_back(slot - 1);
+}
+
+Profiler::~Profiler()
+{
+	if (m_QueryPool != VK_NULL_HANDLE)
+		vkDestroyQueryPool(m_pCpu->GetDevice(), m_QueryPool, nullptr);
+}
+
+void Profiler::Calibrate(SetupContext* pSetupContext)
+{
+	if (!IsGpuSupported())
+		return;
+
+	//Everything that was recorded before would delay our timestamp, so that goes out and finishes first.
+	pSetupContext->Submit().Wait();
+
+	pSetupContext->Record([&](VkCommandBuffer commandBuffer)
+	{
+		vkCmdResetQueryPool(commandBuffer, m_QueryPool, CALIBRATION_QUERY, 1);
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_QueryPool, CALIBRATION_QUERY);
+	});
+
+	//The timestamp is written somewhere between the submission and the fence, we take the middle.
+	const double submitTime = GetCpuTime();
+	pSetupContext->Submit().Wait();
+	const double waitTime = GetCpuTime();
+
+	uint64_t timestamp = 0;
+	if (vkGetQueryPoolResults(m_pCpu->GetDevice(), m_QueryPool, CALIBRATION_QUERY, 1, sizeof(timestamp), &timestamp, sizeof(timestamp),
+		VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT) != VK_SUCCESS)
+		throw std::runtime_error("failed to read the calibration timestamp!");
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_CalibrationTimestamp = timestamp & m_TimestampMask;
+	m_CalibrationTime = (submitTime + waitTime) * 0.5;
+}
+
+void Profiler::BeginFrame()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	++m_Frame;
+	FrameProfile& frame = m_Frames[m_Frame % FRAME_HISTORY];
+	frame.Frame = m_Frame;
+	frame.Events.clear();
+}
+
+void Profiler::CollectGpuResults()
+{
+	if (!IsGpuSupported())
+		return;
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	for (uint32_t slot = 0; slot < MAX_GPU_SCOPES; ++slot)
+	{
+		GpuScopeSlot& scope = m_GpuSlots[slot];
+		if (!scope.IsPending)
+			continue;
+
+		//A timestamp and its availability for each of the 2 queries. Without VK_QUERY_RESULT_WAIT_BIT this returns
+		//VK_NOT_READY until the GPU has written both, and then we look again next frame.
+		uint64_t results[4] = {};
+		if (vkGetQueryPoolResults(m_pCpu->GetDevice(), m_QueryPool, slot * 2, 2, sizeof(results), results, 2 * sizeof(uint64_t),
+			VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT) != VK_SUCCESS || results[1] == 0 || results[3] == 0)
+			continue;
+
+		if (results[0] == scope.CollectedTimestamp)
+			continue;
+
+		const uint64_t begin = results[0] & m_TimestampMask;
+		const uint64_t end = results[2] & m_TimestampMask;
+
+		//The difference to the calibration is signed, scopes can have been recorded before it.
+		const double start = m_CalibrationTime + (static_cast<double>(begin) - static_cast<double>(m_CalibrationTimestamp)) * m_TimestampPeriod / 1000.0;
+		const double duration = static_cast<double>((end - begin) & m_TimestampMask) * m_TimestampPeriod / 1000.0;
+
+		ProfileEvent profileEvent = { scope.Name, Track::Gpu, 0, start, duration };
+		AddEvent(scope.Frame, profileEvent);
+
+		scope.IsPending = false;
+		scope.CollectedTimestamp = results[0];
+		m_FreeGpuSlots.push_back(slot);
+	}
+}
+
+void Profiler::PrintSummary() const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	//Total time and number of frames per event name, CPU and GPU apart.
+	std::map<std::pair<int, std::string>, std::pair<double, uint32_t>> totals;
+	uint32_t frameCount = 0;
+
+	for (const FrameProfile& frame : m_Frames)
+	{
+		//The current frame is still running.
+		if (frame.Frame == 0 || frame.Frame == m_Frame)
+			continue;
+
+		++frameCount;
+
+		std::map<std::pair<int, std::string>, double> frameTotals;
+		for (const ProfileEvent& profileEvent : frame.Events)
+			frameTotals[std::make_pair(static_cast<int>(profileEvent.EventTrack), std::string(profileEvent.Name))] += profileEvent.Duration;
+
+		for (const auto& frameTotal : frameTotals)
+		{
+			totals[frameTotal.first].first += frameTotal.second;
+			++totals[frameTotal.first].second;
+		}
+	}
+
+	std::cout << "profiler: average ms per frame over the last " << frameCount << " frames" << std::endl;
+	std::cout << std::fixed << std::setprecision(3);
+	for (const auto& total : totals)
+	{
+		std::cout << (total.first.first == static_cast<int>(Track::Cpu) ? "  cpu " : "  gpu ") << std::setw(24) << std::left << total.first.second
+			<< std::right << std::setw(10) << total.second.first / total.second.second / 1000.0 << std::endl;
+	}
+}
+
+void Profiler::WriteChromeTrace(const std::string& path) const
+{
+	std::ofstream file(path);
+	if (!file)
+		throw std::runtime_error("failed to open " + path + " for writing!");
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	//The Trace Event Format: complete events ("X") with a start and a duration in microseconds,
+	//the CPU threads are threads of process 0 and the GPU is process 1.
+	file << std::fixed << std::setprecision(3);
+	file << "{\"traceEvents\":[" << std::endl;
+	file << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"tid\":0,\"args\":{\"name\":\"CPU\"}}," << std::endl;
+	file << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"GPU\"}}";
+
+	for (uint32_t thread = 0; thread < m_Threads.size(); ++thread)
+	{
+		file << "," << std::endl << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << thread
+			<< ",\"args\":{\"name\":\"" << (thread == 0 ? "main" : "worker") << " " << thread << "\"}}";
+	}
+
+	//Oldest frame first.
+	for (uint32_t i = 1; i <= FRAME_HISTORY; ++i)
+	{
+		//Frame 0 is the startup, until the history wraps around.
+		const FrameProfile& frame = m_Frames[(m_Frame + i) % FRAME_HISTORY];
+
+		for (const ProfileEvent& profileEvent : frame.Events)
+		{
+			file << "," << std::endl << "{\"name\":\"" << profileEvent.Name << "\",\"cat\":\"" << (profileEvent.EventTrack == Track::Cpu ? "cpu" : "gpu")
+				<< "\",\"ph\":\"X\",\"pid\":" << (profileEvent.EventTrack == Track::Cpu ? 0 : 1) << ",\"tid\":" << profileEvent.Thread
+				<< ",\"ts\":" << profileEvent.Start << ",\"dur\":" << profileEvent.Duration << ",\"args\":{\"frame\":" << frame.Frame << "}}";
+		}
+	}
+
+	file << std::endl << "]}" << std::endl;
+
+	std::cout << "profiler: wrote the trace of the last frames to " << path << std::endl;
+}
+
+double Profiler::GetCpuTime() const
+{
+	return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - m_Epoch).count();
+}
+
+uint32_t Profiler::GetThreadIndex()
+{
+	//The first thread that records an event is the main thread, there are only a handful, so a linear search is fine.
+	const std::thread::id id = std::this_thread::get_id();
+
+	const auto it = std::find(m_Threads.begin(), m_Threads.end(), id);
+	if (it != m_Threads.end())
+		return static_cast<uint32_t>(it - m_Threads.begin());
+
+	m_Threads.push_back(id);
+	return static_cast<uint32_t>(m_Threads.size() - 1);
+}
+
+void Profiler::AddEvent(uint64_t frame, const ProfileEvent& profileEvent)
+{
+	//Results of frames that have left the history are dropped.
+	FrameProfile& frameProfile = m_Frames[frame % FRAME_HISTORY];
+	if (frameProfile.Frame == frame)
+		frameProfile.Events.push_back(profileEvent);
+}
+
+uint32_t Profiler::BeginGpuScope(VkCommandBuffer commandBuffer, const char* name)
+{
+	if (!IsGpuSupported())
+		return INVALID_SCOPE;
+
+	uint32_t slot = INVALID_SCOPE;
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		//When every slot is waiting for its results, the scope isn't measured rather than waiting for one.
+		if (m_FreeGpuSlots.empty())
+			return INVALID_SCOPE;
+
+		slot = m_FreeGpuSlots.back();
+		m_FreeGpuSlots.pop_back();
+
+		m_GpuSlots[slot].Name = name;
+		m_GpuSlots[slot].Frame = m_Frame;
+		m_GpuSlots[slot].IsPending = true;
+	}
+
+	//The queries of a free slot were last used by a scope whose results have been read, so they can be reset.
+	vkCmdResetQueryPool(commandBuffer, m_QueryPool, slot * 2, 2);
+	vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_QueryPool, slot * 2);
+
+	return slot;
+}
+
+void Profiler::EndGpuScope(VkCommandBuffer commandBuffer, uint32_t scope)
+{
+	if (scope == INVALID_SCOPE)
+		return;
+
+	//Written once all the work before it has completed.
+	vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_QueryPool, scope * 2 + 1);
+}
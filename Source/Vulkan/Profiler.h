@@ -0,0 +1,146 @@
+#pragma once
+
+#ifndef GLFW_INCLUDE_VULKAN
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+#endif
+
+#include <vector>
+#include <string>
+#include <mutex>
+#include <chrono>
+#include <thread>
+
+class LogicalDevice;
+class PhysicalDevice;
+class SetupContext;
+
+//Measures where the frame time goes, on the CPU with scoped markers and on the GPU with timestamp queries.
+//Every event belongs to the frame that was current when it began, the last FRAME_HISTORY frames are kept
+//and can be written as a Chrome trace (chrome://tracing or ui.perfetto.dev) with CPU threads and the GPU as separate tracks.
+//A GPU scope resets and writes its own pair of queries, so it has to begin and end outside a render pass, on a queue
+//that supports timestamps. Its results are read back without waiting once they're available, see CollectGpuResults,
+//so a scope whose command buffer is never submitted keeps its queries.
+//GPU timestamps are mapped onto the CPU clock with one calibration at startup, so their offset to the CPU events is
+//only as good as that, and can drift over long runs.
+//All functions may be called from several threads. The scopes take a null profiler, so instrumented code needs no checks.
+class Profiler
+{
+public:
+	static const uint32_t MAX_GPU_SCOPES = 512;
+	static const uint32_t FRAME_HISTORY = 256;
+	static const uint32_t INVALID_SCOPE = ~0u;
+
+	class CpuScope
+	{
+	public:
+		//name must outlive the profiler, string literals are fine.
+		CpuScope(Profiler* pProfiler, const char* name);
+		~CpuScope();
+
+	private:
+		Profiler* m_pProfiler;
+		const char* m_Name;
+		double m_Start;
+	};
+
+	class GpuScope
+	{
+	public:
+		//Writes the start timestamp into commandBuffer now and the end timestamp when the scope ends.
+		GpuScope(Profiler* pProfiler, VkCommandBuffer commandBuffer, const char* name);
+		~GpuScope();
+
+	private:
+		Profiler* m_pProfiler;
+		VkCommandBuffer m_CommandBuffer;
+		uint32_t m_Slot;
+	};
+
+	//Every query is reset once in the current batch of pSetupContext, which has to be submitted before any GPU scope.
+	Profiler(LogicalDevice* pCpu, PhysicalDevice* pGpu, SetupContext* pSetupContext);
+	~Profiler();
+
+	//Whether the graphics queue writes timestamps, without it GPU scopes record nothing.
+	bool IsGpuSupported() const { return m_TimestampMask != 0; }
+
+	//Writes a timestamp on the graphics queue and waits for it, to line the GPU clock up with the CPU clock.
+	//Has to be called from the thread that submits to the graphics queue, before the first GPU results are collected.
+	void Calibrate(SetupContext* pSetupContext);
+
+	//Starts a new frame, the events that begin from now on belong to it.
+	void BeginFrame();
+
+	//Adds the GPU scopes whose queries are available to their frames and frees their queries. Never blocks.
+	void CollectGpuResults();
+
+	//For work that doesn't begin and end in one C++ scope, GpuScope is preferred otherwise.
+	//Returns INVALID_SCOPE when the scope isn't measured, EndGpuScope ignores that.
+	uint32_t BeginGpuScope(VkCommandBuffer commandBuffer, const char* name);
+	void EndGpuScope(VkCommandBuffer commandBuffer, uint32_t scope);
+
+	//Average duration of every event name over the frames in the history.
+	void PrintSummary() const;
+	void WriteChromeTrace(const std::string& path) const;
+
+private:
+	enum class Track
+	{
+		Cpu,
+		Gpu
+	};
+
+	struct ProfileEvent
+	{
+		const char* Name;
+		Track EventTrack;
+		//Index of the CPU thread, unused for the GPU.
+		uint32_t Thread;
+		//Microseconds since the profiler was created.
+		double Start;
+		double Duration;
+	};
+
+	struct FrameProfile
+	{
+		uint64_t Frame = 0;
+		std::vector<ProfileEvent> Events;
+	};
+
+	struct GpuScopeSlot
+	{
+		const char* Name = nullptr;
+		uint64_t Frame = 0;
+		bool IsPending = false;
+		//The queries of a slot keep their last results until the reset of the next scope executes on the GPU,
+		//so results that start at the previous timestamp aren't new.
+		uint64_t CollectedTimestamp = 0;
+	};
+
+	double GetCpuTime() const;
+	uint32_t GetThreadIndex();
+	void AddEvent(uint64_t frame, const ProfileEvent& profileEvent);
+
+private:
+	LogicalDevice* m_pCpu;
+
+	std::chrono::steady_clock::time_point m_Epoch;
+
+	VkQueryPool m_QueryPool;
+	//Nanoseconds per timestamp tick, and the bits of a timestamp that are valid on the graphics queue.
+	double m_TimestampPeriod;
+	uint64_t m_TimestampMask;
+	//The GPU timestamp that was written at CPU time m_CalibrationTime.
+	uint64_t m_CalibrationTimestamp = 0;
+	double m_CalibrationTime = 0.0;
+
+	mutable std::mutex m_Mutex;
+	uint64_t m_Frame = 0;
+	std::vector<FrameProfile> m_Frames;
+
+	//Every slot owns 2 queries, free slots are reused once their results have been collected.
+	std::vector<GpuScopeSlot> m_GpuSlots;
+	std::vector<uint32_t> m_FreeGpuSlots;
+
+	std::vector<std::thread::id> m_Threads;
+};
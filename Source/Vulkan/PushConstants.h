@@ -0,0 +1,48 @@
+#pragma once
+
+#ifndef GLFW_INCLUDE_VULKAN
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+#endif
+
+#include <type_traits>
+
+#include "Vertex.h"
+
+//Push constants are written straight into the command buffer, so per draw data doesn't need a buffer, a memory write
+//or a descriptor update. A block is described once in the pipeline layout and pushed with the same type when recording.
+//maxPushConstantsSize is a device limit, but every device supports at least MIN_PUSH_CONSTANTS_SIZE bytes. Blocks that fit
+//in that are checked at compile time and work everywhere, larger data belongs in a uniform or storage buffer.
+const uint32_t MIN_PUSH_CONSTANTS_SIZE = 128;
+
+//What the push constant vertex shader gets per draw, see VulkanTestPush.vert.
+struct DrawPushConstants
+{
+	glm::mat4 Model;
+};
+
+//The range a block of type T takes at Offset, for the stages that read it.
+template<typename T, uint32_t Offset = 0>
+VkPushConstantRange GetPushConstantRange(VkShaderStageFlags stages)
+{
+	static_assert(std::is_trivially_copyable<T>::value, "push constants are copied byte for byte!");
+	static_assert(Offset % 4 == 0 && sizeof(T) % 4 == 0, "push constant offset and size must be multiples of 4!");
+	static_assert(Offset + sizeof(T) <= MIN_PUSH_CONSTANTS_SIZE, "push constant block doesn't fit in the guaranteed maxPushConstantsSize!");
+
+	VkPushConstantRange range = {};
+	range.stageFlags = stages;
+	range.offset = Offset;
+	range.size = static_cast<uint32_t>(sizeof(T));
+	return range;
+}
+
+//Records the push of data, stages and Offset must match a range of the layout created with GetPushConstantRange<T, Offset>.
+template<typename T, uint32_t Offset = 0>
+void CmdPushConstants(VkCommandBuffer commandBuffer, VkPipelineLayout layout, VkShaderStageFlags stages, const T& data)
+{
+	static_assert(std::is_trivially_copyable<T>::value, "push constants are copied byte for byte!");
+	static_assert(Offset % 4 == 0 && sizeof(T) % 4 == 0, "push constant offset and size must be multiples of 4!");
+	static_assert(Offset + sizeof(T) <= MIN_PUSH_CONSTANTS_SIZE, "push constant block doesn't fit in the guaranteed maxPushConstantsSize!");
+
+	vkCmdPushConstants(commandBuffer, layout, stages, Offset, static_cast<uint32_t>(sizeof(T)), &data);
+}
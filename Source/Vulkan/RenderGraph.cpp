@@ -0,0 +1,595 @@
+#include "RenderGraph.h"
+
+#include "LogicalDevice.h"
+#include "PhysicalDevice.h"
+#include "Profiler.h"
+
+#include "../Help/HelperMethods.h"
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <iostream>
+#include <iomanip>
+
+namespace
+{
+	struct UsageInfo
+	{
+		VkPipelineStageFlags Stages;
+		VkAccessFlags Access;
+		//VK_IMAGE_LAYOUT_UNDEFINED for usages that only apply to buffers.
+		VkImageLayout Layout;
+		bool IsWrite;
+	};
+
+	UsageInfo GetUsageInfo(ResourceUsage usage)
+	{
+		switch (usage)
+		{
+		case ResourceUsage::Undefined:
+			return { VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0, VK_IMAGE_LAYOUT_UNDEFINED, false };
+		case ResourceUsage::Acquired:
+			return { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, 0, VK_IMAGE_LAYOUT_UNDEFINED, false };
+		case ResourceUsage::ColorAttachment:
+			return { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+				VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, true };
+		//The depth test reads in the early fragment tests, and the depth is written in the late ones.
+		case ResourceUsage::DepthAttachment:
+			return { VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+				VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, true };
+		case ResourceUsage::FragmentRead:
+			return { VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, false };
+		case ResourceUsage::ComputeRead:
+			return { VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, false };
+		//Storage writes are often atomics, which read as well.
+		case ResourceUsage::ComputeWrite:
+			return { VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_GENERAL, true };
+		case ResourceUsage::IndirectRead:
+			return { VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED, false };
+		case ResourceUsage::VertexRead:
+			return { VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED, false };
+		case ResourceUsage::TransferSrc:
+			return { VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, false };
+		case ResourceUsage::TransferDst:
+			return { VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, true };
+		case ResourceUsage::HostRead:
+			return { VK_PIPELINE_STAGE_HOST_BIT, VK_ACCESS_HOST_READ_BIT, VK_IMAGE_LAYOUT_GENERAL, false };
+		//Presenting is ordered by the render finished semaphore, the barrier only has to change the layout.
+		case ResourceUsage::Present:
+			return { VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, false };
+		}
+
+		throw std::invalid_argument("unknown resource usage!");
+	}
+
+	bool IsWrite(ResourceUsage usage)
+	{
+		return GetUsageInfo(usage).IsWrite;
+	}
+
+	VkImageAspectFlags GetAspect(VkFormat format)
+	{
+		switch (format)
+		{
+		case VK_FORMAT_D16_UNORM:
+		case VK_FORMAT_X8_D24_UNORM_PACK32:
+		case VK_FORMAT_D32_SFLOAT:
+			return VK_IMAGE_ASPECT_DEPTH_BIT;
+		case VK_FORMAT_D16_UNORM_S8_UINT:
+		case VK_FORMAT_D24_UNORM_S8_UINT:
+		case VK_FORMAT_D32_SFLOAT_S8_UINT:
+			return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+		default:
+			return VK_IMAGE_ASPECT_COLOR_BIT;
+		}
+	}
+
+	//Images that are nothing but attachments can be transient attachments, which may live in lazily allocated memory.
+	const VkImageUsageFlags ATTACHMENT_USAGE = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT |
+		VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+
+	const uint32_t NOT_USED = ~0u;
+
+	bool Overlap(uint32_t firstA, uint32_t lastA, uint32_t firstB, uint32_t lastB)
+	{
+		return firstA <= lastB && firstB <= lastA;
+	}
+}
+
+RenderGraph::RenderGraph(LogicalDevice* pCpu, PhysicalDevice* pGpu):
+	m_pCpu(pCpu),
+	m_pGpu(pGpu)
+{
+}
+
+RenderGraph::~RenderGraph()
+{
+	for (const auto& framebuffer : m_Framebuffers)
+		vkDestroyFramebuffer(m_pCpu->GetDevice(), framebuffer.second, nullptr);
+
+	for (uint32_t i = 0; i < m_TransientCount; ++i)
+	{
+		vkDestroyImageView(m_pCpu->GetDevice(), m_Resources[i].View, nullptr);
+		vkDestroyImage(m_pCpu->GetDevice(), m_Resources[i].Image, nullptr);
+	}
+
+	for (MemorySlot& slot : m_Slots)
+		m_pCpu->GetAllocator()->Free(slot.Memory);
+}
+
+RenderGraph::ResourceId RenderGraph::CreateImage(const char* name, const ImageDesc& desc)
+{
+	if (m_HasTransientImages || m_Resources.size() != m_TransientCount)
+		throw std::runtime_error("transient images have to be created before anything is imported!");
+
+	Resource resource;
+	resource.Name = name;
+	resource.IsImage = true;
+	resource.IsTransient = true;
+	resource.Aspect = GetAspect(desc.Format);
+	resource.Desc = desc;
+
+	m_Resources.push_back(resource);
+	return m_TransientCount++;
+}
+
+void RenderGraph::Reset()
+{
+	m_Resources.resize(m_TransientCount);
+	m_Passes.clear();
+}
+
+RenderGraph::ResourceId RenderGraph::ImportImage(const char* name, VkImage image, VkImageView view, VkFormat format, ResourceUsage initialUsage, ResourceUsage finalUsage)
+{
+	Resource resource;
+	resource.Name = name;
+	resource.IsImage = true;
+	resource.Image = image;
+	resource.View = view;
+	resource.Aspect = GetAspect(format);
+	resource.InitialUsage = initialUsage;
+	resource.FinalUsage = finalUsage;
+
+	m_Resources.push_back(resource);
+	return static_cast<ResourceId>(m_Resources.size() - 1);
+}
+
+RenderGraph::ResourceId RenderGraph::ImportBuffer(const char* name, VkBuffer buffer, ResourceUsage initialUsage, ResourceUsage finalUsage)
+{
+	Resource resource;
+	resource.Name = name;
+	resource.Buffer = buffer;
+	resource.InitialUsage = initialUsage;
+	resource.FinalUsage = finalUsage;
+
+	m_Resources.push_back(resource);
+	return static_cast<ResourceId>(m_Resources.size() - 1);
+}
+
+void RenderGraph::AddPass(const char* name, const std::vector<PassResource>& resources, const std::function<void(VkCommandBuffer)>& record)
+{
+	for (size_t i = 0; i < resources.size(); ++i)
+	{
+		for (size_t j = i + 1; j < resources.size(); ++j)
+		{
+			if (resources[i].Resource == resources[j].Resource)
+				throw std::runtime_error(std::string("pass ") + name + " lists " + m_Resources[resources[i].Resource].Name + " more than once!");
+		}
+	}
+
+	Pass pass;
+	pass.Name = name;
+	pass.Resources = resources;
+	pass.Record = record;
+	m_Passes.push_back(pass);
+}
+
+void RenderGraph::Execute(VkCommandBuffer commandBuffer, Profiler* pProfiler)
+{
+	CullPasses();
+
+	std::vector<uint32_t> first;
+	std::vector<uint32_t> last;
+	GetLifetimes(first, last);
+
+	if (!m_HasTransientImages)
+		CreateTransientImages(first, last);
+	else
+		CheckAliasing(first, last);
+
+	std::vector<ResourceState> states;
+	states.reserve(m_Resources.size());
+	for (const Resource& resource : m_Resources)
+		states.push_back(GetInitialState(resource));
+
+	for (const Pass& pass : m_Passes)
+	{
+		if (!pass.IsLive)
+			continue;
+
+		Barriers barriers;
+		for (const PassResource& passResource : pass.Resources)
+			Use(passResource.Resource, passResource.Usage, states, barriers);
+		RecordBarriers(commandBuffer, barriers);
+
+		Profiler::GpuScope scope(pProfiler, commandBuffer, pass.Name);
+		pass.Record(commandBuffer);
+	}
+
+	//Hands the imported resources over to the work after the frame, like presenting or reading back on the host.
+	Barriers barriers;
+	for (ResourceId i = m_TransientCount; i < m_Resources.size(); ++i)
+	{
+		if (m_Resources[i].FinalUsage != ResourceUsage::Undefined)
+			Use(i, m_Resources[i].FinalUsage, states, barriers);
+	}
+	RecordBarriers(commandBuffer, barriers);
+}
+
+VkFramebuffer RenderGraph::GetFramebuffer(VkRenderPass renderPass, const std::vector<ResourceId>& attachments, VkExtent2D extent)
+{
+	std::vector<VkImageView> views;
+	for (ResourceId attachment : attachments)
+		views.push_back(m_Resources[attachment].View);
+
+	const auto key = std::make_pair(renderPass, views);
+	const auto it = m_Framebuffers.find(key);
+	if (it != m_Framebuffers.end())
+		return it->second;
+
+	//You can only use a framebuffer with the render passes that it is compatible with,
+	//which roughly means that they use the same number and type of attachments.
+	VkFramebufferCreateInfo framebufferInfo = {};
+	framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+	framebufferInfo.renderPass = renderPass;
+	framebufferInfo.attachmentCount = static_cast<uint32_t>(views.size());
+	framebufferInfo.pAttachments = views.data();
+	framebufferInfo.width = extent.width;
+	framebufferInfo.height = extent.height;
+	framebufferInfo.layers = 1;
+
+	VkFramebuffer framebuffer;
+	if (vkCreateFramebuffer(m_pCpu->GetDevice(), &framebufferInfo, nullptr, &framebuffer) != VK_SUCCESS)
+		throw std::runtime_error("failed to create framebuffer!");
+
+	m_Framebuffers[key] = framebuffer;
+	return framebuffer;
+}
+
+void RenderGraph::CullPasses()
+{
+	//A live pass that writes a resource keeps it needed, so the earlier passes that write it stay as well.
+	//That is conservative: we don't know whether the later pass overwrites all of it.
+	std::vector<bool> isNeeded(m_Resources.size(), false);
+	for (ResourceId i = m_TransientCount; i < m_Resources.size(); ++i)
+		isNeeded[i] = m_Resources[i].FinalUsage != ResourceUsage::Undefined;
+
+	for (auto pass = m_Passes.rbegin(); pass != m_Passes.rend(); ++pass)
+	{
+		pass->IsLive = false;
+		for (const PassResource& passResource : pass->Resources)
+		{
+			if (IsWrite(passResource.Usage) && isNeeded[passResource.Resource])
+				pass->IsLive = true;
+		}
+
+		if (!pass->IsLive)
+			continue;
+
+		for (const PassResource& passResource : pass->Resources)
+		{
+			if (!IsWrite(passResource.Usage))
+				isNeeded[passResource.Resource] = true;
+		}
+	}
+}
+
+void RenderGraph::GetLifetimes(std::vector<uint32_t>& first, std::vector<uint32_t>& last) const
+{
+	first.assign(m_TransientCount, NOT_USED);
+	last.assign(m_TransientCount, NOT_USED);
+
+	for (uint32_t i = 0; i < m_Passes.size(); ++i)
+	{
+		if (!m_Passes[i].IsLive)
+			continue;
+
+		for (const PassResource& passResource : m_Passes[i].Resources)
+		{
+			if (passResource.Resource >= m_TransientCount)
+				continue;
+
+			if (first[passResource.Resource] == NOT_USED)
+				first[passResource.Resource] = i;
+			last[passResource.Resource] = i;
+		}
+	}
+}
+
+void RenderGraph::CreateTransientImages(const std::vector<uint32_t>& first, const std::vector<uint32_t>& last)
+{
+	std::vector<VkMemoryRequirements> requirements(m_TransientCount);
+	for (uint32_t i = 0; i < m_TransientCount; ++i)
+	{
+		Resource& resource = m_Resources[i];
+
+		VkImageCreateInfo imageInfo = {};
+		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		imageInfo.imageType = VK_IMAGE_TYPE_2D;
+		imageInfo.extent = { resource.Desc.Width, resource.Desc.Height, 1 };
+		imageInfo.mipLevels = 1;
+		imageInfo.arrayLayers = 1;
+		imageInfo.format = resource.Desc.Format;
+		imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+		imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		imageInfo.usage = resource.Desc.Usage;
+		imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		imageInfo.samples = resource.Desc.Samples;
+
+		if ((resource.Desc.Usage & ~ATTACHMENT_USAGE) == 0)
+			imageInfo.usage |= VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+
+		if (vkCreateImage(m_pCpu->GetDevice(), &imageInfo, nullptr, &resource.Image) != VK_SUCCESS)
+			throw std::runtime_error(std::string("failed to create transient image ") + resource.Name + "!");
+
+		vkGetImageMemoryRequirements(m_pCpu->GetDevice(), resource.Image, &requirements[i]);
+	}
+
+	//The largest images pick their slots first, so the smaller ones fill the slots they fit in.
+	//Images that aren't used in this frame get a slot of their own, we don't know when they will be used.
+	std::vector<ResourceId> order(m_TransientCount);
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [&](ResourceId a, ResourceId b) { return requirements[a].size > requirements[b].size; });
+
+	VkDeviceSize unaliasedSize = 0;
+	for (ResourceId i : order)
+	{
+		const bool isAttachmentOnly = (m_Resources[i].Desc.Usage & ~ATTACHMENT_USAGE) == 0;
+		unaliasedSize += requirements[i].size;
+
+		uint32_t slotIndex = static_cast<uint32_t>(m_Slots.size());
+		for (uint32_t s = 0; s < m_Slots.size() && first[i] != NOT_USED; ++s)
+		{
+			const MemorySlot& slot = m_Slots[s];
+			if (slot.IsAttachmentOnly != isAttachmentOnly || (slot.Requirements.memoryTypeBits & requirements[i].memoryTypeBits) == 0)
+				continue;
+
+			const bool isFree = std::none_of(slot.Images.begin(), slot.Images.end(), [&](ResourceId j)
+			{
+				return first[j] == NOT_USED || Overlap(first[i], last[i], first[j], last[j]);
+			});
+
+			if (isFree)
+			{
+				slotIndex = s;
+				break;
+			}
+		}
+
+		if (slotIndex == m_Slots.size())
+		{
+			MemorySlot slot;
+			slot.Requirements = requirements[i];
+			slot.IsAttachmentOnly = isAttachmentOnly;
+			m_Slots.push_back(slot);
+		}
+		else
+		{
+			VkMemoryRequirements& slotRequirements = m_Slots[slotIndex].Requirements;
+			slotRequirements.size = std::max(slotRequirements.size, requirements[i].size);
+			slotRequirements.alignment = std::max(slotRequirements.alignment, requirements[i].alignment);
+			slotRequirements.memoryTypeBits &= requirements[i].memoryTypeBits;
+		}
+
+		m_Slots[slotIndex].Images.push_back(i);
+		m_Resources[i].Slot = slotIndex;
+	}
+
+	VkDeviceSize aliasedSize = 0;
+	uint32_t lazyCount = 0;
+	for (MemorySlot& slot : m_Slots)
+	{
+		VkMemoryPropertyFlags properties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+		if (slot.IsAttachmentOnly && HasLazyMemory(slot.Requirements.memoryTypeBits))
+		{
+			properties |= VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT;
+			++lazyCount;
+		}
+
+		slot.Memory = m_pCpu->GetAllocator()->Allocate(slot.Requirements, properties, true);
+		aliasedSize += slot.Requirements.size;
+
+		for (ResourceId i : slot.Images)
+		{
+			Resource& resource = m_Resources[i];
+			vkBindImageMemory(m_pCpu->GetDevice(), resource.Image, slot.Memory.Memory, slot.Memory.Offset);
+			resource.View = CreateImageView(resource.Image, resource.Desc.Format, resource.Aspect, 1, m_pCpu);
+		}
+	}
+
+	m_HasTransientImages = true;
+	if (m_TransientCount == 0)
+		return;
+
+	std::cout << std::fixed << std::setprecision(1);
+	std::cout << "render graph: " << m_TransientCount << " transient images in " << m_Slots.size() << " allocations ("
+		<< lazyCount << " lazily allocated), " << aliasedSize / (1024.0 * 1024.0) << " MiB instead of " << unaliasedSize / (1024.0 * 1024.0) << " MiB" << std::endl;
+	std::cout.unsetf(std::ios::fixed);
+}
+
+void RenderGraph::CheckAliasing(const std::vector<uint32_t>& first, const std::vector<uint32_t>& last) const
+{
+	for (const MemorySlot& slot : m_Slots)
+	{
+		for (size_t a = 0; a < slot.Images.size(); ++a)
+		{
+			for (size_t b = a + 1; b < slot.Images.size(); ++b)
+			{
+				const ResourceId i = slot.Images[a];
+				const ResourceId j = slot.Images[b];
+				if (first[i] != NOT_USED && first[j] != NOT_USED && Overlap(first[i], last[i], first[j], last[j]))
+					throw std::runtime_error(std::string("transient images ") + m_Resources[i].Name + " and " + m_Resources[j].Name + " share memory, but are used by overlapping passes!");
+			}
+		}
+	}
+}
+
+RenderGraph::ResourceState RenderGraph::GetInitialState(const Resource& resource) const
+{
+	//A transient image waits for its memory slot at its first use instead, see Use.
+	ResourceState state;
+	if (resource.IsTransient || resource.InitialUsage == ResourceUsage::Undefined)
+		return state;
+
+	const UsageInfo info = GetUsageInfo(resource.InitialUsage);
+	if (resource.IsImage)
+		state.Layout = info.Layout;
+
+	if (info.IsWrite)
+	{
+		state.WriteStages = info.Stages;
+		state.WriteAccess = info.Access;
+	}
+	else
+	{
+		state.ReadStages = info.Stages;
+		state.ReadAccess = info.Access;
+	}
+	return state;
+}
+
+void RenderGraph::Use(ResourceId resourceId, ResourceUsage usage, std::vector<ResourceState>& states, Barriers& barriers)
+{
+	const Resource& resource = m_Resources[resourceId];
+	const UsageInfo info = GetUsageInfo(usage);
+	ResourceState& state = states[resourceId];
+
+	if (resource.IsImage && info.Layout == VK_IMAGE_LAYOUT_UNDEFINED)
+		throw std::runtime_error(std::string(resource.Name) + " is an image, it can't be used as a buffer!");
+
+	//The first use of a transient image discards its contents, but the last use of its memory has to be done with it.
+	MemorySlot* pSlot = resource.IsTransient ? &m_Slots[resource.Slot] : nullptr;
+	if (pSlot && state.Layout == VK_IMAGE_LAYOUT_UNDEFINED)
+	{
+		state.WriteStages = pSlot->Stages;
+		state.WriteAccess = pSlot->Access;
+	}
+
+	const VkImageLayout oldLayout = state.Layout;
+	const VkImageLayout newLayout = resource.IsImage ? info.Layout : VK_IMAGE_LAYOUT_UNDEFINED;
+
+	VkPipelineStageFlags srcStages = 0;
+	VkAccessFlags srcAccess = 0;
+	VkPipelineStageFlags dstStages = info.Stages;
+	VkAccessFlags dstAccess = info.Access;
+	bool needsBarrier = false;
+
+	if (info.IsWrite || oldLayout != newLayout)
+	{
+		//Writes, and layout transitions which write too, wait for the last write and for the reads since.
+		//Reads have nothing to make available, they only have to be done.
+		srcStages = state.WriteStages | state.ReadStages;
+		srcAccess = state.WriteAccess;
+		needsBarrier = srcStages != 0 || oldLayout != newLayout;
+
+		state.Layout = newLayout;
+		if (info.IsWrite)
+		{
+			state.WriteStages = info.Stages;
+			state.WriteAccess = info.Access;
+			state.ReadStages = 0;
+			state.ReadAccess = 0;
+		}
+		else
+		{
+			//Only the transition was written, and this read already sees it.
+			state.WriteStages = info.Stages;
+			state.WriteAccess = 0;
+			state.ReadStages = info.Stages;
+			state.ReadAccess = info.Access;
+		}
+	}
+	else if ((info.Stages & ~state.ReadStages) != 0 || (info.Access & ~state.ReadAccess) != 0)
+	{
+		//A read that doesn't see the last write yet. The barrier covers the earlier reads as well,
+		//so every stage in ReadStages sees the write through every access in ReadAccess.
+		srcStages = state.WriteStages;
+		srcAccess = state.WriteAccess;
+		needsBarrier = srcStages != 0;
+
+		state.ReadStages |= info.Stages;
+		state.ReadAccess |= info.Access;
+		dstStages = state.ReadStages;
+		dstAccess = state.ReadAccess;
+	}
+
+	if (pSlot)
+	{
+		pSlot->Stages = state.WriteStages | state.ReadStages;
+		pSlot->Access = state.WriteAccess;
+	}
+
+	if (!needsBarrier)
+		return;
+
+	//Nothing to wait for, only the layout changes.
+	barriers.SrcStages |= srcStages != 0 ? srcStages : static_cast<VkPipelineStageFlags>(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+	barriers.DstStages |= dstStages;
+
+	if (resource.IsImage)
+	{
+		VkImageMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.srcAccessMask = srcAccess;
+		barrier.dstAccessMask = dstAccess;
+		barrier.oldLayout = oldLayout;
+		barrier.newLayout = newLayout;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = resource.Image;
+		barrier.subresourceRange.aspectMask = resource.Aspect;
+		barrier.subresourceRange.baseMipLevel = 0;
+		barrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+		barrier.subresourceRange.baseArrayLayer = 0;
+		barrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+		barriers.Images.push_back(barrier);
+	}
+	else
+	{
+		VkBufferMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		barrier.srcAccessMask = srcAccess;
+		barrier.dstAccessMask = dstAccess;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.buffer = resource.Buffer;
+		barrier.offset = 0;
+		barrier.size = VK_WHOLE_SIZE;
+		barriers.Buffers.push_back(barrier);
+	}
+}
+
+void RenderGraph::RecordBarriers(VkCommandBuffer commandBuffer, const Barriers& barriers) const
+{
+	if (barriers.Images.empty() && barriers.Buffers.empty())
+		return;
+
+	vkCmdPipelineBarrier(commandBuffer, barriers.SrcStages, barriers.DstStages, 0, 0, nullptr,
+		static_cast<uint32_t>(barriers.Buffers.size()), barriers.Buffers.data(),
+		static_cast<uint32_t>(barriers.Images.size()), barriers.Images.data());
+}
+
+bool RenderGraph::HasLazyMemory(uint32_t memoryTypeBits) const
+{
+	const VkPhysicalDeviceMemoryProperties& memProperties = m_pGpu->GetDesc().MemProperties;
+	const VkMemoryPropertyFlags properties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT;
+
+	for (uint32_t i = 0; i < memProperties.memoryTypeCount; ++i)
+	{
+		if ((memoryTypeBits & (1 << i)) && (memProperties.memoryTypes[i].propertyFlags & properties) == properties)
+			return true;
+	}
+	return false;
+}
@@ -0,0 +1,189 @@
+#pragma once
+
+#ifndef GLFW_INCLUDE_VULKAN
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+#endif
+
+#include <vector>
+#include <map>
+#include <utility>
+#include <functional>
+
+#include "MemoryAllocator.h"
+
+class LogicalDevice;
+class PhysicalDevice;
+class Profiler;
+
+//How a pass uses a resource. Every usage stands for the pipeline stages, the memory access and, for images, the layout
+//it needs, see GetUsageInfo in RenderGraph.cpp. ColorAttachment, DepthAttachment, ComputeWrite and TransferDst write.
+enum class ResourceUsage
+{
+	//Only as the initial or final usage of an imported resource: its contents don't matter before or after the frame.
+	Undefined,
+	//Only as the initial usage of a swap chain image, the acquire semaphore is waited on at the color attachment output stage.
+	Acquired,
+	ColorAttachment,
+	DepthAttachment,
+	FragmentRead,
+	ComputeRead,
+	ComputeWrite,
+	IndirectRead,
+	VertexRead,
+	TransferSrc,
+	TransferDst,
+	//Only as the final usage of an imported resource, the host reads it once the fence of the frame has signaled.
+	HostRead,
+	Present
+};
+
+//Orders the GPU work of a frame. Passes list the resources they use and how, and execute in the order they were added.
+//The graph records the barriers between them: one batched vkCmdPipelineBarrier before every pass that needs one,
+//and only where a pass has to wait for an earlier write, an earlier read has to finish before a write, or a layout changes.
+//
+//Passes whose writes nothing needs are culled. What is needed starts at the imported resources with a final usage,
+//and includes everything the passes that write those read, and so on back to the first pass.
+//
+//Transient images, like the multisampled color target and the depth buffer, belong to the graph and only live
+//from the first to the last pass that uses them. Transient images whose passes don't overlap share their memory.
+//They are created at the first Execute, so every frame after that must keep the images that share memory apart.
+//Attachment only transient images are lazily allocated when the device supports it, tiled GPUs then may never back them.
+//
+//The graph is built again for every frame: Reset, import the resources of the frame, add the passes and Execute.
+//It is not thread safe.
+class RenderGraph
+{
+public:
+	typedef uint32_t ResourceId;
+
+	struct ImageDesc
+	{
+		uint32_t Width = 0;
+		uint32_t Height = 0;
+		VkFormat Format = VK_FORMAT_UNDEFINED;
+		VkSampleCountFlagBits Samples = VK_SAMPLE_COUNT_1_BIT;
+		VkImageUsageFlags Usage = 0;
+	};
+
+	struct PassResource
+	{
+		ResourceId Resource;
+		ResourceUsage Usage;
+	};
+
+	RenderGraph(LogicalDevice* pCpu, PhysicalDevice* pGpu);
+	~RenderGraph();
+
+	//Transient images are kept across Reset, so they are created once, before the first resource is imported.
+	ResourceId CreateImage(const char* name, const ImageDesc& desc);
+
+	//Forgets the imported resources and passes of the last frame.
+	void Reset();
+
+	//The contents and pending work of an imported resource are described by initialUsage, and finalUsage is how
+	//the work after the frame uses it. view may be VK_NULL_HANDLE when the image isn't a framebuffer attachment.
+	ResourceId ImportImage(const char* name, VkImage image, VkImageView view, VkFormat format, ResourceUsage initialUsage, ResourceUsage finalUsage);
+	ResourceId ImportBuffer(const char* name, VkBuffer buffer, ResourceUsage initialUsage, ResourceUsage finalUsage);
+
+	//A pass may list a resource once. record is only called for passes that aren't culled, from Execute.
+	//name must be a string literal, it names the GPU scope of the pass.
+	void AddPass(const char* name, const std::vector<PassResource>& resources, const std::function<void(VkCommandBuffer)>& record);
+
+	//Records the passes that aren't culled and their barriers into commandBuffer, every pass in a GPU scope of pProfiler.
+	void Execute(VkCommandBuffer commandBuffer, Profiler* pProfiler);
+
+	VkImage GetImage(ResourceId resource) const { return m_Resources[resource].Image; }
+	VkImageView GetImageView(ResourceId resource) const { return m_Resources[resource].View; }
+	VkBuffer GetBuffer(ResourceId resource) const { return m_Resources[resource].Buffer; }
+
+	//A framebuffer of renderPass with these attachments, created on first use and kept as long as the graph.
+	//Only valid from a pass, when the transient images exist. The image views have to outlive the graph.
+	VkFramebuffer GetFramebuffer(VkRenderPass renderPass, const std::vector<ResourceId>& attachments, VkExtent2D extent);
+
+private:
+	struct Resource
+	{
+		const char* Name = nullptr;
+		bool IsImage = false;
+		bool IsTransient = false;
+
+		VkImage Image = VK_NULL_HANDLE;
+		VkImageView View = VK_NULL_HANDLE;
+		VkBuffer Buffer = VK_NULL_HANDLE;
+		VkImageAspectFlags Aspect = 0;
+
+		//Transient only.
+		ImageDesc Desc;
+		uint32_t Slot = 0;
+
+		//Imported only.
+		ResourceUsage InitialUsage = ResourceUsage::Undefined;
+		ResourceUsage FinalUsage = ResourceUsage::Undefined;
+	};
+
+	struct Pass
+	{
+		const char* Name;
+		std::vector<PassResource> Resources;
+		std::function<void(VkCommandBuffer)> Record;
+		bool IsLive = false;
+	};
+
+	//Where the passes so far left a resource. A read in ReadStages with ReadAccess already sees the last write,
+	//and a write has to wait for the last write and for those reads.
+	struct ResourceState
+	{
+		VkImageLayout Layout = VK_IMAGE_LAYOUT_UNDEFINED;
+		VkPipelineStageFlags WriteStages = 0;
+		VkAccessFlags WriteAccess = 0;
+		VkPipelineStageFlags ReadStages = 0;
+		VkAccessFlags ReadAccess = 0;
+	};
+
+	//Memory shared by transient images. Stages and Access are those of the last use of any of them, even in the previous
+	//frame, the first use of the next one has to wait for them before it overwrites the memory.
+	struct MemorySlot
+	{
+		Allocation Memory;
+		VkMemoryRequirements Requirements;
+		bool IsAttachmentOnly = false;
+		std::vector<ResourceId> Images;
+		VkPipelineStageFlags Stages = 0;
+		VkAccessFlags Access = 0;
+	};
+
+	struct Barriers
+	{
+		VkPipelineStageFlags SrcStages = 0;
+		VkPipelineStageFlags DstStages = 0;
+		std::vector<VkImageMemoryBarrier> Images;
+		std::vector<VkBufferMemoryBarrier> Buffers;
+	};
+
+	void CullPasses();
+	//First and last live pass of every transient image, ~0u for both when no live pass uses it.
+	void GetLifetimes(std::vector<uint32_t>& first, std::vector<uint32_t>& last) const;
+	void CreateTransientImages(const std::vector<uint32_t>& first, const std::vector<uint32_t>& last);
+	void CheckAliasing(const std::vector<uint32_t>& first, const std::vector<uint32_t>& last) const;
+
+	ResourceState GetInitialState(const Resource& resource) const;
+	void Use(ResourceId resource, ResourceUsage usage, std::vector<ResourceState>& states, Barriers& barriers);
+	void RecordBarriers(VkCommandBuffer commandBuffer, const Barriers& barriers) const;
+
+	bool HasLazyMemory(uint32_t memoryTypeBits) const;
+
+private:
+	LogicalDevice* m_pCpu;
+	PhysicalDevice* m_pGpu;
+
+	//The transient images come first, Reset drops everything after them.
+	std::vector<Resource> m_Resources;
+	uint32_t m_TransientCount = 0;
+	std::vector<Pass> m_Passes;
+
+	bool m_HasTransientImages = false;
+	std::vector<MemorySlot> m_Slots;
+
+	std::map<std::pair<VkRenderPass, std::vector<VkImageView>>, VkFramebuffer> m_Framebuffers;
+};
@@ -32,8 +32,9 @@ RenderPass::RenderPass(LogicalDevice* pDevice, SwapChain* pSwapchain, PhysicalDe
 	//VK_ATTACHMENT_STORE_OP_STORE: Rendered contents will be stored in memory and can be read later.
 	//VK_ATTACHMENT_STORE_OP_DONT_CARE: Contents of the framebuffer will be undefined after rendering operation.
 
-	//We're interested in seeing the rendered triangle on the screen, so we're going with the store operation here.
-	colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+	//We only see the resolved image, the multisampled one isn't read after the render pass.
+	//Not storing it lets a tiled GPU keep it in tile memory, and the render graph allocate it lazily.
+	colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
 
 	//The loadOp and storeOp apply to color and depth data, and stencilLoadOp / stencilStoreOp apply to stencil data.
 	//Our applocation won't do anything with the stencil buffer, so the results of loading and storing are irrelevant.
@@ -54,16 +55,14 @@ RenderPass::RenderPass(LogicalDevice* pDevice, SwapChain* pSwapchain, PhysicalDe
 
 	//The initialLayout specifies which layout the image will have before the render pass begins.
 	//The finalLayout specifies the layout to automatically transition to when the render pass finishes.
-	//Using VK_IMAGE_LAYOUT_UNDEFINED for initalLayout means that we don't care what previous layout the image was in.
-	//The caveat of this special value is that the contents of the image are not guaranteed to be preserved, but that doesn't
-	//matter since we're going to clear it anywawy. We want the image to be ready for presentation using the swap chain
-	//after rendering, which is why we use VK_IMAGE_LAYOUT_PRESENT_SRC_KHR as finalLayout.
-	//MSAA: finalLayout --> VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
-	//this change is because multisampled images cannot be presented directly.
+	//The render graph moves every attachment into the layout of the subpass before the render pass begins,
+	//and out of it once a later pass or the present needs something else, together with the barriers it needs anyway.
+	//So the render pass itself doesn't change any layout.
+	//MSAA: multisampled images cannot be presented directly.
 	//We first need to resolve them to a regular image. this requirement doest not apply to the depth buffer,
 	//since we won't be presented at any point. Therefore we will have to add onl one new attachment for color
 	//which is a so-called resolve attachment.
-	colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	colorAttachment.initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 	colorAttachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 
 	VkAttachmentDescription colorAttachmentResolve = {};
@@ -73,8 +72,8 @@ RenderPass::RenderPass(LogicalDevice* pDevice, SwapChain* pSwapchain, PhysicalDe
 	colorAttachmentResolve.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
 	colorAttachmentResolve.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 	colorAttachmentResolve.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-	colorAttachmentResolve.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-	colorAttachmentResolve.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+	colorAttachmentResolve.initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+	colorAttachmentResolve.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 
 	VkAttachmentDescription depthAttachment = {};
 
@@ -89,9 +88,9 @@ RenderPass::RenderPass(LogicalDevice* pDevice, SwapChain* pSwapchain, PhysicalDe
 	depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 	depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
 
-	//Just like the color buffer, we don't care about the previous depth contents, so we can use VK_IMAGE_LAYOUT_UNDEFINED as initialLayout.
-	depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-	depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+	//Just like the color buffer, the render graph has it in the layout of the subpass already.
+	depthAttachment.initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+	depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
 
 	//the attachment parameter specifies which attachment to reference by its index in the attachment descriptions array.
 	//Out array consists of a single vkAttachmentDescription, so its index is 0.
@@ -132,25 +131,9 @@ RenderPass::RenderPass(LogicalDevice* pDevice, SwapChain* pSwapchain, PhysicalDe
 	//pPreserveAttachments: attachments that are not used by this subpass, but for which the data must be preserved.
 	subpass.pResolveAttachments = &colorAttachmentResolveRef;
 
-	//the first 2 fields specify the indices of the dependency and the dependent subpass. The special value VK_SUBPASS_EXTERNAL refers to
-	//the implicit subpass before or after the render pass depending on whether it is specified in srcSubpass or dstSubpass.
-	//The index 0 refers to our subpass, which is the first and only one.
-	//The dstSubpass must always be higher than srcSubpass to prevent cycles in the dependency graph.
-	VkSubpassDependency dependency = {};
-	dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
-	dependency.dstSubpass = 0;
-
-	//The next two fields specify the operations to wait on and the stages in which these operation occur.
-	//We need to wait for the swap chain to finish reading from the image before we can access it.
-	//This can be accomplished by waiting on the color attachment output stage itself.
-	dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-	dependency.srcAccessMask = 0;
-
-	//The operation that should wait on this are the color attachment stage and involve the reading and writing of the color attachment.
-	//These settings will prevent the transition from happening until it's actually necessary (and allowed).
-	//this is when we want to start writing colors to it.
-	dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-	dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	//There are no subpass dependencies: the render graph records the barriers before and after the render pass,
+	//waiting for the acquire, the culling and the last use of the memory of the transient attachments, and making
+	//the resolve visible to the present or the readback. See RenderGraph.
 
 	std::array<VkAttachmentDescription, 3> attachments = { colorAttachment, depthAttachment, colorAttachmentResolve };
 
@@ -160,8 +143,8 @@ RenderPass::RenderPass(LogicalDevice* pDevice, SwapChain* pSwapchain, PhysicalDe
 	renderPassInfo.pAttachments = attachments.data();
 	renderPassInfo.subpassCount = 1;
 	renderPassInfo.pSubpasses = &subpass;
-	renderPassInfo.dependencyCount = 1;
-	renderPassInfo.pDependencies = &dependency;
+	renderPassInfo.dependencyCount = 0;
+	renderPassInfo.pDependencies = nullptr;
 
 	if (vkCreateRenderPass(m_pDevice->GetDevice(), &renderPassInfo, nullptr, &m_RenderPass) != VK_SUCCESS)
 		throw std::runtime_error("failed to create render pass");
@@ -0,0 +1,201 @@
+#include "SetupContext.h"
+
+#include "LogicalDevice.h"
+#include "PhysicalDevice.h"
+#include "CommandPool.h"
+
+#include <stdexcept>
+#include <limits>
+
+SetupFuture::SetupFuture():
+	m_pContext(nullptr),
+	m_BatchId(0)
+{
+}
+
+SetupFuture::SetupFuture(SetupContext* pContext, uint64_t batchId):
+	m_pContext(pContext),
+	m_BatchId(batchId)
+{
+}
+
+bool SetupFuture::IsReady() const
+{
+	return !m_pContext || m_pContext->IsComplete(m_BatchId);
+}
+
+void SetupFuture::Wait() const
+{
+	if (m_pContext)
+		m_pContext->Wait(m_BatchId);
+}
+
+SetupContext::SetupContext(LogicalDevice* pCpu, PhysicalDevice* pGpu):
+	m_pCpu(pCpu)
+{
+	//VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT lets us reset and rerecord the command buffer of a finished batch
+	//on its own, while the command buffers of other batches may still be executing.
+	m_UniquePool = std::make_unique<CommandPool>(pCpu, pGpu, VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT);
+}
+
+SetupContext::~SetupContext()
+{
+	//Work that was never submitted is dropped, nothing can be waiting for it.
+	if (m_IsRecording)
+		vkEndCommandBuffer(m_Recording.CommandBuffer);
+
+	for (const Batch& batch : m_InFlight)
+	{
+		vkWaitForFences(m_pCpu->GetDevice(), 1, &batch.Fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+		vkDestroyFence(m_pCpu->GetDevice(), batch.Fence, nullptr);
+	}
+
+	for (VkFence fence : m_FreeFences)
+		vkDestroyFence(m_pCpu->GetDevice(), fence, nullptr);
+
+	//The command buffers are freed together with the pool.
+	m_UniquePool.reset();
+}
+
+SetupFuture SetupContext::Record(const std::function<void(VkCommandBuffer)>& record)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	BeginBatch();
+
+	record(m_Recording.CommandBuffer);
+
+	return SetupFuture(this, m_Recording.Id);
+}
+
+SetupFuture SetupContext::Submit()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	if (!m_IsRecording)
+		return SetupFuture();
+
+	const uint64_t batchId = m_Recording.Id;
+	SubmitRecording();
+
+	return SetupFuture(this, batchId);
+}
+
+bool SetupContext::IsComplete(uint64_t batchId)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	if (m_IsRecording && m_Recording.Id == batchId)
+		return false;
+
+	for (const Batch& batch : m_InFlight)
+	{
+		if (batch.Id == batchId)
+			return vkGetFenceStatus(m_pCpu->GetDevice(), batch.Fence) == VK_SUCCESS;
+	}
+
+	//Batches that aren't in flight anymore have been recycled.
+	return true;
+}
+
+void SetupContext::Wait(uint64_t batchId)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	if (m_IsRecording && m_Recording.Id == batchId)
+		SubmitRecording();
+
+	for (const Batch& batch : m_InFlight)
+	{
+		if (batch.Id == batchId)
+			vkWaitForFences(m_pCpu->GetDevice(), 1, &batch.Fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+	}
+}
+
+void SetupContext::BeginBatch()
+{
+	if (m_IsRecording)
+		return;
+
+	RecycleCompleted();
+
+	m_Recording = Batch();
+	m_Recording.Id = m_NextBatchId++;
+
+	if (!m_FreeCommandBuffers.empty())
+	{
+		m_Recording.CommandBuffer = m_FreeCommandBuffers.back();
+		m_FreeCommandBuffers.pop_back();
+	}
+	else
+	{
+		VkCommandBufferAllocateInfo allocInfo = {};
+		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocInfo.commandPool = m_UniquePool->GetPool();
+		allocInfo.commandBufferCount = 1;
+
+		if (vkAllocateCommandBuffers(m_pCpu->GetDevice(), &allocInfo, &m_Recording.CommandBuffer) != VK_SUCCESS)
+			throw std::runtime_error("failed to allocate setup command buffer!");
+	}
+
+	//Every batch is submitted exactly once, it's good practice to tell the driver about that
+	//with VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT.
+	VkCommandBufferBeginInfo beginInfo = {};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+	if (vkBeginCommandBuffer(m_Recording.CommandBuffer, &beginInfo) != VK_SUCCESS)
+		throw std::runtime_error("failed to begin recording setup command buffer!");
+
+	m_IsRecording = true;
+}
+
+void SetupContext::SubmitRecording()
+{
+	if (vkEndCommandBuffer(m_Recording.CommandBuffer) != VK_SUCCESS)
+		throw std::runtime_error("failed to record setup command buffer!");
+
+	if (!m_FreeFences.empty())
+	{
+		m_Recording.Fence = m_FreeFences.back();
+		m_FreeFences.pop_back();
+	}
+	else
+	{
+		VkFenceCreateInfo fenceInfo = {};
+		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+		if (vkCreateFence(m_pCpu->GetDevice(), &fenceInfo, nullptr, &m_Recording.Fence) != VK_SUCCESS)
+			throw std::runtime_error("failed to create setup fence!");
+	}
+
+	//Unlike the draw commands, there are no semaphores to wait on. Layout transitions are ordered before the frames
+	//that are submitted later by their own barriers, so only code that reads the results on the CPU has to wait on the fence.
+	VkSubmitInfo submitInfo = {};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &m_Recording.CommandBuffer;
+
+	if (vkQueueSubmit(m_pCpu->GetGraphicsQueue(), 1, &submitInfo, m_Recording.Fence) != VK_SUCCESS)
+		throw std::runtime_error("failed to submit setup command buffer!");
+
+	m_InFlight.push_back(m_Recording);
+	m_Recording = Batch();
+	m_IsRecording = false;
+}
+
+void SetupContext::RecycleCompleted()
+{
+	while (!m_InFlight.empty() && vkGetFenceStatus(m_pCpu->GetDevice(), m_InFlight.front().Fence) == VK_SUCCESS)
+	{
+		const Batch& batch = m_InFlight.front();
+
+		vkResetCommandBuffer(batch.CommandBuffer, 0);
+		vkResetFences(m_pCpu->GetDevice(), 1, &batch.Fence);
+
+		m_FreeCommandBuffers.push_back(batch.CommandBuffer);
+		m_FreeFences.push_back(batch.Fence);
+
+		m_InFlight.pop_front();
+	}
+}
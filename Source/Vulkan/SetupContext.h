@@ -0,0 +1,86 @@
+#pragma once
+
+#ifndef GLFW_INCLUDE_VULKAN
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+#endif
+
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <memory>
+#include <functional>
+
+class LogicalDevice;
+class PhysicalDevice;
+class CommandPool;
+class SetupContext;
+
+//Completes once the setup batch it was handed out for has finished executing on the GPU.
+//Copyable and cheap, a default constructed future is always ready.
+class SetupFuture
+{
+public:
+	SetupFuture();
+	SetupFuture(SetupContext* pContext, uint64_t batchId);
+
+	bool IsReady() const;
+
+	//Submits the batch first if that hasn't happened yet, so the same threading rules as SetupContext::Submit apply.
+	void Wait() const;
+
+private:
+	SetupContext* m_pContext;
+	uint64_t m_BatchId;
+};
+
+//Collects one time setup work, like layout transitions, into a single command buffer on the graphics queue
+//and submits it once with a fence, instead of a submission and vkQueueWaitIdle per operation.
+//Command buffers and fences of finished batches are reset and reused for the next batch.
+//Record may be called from several threads, Submit and Wait submit to the graphics queue and have to be called
+//from the thread that submits the frames.
+class SetupContext
+{
+public:
+	SetupContext(LogicalDevice* pCpu, PhysicalDevice* pGpu);
+	~SetupContext();
+
+	//Appends the commands recorded by record to the current batch. record runs before this returns.
+	SetupFuture Record(const std::function<void(VkCommandBuffer)>& record);
+
+	//Submits the current batch without waiting for it. Returns its future, or a ready one if nothing was recorded.
+	SetupFuture Submit();
+
+	bool IsComplete(uint64_t batchId);
+	void Wait(uint64_t batchId);
+
+private:
+	struct Batch
+	{
+		uint64_t Id = 0;
+		VkCommandBuffer CommandBuffer = VK_NULL_HANDLE;
+		VkFence Fence = VK_NULL_HANDLE;
+	};
+
+	void BeginBatch();
+	void SubmitRecording();
+
+	//Moves the command buffers and fences of completed batches back to the free lists.
+	void RecycleCompleted();
+
+private:
+	LogicalDevice* m_pCpu;
+	std::unique_ptr<CommandPool> m_UniquePool;
+
+	std::mutex m_Mutex;
+	Batch m_Recording;
+	bool m_IsRecording = false;
+
+	//Submitted batches, oldest first.
+	std::deque<Batch> m_InFlight;
+
+	std::vector<VkCommandBuffer> m_FreeCommandBuffers;
+	std::vector<VkFence> m_FreeFences;
+
+	uint64_t m_NextBatchId = 1;
+};
@@ -1,31 +1,34 @@
 #include "SwapChain.h"
 
 #include "PhysicalDevice.h"
-#include "../Core/Window.h"
 #include "Surface.h"
 #include "LogicalDevice.h"
+#include "UniformRingBuffer.h"
 
 #include "../Help/HelperMethods.h"
 
-#include <array>
-#include <chrono>
-
+#include <cmath>
+#include <algorithm>
 
+namespace
+{
+	//The field of view of the camera every frame is rendered with, see UpdateUniformBuffer.
+	const float CAMERA_FOV_DEGREES = 45.0f;
+}
 
-SwapChain::SwapChain(PhysicalDevice* pPhysicalDevice, Window* pWindow, Surface* pSurface, LogicalDevice* pCpu):
-	m_pWindow(pWindow),
+SwapChain::SwapChain(PhysicalDevice* pPhysicalDevice, VkExtent2D framebufferSize, Surface* pSurface, LogicalDevice* pCpu, PresentPolicy presentPolicy,
+	SwapChain* pOldSwapChain):
 	m_pCpu(pCpu),
 	m_pPhysicalDevice(pPhysicalDevice)
 {
 	const SwapChainSupportDetails swapChainSupport = pPhysicalDevice->GetDesc().SwapChainSupportDetails;
 
 	VkSurfaceFormatKHR surfaceFormat = ChooseSwapChainSurfaceFormat(swapChainSupport.Formats);
-	VkPresentModeKHR presentMode = ChooseSwapChainPresentMode(swapChainSupport.PresentModes);
-	VkExtent2D extent = ChooseSwapExtent(swapChainSupport.Capabilities);
+	VkPresentModeKHR presentMode = ChooseSwapChainPresentMode(swapChainSupport.PresentModes, presentPolicy);
+	VkExtent2D extent = ChooseSwapExtent(swapChainSupport.Capabilities, framebufferSize);
 
-	uint32_t imageCount = swapChainSupport.Capabilities.minImageCount + 1;
-	if (swapChainSupport.Capabilities.minImageCount > 0 && imageCount > swapChainSupport.Capabilities.maxImageCount)
-		imageCount = swapChainSupport.Capabilities.maxImageCount;
+	uint32_t imageCount = ChooseImageCount(swapChainSupport.Capabilities, presentPolicy);
+	m_PresentMode = presentMode;
 
 	VkSwapchainCreateInfoKHR createInfo = {};
 	createInfo.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
@@ -72,12 +75,17 @@ SwapChain::SwapChain(PhysicalDevice* pPhysicalDevice, Window* pWindow, Surface*
 	//That leaves one last field, oldSwapChain. with Vulakn it's possible that your swap chain becomes invalid or unoptimized,
 	//while your application is running, for example because the window was resized. In that case the swap chain actually,
 	//needs to be recreated from scratch and a reference to the old one must be specified in this field.
-	//This is a complex topic that we'll learn more about in a future chapter. For now we'll assume that we'll only ever create one swap chain.
-	createInfo.oldSwapchain = VK_NULL_HANDLE;
+	//The old one is retired: no more images can be acquired from it, but images that were already presented are shown,
+	//and the driver can hand its resources over to the new one instead of allocating everything again.
+	createInfo.oldSwapchain = pOldSwapChain ? pOldSwapChain->GetSwapChain() : VK_NULL_HANDLE;
 
 	if (vkCreateSwapchainKHR(pCpu->GetDevice(), &createInfo, nullptr, &m_SwapChain) != VK_SUCCESS)
 		throw std::runtime_error("failed to create swap chain!");
 
+	//The ring is indexed by frame, not by image, so it carries over as it is and the descriptor sets that point to it stay valid.
+	if (pOldSwapChain)
+		m_UniqueUniformRing = std::move(pOldSwapChain->m_UniqueUniformRing);
+
 	vkGetSwapchainImagesKHR(pCpu->GetDevice(), m_SwapChain, &imageCount, nullptr);
 	m_Images.resize(imageCount);
 	vkGetSwapchainImagesKHR(pCpu->GetDevice(), m_SwapChain, &imageCount, m_Images.data());
@@ -86,21 +94,58 @@ SwapChain::SwapChain(PhysicalDevice* pPhysicalDevice, Window* pWindow, Surface*
 	m_SwapChainExtent = extent;
 }
 
-SwapChain::~SwapChain()
+SwapChain::SwapChain(PhysicalDevice* pPhysicalDevice, LogicalDevice* pCpu, uint32_t width, uint32_t height, uint32_t imageCount):
+	m_SwapChain(VK_NULL_HANDLE),
+	m_SwapChainImageFormat(VK_FORMAT_R8G8B8A8_UNORM),
+	m_SwapChainExtent({ width, height }),
+	m_pCpu(pCpu),
+	m_pPhysicalDevice(pPhysicalDevice),
+	m_IsHeadless(true)
 {
-	for (size_t i = 0; i < m_FrameBuffers.size(); ++i)
-		vkDestroyFramebuffer(m_pCpu->GetDevice(), m_FrameBuffers[i], nullptr);
+	//Without a presentation engine we create the images ourselves. They are single sampled like swap chain images,
+	//because they are the resolve target of the render pass, and they need to be a transfer source so that
+	//every frame can be copied into a host visible buffer for readback.
+	//RGBA8 is supported as color attachment by every implementation, including software ones like lavapipe.
+	const VkDeviceSize readbackSize = static_cast<VkDeviceSize>(width) * height * 4;
 
-	for (size_t i = 0; i < m_Images.size(); ++i)
+	m_Images.resize(imageCount);
+	m_ImagesAllocations.resize(imageCount);
+	m_ReadbackBuffers.resize(imageCount);
+	m_ReadbackBuffersAllocations.resize(imageCount);
+
+	for (uint32_t i = 0; i < imageCount; ++i)
 	{
-		vkDestroyBuffer(m_pCpu->GetDevice(), m_UniformBuffers[i], nullptr);
-		vkFreeMemory(m_pCpu->GetDevice(), m_UniformBuffersMemory[i], nullptr);
+		CreateImage(width, height, 1, VK_SAMPLE_COUNT_1_BIT, m_SwapChainImageFormat, VK_IMAGE_TILING_OPTIMAL,
+			VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			m_Images[i], m_ImagesAllocations[i], pCpu);
+
+		CreateBuffer(readbackSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			m_ReadbackBuffers[i], m_ReadbackBuffersAllocations[i], pCpu);
 	}
+}
+
+SwapChain::~SwapChain()
+{
+	m_UniqueUniformRing.reset();
 
 	for (size_t i = 0; i < m_ImageViews.size(); ++i)
 		vkDestroyImageView(m_pCpu->GetDevice(), m_ImageViews[i], nullptr);
 
-	vkDestroySwapchainKHR(m_pCpu->GetDevice(), m_SwapChain, nullptr);
+	for (size_t i = 0; i < m_ReadbackBuffers.size(); ++i)
+	{
+		vkDestroyBuffer(m_pCpu->GetDevice(), m_ReadbackBuffers[i], nullptr);
+		m_pCpu->GetAllocator()->Free(m_ReadbackBuffersAllocations[i]);
+	}
+
+	//Swap chain images are owned by the swap chain, only the headless images have to be destroyed by us.
+	for (size_t i = 0; i < m_ImagesAllocations.size(); ++i)
+	{
+		vkDestroyImage(m_pCpu->GetDevice(), m_Images[i], nullptr);
+		m_pCpu->GetAllocator()->Free(m_ImagesAllocations[i]);
+	}
+
+	if (!m_IsHeadless)
+		vkDestroySwapchainKHR(m_pCpu->GetDevice(), m_SwapChain, nullptr);
 
 }
 
@@ -128,127 +173,154 @@ void SwapChain::CreateImageViews()
 	}
 }
 
-void SwapChain::CreateFrameBuffers(const VkRenderPass& renderPass, const VkImageView& colorImageView, const VkImageView& depthImageView)
+void SwapChain::CreateUniformBuffer(uint32_t maxBlocksPerFrame, uint32_t framesInFlight)
 {
-	m_FrameBuffers.resize(m_ImageViews.size());
-
-	for (size_t i = 0; i < m_ImageViews.size(); ++i)
-	{
-		std::array<VkImageView, 3> attachements =
-		{
-			colorImageView,
-			depthImageView,
-			m_ImageViews[i]
-		};
-
-		//as you can see, creation of framebuffers is quite straightforward.
-		//We first need to specify with which renderPass the framebuffer needs to be compatible.
-		//You can only use a framebuffer with the render passes that it is compatible with,
-		//which roughly means that they use the same number and type of attachments.
-		VkFramebufferCreateInfo framebufferInfo = {};
-		framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-		framebufferInfo.renderPass = renderPass;
-
-		//the attachmentCount and pAttachments parameters specify the VkImageView objects that should be bound
-		//to the respective attachment descriptions in the render pass pAttachment array.
-		framebufferInfo.attachmentCount = static_cast<uint32_t>(attachements.size());
-		framebufferInfo.pAttachments = attachements.data();
-
-		//The width and height parameters are self-explanatory and layers reders to the number of layers in image arrays
-		//Our swap chain images are single images, so the number of layers is 1.
-		framebufferInfo.width = m_SwapChainExtent.width;
-		framebufferInfo.height = m_SwapChainExtent.height;
-		framebufferInfo.layers = 1;
-
-		if (vkCreateFramebuffer(m_pCpu->GetDevice(), &framebufferInfo, nullptr, &m_FrameBuffers[i]) != VK_SUCCESS)
-			throw std::runtime_error("failed to create framebuffer!");
-	}
-
+	//Instead of a uniform buffer with its own memory per swap chain image, we use one ring buffer
+	//with a segment per frame in flight. The segment of a frame is only rewritten after its fence has been waited on.
+	//Every block starts on a minUniformBufferOffsetAlignment boundary, so that's the size it really takes up.
+	const VkDeviceSize alignment = m_pPhysicalDevice->GetDesc().Properties.limits.minUniformBufferOffsetAlignment;
+	const VkDeviceSize alignedBlockSize = (sizeof(UniformBufferObject) + alignment - 1) / alignment * alignment;
+	const VkDeviceSize segmentSize = alignedBlockSize * maxBlocksPerFrame;
+
+	m_UniqueUniformRing = std::make_unique<UniformRingBuffer>(m_pCpu, m_pPhysicalDevice, segmentSize, framesInFlight);
 }
 
-void SwapChain::CreateUniformBuffer()
+VkPresentModeKHR SwapChain::ChooseSwapChainPresentMode(const std::vector<VkPresentModeKHR> availablePresentModes, PresentPolicy presentPolicy)
 {
-	VkDeviceSize bufferSize = sizeof(UniformBufferObject);
-
-	m_UniformBuffers.resize(m_Images.size());
-	m_UniformBuffersMemory.resize(m_Images.size());
+	//FIFO is the only mode every device has to support.
+	if (presentPolicy == PresentPolicy::VSync)
+		return VK_PRESENT_MODE_FIFO_KHR;
 
-	for (size_t i = 0; i < m_Images.size(); ++i)
-		CreateBuffer(bufferSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, m_UniformBuffers[i], m_UniformBuffersMemory[i], m_pCpu, m_pPhysicalDevice);
+	const VkPresentModeKHR preferredMode = presentPolicy == PresentPolicy::LowLatency ? VK_PRESENT_MODE_MAILBOX_KHR : VK_PRESENT_MODE_IMMEDIATE_KHR;
+	const VkPresentModeKHR secondMode = presentPolicy == PresentPolicy::LowLatency ? VK_PRESENT_MODE_IMMEDIATE_KHR : VK_PRESENT_MODE_MAILBOX_KHR;
 
-}
-
-VkPresentModeKHR SwapChain::ChooseSwapChainPresentMode(const std::vector<VkPresentModeKHR> availablePresentModes)
-{
 	VkPresentModeKHR bestMode = VK_PRESENT_MODE_FIFO_KHR;
 
 	for (const VkPresentModeKHR& availablePresentMode : availablePresentModes)
 	{
-		if (availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR)
+		if (availablePresentMode == preferredMode)
 			return availablePresentMode;
-		else if (availablePresentMode == VK_PRESENT_MODE_IMMEDIATE_KHR)
+		else if (availablePresentMode == secondMode)
 			bestMode = availablePresentMode;
 	}
 
 	return bestMode;
 }
 
-VkExtent2D SwapChain::ChooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities)
+uint32_t SwapChain::ChooseImageCount(const VkSurfaceCapabilitiesKHR& capabilities, PresentPolicy presentPolicy)
+{
+	//Sticking to the minimum means we sometimes have to wait on the driver to complete internal operations
+	//before we can acquire another image to render to, so at least one more than that.
+	//Every image more is a frame that can be queued, which smooths out slow frames but adds latency.
+	uint32_t imageCount = capabilities.minImageCount + 1;
+	if (presentPolicy == PresentPolicy::VSync)
+		imageCount = std::max(imageCount, 3u);
+	else if (presentPolicy == PresentPolicy::Throughput)
+		++imageCount;
+
+	//A maxImageCount of 0 means there is no maximum.
+	if (capabilities.maxImageCount > 0 && imageCount > capabilities.maxImageCount)
+		imageCount = capabilities.maxImageCount;
+
+	return imageCount;
+}
+
+VkExtent2D SwapChain::ChooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities, VkExtent2D framebufferSize) const
 {
 	if (capabilities.currentExtent.width != std::numeric_limits<uint32_t>::max())
 		return capabilities.currentExtent;
 
 	else
 	{
-		int width, height;
-		glfwGetFramebufferSize(m_pWindow->GetGLFWWindow(), &width, &height);
+		VkExtent2D actualtExtent = framebufferSize;
 
-		VkExtent2D actualtExtent = {
-			static_cast<uint32_t>(width),
-			static_cast<uint32_t>(height)
-		};
+		//While the window is being resized the framebuffer size may lag behind what the surface allows.
+		actualtExtent.width = std::max(capabilities.minImageExtent.width, std::min(capabilities.maxImageExtent.width, actualtExtent.width));
+		actualtExtent.height = std::max(capabilities.minImageExtent.height, std::min(capabilities.maxImageExtent.height, actualtExtent.height));
 
 		return actualtExtent;
 	}
 }
 
-void SwapChain::UpdateUniformBuffer(uint32_t currentImage)
+float SwapChain::GetProjectedDiameter(const glm::vec3& center, float radius) const
 {
-	//this function will generate a new transformation every frame to make the geometry spin around.
-	static auto startTime = std::chrono::high_resolution_clock::now();
-	auto currentTime = std::chrono::high_resolution_clock::now();
-	float time = std::chrono::duration<float, std::chrono::seconds::period>(currentTime - startTime).count();
-
-	UniformBufferObject ubo = {};
-	//The glm::rotate takes in an exisiting transformation, rotation angle and rotatoin axis as parameters.
-	//the glm::mat4(1.0f) constructor return an identity matrix.
-	//Using a rotation of time * glm::radians(90.f) accomplishes the purpose of rotation 90 degrees per second.
+	//A sphere at distance d covers about 2 * radius / (2 * d * tan(fov / 2)) of the height of the screen.
+	const float distance = std::max(glm::length(center - m_CameraEye), radius);
+	return radius * m_SwapChainExtent.height / (distance * std::tan(glm::radians(CAMERA_FOV_DEGREES) * 0.5f));
+}
 
-	ubo.Model = glm::rotate(glm::mat4(1.0f), time * glm::radians(90.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+glm::mat4 SwapChain::GetViewProjection() const
+{
+	return GetProjection() * GetView();
+}
 
+glm::mat4 SwapChain::GetView() const
+{
 	//For the view transformation I've decided to look a tthe geometry form above at a 45 degree angle.
 	//The glm::lookAt function takes the eye position, center position and up axis as parameters.
-	ubo.View = glm::lookAt(glm::vec3(2.0f, 2.0f, 2.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+	return glm::lookAt(m_CameraEye, m_CameraTarget, glm::vec3(0.0f, 0.0f, 1.0f));
+}
 
+glm::mat4 SwapChain::GetProjection() const
+{
 	//I've chosen to use a perspective projection with a 45 degree angle vertical fov.
 	//The other parameters are the aspect ratio, near and far view planes.
 	//it is important to use the current swapchain extent to calculate the aspect ration to take into account the
 	//new width and height of the window after a resize.
-	ubo.Proj = glm::perspective(glm::radians(45.0f), m_SwapChainExtent.width / (float)m_SwapChainExtent.height, 0.1f, 10.f);
+	glm::mat4 proj = glm::perspective(glm::radians(CAMERA_FOV_DEGREES), m_SwapChainExtent.width / (float)m_SwapChainExtent.height, 0.1f, 10.f);
 
 	//GLM was originally designed for OpenGL, where the Y coordinate of the clip coordinates is inverted.
 	//The easies way to compensate for that is to flip the sign on the scaling factor of the Y axis in the proj matrix.
 	//If you don't do this, then the image will be rendered upside down.
-	ubo.Proj[1][1] *= -1;
+	proj[1][1] *= -1;
+	return proj;
+}
+
+void SwapChain::UpdateUniformBuffer(uint32_t frameIndex, float time, const std::vector<glm::mat4>& objectTransforms, const std::vector<uint32_t>& objectTextures,
+	const glm::mat4& meshTransform, std::vector<uint32_t>& dynamicOffsets)
+{
+	//this function will generate a new transformation every frame to make the geometry spin around.
+	//The caller decides what time it is, so a benchmark can step it by a fixed amount every frame.
+	UniformBufferObject ubo = {};
+	//The glm::rotate takes in an exisiting transformation, rotation angle and rotatoin axis as parameters.
+	//the glm::mat4(1.0f) constructor return an identity matrix.
+	//Using a rotation of time * glm::radians(90.f) accomplishes the purpose of rotation 90 degrees per second.
+
+	const glm::mat4 rotation = glm::rotate(glm::mat4(1.0f), time * glm::radians(90.0f), glm::vec3(0.0f, 0.0f, 1.0f)) * meshTransform;
+
+	ubo.View = GetView();
+	ubo.Proj = GetProjection();
 
 	//Using a UBO this way is not the moest efficient way to pass frequently changing values to the shader.
 	//A more fficine tway to pass a smaal buffer of data to shaders push constants.
 	//https://stackoverflow.com/questions/50956414/what-is-a-push-constant-in-vulkan
 	//https://github.com/PacktPublishing/Vulkan-Cookbook
 	//https://github.com/SaschaWillems/Vulkan
-	void* data;
-	vkMapMemory(m_pCpu->GetDevice(), m_UniformBuffersMemory[currentImage], 0, sizeof(ubo), 0, &data);
-	memcpy(data, &ubo, sizeof(ubo));
-	vkUnmapMemory(m_pCpu->GetDevice(), m_UniformBuffersMemory[currentImage]);
+	//The ring buffer is persistently mapped, so updating it is a plain memcpy.
+	//Every object gets its own uniform block, the command buffer binds the dynamic offset of a block before each draw.
+	m_UniqueUniformRing->BeginSegment(frameIndex);
 
+	dynamicOffsets.clear();
+	for (size_t i = 0; i < objectTransforms.size(); ++i)
+	{
+		ubo.Model = objectTransforms[i] * rotation;
+		ubo.TextureIndex = objectTextures.empty() ? 0 : objectTextures[i];
+
+		const UniformAllocation allocation = m_UniqueUniformRing->Allocate(sizeof(ubo));
+		memcpy(allocation.pData, &ubo, sizeof(ubo));
+		dynamicOffsets.push_back(allocation.DynamicOffset);
+	}
 }
+
+void SwapChain::ReadbackImage(uint32_t imageIndex, std::vector<unsigned char>& pixels) const
+{
+	if (!m_IsHeadless)
+		throw std::runtime_error("only offscreen images can be read back!");
+
+	const VkDeviceSize size = static_cast<VkDeviceSize>(m_SwapChainExtent.width) * m_SwapChainExtent.height * 4;
+	pixels.resize(static_cast<size_t>(size));
+
+	//The command buffer already made the transfer writes available to the host with a barrier,
+	//and the memory is host coherent and persistently mapped, so copying is all that's left.
+	memcpy(pixels.data(), m_ReadbackBuffersAllocations[imageIndex].pMapped, static_cast<size_t>(size));
+}
\ No newline at end of file
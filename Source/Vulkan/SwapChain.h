@@ -6,11 +6,14 @@
 #endif
 
 #include <vector>
+#include <memory>
+
+#include "MemoryAllocator.h"
 
 class PhysicalDevice;
-class Window;
 class Surface;
 class LogicalDevice;
+class UniformRingBuffer;
 
 //Exposes functions that can be used to generate model transformations like glm::rotate, 
 //view transformations like glm::lookat
@@ -22,45 +25,98 @@ struct UniformBufferObject
 	glm::mat4 Model;
 	glm::mat4 View;
 	glm::mat4 Proj;
+
+	//Slot of the object's texture in the BindlessTextureTable, the other shaders don't read it.
+	uint32_t TextureIndex;
+};
+
+//How the swap chain trades latency against smoothness and throughput, it picks the present mode and image count.
+//LowLatency: MAILBOX, then IMMEDIATE, the newest frame is shown at the next refresh. Frames that are never shown are still rendered.
+//VSync: always FIFO with at least 3 images, every frame is shown without tearing and a slow frame doesn't make the display wait.
+//Throughput: IMMEDIATE, then MAILBOX, with an extra image, so acquiring an image never waits for the display.
+enum class PresentPolicy
+{
+	LowLatency,
+	VSync,
+	Throughput
 };
 
 class SwapChain
 {
 public:
-	SwapChain(PhysicalDevice* pPhysicalDevice, Window* pWindow, Surface* pSurface, LogicalDevice* pCpu);
+	//pOldSwapChain is the swap chain this one replaces after a resize. The presentation engine may reuse its resources,
+	//and its uniform ring is handed over, but it stays alive until the frames that still use it have finished.
+	//framebufferSize is the size of the window's framebuffer, used when the surface leaves the extent up to us.
+	//GLFW may only be asked for it on the main thread, while swap chains are also created on worker threads.
+	SwapChain(PhysicalDevice* pPhysicalDevice, VkExtent2D framebufferSize, Surface* pSurface, LogicalDevice* pCpu, PresentPolicy presentPolicy,
+		SwapChain* pOldSwapChain = nullptr);
+
+	//Headless: creates imageCount offscreen images and host visible readback buffers instead of a VkSwapchainKHR.
+	SwapChain(PhysicalDevice* pPhysicalDevice, LogicalDevice* pCpu, uint32_t width, uint32_t height, uint32_t imageCount);
 	~SwapChain();
 
 	VkSwapchainKHR GetSwapChain() const { return m_SwapChain; }
 	VkExtent2D GetExtent() const { return m_SwapChainExtent; }
 	VkFormat GetFormat() const { return m_SwapChainImageFormat; }
-	const std::vector<VkFramebuffer>& GetFrameBuffers() const { return m_FrameBuffers; }
+	//Headless swap chains don't present, they report FIFO.
+	VkPresentModeKHR GetPresentMode() const { return m_PresentMode; }
 	const std::vector<VkImageView>& GetImageViews() const { return m_ImageViews; }
 	const std::vector<VkImage>& GetImages() const { return m_Images; }
-	const std::vector<VkBuffer>& GetUniformBuffers() const { return m_UniformBuffers; }
+	UniformRingBuffer* GetUniformRing() const { return m_UniqueUniformRing.get(); }
+	const std::vector<VkBuffer>& GetReadbackBuffers() const { return m_ReadbackBuffers; }
+	bool IsHeadless() const { return m_IsHeadless; }
 
 	void CreateImageViews();
-	void CreateFrameBuffers(const VkRenderPass& renderPass, const VkImageView& colorImageView, const VkImageView& depthImageView);
-	void UpdateUniformBuffer(uint32_t currentImage);
-	void CreateUniformBuffer();
+	//Writes a uniform block per object transform into the segment of frameIndex and returns their dynamic offsets.
+	//The mesh spins 90 degrees per second of time. meshTransform is applied to the vertex positions first, see Mesh::GetPositionTransform.
+	//objectTextures holds the texture index of every object, when it is empty they all use index 0.
+	void UpdateUniformBuffer(uint32_t frameIndex, float time, const std::vector<glm::mat4>& objectTransforms, const std::vector<uint32_t>& objectTextures,
+		const glm::mat4& meshTransform, std::vector<uint32_t>& dynamicOffsets);
+	//A segment per frame in flight, so the ring doesn't depend on the number of images and survives a recreation.
+	void CreateUniformBuffer(uint32_t maxBlocksPerFrame, uint32_t framesInFlight);
+
+	//The camera of UpdateUniformBuffer, by default it looks at the origin from above at a 45 degree angle.
+	void SetCamera(const glm::vec3& eye, const glm::vec3& target) { m_CameraEye = eye; m_CameraTarget = target; }
+	const glm::vec3& GetCameraEye() const { return m_CameraEye; }
+
+	//Size in pixels of a sphere in world space on screen, as seen by the camera of UpdateUniformBuffer.
+	float GetProjectedDiameter(const glm::vec3& center, float radius) const;
+	//Projection times view of that camera, for the extent of the swap chain.
+	glm::mat4 GetViewProjection() const;
+
+	//Copies the pixels of an offscreen image from its readback buffer.
+	//The caller must make sure the frame that rendered into the image has finished.
+	void ReadbackImage(uint32_t imageIndex, std::vector<unsigned char>& pixels) const;
 private:
 	VkSurfaceFormatKHR ChooseSwapChainSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats);
-	VkPresentModeKHR ChooseSwapChainPresentMode(const std::vector<VkPresentModeKHR> availablePresentModes);
-	VkExtent2D ChooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities);
+	VkPresentModeKHR ChooseSwapChainPresentMode(const std::vector<VkPresentModeKHR> availablePresentModes, PresentPolicy presentPolicy);
+	uint32_t ChooseImageCount(const VkSurfaceCapabilitiesKHR& capabilities, PresentPolicy presentPolicy);
+	VkExtent2D ChooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities, VkExtent2D framebufferSize) const;
+
+	glm::mat4 GetView() const;
+	glm::mat4 GetProjection() const;
 
 private:
-	Window* m_pWindow;
 
 	VkSwapchainKHR m_SwapChain;
 	std::vector<VkImage> m_Images;
 	VkFormat m_SwapChainImageFormat;
 	VkExtent2D m_SwapChainExtent;
+	VkPresentModeKHR m_PresentMode = VK_PRESENT_MODE_FIFO_KHR;
+
+	glm::vec3 m_CameraEye = glm::vec3(2.0f, 2.0f, 2.0f);
+	glm::vec3 m_CameraTarget = glm::vec3(0.0f, 0.0f, 0.0f);
 	std::vector<VkImageView> m_ImageViews;
 	LogicalDevice* m_pCpu;
-	std::vector<VkBuffer> m_UniformBuffers;
-	std::vector<VkDeviceMemory> m_UniformBuffersMemory;
-	std::vector<VkFramebuffer> m_FrameBuffers;
+	std::unique_ptr<UniformRingBuffer> m_UniqueUniformRing;
 
 	uint32_t m_CurrentImage;
 
 	PhysicalDevice* m_pPhysicalDevice;
+
+	//Headless only: the offscreen images are owned by us instead of the presentation engine.
+	bool m_IsHeadless = false;
+	std::vector<Allocation> m_ImagesAllocations;
+	std::vector<VkBuffer> m_ReadbackBuffers;
+	std::vector<Allocation> m_ReadbackBuffersAllocations;
 };
\ No newline at end of file
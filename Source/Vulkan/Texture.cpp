@@ -2,32 +2,24 @@
 
 #include "LogicalDevice.h"
 #include "PhysicalDevice.h"
-#include "CommandPool.h"
+#include "UploadManager.h"
+#include "Profiler.h"
 
 #include "../Help/HelperMethods.h"
+#include "../Help/Ktx2Texture.h"
+#include "../Help/MipGenerator.h"
 
 #include <algorithm>
 
-#include <stb/stb_image.h>
-
-namespace
-{
-	const std::string TEXTURE_PATH = "../data/textures/chalet.jpg";
-}
-
-Texture::Texture(LogicalDevice* pCpu, PhysicalDevice* pGpu, CommandPool* pCommandPool):
+Texture::Texture(LogicalDevice* pCpu, PhysicalDevice* pGpu, UploadManager* pUploader, const TextureData& data):
+	m_Format(VK_FORMAT_R8G8B8A8_UNORM),
 	m_pCpu(pCpu)
 {
-	int texWidth, texHeight, texChannels;
-
-	//the stbi_load function takes the file path and number of channels as arguments.
-	//the STBI_rgb_alpha value forces the image to be loaded with an alpha channel, even if it doesn't have one,
-	//which is nice for consistency with other textures in the future.
-	//The middle 3 parameters are outputs for the dith, height and actual number of channels in the image.
-	//The pointer that is returned is the first elemtn in an array of pixel values.
-	//The pixels are laid out row by row with 4 bytes per pixel in the case of STBI_rgba_alpha for a total of texWidth * texHeight * 4 values.
-	stbi_uc* pixels = stbi_load(TEXTURE_PATH.c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
-	VkDeviceSize imageSize = texWidth * texHeight * 4; //4 -> rgba
+	//The pixels were already decoded by LoadTexture, possibly on another thread,
+	//so all that's left here is getting them onto the GPU.
+	const int texWidth = data.Width;
+	const int texHeight = data.Height;
+	VkDeviceSize imageSize = data.Pixels.size();
 
 	//In Vulkan each of the mip images is stored in different mip levels of a VkImage.
 	//Mip level 0 is the original image, and the mip levels after level 0 are commonly referred to as the mip chain.
@@ -40,79 +32,92 @@ Texture::Texture(LogicalDevice* pCpu, PhysicalDevice* pGpu, CommandPool* pComman
 	//1 is added so that the original image has a mip level.
 	m_MipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(texWidth, texHeight)))) + 1;
 
-	if (!pixels)
-		throw std::runtime_error("failed to load texture image!");
+	//We must inform Vulkan that we intend to use the texture image as both the source and destination of a transfer.
+		CreateImage(texWidth, texHeight, m_MipLevels, VK_SAMPLE_COUNT_1_BIT, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_Texture, m_Allocation, pCpu);
 
-	VkBuffer stagingBuffer;
-	VkDeviceMemory stagingBufferMemory;
+	//Check if image formt supports linear blitting
+	//The VkFormatProperties has 3 fields named linearTilingFeatures, optimalTilingFeatures and bufferFeatues.
+	//that each describe how the format can be used depending on the way it is used. we create a texture image
+	//with the optimal tiling format, so we need to check optimalTilingFeatures. //Support for the linear filtering feature
+	//can bechecked with the VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT.
+	VkFormatProperties formatProps;
+	vkGetPhysicalDeviceFormatProperties(pGpu->GetDevice(), m_Format, &formatProps);
 
-	//The buffer should be in host visible memory so that we can map it
-	//and it should be usable as a transfer source so that we can copy it to an image later on.
-	CreateBuffer(imageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory, pCpu, pGpu);
+	//Without it, the mips are generated in software and uploaded together with the original image.
+	//That's slower at startup, but the CPU filters in linear light, so it's also the better looking option.
+	if (!(formatProps.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT))
+	{
+		std::vector<std::vector<uint8_t>> mips;
+		GenerateMipChain(data.Pixels.data(), texWidth, texHeight, MipColorSpace::SRGB, MipFilter::Box, mips);
+
+		std::vector<UploadManager::ImageLevel> levels(mips.size());
+		for (uint32_t level = 0; level < mips.size(); ++level)
+		{
+			levels[level].pData = mips[level].data();
+			levels[level].Size = mips[level].size();
+			levels[level].Width = std::max(static_cast<uint32_t>(texWidth) >> level, 1u);
+			levels[level].Height = std::max(static_cast<uint32_t>(texHeight) >> level, 1u);
+		}
+
+		pUploader->UploadImage(m_Texture, levels, m_MipLevels, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+		m_TextureView = CreateImageView(m_Texture, m_Format, VK_IMAGE_ASPECT_COLOR_BIT, m_MipLevels, pCpu);
+		return;
+	}
 
-	void* data;
-	vkMapMemory(pCpu->GetDevice(), stagingBufferMemory, 0, imageSize, 0, &data);
-	memcpy(data, pixels, static_cast<size_t>(imageSize));
-	vkUnmapMemory(pCpu->GetDevice(), stagingBufferMemory);
+	//The upload manager copies the pixels into mip level 0 on the transfer queue. The blits that fill the rest of the
+	//mip chain need a graphics queue, so the image is handed over to it still in VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL.
+	//GenerateMipMaps leaves every level in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, ready for the shader.
+	pUploader->UploadImage(m_Texture, data.Pixels.data(), imageSize, static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight), m_MipLevels,
+		VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
 
-	//clean up the original pixel array
-	stbi_image_free(pixels);
+	pUploader->RecordGraphicsCommands([&](VkCommandBuffer commandBuffer)
+	{
+		Profiler::GpuScope scope(pUploader->GetProfiler(), commandBuffer, "generate mip maps");
+		GenerateMipMaps(commandBuffer, m_Texture, texWidth, texHeight, m_MipLevels);
+	});
 
-		//We must inform Vulkan that we intend to use the texture image as both the source and destination of a transfer.
-		CreateImage(texWidth, texHeight, m_MipLevels, VK_SAMPLE_COUNT_1_BIT, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_Texture, m_Memory, pCpu, pGpu);
+	//The code for this function can be based directly on CreateImageViews.
+	//The only 2 changes you have to make are the format and the image
+	m_TextureView = CreateImageView(m_Texture, m_Format, VK_IMAGE_ASPECT_COLOR_BIT, m_MipLevels, pCpu);
 
-	//Copy the staging buffer to the texture image with 2 steps:
-	//Transition the texture image to VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
-	//Execute the buffer to image copy operation
+}
 
-	//The image was created with the VK_IMAGE_LAYOUT_UNDEFFINED layout, so that one should be specified as old layout 
-	//when transitioning textureImage.
-	TransitionImageLayout(m_Texture, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, m_MipLevels, pCommandPool, pCpu);
-	CopyBufferToImage(stagingBuffer, m_Texture, static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight), pCommandPool->GetPool(), pCpu);
+Texture::Texture(LogicalDevice* pCpu, UploadManager* pUploader, const Ktx2Texture& ktx):
+	m_Format(ktx.GetFormat()),
+	m_pCpu(pCpu),
+	m_MipLevels(ktx.GetLevelCount())
+{
+	//Every level is already in the file, so the image is only ever a transfer destination and no blits are needed.
+	//Block compressed formats can't be blitted into anyway.
+	CreateImage(ktx.GetWidth(), ktx.GetHeight(), m_MipLevels, VK_SAMPLE_COUNT_1_BIT, m_Format, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_Texture, m_Allocation, pCpu);
 
-	GenerateMipMaps(m_Texture, VK_FORMAT_R8G8B8A8_UNORM, texWidth, texHeight, m_MipLevels, pGpu, pCommandPool);
-	//To be able to start sampling from the texture image in the shader, we need one last transition
-	//to prepare it for shader access.
-	//TransitionImageLayout(m_TextureImage, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, m_MipLevels);
-	vkDestroyBuffer(pCpu->GetDevice(), stagingBuffer, nullptr);
-	vkFreeMemory(pCpu->GetDevice(), stagingBufferMemory, nullptr);
+	std::vector<UploadManager::ImageLevel> levels(m_MipLevels);
+	for (uint32_t level = 0; level < m_MipLevels; ++level)
+	{
+		levels[level].pData = ktx.GetLevelData(level);
+		levels[level].Size = ktx.GetLevelSize(level);
+		levels[level].Width = ktx.GetLevelWidth(level);
+		levels[level].Height = ktx.GetLevelHeight(level);
+	}
 
-	//The code for this function can be based directly on CreateImageViews.
-	//The only 2 changes you have to make are the format and the image
-	m_TextureView = CreateImageView(m_Texture, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_ASPECT_COLOR_BIT, m_MipLevels, pCpu);
+	pUploader->UploadImage(m_Texture, levels, m_MipLevels, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
 
+	m_TextureView = CreateImageView(m_Texture, m_Format, VK_IMAGE_ASPECT_COLOR_BIT, m_MipLevels, pCpu);
 }
 
 Texture::~Texture()
 {
 	vkDestroyImageView(m_pCpu->GetDevice(), m_TextureView, nullptr);
 	vkDestroyImage(m_pCpu->GetDevice(), m_Texture, nullptr);
-	vkFreeMemory(m_pCpu->GetDevice(), m_Memory, nullptr);
+	m_pCpu->GetAllocator()->Free(m_Allocation);
 
 }
 
-void Texture::GenerateMipMaps(VkImage image, VkFormat format, int32_t texWidth, int32_t texHeight, uint32_t mipLevels, PhysicalDevice* pGpu, CommandPool* pCommandPool)
+void Texture::GenerateMipMaps(VkCommandBuffer commandBuffer, VkImage image, int32_t texWidth, int32_t texHeight, uint32_t mipLevels)
 {
-	//Check if image formt supports linear blitting
-	//The VkFormatProperties has 3 fields named linearTilingFeatures, optimalTilingFeatures and bufferFeatues.
-	//that each describe how the format can be used depending on the way it is used. we create a texture image
-	//with the optimal tiling format, so we need to check optimalTilingFeatures. //Support for the linear filtering feature
-	//can bechecked with the VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT.
-	VkFormatProperties formatProps;
-	vkGetPhysicalDeviceFormatProperties(pGpu->GetDevice(), format, &formatProps);
-
-	//There are 2 alternatives in this case. You could implement a function that searches common texture image
-	//formats for one that does support linear blitting, or you could implement the mipmap generation in software
-	//with a library like stb_image_resize. Each mip level can then be loaded into the image in the same way 
-	//that you loaded the orignal image.
-
 	//It should be noted that it is uncommon in practice to generate the mipmap levels at runtime anywah.
-	//Usually they are pregenerated and stored in the texture file alongside the base level to improve loading speed.
-	//Implmenting resizing in software and loading multiple levels from a file is left as an exercise to the reader.
-	if (!(formatProps.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT))
-		throw std::runtime_error("texture image format does not support linear blitting!");
-
-	VkCommandBuffer commandBuffer = BeginSingleTimeCommands(pCommandPool->GetPool(), m_pCpu);
+	//Usually they are pregenerated and stored in the texture file alongside the base level to improve loading speed,
+	//see TextureCooker.h.
 
 	VkImageMemoryBarrier barrier = {};
 	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
@@ -154,7 +159,7 @@ void Texture::GenerateMipMaps(VkImage image, VkFormat format, int32_t texWidth,
 		blit.srcSubresource.baseArrayLayer = 0;
 		blit.srcSubresource.layerCount = 1;
 		blit.dstOffsets[0] = { 0,0,0 };
-		blit.dstOffsets[1] = { mipWidth > 1 ? static_cast<int32_t>(mipWidth * 0.5f) : 1, mipHeight > 1 ? static_cast<int32_t>(mipHeight * 0.5f) : 1, 1 };
+		blit.dstOffsets[1] = { std::max(mipWidth / 2, 1), std::max(mipHeight / 2, 1), 1 };
 		blit.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
 		blit.dstSubresource.mipLevel = i;
 		blit.dstSubresource.baseArrayLayer = 0;
@@ -187,13 +192,11 @@ void Texture::GenerateMipMaps(VkImage image, VkFormat format, int32_t texWidth,
 	//before we end the command buffer, we insert one more pipeline barrier. This barrier transitions the last
 	//mip level from VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL to VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL. 
 	//This wasn't handled by the loop, since the last mip level is never blitted from
-	barrier.subresourceRange.baseMipLevel = m_MipLevels - 1;
+	barrier.subresourceRange.baseMipLevel = mipLevels - 1;
 	barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
 	barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
 	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
 
 	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
-
-	EndSingleTimeCommands(commandBuffer, pCommandPool->GetPool(), m_pCpu);
 }
\ No newline at end of file
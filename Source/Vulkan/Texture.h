@@ -5,28 +5,46 @@
 #include <GLFW/glfw3.h>
 #endif
 
+#include <vector>
+
+#include "MemoryAllocator.h"
+
 class LogicalDevice;
 class PhysicalDevice;
-class CommandPool;
+class UploadManager;
+class Ktx2Texture;
+
+//Decoded RGBA8 pixels of a texture, filled in by LoadTexture.
+struct TextureData
+{
+	int Width = 0;
+	int Height = 0;
+	std::vector<unsigned char> Pixels;
+};
 
 class Texture
 {
 public: 
-	Texture(LogicalDevice* pCpu, PhysicalDevice* pGpu, CommandPool* pCommandPool);
+	Texture(LogicalDevice* pCpu, PhysicalDevice* pGpu, UploadManager* pUploader, const TextureData& data);
+	//Uploads a texture cooked offline, in its own format and with its whole mip chain.
+	Texture(LogicalDevice* pCpu, UploadManager* pUploader, const Ktx2Texture& ktx);
 	~Texture();
 
 	const VkImage& GetImage() const { return m_Texture; }
-	const VkDeviceMemory& GetMemory() const { return m_Memory; }
+	const Allocation& GetAllocation() const { return m_Allocation; }
 	const VkImageView& GetImageView() const { return m_TextureView; }
 	const uint32_t GetSamples() const { return m_MipLevels; }
 
 private:
-	void GenerateMipMaps(VkImage image, VkFormat format, int32_t texWidth, int32_t texHeight, uint32_t mipLevels, PhysicalDevice* pGpu, CommandPool* pCommandPool);
+	//Records the blits into commandBuffer, which has to be submitted on the graphics queue.
+	//The format has to support VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT.
+	void GenerateMipMaps(VkCommandBuffer commandBuffer, VkImage image, int32_t texWidth, int32_t texHeight, uint32_t mipLevels);
 
 private:
 	VkImage m_Texture;
-	VkDeviceMemory m_Memory;
+	Allocation m_Allocation;
 	VkImageView m_TextureView;
+	VkFormat m_Format;
 
 	LogicalDevice* m_pCpu;
 	uint32_t m_MipLevels;
@@ -0,0 +1,292 @@
+#include "TextureStreamer.h"
+
+#include "LogicalDevice.h"
+#include "PhysicalDevice.h"
+#include "Texture.h"
+
+#include "../Help/HelperMethods.h"
+#include "../Help/Ktx2Texture.h"
+#include "../Help/MipGenerator.h"
+
+#include <algorithm>
+#include <cmath>
+
+TextureStreamer::TextureStreamer(LogicalDevice* pCpu, PhysicalDevice* pGpu, UploadManager* pUploader, VkDeviceSize budget, uint32_t framesInFlight):
+	m_pCpu(pCpu),
+	m_pGpu(pGpu),
+	m_pUploader(pUploader),
+	m_Budget(budget),
+	m_FramesInFlight(framesInFlight)
+{
+}
+
+TextureStreamer::~TextureStreamer()
+{
+	//The caller has waited for the device to be idle, but uploads into pending images may still be running
+	//on the transfer queue.
+	for (std::unique_ptr<StreamedTexture>& uniqueTexture : m_Textures)
+	{
+		if (uniqueTexture->HasPending)
+		{
+			m_pUploader->Wait(uniqueTexture->PendingBatch);
+			DestroyResidency(uniqueTexture->Pending);
+		}
+
+		DestroyResidency(uniqueTexture->Resident);
+	}
+
+	for (RetiredResidency& retired : m_Retired)
+		DestroyResidency(retired.Retired);
+}
+
+TextureStreamer::TextureId TextureStreamer::Add(std::unique_ptr<Ktx2Texture> uniqueKtx)
+{
+	std::unique_ptr<StreamedTexture> uniqueTexture = std::make_unique<StreamedTexture>();
+	uniqueTexture->Format = uniqueKtx->GetFormat();
+
+	for (uint32_t level = 0; level < uniqueKtx->GetLevelCount(); ++level)
+	{
+		UploadManager::ImageLevel imageLevel;
+		imageLevel.pData = uniqueKtx->GetLevelData(level);
+		imageLevel.Size = uniqueKtx->GetLevelSize(level);
+		imageLevel.Width = uniqueKtx->GetLevelWidth(level);
+		imageLevel.Height = uniqueKtx->GetLevelHeight(level);
+		uniqueTexture->Levels.push_back(imageLevel);
+	}
+
+	uniqueTexture->UniqueKtx = std::move(uniqueKtx);
+	return AddTexture(std::move(uniqueTexture));
+}
+
+TextureStreamer::TextureId TextureStreamer::Add(const TextureData& data)
+{
+	std::unique_ptr<StreamedTexture> uniqueTexture = std::make_unique<StreamedTexture>();
+	uniqueTexture->Format = VK_FORMAT_R8G8B8A8_UNORM;
+
+	GenerateMipChain(data.Pixels.data(), data.Width, data.Height, MipColorSpace::SRGB, MipFilter::Box, uniqueTexture->Mips);
+
+	for (uint32_t level = 0; level < uniqueTexture->Mips.size(); ++level)
+	{
+		UploadManager::ImageLevel imageLevel;
+		imageLevel.pData = uniqueTexture->Mips[level].data();
+		imageLevel.Size = uniqueTexture->Mips[level].size();
+		imageLevel.Width = std::max(static_cast<uint32_t>(data.Width) >> level, 1u);
+		imageLevel.Height = std::max(static_cast<uint32_t>(data.Height) >> level, 1u);
+		uniqueTexture->Levels.push_back(imageLevel);
+	}
+
+	return AddTexture(std::move(uniqueTexture));
+}
+
+TextureStreamer::TextureId TextureStreamer::AddTexture(std::unique_ptr<StreamedTexture> uniqueTexture)
+{
+	StreamedTexture& texture = *uniqueTexture;
+	const uint32_t levelCount = static_cast<uint32_t>(texture.Levels.size());
+
+	texture.TailLevel = 0;
+	while (texture.TailLevel + 1 < levelCount && (texture.Levels[texture.TailLevel].Width > TAIL_SIZE || texture.Levels[texture.TailLevel].Height > TAIL_SIZE))
+		++texture.TailLevel;
+
+	texture.RequestedLevel = levelCount;
+
+	//The tail is uploaded together with the rest of the setup and is resident from the first frame on.
+	texture.Resident = CreateResidency(texture, texture.TailLevel);
+
+	m_Textures.push_back(std::move(uniqueTexture));
+	return static_cast<TextureId>(m_Textures.size() - 1);
+}
+
+void TextureStreamer::RequestFootprint(TextureId id, float pixels)
+{
+	StreamedTexture& texture = *m_Textures[id];
+	const uint32_t levelCount = static_cast<uint32_t>(texture.Levels.size());
+
+	//The level whose width is closest to the footprint from above, that's the one the sampler picks when the whole
+	//texture is mapped once over the footprint. Anything larger is never sampled.
+	uint32_t level = 0;
+	if (pixels > 0.0f)
+	{
+		const float ratio = texture.Levels[0].Width / pixels;
+		level = ratio > 1.0f ? static_cast<uint32_t>(std::floor(std::log2(ratio))) : 0;
+	}
+	else
+		level = levelCount - 1;
+
+	texture.RequestedLevel = std::min(texture.RequestedLevel, std::min(level, levelCount - 1));
+	texture.LastUsedFrame = m_Frame;
+}
+
+void TextureStreamer::Update()
+{
+	//Frames up to m_Frame - m_FramesInFlight have finished, so images retired before them aren't in use anymore.
+	auto retired = m_Retired.begin();
+	while (retired != m_Retired.end())
+	{
+		if (retired->Frame + m_FramesInFlight <= m_Frame)
+		{
+			DestroyResidency(retired->Retired);
+			retired = m_Retired.erase(retired);
+		}
+		else
+			++retired;
+	}
+
+	//Uploads that have landed replace the images they were made for.
+	for (std::unique_ptr<StreamedTexture>& uniqueTexture : m_Textures)
+	{
+		StreamedTexture& texture = *uniqueTexture;
+		if (!texture.HasPending || !m_pUploader->IsComplete(texture.PendingBatch))
+			continue;
+
+		m_Retired.push_back({ texture.Resident, &texture, m_Frame });
+		texture.Resident = texture.Pending;
+		texture.Pending = Residency();
+		texture.HasPending = false;
+		texture.PendingBatch = 0;
+		++texture.ViewVersion;
+	}
+
+	//Textures that want larger levels than they have get them if they fit in the budget, evicting the textures
+	//that haven't been seen for the longest time if necessary. Textures that need fewer levels now keep them,
+	//they are likely to need them again soon, and eviction takes them away once the memory is wanted elsewhere.
+	//An image only gives its memory back once it's destroyed, after the upload that replaces it has landed and
+	//no frame uses it anymore. Until then it counts against the budget, next to the image that replaces it.
+	bool hasStartedUploads = false;
+	VkDeviceSize residentSize = GetResidentSize();
+
+	//The part of residentSize that is already on its way out: retired images and the ones pending uploads replace.
+	VkDeviceSize releasingSize = 0;
+	for (const RetiredResidency& retired : m_Retired)
+		releasingSize += GetResidencySize(*retired.pTexture, retired.Retired.FirstLevel);
+	for (const std::unique_ptr<StreamedTexture>& uniqueTexture : m_Textures)
+	{
+		if (uniqueTexture->HasPending)
+			releasingSize += GetResidencySize(*uniqueTexture, uniqueTexture->Resident.FirstLevel);
+	}
+
+	for (std::unique_ptr<StreamedTexture>& uniqueTexture : m_Textures)
+	{
+		StreamedTexture& texture = *uniqueTexture;
+		uint32_t targetLevel = std::min(texture.RequestedLevel, texture.TailLevel);
+		texture.RequestedLevel = static_cast<uint32_t>(texture.Levels.size());
+
+		if (texture.HasPending || targetLevel >= texture.Resident.FirstLevel)
+			continue;
+
+		//Evict until the texture fits once everything on its way out, its own current image included, is gone.
+		const VkDeviceSize currentSize = GetResidencySize(texture, texture.Resident.FirstLevel);
+		while (targetLevel < texture.Resident.FirstLevel && residentSize - releasingSize - currentSize + GetResidencySize(texture, targetLevel) > m_Budget)
+		{
+			StreamedTexture* pVictim = FindEvictionCandidate(&texture);
+			if (!pVictim)
+			{
+				//Nothing left to evict, settle for smaller levels.
+				++targetLevel;
+				continue;
+			}
+
+			pVictim->Pending = CreateResidency(*pVictim, pVictim->TailLevel);
+			pVictim->HasPending = true;
+			hasStartedUploads = true;
+
+			residentSize += GetResidencySize(*pVictim, pVictim->TailLevel);
+			releasingSize += GetResidencySize(*pVictim, pVictim->Resident.FirstLevel);
+		}
+
+		//The new image has to fit next to everything that is still alive. While memory is on its way out, the footprints
+		//of a later frame ask again. When nothing is, waiting doesn't help, so settle for smaller levels.
+		while (targetLevel < texture.Resident.FirstLevel && releasingSize == 0 && residentSize + GetResidencySize(texture, targetLevel) > m_Budget)
+			++targetLevel;
+
+		if (targetLevel >= texture.Resident.FirstLevel || residentSize + GetResidencySize(texture, targetLevel) > m_Budget)
+			continue;
+
+		texture.Pending = CreateResidency(texture, targetLevel);
+		texture.HasPending = true;
+		hasStartedUploads = true;
+		residentSize += GetResidencySize(texture, targetLevel);
+		releasingSize += currentSize;
+	}
+
+	if (hasStartedUploads)
+	{
+		const uint64_t batch = m_pUploader->Flush();
+		for (std::unique_ptr<StreamedTexture>& uniqueTexture : m_Textures)
+		{
+			if (uniqueTexture->HasPending && uniqueTexture->PendingBatch == 0)
+				uniqueTexture->PendingBatch = batch;
+		}
+	}
+
+	++m_Frame;
+}
+
+VkDeviceSize TextureStreamer::GetResidentSize() const
+{
+	VkDeviceSize size = 0;
+	for (const std::unique_ptr<StreamedTexture>& uniqueTexture : m_Textures)
+	{
+		size += GetResidencySize(*uniqueTexture, uniqueTexture->Resident.FirstLevel);
+		if (uniqueTexture->HasPending)
+			size += GetResidencySize(*uniqueTexture, uniqueTexture->Pending.FirstLevel);
+	}
+
+	for (const RetiredResidency& retired : m_Retired)
+		size += GetResidencySize(*retired.pTexture, retired.Retired.FirstLevel);
+
+	return size;
+}
+
+TextureStreamer::Residency TextureStreamer::CreateResidency(const StreamedTexture& texture, uint32_t firstLevel)
+{
+	const uint32_t levelCount = static_cast<uint32_t>(texture.Levels.size()) - firstLevel;
+
+	Residency residency;
+	residency.FirstLevel = firstLevel;
+
+	CreateImage(texture.Levels[firstLevel].Width, texture.Levels[firstLevel].Height, levelCount, VK_SAMPLE_COUNT_1_BIT, texture.Format, VK_IMAGE_TILING_OPTIMAL,
+		VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, residency.Image, residency.ImageAllocation, m_pCpu);
+
+	const std::vector<UploadManager::ImageLevel> levels(texture.Levels.begin() + firstLevel, texture.Levels.end());
+	m_pUploader->UploadImage(residency.Image, levels, levelCount, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+
+	residency.View = CreateImageView(residency.Image, texture.Format, VK_IMAGE_ASPECT_COLOR_BIT, levelCount, m_pCpu);
+	return residency;
+}
+
+void TextureStreamer::DestroyResidency(Residency& residency)
+{
+	if (residency.Image == VK_NULL_HANDLE)
+		return;
+
+	vkDestroyImageView(m_pCpu->GetDevice(), residency.View, nullptr);
+	vkDestroyImage(m_pCpu->GetDevice(), residency.Image, nullptr);
+	m_pCpu->GetAllocator()->Free(residency.ImageAllocation);
+	residency = Residency();
+}
+
+VkDeviceSize TextureStreamer::GetResidencySize(const StreamedTexture& texture, uint32_t firstLevel)
+{
+	VkDeviceSize size = 0;
+	for (size_t level = firstLevel; level < texture.Levels.size(); ++level)
+		size += texture.Levels[level].Size;
+
+	return size;
+}
+
+TextureStreamer::StreamedTexture* TextureStreamer::FindEvictionCandidate(const StreamedTexture* pExclude) const
+{
+	//Textures seen this frame are never evicted, that would only make them come back next frame.
+	StreamedTexture* pCandidate = nullptr;
+	for (const std::unique_ptr<StreamedTexture>& uniqueTexture : m_Textures)
+	{
+		StreamedTexture* pTexture = uniqueTexture.get();
+		if (pTexture == pExclude || pTexture->HasPending || pTexture->Resident.FirstLevel >= pTexture->TailLevel || pTexture->LastUsedFrame == m_Frame)
+			continue;
+
+		if (!pCandidate || pTexture->LastUsedFrame < pCandidate->LastUsedFrame)
+			pCandidate = pTexture;
+	}
+
+	return pCandidate;
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#ifndef GLFW_INCLUDE_VULKAN
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+#endif
+
+#include <vector>
+#include <memory>
+
+#include "MemoryAllocator.h"
+#include "UploadManager.h"
+
+class LogicalDevice;
+class PhysicalDevice;
+class Ktx2Texture;
+struct TextureData;
+
+//Keeps only the part of every texture's mip chain in device memory that is actually visible.
+//All levels stay in host memory, the mip tail (every level that fits in TAIL_SIZE x TAIL_SIZE texels) is always resident,
+//and the larger levels are uploaded once a texture covers enough of the screen to need them.
+//A texture's resident levels live in an image of their own: to bring in larger levels, a bigger image is created
+//and filled while the old one keeps being sampled. Once the upload has finished the views are swapped, so the shaders
+//never see a level that hasn't arrived yet, and the old image is destroyed when no frame in flight can use it anymore.
+//When the resident levels don't fit in the budget, the textures that were used least recently drop back to their tail.
+class TextureStreamer
+{
+public:
+	typedef uint32_t TextureId;
+
+	static const uint32_t TAIL_SIZE = 64;
+
+	//framesInFlight is the number of frames that may use a view after it has been replaced.
+	TextureStreamer(LogicalDevice* pCpu, PhysicalDevice* pGpu, UploadManager* pUploader, VkDeviceSize budget, uint32_t framesInFlight);
+	~TextureStreamer();
+
+	//Adds a cooked texture. It's only memory mapped, so the OS pages the levels in and out as they are streamed.
+	TextureId Add(std::unique_ptr<Ktx2Texture> uniqueKtx);
+	//Adds a decoded image, its mip chain is generated on the CPU and kept in host memory.
+	TextureId Add(const TextureData& data);
+
+	//Screen space footprint feedback: the texture is stretched over about pixels pixels along its width this frame.
+	//Several requests for the same texture in a frame keep the largest footprint.
+	void RequestFootprint(TextureId id, float pixels);
+
+	//Once per frame, after waiting for the fence of the frame and right before recording it: frees the images
+	//no frame uses anymore, swaps in finished uploads and starts the uploads and evictions the footprints of this frame ask for.
+	void Update();
+
+	VkImageView GetImageView(TextureId id) const { return m_Textures[id]->Resident.View; }
+	//Changes every time the view of the texture is replaced, so descriptor sets know when they are out of date.
+	uint64_t GetViewVersion(TextureId id) const { return m_Textures[id]->ViewVersion; }
+	//The whole mip chain, resident or not.
+	uint32_t GetLevelCount(TextureId id) const { return static_cast<uint32_t>(m_Textures[id]->Levels.size()); }
+	uint32_t GetResidentLevel(TextureId id) const { return m_Textures[id]->Resident.FirstLevel; }
+
+	//Bytes of the resident levels, the ones being uploaded and the replaced ones a frame may still use.
+	//The images take a little more because of alignment.
+	VkDeviceSize GetResidentSize() const;
+	VkDeviceSize GetBudget() const { return m_Budget; }
+
+private:
+	//An image holding levels [FirstLevel, end) of a texture.
+	struct Residency
+	{
+		VkImage Image = VK_NULL_HANDLE;
+		Allocation ImageAllocation;
+		VkImageView View = VK_NULL_HANDLE;
+		uint32_t FirstLevel = 0;
+	};
+
+	struct StreamedTexture
+	{
+		std::unique_ptr<Ktx2Texture> UniqueKtx;
+		std::vector<std::vector<uint8_t>> Mips;
+
+		VkFormat Format = VK_FORMAT_UNDEFINED;
+		std::vector<UploadManager::ImageLevel> Levels;
+		uint32_t TailLevel = 0;
+
+		Residency Resident;
+		Residency Pending;
+		bool HasPending = false;
+		uint64_t PendingBatch = 0;
+
+		//Largest level asked for by this frame's footprints, or the level count when there was no request.
+		uint32_t RequestedLevel = 0;
+		uint64_t LastUsedFrame = 0;
+		uint64_t ViewVersion = 0;
+	};
+
+	struct RetiredResidency
+	{
+		Residency Retired;
+		//The texture the levels belong to, for their size.
+		const StreamedTexture* pTexture;
+		uint64_t Frame;
+	};
+
+	TextureId AddTexture(std::unique_ptr<StreamedTexture> uniqueTexture);
+
+	//Creates an image for the levels from firstLevel on and queues their upload. The caller flushes the upload manager.
+	Residency CreateResidency(const StreamedTexture& texture, uint32_t firstLevel);
+	void DestroyResidency(Residency& residency);
+	//Bytes of the levels from firstLevel on.
+	static VkDeviceSize GetResidencySize(const StreamedTexture& texture, uint32_t firstLevel);
+
+	//Returns the texture that was used the longest ago and has more than its tail resident, or nullptr.
+	StreamedTexture* FindEvictionCandidate(const StreamedTexture* pExclude) const;
+
+private:
+	LogicalDevice* m_pCpu;
+	PhysicalDevice* m_pGpu;
+	UploadManager* m_pUploader;
+
+	VkDeviceSize m_Budget;
+	uint32_t m_FramesInFlight;
+	uint64_t m_Frame = 0;
+
+	std::vector<std::unique_ptr<StreamedTexture>> m_Textures;
+	std::vector<RetiredResidency> m_Retired;
+};
@@ -0,0 +1,63 @@
+#include "UniformRingBuffer.h"
+
+#include "LogicalDevice.h"
+#include "PhysicalDevice.h"
+
+#include "../Help/HelperMethods.h"
+
+#include <stdexcept>
+
+UniformRingBuffer::UniformRingBuffer(LogicalDevice* pCpu, PhysicalDevice* pGpu, VkDeviceSize segmentSize, uint32_t segmentCount):
+	m_Alignment(pGpu->GetDesc().Properties.limits.minUniformBufferOffsetAlignment),
+	m_SegmentCount(segmentCount),
+	m_CurrentSegment(0),
+	m_Head(0),
+	m_pCpu(pCpu)
+{
+	//Dynamic offsets have to be a multiple of minUniformBufferOffsetAlignment, so every segment
+	//(and later every allocation within a segment) starts on such a boundary.
+	m_SegmentSize = GetAlignedSize(segmentSize);
+
+	//Host coherent means the writes of the CPU are visible to the GPU without vkFlushMappedMemoryRanges.
+	//The allocator keeps host visible memory mapped, so there is no vkMapMemory/vkUnmapMemory per frame either.
+	CreateBuffer(m_SegmentSize * m_SegmentCount, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		m_Buffer, m_Allocation, pCpu);
+}
+
+UniformRingBuffer::~UniformRingBuffer()
+{
+	vkDestroyBuffer(m_pCpu->GetDevice(), m_Buffer, nullptr);
+	m_pCpu->GetAllocator()->Free(m_Allocation);
+}
+
+void UniformRingBuffer::BeginSegment(uint32_t segment)
+{
+	m_CurrentSegment = segment % m_SegmentCount;
+	m_Head = 0;
+}
+
+UniformAllocation UniformRingBuffer::Allocate(VkDeviceSize size)
+{
+	const VkDeviceSize alignedSize = GetAlignedSize(size);
+	if (m_Head + alignedSize > m_SegmentSize)
+		throw std::runtime_error("uniform ring buffer segment is full!");
+
+	const VkDeviceSize offset = GetSegmentOffset(m_CurrentSegment) + m_Head;
+	m_Head += alignedSize;
+
+	UniformAllocation allocation = {};
+	allocation.pData = static_cast<char*>(m_Allocation.pMapped) + offset;
+	allocation.DynamicOffset = static_cast<uint32_t>(offset);
+	return allocation;
+}
+
+VkDeviceSize UniformRingBuffer::GetAlignedSize(VkDeviceSize size) const
+{
+	return (size + m_Alignment - 1) / m_Alignment * m_Alignment;
+}
+
+uint32_t UniformRingBuffer::GetSegmentOffset(uint32_t segment) const
+{
+	return static_cast<uint32_t>(m_SegmentSize * (segment % m_SegmentCount));
+}
\ No newline at end of file
@@ -0,0 +1,51 @@
+#pragma once
+
+#ifndef GLFW_INCLUDE_VULKAN
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+#endif
+
+#include "MemoryAllocator.h"
+
+class LogicalDevice;
+class PhysicalDevice;
+
+struct UniformAllocation
+{
+	//Write the uniform data here, the memory is host coherent so no flush is needed.
+	void* pData;
+
+	//Pass this to vkCmdBindDescriptorSets as dynamic offset for the VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC binding.
+	uint32_t DynamicOffset;
+};
+
+//One persistently mapped uniform buffer, split in a segment per frame.
+//Uniform blocks are linearly sub-allocated from the segment of the current frame and
+//addressed through dynamic offsets, so a single descriptor set covers every frame and every object.
+class UniformRingBuffer
+{
+public:
+	UniformRingBuffer(LogicalDevice* pCpu, PhysicalDevice* pGpu, VkDeviceSize segmentSize, uint32_t segmentCount);
+	~UniformRingBuffer();
+
+	//Rewinds to the start of a segment. The caller must make sure the GPU is done with the frame that used it last.
+	void BeginSegment(uint32_t segment);
+	UniformAllocation Allocate(VkDeviceSize size);
+
+	const VkBuffer& GetBuffer() const { return m_Buffer; }
+	VkDeviceSize GetAlignedSize(VkDeviceSize size) const;
+	uint32_t GetSegmentOffset(uint32_t segment) const;
+
+private:
+	VkBuffer m_Buffer;
+	Allocation m_Allocation;
+
+	VkDeviceSize m_Alignment;
+	VkDeviceSize m_SegmentSize;
+	uint32_t m_SegmentCount;
+
+	uint32_t m_CurrentSegment;
+	VkDeviceSize m_Head;
+
+	LogicalDevice* m_pCpu;
+};
\ No newline at end of file
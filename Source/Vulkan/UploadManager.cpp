@@ -0,0 +1,372 @@
+#include "UploadManager.h"
+
+#include "LogicalDevice.h"
+#include "PhysicalDevice.h"
+
+#include "../Help/HelperMethods.h"
+
+#include <iostream>
+#include <stdexcept>
+#include <limits>
+#include <cstring>
+
+UploadManager::UploadManager(LogicalDevice* pCpu, PhysicalDevice* pGpu):
+	m_pCpu(pCpu),
+	m_pGpu(pGpu)
+{
+	const QueueFamilyIndices indices = pGpu->GetDesc().QueueIndices;
+	m_GraphicsFamily = static_cast<uint32_t>(indices.GraphicsFamily);
+	m_TransferFamily = static_cast<uint32_t>(indices.TransferFamily);
+
+	m_TransferPool = CreatePool(m_TransferFamily);
+	m_GraphicsPool = CreatePool(m_GraphicsFamily);
+
+	if (HasDedicatedTransferQueue())
+		std::cout << "upload manager: using transfer queue family " << m_TransferFamily << std::endl;
+	else
+		std::cout << "upload manager: no dedicated transfer queue, uploading on the graphics queue" << std::endl;
+}
+
+UploadManager::~UploadManager()
+{
+	//Uploads that were never flushed are simply dropped, nothing is waiting for them.
+	if (m_IsRecording)
+	{
+		vkEndCommandBuffer(m_Recording.TransferCommands);
+		vkEndCommandBuffer(m_Recording.GraphicsCommands);
+		ReleaseBatch(m_Recording);
+	}
+
+	for (Batch& batch : m_InFlight)
+	{
+		vkWaitForFences(m_pCpu->GetDevice(), 1, &batch.Fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+		ReleaseBatch(batch);
+	}
+
+	vkDestroyCommandPool(m_pCpu->GetDevice(), m_TransferPool, nullptr);
+	vkDestroyCommandPool(m_pCpu->GetDevice(), m_GraphicsPool, nullptr);
+}
+
+void UploadManager::UploadBuffer(VkBuffer dstBuffer, const void* pData, VkDeviceSize size, VkAccessFlags dstAccess, VkPipelineStageFlags dstStage)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	BeginBatch();
+
+	const StagingBuffer staging = CreateStagingBuffer(pData, size);
+
+	CopyBuffer(m_Recording.TransferCommands, staging.Buffer, dstBuffer, size);
+
+	VkBufferMemoryBarrier barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+	barrier.buffer = dstBuffer;
+	barrier.offset = 0;
+	barrier.size = VK_WHOLE_SIZE;
+
+	if (HasDedicatedTransferQueue())
+	{
+		//An ownership transfer is a pair of identical barriers: the release on the queue that owns the buffer now
+		//and the acquire on the queue that will own it. The access masks on the side that doesn't do anything are ignored.
+		barrier.srcQueueFamilyIndex = m_TransferFamily;
+		barrier.dstQueueFamilyIndex = m_GraphicsFamily;
+
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = 0;
+		vkCmdPipelineBarrier(m_Recording.TransferCommands, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+
+		barrier.srcAccessMask = 0;
+		barrier.dstAccessMask = dstAccess;
+		vkCmdPipelineBarrier(m_Recording.GraphicsCommands, VK_PIPELINE_STAGE_TRANSFER_BIT, dstStage, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+	}
+	else
+	{
+		//Everything runs on the graphics queue, a plain barrier makes the copy visible to later submissions.
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = dstAccess;
+		vkCmdPipelineBarrier(m_Recording.TransferCommands, VK_PIPELINE_STAGE_TRANSFER_BIT, dstStage, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+	}
+
+	m_Recording.StagingBuffers.push_back(staging);
+}
+
+void UploadManager::UploadImage(VkImage image, const void* pData, VkDeviceSize size, uint32_t width, uint32_t height, uint32_t mipLevels,
+	VkImageLayout finalLayout, VkAccessFlags dstAccess, VkPipelineStageFlags dstStage)
+{
+	ImageLevel level;
+	level.pData = pData;
+	level.Size = size;
+	level.Width = width;
+	level.Height = height;
+
+	UploadImage(image, std::vector<ImageLevel>(1, level), mipLevels, finalLayout, dstAccess, dstStage);
+}
+
+void UploadManager::UploadImage(VkImage image, const std::vector<ImageLevel>& levels, uint32_t mipLevels,
+	VkImageLayout finalLayout, VkAccessFlags dstAccess, VkPipelineStageFlags dstStage)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	BeginBatch();
+
+	//All levels share one staging buffer. vkCmdCopyBufferToImage wants the offset of each level to be a multiple of the texel size,
+	//or of the block size for block compressed formats, 16 covers every format we upload.
+	std::vector<VkDeviceSize> offsets;
+	VkDeviceSize stagingSize = 0;
+	for (const ImageLevel& level : levels)
+	{
+		stagingSize = (stagingSize + 15) & ~VkDeviceSize(15);
+		offsets.push_back(stagingSize);
+		stagingSize += level.Size;
+	}
+
+	const StagingBuffer staging = CreateStagingBuffer(nullptr, stagingSize);
+	for (size_t level = 0; level < levels.size(); ++level)
+		memcpy(static_cast<uint8_t*>(staging.BufferAllocation.pMapped) + offsets[level], levels[level].pData, static_cast<size_t>(levels[level].Size));
+
+	VkImageMemoryBarrier barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.image = image;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	barrier.subresourceRange.baseMipLevel = 0;
+	barrier.subresourceRange.levelCount = mipLevels;
+	barrier.subresourceRange.baseArrayLayer = 0;
+	barrier.subresourceRange.layerCount = 1;
+
+	//The contents of an image in VK_IMAGE_LAYOUT_UNDEFINED don't belong to any queue yet,
+	//so the transfer queue can just start using it without an acquire.
+	barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	barrier.srcAccessMask = 0;
+	barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	vkCmdPipelineBarrier(m_Recording.TransferCommands, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+	for (uint32_t level = 0; level < levels.size(); ++level)
+		CopyBufferToImage(m_Recording.TransferCommands, staging.Buffer, image, levels[level].Width, levels[level].Height, level, offsets[level]);
+
+	//The layout transition to finalLayout is part of the ownership transfer. Both barriers have to describe it identically,
+	//it only happens once, somewhere between the release and the acquire.
+	barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	barrier.newLayout = finalLayout;
+
+	if (HasDedicatedTransferQueue())
+	{
+		barrier.srcQueueFamilyIndex = m_TransferFamily;
+		barrier.dstQueueFamilyIndex = m_GraphicsFamily;
+
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = 0;
+		vkCmdPipelineBarrier(m_Recording.TransferCommands, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+		barrier.srcAccessMask = 0;
+		barrier.dstAccessMask = dstAccess;
+		vkCmdPipelineBarrier(m_Recording.GraphicsCommands, VK_PIPELINE_STAGE_TRANSFER_BIT, dstStage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+	}
+	else
+	{
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = dstAccess;
+		vkCmdPipelineBarrier(m_Recording.TransferCommands, VK_PIPELINE_STAGE_TRANSFER_BIT, dstStage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+	}
+
+	m_Recording.StagingBuffers.push_back(staging);
+}
+
+void UploadManager::RecordGraphicsCommands(const std::function<void(VkCommandBuffer)>& record)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	BeginBatch();
+
+	record(m_Recording.GraphicsCommands);
+}
+
+uint64_t UploadManager::Flush()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	if (!m_IsRecording)
+		return m_NextBatchId - 1;
+
+	Batch batch = m_Recording;
+	m_Recording = Batch();
+	m_IsRecording = false;
+
+	batch.Id = m_NextBatchId++;
+
+	if (m_pProfiler)
+		m_pProfiler->EndGpuScope(batch.TransferCommands, batch.TransferScope);
+
+	vkEndCommandBuffer(batch.TransferCommands);
+	vkEndCommandBuffer(batch.GraphicsCommands);
+
+	VkFenceCreateInfo fenceInfo = {};
+	fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+	if (vkCreateFence(m_pCpu->GetDevice(), &fenceInfo, nullptr, &batch.Fence) != VK_SUCCESS)
+		throw std::runtime_error("failed to create upload fence!");
+
+	//The fence is signaled by the graphics submission. That one waits for the transfer submission,
+	//so once the fence is signaled the staging buffers of both are no longer in use.
+	if (HasDedicatedTransferQueue())
+	{
+		VkSemaphoreCreateInfo semaphoreInfo = {};
+		semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+		if (vkCreateSemaphore(m_pCpu->GetDevice(), &semaphoreInfo, nullptr, &batch.TransferFinished) != VK_SUCCESS)
+			throw std::runtime_error("failed to create upload semaphore!");
+
+		VkSubmitInfo transferSubmit = {};
+		transferSubmit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		transferSubmit.commandBufferCount = 1;
+		transferSubmit.pCommandBuffers = &batch.TransferCommands;
+		transferSubmit.signalSemaphoreCount = 1;
+		transferSubmit.pSignalSemaphores = &batch.TransferFinished;
+
+		if (vkQueueSubmit(m_pCpu->GetTransferQueue(), 1, &transferSubmit, VK_NULL_HANDLE) != VK_SUCCESS)
+			throw std::runtime_error("failed to submit uploads to the transfer queue!");
+
+		//The acquire barriers are recorded with the transfer stage as their source, which is where the semaphore wait happens.
+		const VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+
+		VkSubmitInfo graphicsSubmit = {};
+		graphicsSubmit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		graphicsSubmit.waitSemaphoreCount = 1;
+		graphicsSubmit.pWaitSemaphores = &batch.TransferFinished;
+		graphicsSubmit.pWaitDstStageMask = &waitStage;
+		graphicsSubmit.commandBufferCount = 1;
+		graphicsSubmit.pCommandBuffers = &batch.GraphicsCommands;
+
+		if (vkQueueSubmit(m_pCpu->GetGraphicsQueue(), 1, &graphicsSubmit, batch.Fence) != VK_SUCCESS)
+			throw std::runtime_error("failed to submit upload acquire barriers!");
+	}
+	else
+	{
+		const VkCommandBuffer commandBuffers[] = { batch.TransferCommands, batch.GraphicsCommands };
+
+		VkSubmitInfo submitInfo = {};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.commandBufferCount = 2;
+		submitInfo.pCommandBuffers = commandBuffers;
+
+		if (vkQueueSubmit(m_pCpu->GetGraphicsQueue(), 1, &submitInfo, batch.Fence) != VK_SUCCESS)
+			throw std::runtime_error("failed to submit uploads!");
+	}
+
+	m_InFlight.push_back(batch);
+	return batch.Id;
+}
+
+bool UploadManager::IsComplete(uint64_t batchId)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	for (const Batch& batch : m_InFlight)
+	{
+		if (batch.Id == batchId)
+			return vkGetFenceStatus(m_pCpu->GetDevice(), batch.Fence) == VK_SUCCESS;
+	}
+
+	//Batches that are no longer in flight have been collected, unless they weren't flushed yet.
+	return batchId < m_NextBatchId;
+}
+
+void UploadManager::Wait(uint64_t batchId)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	if (batchId >= m_NextBatchId)
+		throw std::runtime_error("waiting for an upload batch that wasn't flushed!");
+
+	for (const Batch& batch : m_InFlight)
+	{
+		if (batch.Id == batchId)
+			vkWaitForFences(m_pCpu->GetDevice(), 1, &batch.Fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+	}
+}
+
+void UploadManager::CollectCompleted()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	while (!m_InFlight.empty() && vkGetFenceStatus(m_pCpu->GetDevice(), m_InFlight.front().Fence) == VK_SUCCESS)
+	{
+		ReleaseBatch(m_InFlight.front());
+		m_InFlight.pop_front();
+	}
+}
+
+void UploadManager::BeginBatch()
+{
+	if (m_IsRecording)
+		return;
+
+	m_Recording.TransferCommands = BeginCommandBuffer(m_TransferPool);
+	m_Recording.GraphicsCommands = BeginCommandBuffer(m_GraphicsPool);
+	m_IsRecording = true;
+
+	if (m_pProfiler && !HasDedicatedTransferQueue())
+		m_Recording.TransferScope = m_pProfiler->BeginGpuScope(m_Recording.TransferCommands, "uploads");
+}
+
+UploadManager::StagingBuffer UploadManager::CreateStagingBuffer(const void* pData, VkDeviceSize size)
+{
+	//Host visible memory is persistently mapped by the allocator, so we can write to it directly.
+	StagingBuffer staging;
+	CreateBuffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, staging.Buffer, staging.BufferAllocation, m_pCpu);
+	if (pData)
+		memcpy(staging.BufferAllocation.pMapped, pData, static_cast<size_t>(size));
+
+	return staging;
+}
+
+void UploadManager::ReleaseBatch(Batch& batch)
+{
+	for (StagingBuffer& staging : batch.StagingBuffers)
+	{
+		vkDestroyBuffer(m_pCpu->GetDevice(), staging.Buffer, nullptr);
+		m_pCpu->GetAllocator()->Free(staging.BufferAllocation);
+	}
+	batch.StagingBuffers.clear();
+
+	vkFreeCommandBuffers(m_pCpu->GetDevice(), m_TransferPool, 1, &batch.TransferCommands);
+	vkFreeCommandBuffers(m_pCpu->GetDevice(), m_GraphicsPool, 1, &batch.GraphicsCommands);
+
+	if (batch.TransferFinished != VK_NULL_HANDLE)
+		vkDestroySemaphore(m_pCpu->GetDevice(), batch.TransferFinished, nullptr);
+	if (batch.Fence != VK_NULL_HANDLE)
+		vkDestroyFence(m_pCpu->GetDevice(), batch.Fence, nullptr);
+}
+
+VkCommandPool UploadManager::CreatePool(uint32_t queueFamily) const
+{
+	//Every command buffer is recorded once and freed when its batch completes.
+	VkCommandPoolCreateInfo poolInfo = {};
+	poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	poolInfo.queueFamilyIndex = queueFamily;
+	poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+	VkCommandPool pool;
+	if (vkCreateCommandPool(m_pCpu->GetDevice(), &poolInfo, nullptr, &pool) != VK_SUCCESS)
+		throw std::runtime_error("failed to create upload command pool!");
+
+	return pool;
+}
+
+VkCommandBuffer UploadManager::BeginCommandBuffer(VkCommandPool pool) const
+{
+	VkCommandBufferAllocateInfo allocInfo = {};
+	allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	allocInfo.commandPool = pool;
+	allocInfo.commandBufferCount = 1;
+
+	VkCommandBuffer commandBuffer;
+	if (vkAllocateCommandBuffers(m_pCpu->GetDevice(), &allocInfo, &commandBuffer) != VK_SUCCESS)
+		throw std::runtime_error("failed to allocate upload command buffer!");
+
+	VkCommandBufferBeginInfo beginInfo = {};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	vkBeginCommandBuffer(commandBuffer, &beginInfo);
+
+	return commandBuffer;
+}
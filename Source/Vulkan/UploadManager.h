@@ -0,0 +1,120 @@
+#pragma once
+
+#ifndef GLFW_INCLUDE_VULKAN
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+#endif
+
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <functional>
+
+#include "MemoryAllocator.h"
+#include "Profiler.h"
+
+class LogicalDevice;
+class PhysicalDevice;
+
+//Streams buffer and image data to device local memory without stalling the CPU or the graphics queue.
+//Uploads are recorded into a batch on the transfer queue and go out together in a single submission with Flush.
+//Resources are created with VK_SHARING_MODE_EXCLUSIVE, so when the transfer queue belongs to its own family
+//the transfer queue releases them and a small command buffer on the graphics queue acquires them again.
+//That command buffer waits on a semaphore of the transfer submission, and every frame submitted after it
+//is ordered behind its barriers, so nothing has to wait on the CPU for an upload to finish.
+//All functions may be called from several threads, except Flush, which submits to the graphics queue.
+class UploadManager
+{
+public:
+	//Tightly packed pixels or blocks of one mip level.
+	struct ImageLevel
+	{
+		const void* pData = nullptr;
+		VkDeviceSize Size = 0;
+		uint32_t Width = 0;
+		uint32_t Height = 0;
+	};
+
+	UploadManager(LogicalDevice* pCpu, PhysicalDevice* pGpu);
+	~UploadManager();
+
+	//Copies size bytes of pData into dstBuffer. dstAccess and dstStage describe the first use of the buffer on the graphics queue.
+	void UploadBuffer(VkBuffer dstBuffer, const void* pData, VkDeviceSize size, VkAccessFlags dstAccess, VkPipelineStageFlags dstStage);
+
+	//Copies tightly packed pixels into mip level 0 of image, which has to be in VK_IMAGE_LAYOUT_UNDEFINED.
+	//All mipLevels end up in finalLayout, ready for the given access on the graphics queue.
+	void UploadImage(VkImage image, const void* pData, VkDeviceSize size, uint32_t width, uint32_t height, uint32_t mipLevels,
+		VkImageLayout finalLayout, VkAccessFlags dstAccess, VkPipelineStageFlags dstStage);
+
+	//Same, but copies levels[i] into mip level i, for images whose mip chain was generated offline.
+	void UploadImage(VkImage image, const std::vector<ImageLevel>& levels, uint32_t mipLevels,
+		VkImageLayout finalLayout, VkAccessFlags dstAccess, VkPipelineStageFlags dstStage);
+
+	//Records commands that need the graphics queue, like blits, into the batch. They run after all uploads
+	//before them have been acquired by the graphics queue.
+	void RecordGraphicsCommands(const std::function<void(VkCommandBuffer)>& record);
+
+	//Submits the current batch and returns its id, or the id of the last batch if nothing was uploaded since.
+	//Does not wait for the GPU.
+	uint64_t Flush();
+
+	bool IsComplete(uint64_t batchId);
+	void Wait(uint64_t batchId);
+
+	//Releases the staging memory and command buffers of every batch the GPU is done with. Never blocks.
+	void CollectCompleted();
+
+	bool HasDedicatedTransferQueue() const { return m_TransferFamily != m_GraphicsFamily; }
+
+	//Every batch is measured as a GPU scope, but only when it's uploaded on the graphics queue: a transfer queue
+	//can write timestamps, but not reset the queries. The graphics commands of a batch can use the profiler as well.
+	void SetProfiler(Profiler* pProfiler) { m_pProfiler = pProfiler; }
+	Profiler* GetProfiler() const { return m_pProfiler; }
+
+private:
+	struct StagingBuffer
+	{
+		VkBuffer Buffer = VK_NULL_HANDLE;
+		Allocation BufferAllocation;
+	};
+
+	struct Batch
+	{
+		uint64_t Id = 0;
+		VkCommandBuffer TransferCommands = VK_NULL_HANDLE;
+		VkCommandBuffer GraphicsCommands = VK_NULL_HANDLE;
+		VkSemaphore TransferFinished = VK_NULL_HANDLE;
+		VkFence Fence = VK_NULL_HANDLE;
+		std::vector<StagingBuffer> StagingBuffers;
+		uint32_t TransferScope = Profiler::INVALID_SCOPE;
+	};
+
+	//Begins the command buffers of the batch that is being recorded, if that hasn't happened yet.
+	void BeginBatch();
+	//Leaves the buffer uninitialized when pData is null.
+	StagingBuffer CreateStagingBuffer(const void* pData, VkDeviceSize size);
+	void ReleaseBatch(Batch& batch);
+
+	VkCommandPool CreatePool(uint32_t queueFamily) const;
+	VkCommandBuffer BeginCommandBuffer(VkCommandPool pool) const;
+
+private:
+	LogicalDevice* m_pCpu;
+	PhysicalDevice* m_pGpu;
+
+	uint32_t m_GraphicsFamily;
+	uint32_t m_TransferFamily;
+
+	VkCommandPool m_TransferPool;
+	VkCommandPool m_GraphicsPool;
+
+	std::mutex m_Mutex;
+	Batch m_Recording;
+	bool m_IsRecording = false;
+
+	//Submitted batches, oldest first.
+	std::deque<Batch> m_InFlight;
+	uint64_t m_NextBatchId = 1;
+
+	Profiler* m_pProfiler = nullptr;
+};
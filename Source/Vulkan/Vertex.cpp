@@ -1,5 +1,9 @@
 #include "Vertex.h"
 
+#include <glm/gtc/packing.hpp>
+
+#include <cstring>
+
 VkVertexInputBindingDescription Vertex::GetBindingDescription()
 {
 	//A vertex binding describes at which rate to load data from memory throught the vertices.
@@ -76,4 +80,83 @@ std::array<VkVertexInputAttributeDescription, 3> Vertex::GetAttributeDescription
 bool Vertex::operator==(const Vertex& other) const
 {
 	return Position == other.Position && Color == other.Color && TexCoord == other.TexCoord;
+}
+
+VkVertexInputBindingDescription PackedVertex::GetBindingDescription()
+{
+	VkVertexInputBindingDescription bindingDescription = {};
+	bindingDescription.binding = 0;
+	bindingDescription.stride = sizeof(PackedVertex);
+	bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+	return bindingDescription;
+}
+
+std::array<VkVertexInputAttributeDescription, 3> PackedVertex::GetAttributeDescriptions()
+{
+	//The locations match the ones of Vertex, so the same vertex shader reads both layouts.
+	//UNORM formats arrive in the shader as floats in [0, 1], SFLOAT formats as regular floats.
+	std::array<VkVertexInputAttributeDescription, 3> attributeDescriptions = {};
+
+	//POSITION
+	//------------------
+	attributeDescriptions[0].binding = 0;
+	attributeDescriptions[0].location = 0;
+	attributeDescriptions[0].format = VK_FORMAT_R16G16B16A16_UNORM;
+	attributeDescriptions[0].offset = offsetof(PackedVertex, Position);
+
+	//COLOR
+	//-----------------
+	attributeDescriptions[1].binding = 0;
+	attributeDescriptions[1].location = 1;
+	attributeDescriptions[1].format = VK_FORMAT_R8G8B8A8_UNORM;
+	attributeDescriptions[1].offset = offsetof(PackedVertex, Color);
+
+	//TEXCOORD
+	//-----------------
+	attributeDescriptions[2].binding = 0;
+	attributeDescriptions[2].location = 2;
+	attributeDescriptions[2].format = VK_FORMAT_R16G16_SFLOAT;
+	attributeDescriptions[2].offset = offsetof(PackedVertex, TexCoord);
+
+	return attributeDescriptions;
+}
+
+VkVertexInputBindingDescription InstanceData::GetBindingDescription()
+{
+	VkVertexInputBindingDescription bindingDescription = {};
+	bindingDescription.binding = 1;
+	bindingDescription.stride = sizeof(InstanceData);
+	bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+
+	return bindingDescription;
+}
+
+std::array<VkVertexInputAttributeDescription, 4> InstanceData::GetAttributeDescriptions()
+{
+	std::array<VkVertexInputAttributeDescription, 4> attributeDescriptions = {};
+
+	for (uint32_t column = 0; column < 4; ++column)
+	{
+		attributeDescriptions[column].binding = 1;
+		attributeDescriptions[column].location = 3 + column;
+		attributeDescriptions[column].format = VK_FORMAT_R32G32B32A32_SFLOAT;
+		attributeDescriptions[column].offset = offsetof(InstanceData, Model) + column * sizeof(glm::vec4);
+	}
+
+	return attributeDescriptions;
+}
+
+PackedVertex PackedVertex::Pack(const Vertex& vertex, const glm::vec3& boundsMin, const glm::vec3& boundsExtent)
+{
+	PackedVertex packed = {};
+
+	const glm::vec3 normalized = glm::clamp((vertex.Position - boundsMin) / boundsExtent, 0.0f, 1.0f);
+	const glm::uint64 position = glm::packUnorm4x16(glm::vec4(normalized, 0.0f));
+	memcpy(packed.Position, &position, sizeof(packed.Position));
+
+	packed.TexCoord = glm::packHalf2x16(vertex.TexCoord);
+	packed.Color = glm::packUnorm4x8(glm::vec4(vertex.Color, 1.0f));
+
+	return packed;
 }
\ No newline at end of file
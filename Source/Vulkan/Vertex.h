@@ -42,6 +42,47 @@ struct Vertex
 	bool operator==(const Vertex& other) const;
 };
 
+//Which vertex layout the vertex buffer and the pipeline use.
+enum class VertexFormat
+{
+	//Vertex: 32 bytes of floats.
+	Float,
+
+	//PackedVertex: 16 bytes of quantized attributes.
+	Packed
+};
+
+//Half the size of a Vertex. The vertex shader doesn't need to know about it: the vertex input stage converts
+//the normalized and half float formats to floats, and the positions are mapped back to the mesh bounds by the model matrix.
+struct PackedVertex
+{
+	//Position within the bounding box of the mesh, 0 is the minimum and 65535 the maximum on each axis.
+	//The 4th component is padding, 3 component 16 bit formats are rarely supported for vertex buffers.
+	uint16_t Position[4];
+
+	//2 half floats, so texture coordinates outside [0, 1] for repeating textures keep working.
+	uint32_t TexCoord;
+
+	//RGBA8 unorm.
+	uint32_t Color;
+
+	static VkVertexInputBindingDescription GetBindingDescription();
+	static std::array<VkVertexInputAttributeDescription, 3> GetAttributeDescriptions();
+
+	//Quantizes vertex relative to the bounding box [boundsMin, boundsMin + boundsExtent].
+	static PackedVertex Pack(const Vertex& vertex, const glm::vec3& boundsMin, const glm::vec3& boundsExtent);
+};
+
+//Per instance data of the instanced pipeline, read from binding 1 once per instance instead of once per vertex.
+//A mat4 attribute takes 4 locations, one per column, following the 3 of the vertex.
+struct InstanceData
+{
+	glm::mat4 Model;
+
+	static VkVertexInputBindingDescription GetBindingDescription();
+	static std::array<VkVertexInputAttributeDescription, 4> GetAttributeDescriptions();
+};
+
 
 namespace std
 {
@@ -3,18 +3,16 @@
 #include "../Help/HelperMethods.h"
 
 #include "LogicalDevice.h"
-#include "CommandPool.h"
+#include "UploadManager.h"
 
-VertexBuffer::VertexBuffer(LogicalDevice* pCpu, PhysicalDevice* pGpu, CommandPool* pCommandPool, const std::vector<Vertex>& vertices):
+VertexBuffer::VertexBuffer(LogicalDevice* pCpu, UploadManager* pUploader, const void* pVertexData, VkDeviceSize size):
 	m_pCpu(pCpu)
 {
-	VkDeviceSize bufferSize = sizeof(vertices[0]) * vertices.size();
+	//The data is either an array of Vertex or of PackedVertex, the buffer doesn't care which.
+	VkDeviceSize bufferSize = size;
 	//CreateBuffer(bufferSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, m_VertexBuffer, m_VertexBufferMemory);
 
-	VkBuffer staginBuffer;
-	VkDeviceMemory stagingBufferMemory;
-
-	//We're now using a new staginBuffer with staginBufferMemory for mapping and copying the vertex data.
+	//The upload manager copies the vertex data into a staging buffer for mapping and copying.
 	//In this chapter we're going to use 2 new buffer flags:
 	//VK_BUFFER_USAGE_TRANSFER_SRC_BIT: Buffer can be used as source in a memory transfer operation.
 	//VK_BUFFER_USAGE_TRANSFER_DST_BIT: Buffer can be used as destination in a memory transfer operation.
@@ -23,29 +21,17 @@ VertexBuffer::VertexBuffer(LogicalDevice* pCpu, PhysicalDevice* pGpu, CommandPoo
 	//that we're not able to use vkMapMemory. However, we can copy data from the stagingBuffer to the m_VertexBuffer.
 	//We have to indicate that we inted to do that by specifying the transfer source flag for the stagingBuffer and
 	//the transfer destination flag for the m_VertexBuffer, along with the vrtex buffer usage flag.
-	CreateBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, staginBuffer, stagingBufferMemory, pCpu, pGpu);
-
-	void* data;
-	vkMapMemory(pCpu->GetDevice(), stagingBufferMemory, 0, bufferSize, 0, &data);
-	memcpy(data, vertices.data(), (size_t)bufferSize);
-	vkUnmapMemory(pCpu->GetDevice(), stagingBufferMemory);
+	CreateBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_Buffer, m_BufferAllocation, pCpu);
 
-	CreateBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_Buffer, m_BufferMemory, pCpu, pGpu);
-	CopyBuffer(staginBuffer, m_Buffer, bufferSize, pCommandPool->GetPool(), pCpu);
-
-	vkDestroyBuffer(pCpu->GetDevice(), staginBuffer, nullptr);
-	vkFreeMemory(pCpu->GetDevice(), stagingBufferMemory, nullptr);
+	//The vertices may point straight into a memory mapped mesh cache, in which case the staging buffer is the only copy they go through.
+	//The copy itself only happens once the upload manager flushes, the buffer can't be drawn from before that.
+	pUploader->UploadBuffer(m_Buffer, pVertexData, bufferSize, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT);
 
 	//It should be noted that in real world applications, you're not supposed to actually call vkAllocateMemory
 	//for every individual buffer. The Maximum number of simultaneous memory allocations is limited by the maxMemoryAllocationCount
 	//physical device limit, which may be as low as 4096 even on high end hardware like an NVIDIA GTX 1080.
-	//The right way to allocate memory for a large number of objects at the same time is to create a custom allocator
-	//that splits up a single allocatoin among many different objects by using the offset parameters that we've
-	//seen in many functions.
-
-	//You can either implement such an allocator yourself, or use the VulkanMemoryAllocator library provided by the GPUOpen initiave.
-	//However, for this tutorial it's okay to use a seperate allocation for every resource, because we won't come close
-	//to hitting any of these limits for now.
+	//That's why CreateBuffer goes through the MemoryAllocator of the logical device, which splits up a few large
+	//allocations among many different objects by using the offset parameters that we've seen in many functions.
 
 	//Copy vertices into buffer
 	//Unfortunately the driver may not immediately copy the data into the buffer memory.,
@@ -67,6 +53,6 @@ VertexBuffer::VertexBuffer(LogicalDevice* pCpu, PhysicalDevice* pGpu, CommandPoo
 VertexBuffer::~VertexBuffer()
 {
 	vkDestroyBuffer(m_pCpu->GetDevice(), m_Buffer, nullptr);
-	vkFreeMemory(m_pCpu->GetDevice(), m_BufferMemory, nullptr);
+	m_pCpu->GetAllocator()->Free(m_BufferAllocation);
 
 }
\ No newline at end of file
@@ -8,23 +8,23 @@
 #include <vector>
 
 #include "../Vulkan/Vertex.h"
+#include "MemoryAllocator.h"
 
 class LogicalDevice;
-class CommandPool;
-class PhysicalDevice;
+class UploadManager;
 
 class VertexBuffer
 {
 public: 
-	VertexBuffer(LogicalDevice* pCpu, PhysicalDevice* pGpu, CommandPool* pCommandPool, const std::vector<Vertex>& vertices);
+	VertexBuffer(LogicalDevice* pCpu, UploadManager* pUploader, const void* pVertexData, VkDeviceSize size);
 	~VertexBuffer();
 
 	const VkBuffer& GetBuffer() const { return m_Buffer; }
-	const VkDeviceMemory& GetBufferMemory() const { return m_BufferMemory; }
+	const Allocation& GetBufferAllocation() const { return m_BufferAllocation; }
 
 private:
 	VkBuffer m_Buffer;
-	VkDeviceMemory m_BufferMemory;
+	Allocation m_BufferAllocation;
 
 	LogicalDevice* m_pCpu;
 };
\ No newline at end of file
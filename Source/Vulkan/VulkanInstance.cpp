@@ -14,8 +14,9 @@ static VKAPI_ATTR VkBool32 VKAPI_CALL DebugCallback(VkDebugUtilsMessageSeverityF
 }
 
 
-VulkanInstance::VulkanInstance(bool enableValidationLayers):
-	m_EnableValidationLayers(enableValidationLayers)
+VulkanInstance::VulkanInstance(bool enableValidationLayers, bool isHeadless):
+	m_EnableValidationLayers(enableValidationLayers),
+	m_IsHeadless(isHeadless)
 {
 	//If we have validation layers enabled, we need to check if we actually support them
 	if (m_EnableValidationLayers && !CheckValidationLayerSupport())
@@ -73,6 +74,36 @@ bool VulkanInstance::CheckValidationLayerSupport() const
 
 }
 
+bool VulkanInstance::IsExtensionAvailable(const char* name) const
+{
+	uint32_t extensionCount = 0;
+	vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, nullptr);
+
+	std::vector<VkExtensionProperties> extensions(extensionCount);
+	vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, extensions.data());
+
+	for (const VkExtensionProperties& extension : extensions)
+	{
+		if (strcmp(extension.extensionName, name) == 0)
+			return true;
+	}
+
+	return false;
+}
+
+bool VulkanInstance::GetPhysicalDeviceFeatures2(VkPhysicalDevice device, VkPhysicalDeviceFeatures2KHR* pFeatures) const
+{
+	if (!m_HasPhysicalDeviceProperties2)
+		return false;
+
+	auto func = (PFN_vkGetPhysicalDeviceFeatures2KHR)vkGetInstanceProcAddr(m_Instance, "vkGetPhysicalDeviceFeatures2KHR");
+	if (func == nullptr)
+		return false;
+
+	func(device, pFeatures);
+	return true;
+}
+
 void VulkanInstance::ShowExtensions() const
 {
 	uint32_t extensionCount = 0;
@@ -93,16 +124,27 @@ void VulkanInstance::InitRequiredExtentions()
 {
 	ShowExtensions();
 
-	uint32_t glfwExtensionCount = 0;
-	const char** glfwExtensions;
+	std::vector<const char*> extensions;
 
-	glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+	//GLFW is never initialized in headless mode and we don't need any surface extensions there.
+	if (!m_IsHeadless)
+	{
+		uint32_t glfwExtensionCount = 0;
+		const char** glfwExtensions;
 
-	std::vector<const char*> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
+		glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+
+		extensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+	}
 
 	if (m_EnableValidationLayers)
 		extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
 
+	//Optional, we only need it to ask devices about the features of their extensions.
+	m_HasPhysicalDeviceProperties2 = IsExtensionAvailable(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+	if (m_HasPhysicalDeviceProperties2)
+		extensions.push_back(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+
 	m_RequiredExtentions = std::move(extensions);
 }
 
@@ -13,15 +13,21 @@
 class VulkanInstance
 {
 public:
-	VulkanInstance(bool enableValidationLayers);
+	//A headless instance doesn't ask GLFW for its surface extensions.
+	VulkanInstance(bool enableValidationLayers, bool isHeadless = false);
 	~VulkanInstance();
 
 	VkInstance GetInstance() const { return m_Instance; }
 	const std::vector<const char*>& GetRequiredExtensions() const { return m_RequiredExtentions; }
 	bool AreValidationLayersEnabled() const { return m_EnableValidationLayers; }
 
+	//Queries the features of extensions through the pNext chain of features, see VK_KHR_get_physical_device_properties2.
+	//Returns false when the instance doesn't support that extension.
+	bool GetPhysicalDeviceFeatures2(VkPhysicalDevice device, VkPhysicalDeviceFeatures2KHR* pFeatures) const;
+
 private:
 	bool CheckValidationLayerSupport() const;
+	bool IsExtensionAvailable(const char* name) const;
 	void InitRequiredExtentions();
 	void ShowExtensions() const;
 	void SetupDebugCallback();
@@ -34,6 +40,7 @@ private:
 	VkInstance m_Instance;
 	VkDebugUtilsMessengerEXT m_Callback;
 	std::vector<const char*> m_RequiredExtentions;
+	bool m_HasPhysicalDeviceProperties2 = false;
 
 #ifdef NDEBUG
 	const bool m_EnableValidationLayers = false;
@@ -41,4 +48,5 @@ private:
 	const bool m_EnableValidationLayers = true;
 #endif
 	const std::vector<const char*> m_ValidationLayers = { "VK_LAYER_LUNARG_standard_validation" };
+	bool m_IsHeadless;
 };
\ No newline at end of file